@@ -0,0 +1,82 @@
+#include "broadphase.h"
+#include <stdint.h>
+#include <string.h>
+
+typedef struct {
+    uint8_t count;
+    uint8_t ids[BROADPHASE_CELL_CAPACITY];
+} Cell;
+
+static Cell cells[BROADPHASE_ROWS][BROADPHASE_COLS];
+static uint8_t overflow[BROADPHASE_MAX_ITEMS];
+static int overflowCount = 0;
+
+// An item touching several cells is found once per query by stamping it
+static uint32_t stamps[BROADPHASE_MAX_ITEMS];
+static uint32_t queryStamp = 0;
+
+static int cellIndex(float position, int cellCount) {
+    int cell = (int)(position / BROADPHASE_CELL_SIZE);
+    if (position < 0.0f || cell < 0) return 0;
+    return cell < cellCount ? cell : cellCount - 1;
+}
+
+void broadphaseClear(void) {
+    memset(cells, 0, sizeof(cells));
+    memset(stamps, 0, sizeof(stamps));
+    overflowCount = 0;
+    queryStamp = 0;
+}
+
+int broadphaseInsert(int id, float minX, float minY, float maxX, float maxY) {
+    if (id < 0 || id >= BROADPHASE_MAX_ITEMS) return 0;
+
+    int spilled = 0;
+    for (int row = cellIndex(minY, BROADPHASE_ROWS); row <= cellIndex(maxY, BROADPHASE_ROWS); row++) {
+        for (int col = cellIndex(minX, BROADPHASE_COLS); col <= cellIndex(maxX, BROADPHASE_COLS); col++) {
+            Cell* cell = &cells[row][col];
+            if (cell->count < BROADPHASE_CELL_CAPACITY) {
+                cell->ids[cell->count++] = (uint8_t)id;
+            } else if (!spilled) {
+                overflow[overflowCount++] = (uint8_t)id;
+                spilled = 1;
+            }
+        }
+    }
+    return 1;
+}
+
+static int addCandidate(int id, int* ids, int count, int maxIds) {
+    if (stamps[id] == queryStamp || count >= maxIds) return count;
+    stamps[id] = queryStamp;
+
+    // Insertion keeps the handful of candidates sorted
+    int i = count;
+    while (i > 0 && ids[i - 1] > id) {
+        ids[i] = ids[i - 1];
+        i--;
+    }
+    ids[i] = id;
+    return count + 1;
+}
+
+int broadphaseQuery(float minX, float minY, float maxX, float maxY, int* ids, int maxIds) {
+    if (++queryStamp == 0) {
+        memset(stamps, 0, sizeof(stamps));
+        queryStamp = 1;
+    }
+
+    int count = 0;
+    for (int i = 0; i < overflowCount; i++) {
+        count = addCandidate(overflow[i], ids, count, maxIds);
+    }
+    for (int row = cellIndex(minY, BROADPHASE_ROWS); row <= cellIndex(maxY, BROADPHASE_ROWS); row++) {
+        for (int col = cellIndex(minX, BROADPHASE_COLS); col <= cellIndex(maxX, BROADPHASE_COLS); col++) {
+            const Cell* cell = &cells[row][col];
+            for (int i = 0; i < cell->count; i++) {
+                count = addCandidate(cell->ids[i], ids, count, maxIds);
+            }
+        }
+    }
+    return count;
+}
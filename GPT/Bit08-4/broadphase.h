@@ -0,0 +1,28 @@
+#ifndef BROADPHASE_H
+#define BROADPHASE_H
+
+// Uniform-grid broadphase over the 800x480 playfield. Items go in by
+// their bounding box, into every BROADPHASE_CELL_SIZE square cell the box
+// touches; a query returns each item sharing a cell with the query box,
+// once, in ascending id order, so callers can keep the order a full scan
+// would have used. Boxes past the edges are clamped to the edge cells.
+// The game files its bricks here once per level, and the balls and laser
+// bolts ask it for the few bricks worth a real test. Everything is fixed
+// size; a full cell spills into an overflow list that every query returns.
+
+#define BROADPHASE_CELL_SIZE 40.0f
+#define BROADPHASE_COLS 20
+#define BROADPHASE_ROWS 12
+#define BROADPHASE_CELL_CAPACITY 8
+#define BROADPHASE_MAX_ITEMS 256
+
+// Empties the grid; call before inserting a new set
+void broadphaseClear(void);
+
+// Ids run from 0 to BROADPHASE_MAX_ITEMS - 1; returns 0 if out of range
+int broadphaseInsert(int id, float minX, float minY, float maxX, float maxY);
+
+// Writes up to maxIds candidate ids to ids and returns how many
+int broadphaseQuery(float minX, float minY, float maxX, float maxY, int* ids, int maxIds);
+
+#endif // BROADPHASE_H
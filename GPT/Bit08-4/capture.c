@@ -0,0 +1,194 @@
+#include "capture.h"
+#include <GL/glew.h>
+#include <SDL2/SDL_image.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef enum {
+    CAPTURE_PRESS,
+    CAPTURE_RELEASE,
+    CAPTURE_FRAME,
+    CAPTURE_QUIT
+} CaptureAction;
+
+typedef struct {
+    int frame;
+    CaptureAction action;
+    char key[CAPTURE_KEY_NAME_LENGTH];
+} CaptureEvent;
+
+static CaptureEvent events[CAPTURE_MAX_EVENTS];
+static int eventCount = 0;
+static int nextEvent = 0;           // First event not yet reached
+static int frame = 0;               // Current frame, 0 before the first
+static unsigned seed = 1;
+static int active = 0;
+static const char* output = NULL;
+static Uint8 keyState[SDL_NUM_SCANCODES];
+
+static GLubyte* pixels = NULL;      // Readback buffer, sized on first use
+static int pixelsSize = 0;
+static int framesWritten = 0;
+
+int captureLoad(const char* scriptPath, const char* outputDir) {
+    FILE* file = fopen(scriptPath, "r");
+    if (file == NULL) {
+        printf("Can't open capture script %s\n", scriptPath);
+        return 0;
+    }
+
+    char line[128];
+    int lineNumber = 0;
+    int ok = 1;
+    while (ok && fgets(line, sizeof(line), file) != NULL) {
+        lineNumber++;
+        line[strcspn(line, "\r\n")] = '\0';
+        char* comment = strchr(line, '#');
+        if (comment != NULL) *comment = '\0';
+
+        char word[16];
+        char key[CAPTURE_KEY_NAME_LENGTH] = "";
+        int at;
+        unsigned value;
+        if (sscanf(line, " %15s", word) != 1) {
+            continue;
+        }
+        if (strcmp(word, "seed") == 0 && sscanf(line, " seed %u", &value) == 1) {
+            seed = value;
+            continue;
+        }
+
+        int fields = sscanf(line, " %d %15s %23s", &at, word, key);
+        CaptureEvent event = {at, CAPTURE_FRAME, ""};
+        if (fields == 3 && strcmp(word, "press") == 0) {
+            event.action = CAPTURE_PRESS;
+        } else if (fields == 3 && strcmp(word, "release") == 0) {
+            event.action = CAPTURE_RELEASE;
+        } else if (fields == 2 && strcmp(word, "capture") == 0) {
+            event.action = CAPTURE_FRAME;
+        } else if (fields == 2 && strcmp(word, "quit") == 0) {
+            event.action = CAPTURE_QUIT;
+        } else {
+            printf("%s:%d: can't parse \"%s\"\n", scriptPath, lineNumber, line);
+            ok = 0;
+            break;
+        }
+        if (at < 1 || (eventCount > 0 && at < events[eventCount - 1].frame)) {
+            printf("%s:%d: frames must start at 1 and never go back\n", scriptPath, lineNumber);
+            ok = 0;
+        } else if (eventCount == CAPTURE_MAX_EVENTS) {
+            printf("%s:%d: more than %d events\n", scriptPath, lineNumber, CAPTURE_MAX_EVENTS);
+            ok = 0;
+        } else {
+            memcpy(event.key, key, sizeof(event.key));
+            events[eventCount++] = event;
+        }
+    }
+    fclose(file);
+
+    output = outputDir;
+    active = ok;
+    return ok;
+}
+
+int captureActive(void) {
+    return active;
+}
+
+unsigned captureSeed(void) {
+    return seed;
+}
+
+const Uint8* captureKeyboardState(void) {
+    return keyState;
+}
+
+// Held keys go into the scripted keyboard state; the event is pushed too
+// for anything the game handles as an event (F1)
+static void applyKey(SDL_EventType type, const char* name) {
+    SDL_Scancode scancode = SDL_GetScancodeFromName(name);
+    if (scancode == SDL_SCANCODE_UNKNOWN) {
+        printf("Capture script: unknown key \"%s\"\n", name);
+        return;
+    }
+    keyState[scancode] = type == SDL_KEYDOWN;
+
+    SDL_Event e = {0};
+    e.type = type;
+    e.key.state = type == SDL_KEYDOWN ? SDL_PRESSED : SDL_RELEASED;
+    e.key.keysym.scancode = scancode;
+    e.key.keysym.sym = SDL_GetKeyFromScancode(scancode);
+    SDL_PushEvent(&e);
+}
+
+int captureBeginFrame(void) {
+    if (!active) return 1;
+
+    frame++;
+    for (int i = nextEvent; i < eventCount && events[i].frame == frame; i++) {
+        if (events[i].action == CAPTURE_PRESS) {
+            applyKey(SDL_KEYDOWN, events[i].key);
+        } else if (events[i].action == CAPTURE_RELEASE) {
+            applyKey(SDL_KEYUP, events[i].key);
+        } else if (events[i].action == CAPTURE_QUIT) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+void captureReadFrame(void) {
+    if (!active) return;
+
+    int wanted = 0;
+    while (nextEvent < eventCount && events[nextEvent].frame <= frame) {
+        wanted |= events[nextEvent].frame == frame && events[nextEvent].action == CAPTURE_FRAME;
+        nextEvent++;
+    }
+    if (!wanted) return;
+
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    int width = viewport[2], height = viewport[3];
+    if (width * height > pixelsSize) {
+        free(pixels);
+        pixels = malloc((size_t)width * height * 4);
+        pixelsSize = pixels != NULL ? width * height : 0;
+        if (pixels == NULL) return;
+    }
+
+    // RGBA bytes are the one readback format GLES 2 always supports
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(viewport[0], viewport[1], width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+
+    // GL rows run bottom to top
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_RGBA32);
+    if (surface == NULL) {
+        printf("SDL_CreateRGBSurfaceWithFormat Error: %s\n", SDL_GetError());
+        return;
+    }
+    for (int y = 0; y < height; y++) {
+        memcpy((Uint8*)surface->pixels + y * surface->pitch, pixels + (size_t)(height - 1 - y) * width * 4,
+               (size_t)width * 4);
+    }
+
+    char path[512];
+    snprintf(path, sizeof(path), "%s/frame_%05d.png", output, frame);
+    if (IMG_SavePNG(surface, path) != 0) {
+        printf("IMG_SavePNG Error for %s: %s\n", path, IMG_GetError());
+    } else {
+        framesWritten++;
+    }
+    SDL_FreeSurface(surface);
+}
+
+void captureShutdown(void) {
+    if (!active) return;
+
+    printf("Captured %d frames to %s over %d frames\n", framesWritten, output, frame);
+    free(pixels);
+    pixels = NULL;
+    pixelsSize = 0;
+    active = 0;
+}
@@ -0,0 +1,40 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <SDL2/SDL.h>
+
+// Golden-frame capture for --capture <script> <dir>. The script fixes the
+// random seed and lists key presses by frame; the game then runs one
+// simulation step per frame on the main thread and reads the arrow keys
+// from the script instead of the keyboard, so a script always produces
+// the same frames. The
+// frames it asks for are read back with glReadPixels before the overlay
+// is drawn and written to <dir>/frame_NNNNN.png, for SDL_API_BRICK/07's
+// frame_diff to check against stored goldens.
+//
+// Script lines (# starts a comment, frames count from 1):
+//   seed <n>
+//   <frame> press <SDL key name>      e.g. "90 press Left"
+//   <frame> release <SDL key name>
+//   <frame> capture
+//   <frame> quit
+
+#define CAPTURE_MAX_EVENTS 512
+#define CAPTURE_KEY_NAME_LENGTH 24
+
+int captureLoad(const char* scriptPath, const char* outputDir);
+int captureActive(void);
+unsigned captureSeed(void);
+
+// Starts the next frame: applies its key events and returns 0 once the
+// script's quit frame is reached
+int captureBeginFrame(void);
+
+// Stands in for SDL_GetKeyboardState while capturing
+const Uint8* captureKeyboardState(void);
+
+// Call after the frame is drawn, before the overlay and the swap
+void captureReadFrame(void);
+void captureShutdown(void);
+
+#endif // CAPTURE_H
@@ -0,0 +1,262 @@
+#include "dynres.h"
+#include "glstate.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define OVER_BUDGET 1.05    // Mean over target by this much scales down
+
+static DynResConfig config = {0.5f, 1.0f, 0.1f, 1000.0 / 60.0, 0.75, 30, 300, 0};
+static int enabled = 0;
+
+static GLuint framebuffer = 0;
+static GLuint sceneTexture = 0;
+static GLuint quadVBO = 0;
+static int fullWidth, fullHeight;
+static int scaledWidth, scaledHeight;
+static float scale = 1.0f;
+static int redirected = 0;      // The current scene went to the framebuffer
+
+static double samples[DYNRES_MAX_WINDOW];
+static int sampleCount = 0;
+static int sampleHead = 0;
+static double sampleSum = 0.0;
+static int framesAtScale = 0;
+static int probeWait;
+static int probing = 0;
+
+static int parseOption(const char* key, const char* value) {
+    char* end;
+    double number = strtod(value, &end);
+    int numeric = end != value && *end == '\0';
+
+    if (strcmp(key, "filter") == 0) {
+        if (strcmp(value, "linear") != 0 && strcmp(value, "nearest") != 0) return 0;
+        config.linear = strcmp(value, "linear") == 0;
+    } else if (!numeric) {
+        return 0;
+    } else if (strcmp(key, "min") == 0) {
+        config.minScale = (float)number;
+    } else if (strcmp(key, "max") == 0) {
+        config.maxScale = (float)number;
+    } else if (strcmp(key, "step") == 0) {
+        config.step = (float)number;
+    } else if (strcmp(key, "target") == 0) {
+        config.targetMs = number;
+    } else if (strcmp(key, "headroom") == 0) {
+        config.headroom = number;
+    } else if (strcmp(key, "window") == 0) {
+        config.window = (int)number;
+    } else if (strcmp(key, "probe") == 0) {
+        config.probeFrames = (int)number;
+    } else {
+        return 0;
+    }
+    return 1;
+}
+
+int dynResConfigure(const char* spec) {
+    enabled = 1;
+    if (spec != NULL) {
+        char options[256];
+        snprintf(options, sizeof(options), "%s", spec);
+        for (char* option = strtok(options, ","); option != NULL; option = strtok(NULL, ",")) {
+            char* value = strchr(option, '=');
+            if (value == NULL) {
+                printf("dynres: expected key=value, got %s\n", option);
+                return 0;
+            }
+            *value++ = '\0';
+            if (!parseOption(option, value)) {
+                printf("dynres: bad option %s=%s\n", option, value);
+                return 0;
+            }
+        }
+    }
+
+    if (config.minScale <= 0.0f || config.minScale > config.maxScale || config.maxScale > 1.0f ||
+        config.step <= 0.0f || config.targetMs <= 0.0 || config.headroom <= 0.0 || config.headroom >= 1.0 ||
+        config.window < 1 || config.window > DYNRES_MAX_WINDOW || config.probeFrames < config.window) {
+        printf("dynres: need 0 < min <= max <= 1, step and target over 0, 0 < headroom < 1, "
+               "1 <= window <= %d and probe >= window\n", DYNRES_MAX_WINDOW);
+        return 0;
+    }
+    return 1;
+}
+
+int dynResEnabled(void) {
+    return enabled;
+}
+
+static void resetSamples(void) {
+    sampleCount = 0;
+    sampleHead = 0;
+    sampleSum = 0.0;
+    framesAtScale = 0;
+}
+
+// The upscale quad covers the window and samples the used corner of the
+// scene texture, so it's rebuilt whenever the scale changes
+static void resize(float wanted) {
+    if (wanted < config.minScale) wanted = config.minScale;
+    if (wanted > config.maxScale) wanted = config.maxScale;
+    scale = wanted;
+    scaledWidth = (int)(fullWidth * scale + 0.5f);
+    scaledHeight = (int)(fullHeight * scale + 0.5f);
+    resetSamples();
+
+    float w = (float)fullWidth, h = (float)fullHeight;
+    float u = (float)scaledWidth / fullWidth, v = (float)scaledHeight / fullHeight;
+    GLfloat vertices[] = {
+        // Position (X, Y, Z)    // Texture coordinates (U, V)
+        0.0f, h, 0.0f,   0.0f, v,  // Top-left
+        0.0f, 0.0f, 0.0f,   0.0f, 0.0f,  // Bottom-left
+        w, 0.0f, 0.0f,   u, 0.0f,  // Bottom-right
+
+        0.0f, h, 0.0f,   0.0f, v,  // Top-left
+        w, 0.0f, 0.0f,   u, 0.0f,  // Bottom-right
+        w, h, 0.0f,   u, v   // Top-right
+    };
+    glStateBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+}
+
+int dynResInit(int width, int height) {
+    if (!enabled) return 1;
+
+    GLint filter = config.linear ? GL_LINEAR : GL_NEAREST;
+    glGenTextures(1, &sceneTexture);
+    glStateBindTexture(GL_TEXTURE_2D, sceneTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+    // GLES2 only takes non-power-of-two textures clamped and unmipmapped
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, sceneTexture, 0);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        printf("dynres: framebuffer incomplete (0x%x), staying at native resolution\n", status);
+        dynResCleanup();
+        return 0;
+    }
+
+    glGenBuffers(1, &quadVBO);
+    fullWidth = width;
+    fullHeight = height;
+    probeWait = config.probeFrames;
+    resize(config.maxScale);
+    printf("dynres %dx%d, scale %.2f to %.2f, target %.2f ms, %s filter\n", width, height,
+           config.minScale, config.maxScale, config.targetMs, config.linear ? "linear" : "nearest");
+    return 1;
+}
+
+float dynResScale(void) {
+    return framebuffer != 0 ? scale : 1.0f;
+}
+
+void dynResBeginScene(void) {
+    // Full size draws straight to the window and skips the extra pass
+    redirected = framebuffer != 0 && (scaledWidth != fullWidth || scaledHeight != fullHeight);
+    if (!redirected) return;
+
+    // The projection is unchanged, so the whole playfield lands in the
+    // smaller viewport
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glViewport(0, 0, scaledWidth, scaledHeight);
+}
+
+void dynResEndScene(GLint positionAttrib, GLint texCoordAttrib, GLint modelUniform) {
+    if (!redirected) return;
+    redirected = 0;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, fullWidth, fullHeight);
+
+    static const float identity[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+    glStateUniformMatrix4fv(modelUniform, 1, GL_FALSE, identity);
+    glStateBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+    glEnableVertexAttribArray(positionAttrib);
+    glVertexAttribPointer(positionAttrib, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (void*)0);
+    glEnableVertexAttribArray(texCoordAttrib);
+    glVertexAttribPointer(texCoordAttrib, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
+    glStateBindTexture(GL_TEXTURE_2D, sceneTexture);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+    glDisableVertexAttribArray(positionAttrib);
+    glDisableVertexAttribArray(texCoordAttrib);
+}
+
+static void changeScale(float wanted, double mean, const char* reason) {
+    if (wanted < config.minScale) wanted = config.minScale;
+    if (wanted > config.maxScale) wanted = config.maxScale;
+    if ((int)(fullWidth * wanted + 0.5f) == scaledWidth && (int)(fullHeight * wanted + 0.5f) == scaledHeight) {
+        return;
+    }
+
+    float from = scale;
+    resize(wanted);
+    printf("dynres %.2f -> %.2f (%dx%d), mean %.2f ms, target %.2f ms, %s\n",
+           from, scale, scaledWidth, scaledHeight, mean, config.targetMs, reason);
+    fflush(stdout);
+}
+
+void dynResFrameEnd(double frameMs) {
+    if (framebuffer == 0) return;
+
+    if (sampleCount == config.window) {
+        sampleSum -= samples[sampleHead];
+    } else {
+        sampleCount++;
+    }
+    samples[sampleHead] = frameMs;
+    sampleSum += frameMs;
+    sampleHead = (sampleHead + 1) % config.window;
+    framesAtScale++;
+
+    // Nothing is decided until a whole window has run at this scale
+    if (sampleCount < config.window) return;
+    double mean = sampleSum / sampleCount;
+
+    if (mean > config.targetMs * OVER_BUDGET) {
+        if (probing) {
+            probeWait = probeWait * 2 < DYNRES_MAX_PROBE_FRAMES ? probeWait * 2 : DYNRES_MAX_PROBE_FRAMES;
+            probing = 0;
+        }
+        // Fill cost goes with the area, so the side goes with its root
+        float wanted = scale * (float)sqrt(config.targetMs / mean);
+        changeScale(wanted < scale - config.step ? scale - config.step : wanted, mean, "over budget");
+        return;
+    }
+
+    if (probing) {
+        probing = 0;
+        probeWait = config.probeFrames;
+    }
+    if (scale >= config.maxScale) return;
+    if (mean < config.targetMs * config.headroom) {
+        changeScale(scale + config.step, mean, "headroom");
+    } else if (framesAtScale >= probeWait) {
+        probing = 1;
+        changeScale(scale + config.step / 2, mean, "probe");
+    }
+}
+
+void dynResCleanup(void) {
+    if (framebuffer != 0) {
+        glDeleteFramebuffers(1, &framebuffer);
+        framebuffer = 0;
+    }
+    if (sceneTexture != 0) {
+        glStateDeleteTextures(1, &sceneTexture);
+        sceneTexture = 0;
+    }
+    if (quadVBO != 0) {
+        glStateDeleteBuffers(1, &quadVBO);
+        quadVBO = 0;
+    }
+}
@@ -0,0 +1,52 @@
+#ifndef DYNRES_H
+#define DYNRES_H
+
+#include <GL/glew.h>
+
+// Dynamic resolution for --dynres. The game scene is drawn into a
+// framebuffer object through a viewport that's a fraction of the window,
+// then stretched over the window with the game's shader; the overlay
+// goes on top at native resolution. A governor keeps a rolling mean of
+// each frame's render and present time and moves the fraction between
+// min and max: down in proportion to the overrun (fill cost goes with the
+// area), up a step when there's clear headroom, and up a probing half
+// step after a long run on budget, since with vsync on frames never look
+// faster than the refresh. A probe that drops back straight away doubles
+// the wait before the next. Every change is logged as a "dynres" line.
+// SDL_API_BRICK/07 and the claude build carry the same governor.
+
+#define DYNRES_MAX_WINDOW 240
+#define DYNRES_MAX_PROBE_FRAMES 3600
+
+typedef struct {
+    float minScale;      // Fraction of the window on each axis
+    float maxScale;
+    float step;          // Largest change per decision
+    double targetMs;     // Budget for render plus present
+    double headroom;     // Step up while the mean is under targetMs * headroom
+    int window;          // Frames in the rolling mean, and held after a change
+    int probeFrames;     // Frames on budget before probing a step up
+    int linear;          // Upscale filter; nearest keeps pixel art sharp
+} DynResConfig;
+
+// Takes "key=value,..." with keys min, max, step, target (ms), headroom,
+// window, probe and filter (nearest or linear); NULL keeps the defaults.
+// Prints the problem and returns 0 on a bad spec.
+int dynResConfigure(const char* spec);
+int dynResEnabled(void);
+
+// Creates the framebuffer; without one the game stays at native resolution
+int dynResInit(int width, int height);
+float dynResScale(void);
+
+// Bracket the scene: between these, draws use the game's projection and
+// land in the scaled framebuffer. dynResEndScene draws it back over the
+// window with the game's shader and leaves the window bound.
+void dynResBeginScene(void);
+void dynResEndScene(GLint positionAttrib, GLint texCoordAttrib, GLint modelUniform);
+
+// Feeds one frame's render plus present time to the governor
+void dynResFrameEnd(double frameMs);
+void dynResCleanup(void);
+
+#endif // DYNRES_H
@@ -0,0 +1,155 @@
+#include "glstate.h"
+#include <stdio.h>
+#include <string.h>
+
+#define UNKNOWN_BINDING 0xFFFFFFFFu
+#define MAX_SHADOWED_UNIFORMS 16
+
+typedef struct {
+    GLuint program;
+    GLint location;
+    GLfloat value[16];
+} UniformShadow;
+
+static const char* callNames[GLSTATE_CALL_COUNT] = {
+    "glBindTexture", "glBindBuffer", "glUseProgram", "glUniformMatrix4fv"
+};
+
+static GLuint boundTexture2D = UNKNOWN_BINDING;
+static GLuint boundArrayBuffer = UNKNOWN_BINDING;
+static GLuint boundElementBuffer = UNKNOWN_BINDING;
+static GLuint currentProgram = UNKNOWN_BINDING;
+static UniformShadow uniforms[MAX_SHADOWED_UNIFORMS];
+static int uniformCount = 0;
+
+static GlStateCounts currentFrame;
+static GlStateCounts lastFrame;
+static GlStateCounts totals;
+static Uint32 frameCount = 0;
+
+// Returns 1 if the call should be issued, and records the shadow value
+static int changeBinding(GLuint* shadow, GLuint value, GlStateCall call) {
+    if (*shadow == value) {
+        currentFrame.filtered[call]++;
+        return 0;
+    }
+    *shadow = value;
+    currentFrame.issued[call]++;
+    return 1;
+}
+
+void glStateBindTexture(GLenum target, GLuint texture) {
+    if (target != GL_TEXTURE_2D) {
+        currentFrame.issued[GLSTATE_TEXTURE]++;
+        glBindTexture(target, texture);
+    } else if (changeBinding(&boundTexture2D, texture, GLSTATE_TEXTURE)) {
+        glBindTexture(target, texture);
+    }
+}
+
+void glStateBindBuffer(GLenum target, GLuint buffer) {
+    GLuint* shadow = target == GL_ARRAY_BUFFER ? &boundArrayBuffer :
+                     target == GL_ELEMENT_ARRAY_BUFFER ? &boundElementBuffer : NULL;
+    if (shadow == NULL) {
+        currentFrame.issued[GLSTATE_BUFFER]++;
+        glBindBuffer(target, buffer);
+    } else if (changeBinding(shadow, buffer, GLSTATE_BUFFER)) {
+        glBindBuffer(target, buffer);
+    }
+}
+
+void glStateUseProgram(GLuint program) {
+    if (changeBinding(&currentProgram, program, GLSTATE_PROGRAM)) {
+        glUseProgram(program);
+    }
+}
+
+static UniformShadow* findUniform(GLuint program, GLint location) {
+    for (int i = 0; i < uniformCount; i++) {
+        if (uniforms[i].program == program && uniforms[i].location == location) {
+            return &uniforms[i];
+        }
+    }
+    if (uniformCount == MAX_SHADOWED_UNIFORMS) {
+        return NULL;
+    }
+
+    // New entries start out different from anything a caller could send
+    UniformShadow* shadow = &uniforms[uniformCount++];
+    shadow->program = program;
+    shadow->location = location;
+    memset(shadow->value, 0xFF, sizeof(shadow->value));
+    return shadow;
+}
+
+void glStateUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value) {
+    // Uniform values belong to the program, so only cache single matrices
+    // for a known program
+    UniformShadow* shadow = NULL;
+    if (count == 1 && !transpose && location >= 0 && currentProgram != UNKNOWN_BINDING) {
+        shadow = findUniform(currentProgram, location);
+    }
+
+    if (shadow != NULL) {
+        if (memcmp(shadow->value, value, sizeof(shadow->value)) == 0) {
+            currentFrame.filtered[GLSTATE_UNIFORM]++;
+            return;
+        }
+        memcpy(shadow->value, value, sizeof(shadow->value));
+    }
+    currentFrame.issued[GLSTATE_UNIFORM]++;
+    glUniformMatrix4fv(location, count, transpose, value);
+}
+
+// GL unbinds a deleted object, so the shadow has to follow
+void glStateDeleteTextures(GLsizei n, const GLuint* textures) {
+    for (GLsizei i = 0; i < n; i++) {
+        if (textures[i] == boundTexture2D) boundTexture2D = 0;
+    }
+    glDeleteTextures(n, textures);
+}
+
+void glStateDeleteBuffers(GLsizei n, const GLuint* buffers) {
+    for (GLsizei i = 0; i < n; i++) {
+        if (buffers[i] == boundArrayBuffer) boundArrayBuffer = 0;
+        if (buffers[i] == boundElementBuffer) boundElementBuffer = 0;
+    }
+    glDeleteBuffers(n, buffers);
+}
+
+void glStateInvalidate(void) {
+    boundTexture2D = UNKNOWN_BINDING;
+    boundArrayBuffer = UNKNOWN_BINDING;
+    boundElementBuffer = UNKNOWN_BINDING;
+    currentProgram = UNKNOWN_BINDING;
+    uniformCount = 0;
+}
+
+void glStateFrameEnd(void) {
+    for (int call = 0; call < GLSTATE_CALL_COUNT; call++) {
+        totals.issued[call] += currentFrame.issued[call];
+        totals.filtered[call] += currentFrame.filtered[call];
+    }
+    lastFrame = currentFrame;
+    memset(&currentFrame, 0, sizeof(currentFrame));
+    frameCount++;
+}
+
+const GlStateCounts* glStateCurrentFrame(void) {
+    return &currentFrame;
+}
+
+const GlStateCounts* glStateLastFrame(void) {
+    return &lastFrame;
+}
+
+void glStateReport(void) {
+    printf("GL state calls over %u frames (per frame issued / filtered):\n", frameCount);
+    printf("%-20s %10s %10s %8s %8s\n", "call", "issued", "filtered", "issued", "filtered");
+    for (int call = 0; call < GLSTATE_CALL_COUNT; call++) {
+        double frames = frameCount > 0 ? frameCount : 1;
+        printf("%-20s %10u %10u %8.1f %8.1f\n", callNames[call],
+               totals.issued[call], totals.filtered[call],
+               totals.issued[call] / frames, totals.filtered[call] / frames);
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef GLSTATE_H
+#define GLSTATE_H
+
+#include <SDL2/SDL.h>
+#include <GL/glew.h>
+
+// Thin layer over the GL state calls the game makes every frame. It
+// shadows the bound 2D texture, array/element buffers, program and mat4
+// uniforms, drops calls that wouldn't change anything, and counts issued
+// versus filtered calls per frame. Every bind, program and matrix uniform
+// call has to go through here, or the shadow goes stale.
+
+typedef enum {
+    GLSTATE_TEXTURE,
+    GLSTATE_BUFFER,
+    GLSTATE_PROGRAM,
+    GLSTATE_UNIFORM,
+    GLSTATE_CALL_COUNT
+} GlStateCall;
+
+typedef struct {
+    Uint32 issued[GLSTATE_CALL_COUNT];
+    Uint32 filtered[GLSTATE_CALL_COUNT];
+} GlStateCounts;
+
+void glStateBindTexture(GLenum target, GLuint texture);
+void glStateBindBuffer(GLenum target, GLuint buffer);
+void glStateUseProgram(GLuint program);
+void glStateUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value);
+void glStateDeleteTextures(GLsizei n, const GLuint* textures);
+void glStateDeleteBuffers(GLsizei n, const GLuint* buffers);
+
+// Forget everything shadowed, e.g. after GL was called directly
+void glStateInvalidate(void);
+
+// Call once per swap. The counts are the frame so far, the last finished
+// frame, and everything since startup.
+void glStateFrameEnd(void);
+const GlStateCounts* glStateCurrentFrame(void);
+const GlStateCounts* glStateLastFrame(void);
+void glStateReport(void);
+
+#endif // GLSTATE_H
@@ -1,5 +1,8 @@
 #include "init.h"
 #include "utils.h"  // Include utils.h for createShaderProgram
+#include "glstate.h"
+#include "startup.h"
+#include "texupload.h"
 #include <stdio.h>
 
 void initPaddle(Paddle* paddle, GLuint shaderProgram) {
@@ -23,7 +26,7 @@ void initPaddle(Paddle* paddle, GLuint shaderProgram) {
 
     // Generate and bind the VBO
     glGenBuffers(1, &paddle->VBO);
-    glBindBuffer(GL_ARRAY_BUFFER, paddle->VBO);
+    glStateBindBuffer(GL_ARRAY_BUFFER, paddle->VBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 
     // Optional: Load paddle texture if you want
@@ -53,7 +56,7 @@ void initBall(Ball* ball, GLuint shaderProgram) {
 
     // Generate and bind the VBO
     glGenBuffers(1, &ball->VBO);
-    glBindBuffer(GL_ARRAY_BUFFER, ball->VBO);
+    glStateBindBuffer(GL_ARRAY_BUFFER, ball->VBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 
     // Hard-coded texture file path for the ball
@@ -62,73 +65,31 @@ void initBall(Ball* ball, GLuint shaderProgram) {
 
 }
 
-void initBricks(Brick* bricks, int cols, int rows, float brickWidth, float brickHeight) {
-
-    GLuint redTexture[] = {
-        loadTexture("brick-red.png"),
-        loadTexture("brick-red-cracked.png"),
-        loadTexture("brick-red-broken.png")
-    };
-    GLuint blueTexture[] = {
-        loadTexture("brick-blue.png"),
-        loadTexture("brick-blue-cracked.png"),
-        loadTexture("brick-blue-broken.png")
-    };
-
-    GLuint yellowTexture[] = {
-        loadTexture("brick-yellow.png"),
-        loadTexture("brick-yellow-cracked.png"),
-        loadTexture("brick-yellow-broken.png")
-    };
-
-   //  const float paddingX = 10.0f;  // Horizontal padding
-    const float paddingY = 5.0f;   // Vertical padding
-
-    // Calculate the total width and height of a single brick including padding
-    // const float totalBrickWidth = brickWidth*3 + paddingX;
-    const float totalBrickHeight = brickHeight + paddingY;
-
-    // Calculate the starting X and Y positions to center the grid
-    float startX = 5.0f;  // Center horizontally
-    float startY = 460.0f;  // Start near the top of the window
-
-    int brickIndex = 0;
-    for (int row = 0; row < rows; row++) {
-        //
-        for (int col = 0; col < cols; col++) {
-            int index = row * cols + col;
-            bricks[index].x = startX + brickWidth/2;  // X position with padding
-            bricks[index].y = startY;  // Y position with padding (top-down)
-            bricks[index].health = 3;
-            bricks[index].width = brickWidth;
-            bricks[index].height = brickHeight;
-            bricks[index].isActive = 1;
-            startX += 79.0f;
-
-            // Assign texture based on row (alternating every two rows)
-            if (row < 2) {
-                bricks[brickIndex].textureID = redTexture[0];
-                bricks[brickIndex].crackedTexture = redTexture[1];
-                bricks[brickIndex].moreCrackedTexture = redTexture[2];
-            } else if (row < 4) {
-                bricks[brickIndex].textureID = blueTexture[0];
-                bricks[brickIndex].crackedTexture = blueTexture[1];
-                bricks[brickIndex].moreCrackedTexture = blueTexture[2];
-            } else {
-                bricks[brickIndex].textureID = yellowTexture[0];
-                bricks[brickIndex].crackedTexture = yellowTexture[1];
-                bricks[brickIndex].moreCrackedTexture = yellowTexture[2];
-            }
-
-            brickIndex++;
-        }
-
-        startY -= totalBrickHeight;
-        startX = 5.0f;
+// Every level has the same three colours of brick art for now; a level
+// with art of its own only needs another entry here
+static const char* brickArtFiles[][3][3] = {
+    {
+        {"brick-red.png", "brick-red-cracked.png", "brick-red-broken.png"},
+        {"brick-blue.png", "brick-blue-cracked.png", "brick-blue-broken.png"},
+        {"brick-yellow.png", "brick-yellow-cracked.png", "brick-yellow-broken.png"}
+    }
+};
+
+void queueBrickArt(int level, BrickArt art[3]) {
+    int set = level % (int)(sizeof(brickArtFiles) / sizeof(brickArtFiles[0]));
+    for (int colour = 0; colour < 3; colour++) {
+        art[colour].full = textureUploadQueue(brickArtFiles[set][colour][0]);
+        art[colour].cracked = textureUploadQueue(brickArtFiles[set][colour][1]);
+        art[colour].broken = textureUploadQueue(brickArtFiles[set][colour][2]);
     }
 }
 
-
+void deleteBrickArt(BrickArt art[3]) {
+    for (int colour = 0; colour < 3; colour++) {
+        GLuint textures[3] = {art[colour].full, art[colour].cracked, art[colour].broken};
+        glStateDeleteTextures(3, textures);
+    }
+}
 
 int initializeSDLAndOpenGL(SDL_Window** window, SDL_GLContext* glContext, GLuint* shaderProgram) {
     // Initialize SDL
@@ -136,6 +97,7 @@ int initializeSDLAndOpenGL(SDL_Window** window, SDL_GLContext* glContext, GLuint
         printf("SDL could not initialize! SDL_Error: %s\n", SDL_GetError());
         return 1;
     }
+    startupBenchMark("SDL_Init");
 
     // Set OpenGL ES 2.0
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 2);
@@ -155,6 +117,8 @@ int initializeSDLAndOpenGL(SDL_Window** window, SDL_GLContext* glContext, GLuint
         return 1;
     }
 
+    startupBenchMark("SDL_CreateWindow");
+
     // Create an OpenGL context
     *glContext = SDL_GL_CreateContext(*window);
     if (*glContext == NULL) {
@@ -164,9 +128,19 @@ int initializeSDLAndOpenGL(SDL_Window** window, SDL_GLContext* glContext, GLuint
         return 1;
     }
 
+    startupBenchMark("SDL_GL_CreateContext");
+
     // Initialize GLEW
     glewExperimental = GL_TRUE; // Ensure GLEW uses modern techniques
-    if (glewInit() != GLEW_OK) {
+    GLenum glewStatus = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+    // A GLX build of GLEW has loaded every GL entry point by the time it
+    // finds no X display, which is all a headless EGL context needs
+    if (glewStatus == GLEW_ERROR_NO_GLX_DISPLAY) {
+        glewStatus = GLEW_OK;
+    }
+#endif
+    if (glewStatus != GLEW_OK) {
         printf("Error initializing GLEW!\n");
         SDL_GL_DeleteContext(*glContext);
         SDL_DestroyWindow(*window);
@@ -174,12 +148,15 @@ int initializeSDLAndOpenGL(SDL_Window** window, SDL_GLContext* glContext, GLuint
         return 1;
     }
 
+    startupBenchMark("glewInit");
+
     // Set the viewport
     glViewport(0, 0, 800, 480);
 
     // Create and use the shader program
     *shaderProgram = createShaderProgram();
-    glUseProgram(*shaderProgram);
+    glStateUseProgram(*shaderProgram);
+    startupBenchMark("createShaderProgram");
 
     // Create an orthographic projection matrix for 800x480 window
     float orthoMatrix[16];
@@ -187,7 +164,7 @@ int initializeSDLAndOpenGL(SDL_Window** window, SDL_GLContext* glContext, GLuint
 
     // Set the projection matrix uniform in the shader
     GLint projectionUniform = glGetUniformLocation(*shaderProgram, "projection");
-    glUniformMatrix4fv(projectionUniform, 1, GL_FALSE, orthoMatrix);
+    glStateUniformMatrix4fv(projectionUniform, 1, GL_FALSE, orthoMatrix);
 
     // Clear the screen
     glClearColor(0.2f, 0.2f, 0.2f, 1.0f); // Set a background color
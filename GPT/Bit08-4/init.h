@@ -23,19 +23,19 @@ typedef struct {
     float speed;        // Paddle movement speed
 } Paddle;
 
-typedef struct {
-    float x, y;        // Position of the brick
-    float width, height;  // Size of the brick
-    int isActive;      // Whether the brick is still active (not hit)
-    int health;           // Brick health (3 = full, 2 = cracked, 1 = more cracked)
-    GLuint textureID;  // Texture ID for the brick
-    GLuint crackedTexture; // Texture for first hit
-    GLuint moreCrackedTexture; // Texture for second hit
-} Brick;
-
 void initPaddle(Paddle* paddle, GLuint shaderProgram);
 int initializeSDLAndOpenGL(SDL_Window** window, SDL_GLContext* glContext, GLuint* shaderProgram);
 void initBall(Ball* ball, GLuint shaderProgram);
-void initBricks(Brick* bricks, int cols, int rows, float brickWidth, float brickHeight);
+// The three textures of one brick colour
+typedef struct {
+    GLuint full;
+    GLuint cracked;
+    GLuint broken;
+} BrickArt;
+
+// Queues a level's red, blue and yellow brick art with the budgeted
+// uploader (texupload.h); the names are valid straight away
+void queueBrickArt(int level, BrickArt art[3]);
+void deleteBrickArt(BrickArt art[3]);
 
 #endif // INIT_H
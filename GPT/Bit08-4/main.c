@@ -2,9 +2,42 @@
 #include <SDL2/SDL_image.h>
 #include <GL/glew.h>
 #include <stdio.h>
-#include <stdlib.h>  // For rand()
+#include <stdlib.h>
 #include <time.h>    // For seeding random number generator
+#include <string.h>
 #include "init.h"  // Include init.h for initialization
+#include "profiler.h"
+#include "trace.h"
+#include "overlay.h"
+#include "glstate.h"
+#include "startup.h"
+#include "capture.h"
+#include "record.h"
+#include "renderbench.h"
+#include "dynres.h"
+#include "renderqueue.h"
+#include "texupload.h"
+#include "particles.h"
+#include "particlebench.h"
+#include "powerups.h"
+#include "sim.h"
+#include "handoff.h"
+
+#define SIM_MAX_LAG_STEPS 5   // Steps of lag after which the simulation stops catching up
+
+// Simulation/render handoff, as in claude/07. sim belongs to the
+// simulation thread, which steps it at SIM_HZ and publishes a copy after
+// every step; the main thread reads the newest copy, spawns the
+// particles for the hits queued since the last frame and does all the GL
+// work. Captures and the benchmarks step inline, one step per frame.
+SimState sim;
+SimState snapshotSlots[3];
+TripleBuffer snapshots;
+SpscQueue simHits;             // Simulation -> main thread, packed SimHits
+SDL_atomic_t inputState;       // INPUT_* bits, sampled once a step
+SDL_atomic_t simRunning;
+SDL_Thread* simThread = NULL;
+int threaded = 1;
 
 void createTranslationMatrix(float* matrix, float x, float y) {
     matrix[0] = 1.0f;  matrix[1] = 0.0f;  matrix[2] = 0.0f;  matrix[3] = 0.0f;
@@ -13,92 +46,307 @@ void createTranslationMatrix(float* matrix, float x, float y) {
     matrix[12] = x;    matrix[13] = y;    matrix[14] = 0.0f; matrix[15] = 1.0f;
 }
 
-void drawBrick(Brick brick, GLuint shaderProgram, GLint modelUniform) {
-    if (!brick.isActive) return; // Only draw active bricks
+// Everything after the frame is drawn: render time, capture, overlay, the
+// swap and the per-frame counters. Returns 0 when the loop should stop.
+int presentFrame(SDL_Window* window, Uint64 renderStart,
+                 GLint positionAttrib, GLint texCoordAttrib, GLint modelUniform) {
+    static Uint64 lastPresentCounter = 0;
+    int keepRunning = 1;
 
-    // Create the translation matrix for the brick
-    float modelMatrix[16];
-    createTranslationMatrix(modelMatrix, brick.x, brick.y);
+    profilerRecord(PROF_RENDER, renderStart);
+    captureReadFrame();
+    recordFrame();
 
-    // Pass the model matrix to the shader
-    glUniformMatrix4fv(modelUniform, 1, GL_FALSE, modelMatrix);
+    // After the render time is taken, so the overlay doesn't count itself
+    overlayDraw(positionAttrib, texCoordAttrib, modelUniform);
 
-    // Bind the brick texture
-    glBindTexture(GL_TEXTURE_2D, brick.textureID);
+    // Swap the buffers (double buffering)
+    Uint64 presentStart = profilerNow();
+    {
+        TRACE_ZONE("present");
+        SDL_GL_SwapWindow(window);
+    }
+    profilerRecord(PROF_PRESENT, presentStart);
+
+    // --bench-startup stops at the first frame on screen
+    if (startupBenchEnabled()) {
+        startupBenchMark("first_present");
+        keepRunning = 0;
+    }
+
+    // Frame time is present to present
+    if (lastPresentCounter != 0) {
+        profilerRecord(PROF_FRAME, lastPresentCounter);
+    }
+    lastPresentCounter = profilerNow();
+    // The governors see the work of the frame, not pacing waits
+    dynResFrameEnd(profilerLastMs(PROF_RENDER) + profilerLastMs(PROF_PRESENT));
+    particlesFrameEnd(profilerLastMs(PROF_RENDER) + profilerLastMs(PROF_PRESENT));
+    overlayFrameEnd();
+    glStateFrameEnd();
+    return keepRunning;
+}
+
+// The --bench-render background: this build has no background art, so
+// it's a generated gradient the size of the bench area, sampled one texel
+// per pixel like the other builds' background images. It's made before
+// the brick art so its name, and with it its place in the world layer's
+// sort, comes ahead of the bricks'.
+GLuint createBenchBackground(void) {
+    GLubyte* pixels = malloc(RENDER_BENCH_AREA_WIDTH * RENDER_BENCH_AREA_HEIGHT * 4);
+    if (pixels == NULL) return 0;
+    for (int y = 0; y < RENDER_BENCH_AREA_HEIGHT; y++) {
+        for (int x = 0; x < RENDER_BENCH_AREA_WIDTH; x++) {
+            GLubyte* texel = &pixels[(y * RENDER_BENCH_AREA_WIDTH + x) * 4];
+            texel[0] = (GLubyte)(x * 40 / RENDER_BENCH_AREA_WIDTH);
+            texel[1] = (GLubyte)(y * 40 / RENDER_BENCH_AREA_HEIGHT);
+            texel[2] = 80;
+            texel[3] = 255;
+        }
+    }
 
-    // Draw the brick
-    glDrawArrays(GL_TRIANGLES, 0, 6);
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glStateBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, RENDER_BENCH_AREA_WIDTH, RENDER_BENCH_AREA_HEIGHT, 0,
+                 GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    free(pixels);
+    return texture;
 }
 
-// Function to check collision between ball and brick
-int checkBrickCollision(Ball ball, Brick brick) {
-    // If the brick is not active, skip collision check
-    if (!brick.isActive) return 0;
+// One --bench-render scene, queued the way the game queues its sprites:
+// a command per sprite, scaled from the brick and ball quads. The
+// background is the brick quad stretched over the bench area, first in
+// the world layer; the HUD line is drawn after the queue runs.
+void queueBenchScene(GLuint brickVBO, GLuint backgroundTexture, const GLuint brickTextures[3],
+                     const Ball* ball, int shader) {
+    const RenderBenchScene* scene = renderBenchScene();
+
+    RenderSprite background = {brickVBO, backgroundTexture, RENDER_BENCH_AREA_WIDTH / 2.0f,
+                               480 - RENDER_BENCH_AREA_HEIGHT / 2.0f,
+                               RENDER_BENCH_AREA_WIDTH / (float)BRICK_WIDTH,
+                               RENDER_BENCH_AREA_HEIGHT / (float)BRICK_HEIGHT};
+    renderQueuePush(RENDER_LAYER_WORLD, shader, 0, &background);
+
+    for (int i = 0; i < scene->bricks; i++) {
+        // Bench rects are top-left with y down, the projection has y up
+        BenchRect brick = renderBenchBrick(i);
+        RenderSprite sprite = {brickVBO, brickTextures[i % 3], brick.x + brick.w / 2.0f,
+                               480 - (brick.y + brick.h / 2.0f), brick.w / (float)BRICK_WIDTH, brick.h / (float)BRICK_HEIGHT};
+        renderQueuePush(RENDER_LAYER_WORLD, shader, 0, &sprite);
+    }
 
-    // Simple AABB collision detection
-    return ball.x < brick.x + brick.width &&
-           ball.x + ball.radius > brick.x &&
-           ball.y < brick.y + brick.height &&
-           ball.y + ball.radius > brick.y;
+    for (int i = 0; i < scene->balls; i++) {
+        BenchRect benchBall = renderBenchBall(i, scene->frame);
+        float scale = benchBall.w / (2.0f * ball->radius);
+        RenderSprite sprite = {ball->VBO, ball->textureID, benchBall.x + benchBall.w / 2.0f,
+                               480 - (benchBall.y + benchBall.h / 2.0f), scale, scale};
+        renderQueuePush(RENDER_LAYER_ACTORS, shader, 0, &sprite);
+    }
 }
 
-// Function to handle ball and brick collision
-void handleBallBrickCollision(Ball* ball, Brick* brick) {
-    if (checkBrickCollision(*ball, *brick)) {
-        // Reverse the ball's vertical velocity
-        ball->vy = -ball->vy;
-        brick->health--;
+#define SPARKS_PER_HIT 48
+#define DEBRIS_PER_BREAK 320
 
-        // If the brick has full health (health == 3), there's a 25% chance of double break
-        if (brick->health == 2) {
-            int randomChance = rand() % 100;  // Generate a number between 0 and 99
+// Red, blue and yellow, in brick art order
+static const GLubyte brickColours[3][3] = {{210, 60, 50}, {60, 100, 220}, {240, 200, 50}};
+static const GLubyte sparkColour[3] = {255, 240, 170};
 
-            if (randomChance < 25) {
-                // 75% chance: Set brick's health to 0, break it instantly
-                brick->health--;
-            }
-        } else if (brick->health == 1) {
-            int randomChance = rand() % 100;  // Generate a number between 0 and 99
+// Sparks where the hit landed, and debris when the brick broke
+void spawnBrickParticles(const SimHit* hit, const Brick* brick, int colour) {
+    particlesBurst(PARTICLE_SPARK, (float)hit->x, (float)hit->y, 0.0f, 0.0f, SPARKS_PER_HIT, sparkColour);
+    if (hit->broken) {
+        particlesBurst(PARTICLE_DEBRIS, fxToFloat(brick->x), fxToFloat(brick->y), BRICK_WIDTH, BRICK_HEIGHT,
+                       DEBRIS_PER_BREAK, brickColours[colour]);
+    }
+}
 
-            if (randomChance < 75) {
-                // 75% chance: Set brick's health to 0, break it instantly
-                brick->health--;
-            }
-        }
+// A hit in one queue item: x in bits 0-9, y in 10-19, the brick in 20-27
+// and broken in bit 28
+Uint32 packHit(const SimHit* hit) {
+    int x = hit->x < 0 ? 0 : hit->x > 1023 ? 1023 : hit->x;
+    int y = hit->y < 0 ? 0 : hit->y > 1023 ? 1023 : hit->y;
+    return (Uint32)x | (Uint32)y << 10 | (Uint32)hit->brick << 20 | (Uint32)(hit->broken != 0) << 28;
+}
 
-        // Update brick's state based on health
-        if (brick->health <= 0) {
-            brick->isActive = 0;  // Deactivate the brick if health is 0
-        }
+SimHit unpackHit(Uint32 item) {
+    SimHit hit;
+    hit.x = (int)(item & 1023);
+    hit.y = (int)(item >> 10 & 1023);
+    hit.brick = (int)(item >> 20 & 255);
+    hit.broken = (int)(item >> 28 & 1);
+    return hit;
+}
+
+void publishSnapshot(void) {
+    SimState* snap = tripleBufferWriteSlot(&snapshots);
+    *snap = sim;
+    tripleBufferPublish(&snapshots);
+}
+
+// One fixed step. Runs on the simulation thread, or inline in the main
+// loop when capturing, benchmarking or with --single-thread. A full hit
+// queue drops hits, which only costs their particles.
+void simStep(void) {
+    static SimEvents events;
+    // simAdvance's two halves, called apart so movement and collision are
+    // timed as phases of their own
+    Uint64 phaseStart = profilerNow();
+    simMove(&sim, (Uint32)SDL_AtomicGet(&inputState), &events);
+    profilerRecord(PROF_UPDATE, phaseStart);
+
+    phaseStart = profilerNow();
+    {
+        TRACE_ZONE("collision");
+        simCollide(&sim, &events);
+    }
+    profilerRecord(PROF_COLLISION, phaseStart);
+
+    for (int i = 0; i < events.hitCount; i++) {
+        spscPush(&simHits, packHit(&events.hits[i]));
     }
+    if (events.levelCleared) {
+        printf("Level %d clear\n", sim.level + 1);
+    }
+    publishSnapshot();
 }
 
-int checkCollision (Ball ball, Paddle paddle) {
-    return ball.x < paddle.x + paddle.width &&
-            ball.x + ball.radius > paddle.x &&
-            ball.y < paddle.y + paddle.height &&
-            ball.y + ball.radius > paddle.y;
+int simThreadMain(void* data) {
+    (void)data;
+    traceThreadName("simulation");
+    Uint64 freq = SDL_GetPerformanceFrequency();
+    Uint64 step = freq / SIM_HZ;
+    Uint64 next = SDL_GetPerformanceCounter();
+
+    while (SDL_AtomicGet(&simRunning)) {
+        simStep();
+
+        // Sleep to the next tick on an absolute schedule, so a late wakeup
+        // shortens the following sleep instead of slowing the game down
+        next += step;
+        Uint64 now = SDL_GetPerformanceCounter();
+        if (now < next) {
+            SDL_Delay((Uint32)((next - now) * 1000 / freq));
+        } else if (now - next > step * SIM_MAX_LAG_STEPS) {
+            next = now;
+        }
+    }
+
+    return 0;
 }
 
 int main(int argc, char* argv[]) {
+    startupBenchBegin();
     SDL_Window* window = NULL;
     SDL_GLContext glContext;
     GLuint shaderProgram;
-
-    srand(time(NULL));  // Seed random number generator
+    Uint32 seed = (Uint32)time(NULL);  // Seed random number generator
+    int powerupStress = 0;
+
+    // --profile [file.csv] prints frame phase percentiles on exit,
+    // --trace out.json writes the trace zones (built with TRACE=1),
+    // --overlay starts with the performance overlay (F1) shown,
+    // --bench-startup prints startup timings and exits after one frame,
+    // --headless renders without a display or GPU,
+    // --capture script.txt dir replays a script and saves golden frames,
+    // --record out.y4m records gameplay video,
+    // --bench-render [frames] runs the synthetic render benchmark,
+    // --particles max=N,... sets the particle cap and its governor,
+    // --bench-particles [frames] runs the particle benchmark,
+    // --powerup-stress N keeps N capsules and laser bolts in flight,
+    // --single-thread steps the simulation in the main loop
+    int showOverlay = 0;
+    int profileAtExit = 0;
+    const char* profileCsv = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--overlay") == 0) {
+            showOverlay = 1;
+        } else if (strcmp(argv[i], "--bench-startup") == 0) {
+            startupBenchEnable();
+        } else if (strcmp(argv[i], "--capture") == 0 && i + 2 < argc) {
+            if (!captureLoad(argv[i + 1], argv[i + 2])) {
+                return 1;
+            }
+            seed = captureSeed();
+            i += 2;
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            if (!recordStart(argv[++i], 800, 480)) {
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--bench-render") == 0) {
+            int frames = RENDER_BENCH_DEFAULT_FRAMES;
+            if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0) {
+                frames = atoi(argv[++i]);
+            }
+            renderBenchInit("gles2", frames);
+        } else if (strcmp(argv[i], "--particles") == 0 && i + 1 < argc) {
+            if (!particlesConfigure(argv[++i])) {
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--bench-particles") == 0) {
+            int frames = PARTICLE_BENCH_DEFAULT_FRAMES;
+            if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0) {
+                frames = atoi(argv[++i]);
+            }
+            particleBenchInit(frames);
+        } else if (strcmp(argv[i], "--powerup-stress") == 0 && i + 1 < argc) {
+            powerupStress = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--single-thread") == 0) {
+            threaded = 0;
+        } else if (strcmp(argv[i], "--dynres") == 0) {
+            const char* spec = NULL;
+            if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0) {
+                spec = argv[++i];
+            }
+            if (!dynResConfigure(spec)) {
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--upload-budget") == 0 && i + 1 < argc) {
+            // Kilobytes of texture data uploaded per frame
+            textureUploadSetBudget((size_t)atoi(argv[++i]) * 1024);
+        } else if (strcmp(argv[i], "--headless") == 0) {
+            // SDL's offscreen video driver makes a surfaceless EGL context
+            // (llvmpipe without a GPU) and swaps to a pbuffer. It has to be
+            // picked before SDL_Init
+            SDL_setenv("SDL_VIDEODRIVER", "offscreen", 1);
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            traceInit(argv[++i]);
+        } else if (strcmp(argv[i], "--profile") == 0) {
+            profileAtExit = 1;
+            if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0) {
+                profileCsv = argv[++i];
+            }
+        }
+    }
+    profilerInit(profileAtExit, profileCsv);
 
     // Initialize SDL and OpenGL
     if (initializeSDLAndOpenGL(&window, &glContext, &shaderProgram) != 0) {
         return 1;  // Exit if initialization failed
     }
 
+    overlayInit();
+    if (showOverlay) {
+        overlayToggle();
+    }
+    startupBenchMark("overlay");
+
+    // Without a framebuffer the game just stays at native resolution
+    dynResInit(800, 480);
+
+    // Without the point program the game just runs without particles
+    particlesInit(shaderProgram, 800, 480);
+    powerupsInit(shaderProgram);
+
     // Initialize ball (vertices, VBO, and texture)
     // Initialize ball (vertices, VBO, and texture)
     Ball ball;
     initBall(&ball, shaderProgram);
 
     // Bind ball VBO and set up vertex attributes
-    glBindBuffer(GL_ARRAY_BUFFER, ball.VBO);
+    glStateBindBuffer(GL_ARRAY_BUFFER, ball.VBO);
 
     // Set up position attribute for ball
     GLint positionAttrib = glGetAttribLocation(shaderProgram, "position");
@@ -115,7 +363,7 @@ int main(int argc, char* argv[]) {
     initPaddle(&paddle, shaderProgram);
 
     // Bind paddle VBO and set up vertex attributes
-    glBindBuffer(GL_ARRAY_BUFFER, paddle.VBO);
+    glStateBindBuffer(GL_ARRAY_BUFFER, paddle.VBO);
 
     // Set up position attribute for paddle
     glEnableVertexAttribArray(positionAttrib);  // You can reuse the positionAttrib location
@@ -126,14 +374,8 @@ int main(int argc, char* argv[]) {
     glVertexAttribPointer(texCoordAttrib, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
 
 
-    const int rows = 6;
-    const int cols = 10; // Number of bricks per row
-    const float brickWidth = 79.0f;  // Assuming window width of 800
-    const float brickHeight = 34.0f;
-    Brick bricks[rows * cols];
-
-    const float halfBrickWidth = brickWidth / 2.0f;
-    const float halfBrickHeight = brickHeight / 2.0f;
+    const float halfBrickWidth = BRICK_WIDTH / 2.0f;
+    const float halfBrickHeight = BRICK_HEIGHT / 2.0f;
 
     float brickVertices[] = {
         // First triangle
@@ -150,12 +392,12 @@ int main(int argc, char* argv[]) {
 
     GLuint brickVBO;
     glGenBuffers(1, &brickVBO);
-    glBindBuffer(GL_ARRAY_BUFFER, brickVBO);
+    glStateBindBuffer(GL_ARRAY_BUFFER, brickVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(brickVertices), brickVertices, GL_STATIC_DRAW);
 
 
     // Bind paddle VBO and set up vertex attributes
-    glBindBuffer(GL_ARRAY_BUFFER, brickVBO);
+    glStateBindBuffer(GL_ARRAY_BUFFER, brickVBO);
 
     // Set up position attribute for paddle
     glEnableVertexAttribArray(positionAttrib);  // You can reuse the positionAttrib location
@@ -164,153 +406,232 @@ int main(int argc, char* argv[]) {
     // Set up texture coordinate attribute for paddle
     glEnableVertexAttribArray(texCoordAttrib);  // You can reuse the texCoordAttrib location
     glVertexAttribPointer(texCoordAttrib, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
-   initBricks(bricks, cols, rows, brickWidth, brickHeight );
+    // The first level's art goes up before the first frame. Each level
+    // queues the next one's as it starts, so the decode and the budgeted
+    // upload have the whole level to finish in.
+    int artLevel = 0;
+    BrickArt brickArt[3], nextBrickArt[3];
+    GLuint benchBackground = renderBenchActive() ? createBenchBackground() : 0;
+    queueBrickArt(artLevel, brickArt);
+    textureUploadFlush();
+    queueBrickArt(artLevel + 1, nextBrickArt);
+
+    simInit(&sim, seed);
+    sim.stressCount = powerupStress;
+    tripleBufferInit(&snapshots, &snapshotSlots[0], &snapshotSlots[1], &snapshotSlots[2]);
+    spscInit(&simHits);
+    publishSnapshot();
 
     // Main loop
     int running = 1;
     SDL_Event event;
-    Uint32 previousTime = 0;
+    Uint32 previousTime = SDL_GetTicks();
     Uint32 currentTime = 0;
-    float deltaTime = 0.0f;
-    float modelMatrix[16];
+    float frameSeconds = 0.0f;
     GLint modelUniform = glGetUniformLocation(shaderProgram, "model");
+    int gameShader = renderQueueAddShader(shaderProgram, positionAttrib, texCoordAttrib, modelUniform);
+
+    // Full-health red, blue and yellow, two rows apart; and no vsync for
+    // the benchmark, which measures how fast frames can go
+    const GLuint benchBrickTextures[3] = {brickArt[0].full, brickArt[1].full, brickArt[2].full};
+    if (renderBenchActive() || particleBenchActive()) {
+        SDL_GL_SetSwapInterval(0);
+    }
+
+    // Captures replay one step per frame so they come out the same every
+    // time, and the benchmarks leave the game alone
+    if (captureActive() || renderBenchActive() || particleBenchActive()) {
+        threaded = 0;
+    }
+    if (threaded) {
+        SDL_AtomicSet(&simRunning, 1);
+        simThread = SDL_CreateThread(simThreadMain, "simulation", NULL);
+        if (simThread == NULL) {
+            printf("SDL_CreateThread failed: %s, running single-threaded\n", SDL_GetError());
+            threaded = 0;
+        }
+    }
 
     // Main loop
     while (running) {
-        // Calculate delta time
+        profilerPoll();
+        if (!captureBeginFrame()) {
+            break;
+        }
+
+        // Frame time for the particles; captures step a fixed frame so
+        // they replay the same way every time
         currentTime = SDL_GetTicks();
-        deltaTime = (currentTime - previousTime) / 10.0f;
+        frameSeconds = (currentTime - previousTime) / 1000.0f;
         previousTime = currentTime;
+        if (captureActive()) {
+            frameSeconds = 1.0f / SIM_HZ;
+        }
 
         // Event handling
+        Uint64 phaseStart = profilerNow();
         while (SDL_PollEvent(&event)) {
             if (event.type == SDL_QUIT) {
                 running = 0;
+            } else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_F1 && !event.key.repeat) {
+                overlayToggle();
             }
         }
 
-        glClear(GL_COLOR_BUFFER_BIT);
-
-        // Update ball position based on velocity
-        ball.x += ball.vx * deltaTime;
-        ball.y += ball.vy * deltaTime;
-
-        // Collision with window edges (bounce back)
-        if (ball.x + ball.radius > 800 || ball.x - ball.radius < 0) {
-            ball.vx = -ball.vx;  // Reverse horizontal direction
-        }
-        if (ball.y + ball.radius > 480 || ball.y - ball.radius < 0) {
-            ball.vy = -ball.vy;  // Reverse vertical direction
-        }
-
-        // Move the paddle based on user input
-        const Uint8* state = SDL_GetKeyboardState(NULL);
+        // Held keys are sampled by the simulation once per step
+        const Uint8* state = captureActive() ? captureKeyboardState() : SDL_GetKeyboardState(NULL);
+        int input = 0;
         if (state[SDL_SCANCODE_LEFT]) {
-            paddle.x -= paddle.speed * deltaTime;  // Move left
+            input |= INPUT_LEFT;
         }
         if (state[SDL_SCANCODE_RIGHT]) {
-            paddle.x += paddle.speed * deltaTime;  // Move right
+            input |= INPUT_RIGHT;
         }
-
-        // Keep the paddle within the window bounds
-        if (paddle.x - paddle.width / 2 < 0) {
-            paddle.x = paddle.width / 2;
+        SDL_AtomicSet(&inputState, input);
+        profilerRecord(PROF_INPUT, phaseStart);
+
+        if (renderBenchActive()) {
+            phaseStart = profilerNow();
+            dynResBeginScene();
+            glClear(GL_COLOR_BUFFER_BIT);
+            renderQueueBegin();
+            queueBenchScene(brickVBO, benchBackground, benchBrickTextures, &ball, gameShader);
+            renderQueueExecute();
+            dynResEndScene(positionAttrib, texCoordAttrib, modelUniform);
+
+            // The score line the other builds draw in their HUD font
+            overlayDrawNumber(renderBenchScene()->frame * 10, 10.0f, 470.0f,
+                              positionAttrib, texCoordAttrib, modelUniform);
+            if (!presentFrame(window, phaseStart, positionAttrib, texCoordAttrib, modelUniform) ||
+                !renderBenchFrameEnd(profilerLastMs(PROF_RENDER), profilerLastMs(PROF_FRAME),
+                                     overlayLastDrawCalls())) {
+                running = 0;
+            }
+            continue;
         }
-        if (paddle.x + paddle.width / 2 > 800) {
-            paddle.x = 800 - paddle.width / 2;
+
+        // The particle benchmark steps a fixed 1/60 s so every run does the same work
+        if (particleBenchActive()) {
+            phaseStart = profilerNow();
+            particleBenchEmit();
+            particlesUpdate(1.0f / 60.0f);
+            profilerRecord(PROF_UPDATE, phaseStart);
+
+            phaseStart = profilerNow();
+            dynResBeginScene();
+            glClear(GL_COLOR_BUFFER_BIT);
+            particlesDraw();
+            dynResEndScene(positionAttrib, texCoordAttrib, modelUniform);
+            if (!presentFrame(window, phaseStart, positionAttrib, texCoordAttrib, modelUniform) ||
+                !particleBenchFrameEnd(profilerLastMs(PROF_UPDATE), profilerLastMs(PROF_RENDER),
+                                       profilerLastMs(PROF_FRAME))) {
+                running = 0;
+            }
+            continue;
         }
 
-        if (checkCollision(ball, paddle)) {
-            ball.vy = ball.vy * -1.05f;
-            if(ball.vy > 2.0f) {
-                ball.vy = 2.0f;
-            } else if(ball.vy < -2.0f) {
-                ball.vy = -2.0f;
+        if (!threaded) {
+            simStep();
+        }
+        const SimState* view = tripleBufferRead(&snapshots);
+
+        // The simulation moves on to the next level's bricks on its own
+        // clock; the art queued a level ahead follows, and if it hasn't
+        // finished uploading by then it's flushed. Otherwise the next
+        // level's art uploads a budget's worth per frame while this one
+        // plays.
+        if (view->level != artLevel) {
+            if (textureUploadPending() != 0) {
+                textureUploadFlush();
             }
+            deleteBrickArt(brickArt);
+            memcpy(brickArt, nextBrickArt, sizeof(brickArt));
+            artLevel = view->level;
+            queueBrickArt(artLevel + 1, nextBrickArt);
+        }
+        textureUploadPump();
+
+        phaseStart = profilerNow();
+        Uint32 item;
+        while (spscPop(&simHits, &item)) {
+            SimHit hit = unpackHit(item);
+            spawnBrickParticles(&hit, &view->bricks[hit.brick], (hit.brick / BRICK_COLS / 2 + view->level) % 3);
         }
+        particlesUpdate(frameSeconds);
 
-        // 1. Render Ball
-        createTranslationMatrix(modelMatrix, ball.x, ball.y);
-        glUniformMatrix4fv(modelUniform, 1, GL_FALSE, modelMatrix);
-
-        // Bind ball VBO and set up vertex attributes for ball
-        glBindBuffer(GL_ARRAY_BUFFER, ball.VBO);
-        glEnableVertexAttribArray(positionAttrib);
-        glVertexAttribPointer(positionAttrib, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (void*)0);
-        glEnableVertexAttribArray(texCoordAttrib);
-        glVertexAttribPointer(texCoordAttrib, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
-
-        // Draw the ball
-        glBindTexture(GL_TEXTURE_2D, ball.textureID);
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-
-        // Disable vertex attributes for the ball
-        glDisableVertexAttribArray(positionAttrib);
-        glDisableVertexAttribArray(texCoordAttrib);
-
-        // 2. Render Paddle
-        createTranslationMatrix(modelMatrix, paddle.x, paddle.y);
-        glUniformMatrix4fv(modelUniform, 1, GL_FALSE, modelMatrix);
-
-        // Bind paddle VBO and set up vertex attributes for paddle
-        glBindBuffer(GL_ARRAY_BUFFER, paddle.VBO);
-        glEnableVertexAttribArray(positionAttrib);
-        glVertexAttribPointer(positionAttrib, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (void*)0);
-        glEnableVertexAttribArray(texCoordAttrib);
-        glVertexAttribPointer(texCoordAttrib, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
-
-        // Draw the paddle
-        glBindTexture(GL_TEXTURE_2D, paddle.textureID);
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-
-        // Disable vertex attributes for the paddle
-        glDisableVertexAttribArray(positionAttrib);
-        glDisableVertexAttribArray(texCoordAttrib);
-
-        // 3. Render Bricks
-        glBindBuffer(GL_ARRAY_BUFFER, brickVBO);
-        glEnableVertexAttribArray(positionAttrib);
-        glVertexAttribPointer(positionAttrib, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (void*)0);
-        glEnableVertexAttribArray(texCoordAttrib);
-        glVertexAttribPointer(texCoordAttrib, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
-
-        for (int i = 0; i < rows * cols; i++) {
-            // Check ball-brick collision and deactivate the brick if hit
-            handleBallBrickCollision(&ball, &bricks[i]);
-
-            if (!bricks[i].isActive) continue;
-
-            // Create and pass model matrix for each brick
-            createTranslationMatrix(modelMatrix, bricks[i].x, bricks[i].y);
-            glUniformMatrix4fv(modelUniform, 1, GL_FALSE, modelMatrix);
-
-            // Bind brick texture and draw
-            if ( bricks[i].health == 3) {
-                glBindTexture(GL_TEXTURE_2D,  bricks[i].textureID);  // Full health texture
-            } else if ( bricks[i].health == 2) {
-                glBindTexture(GL_TEXTURE_2D,  bricks[i].crackedTexture); // First hit texture
-            } else if ( bricks[i].health == 1) {
-                glBindTexture(GL_TEXTURE_2D,  bricks[i].moreCrackedTexture); // Second hit texture
+        dynResBeginScene();
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        // Queue every sprite; the queue picks the draw order within a
+        // layer to keep state changes down
+        renderQueueBegin();
+        for (int i = 0; i < BRICK_COUNT; i++) {
+            const Brick* brick = &view->bricks[i];
+            if (!brick->isActive) continue;
+
+            // Colours alternate every two rows and move down a band every level
+            const BrickArt* art = &brickArt[(i / BRICK_COLS / 2 + view->level) % 3];
+            RenderSprite sprite = {brickVBO, art->full, fxToFloat(brick->x), fxToFloat(brick->y), 1.0f, 1.0f};
+            if (brick->health == 2) {
+                sprite.textureID = art->cracked;  // First hit texture
+            } else if (brick->health == 1) {
+                sprite.textureID = art->broken;  // Second hit texture
             }
-            glDrawArrays(GL_TRIANGLES, 0, 6);
+            renderQueuePush(RENDER_LAYER_WORLD, gameShader, 0, &sprite);
         }
 
-        // Disable vertex attributes for bricks
-        glDisableVertexAttribArray(positionAttrib);
-        glDisableVertexAttribArray(texCoordAttrib);
+        RenderSprite paddleSprite = {paddle.VBO, paddle.textureID, fxToFloat(view->paddleX), PADDLE_Y,
+                                     simPaddleScale(view), 1.0f};
+        renderQueuePush(RENDER_LAYER_ACTORS, gameShader, 0, &paddleSprite);
+        RenderSprite ballSprite = {ball.VBO, ball.textureID, fxToFloat(view->ball.x), fxToFloat(view->ball.y), 1.0f, 1.0f};
+        renderQueuePush(RENDER_LAYER_ACTORS, gameShader, 1, &ballSprite);
+        for (int i = 0; i < view->extraBallCount; i++) {
+            ballSprite.x = fxToFloat(view->extraBalls[i].x);
+            ballSprite.y = fxToFloat(view->extraBalls[i].y);
+            renderQueuePush(RENDER_LAYER_ACTORS, gameShader, 1, &ballSprite);
+        }
 
-        // Swap the buffers (double buffering)
-        SDL_GL_SwapWindow(window);
+        renderQueueExecute();
+        powerupsDraw(view, positionAttrib, texCoordAttrib, modelUniform);
+        particlesDraw();
+        dynResEndScene(positionAttrib, texCoordAttrib, modelUniform);
+
+        if (!presentFrame(window, phaseStart, positionAttrib, texCoordAttrib, modelUniform)) {
+            running = 0;
+        }
+    }
+
+    if (simThread != NULL) {
+        SDL_AtomicSet(&simRunning, 0);
+        SDL_WaitThread(simThread, NULL);
     }
 
+    profilerShutdown();
+    glStateReport();
+    traceShutdown();
+    captureShutdown();
+    recordStop();
+
 
     // Cleanup
-    glDeleteBuffers(1, &ball.VBO);
-    glDeleteTextures(1, &ball.textureID);
+    textureUploadCleanup();
+    deleteBrickArt(nextBrickArt);
+    powerupsCleanup();
+    particlesCleanup();
+    dynResCleanup();
+    overlayCleanup();
+    glStateDeleteBuffers(1, &ball.VBO);
+    glStateDeleteTextures(1, &ball.textureID);
+    if (benchBackground != 0) {
+        glStateDeleteTextures(1, &benchBackground);
+    }
+    deleteBrickArt(brickArt);
     glDeleteProgram(shaderProgram);
     SDL_GL_DeleteContext(glContext);
     SDL_DestroyWindow(window);
     SDL_Quit();
 
+    startupBenchMark("exit");
+    startupBenchReport();
     return 0;
 }
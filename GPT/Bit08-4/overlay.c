@@ -0,0 +1,255 @@
+#include "overlay.h"
+#include "profiler.h"
+#include "glstate.h"
+#include <stdio.h>
+#include <string.h>
+
+#define ATLAS_WIDTH 64
+#define ATLAS_HEIGHT 8
+#define GLYPH_DOT 10         // Glyphs 0-9 are the digits
+#define GLYPH_COUNT 11
+#define SWATCH_X 44          // Colour swatches sit after the glyphs, 2x2 each
+#define SWATCH_Y 6
+
+#define PIXEL_SIZE 2.0f      // Screen pixels per atlas texel
+#define DIGIT_ADVANCE (4 * PIXEL_SIZE)
+#define ROW_HEIGHT 14.0f
+#define GRAPH_HEIGHT 60.0f
+#define GRAPH_BAR_WIDTH 2.0f
+#define GRAPH_PX_PER_MS 2.0f
+#define FRAME_BUDGET_MS (1000.0f / 60.0f)
+#define MAX_QUADS (OVERLAY_HISTORY + 96)
+
+typedef enum {
+    SWATCH_PANEL,
+    SWATCH_GREEN,
+    SWATCH_RED,
+    SWATCH_YELLOW,
+    SWATCH_CYAN,
+    SWATCH_MAGENTA,
+    SWATCH_WHITE,
+    SWATCH_ORANGE,
+    SWATCH_COUNT
+} Swatch;
+
+static const GLubyte swatchColors[SWATCH_COUNT][4] = {
+    {30, 30, 30, 255},
+    {80, 220, 80, 255},
+    {230, 60, 60, 255},
+    {255, 230, 50, 255},
+    {50, 230, 255, 255},
+    {255, 80, 255, 255},
+    {255, 255, 255, 255},
+    {255, 150, 30, 255}
+};
+
+// 3x5 glyphs, one row per entry from the top, leftmost pixel in bit 2
+static const unsigned char glyphRows[GLYPH_COUNT][5] = {
+    {7, 5, 5, 5, 7}, {2, 6, 2, 2, 7}, {7, 1, 7, 4, 7}, {7, 1, 7, 1, 7},
+    {5, 5, 7, 1, 1}, {7, 4, 7, 1, 7}, {7, 4, 7, 5, 7}, {7, 1, 1, 1, 1},
+    {7, 5, 7, 5, 7}, {7, 5, 7, 1, 7}, {0, 0, 0, 0, 2}
+};
+
+static GLuint atlasTexture = 0;
+static GLuint overlayVBO = 0;
+static GLfloat vertices[MAX_QUADS * 6 * 5];
+static int vertexCount = 0;
+static int visible = 0;
+
+static float frameTimes[OVERLAY_HISTORY];
+static int frameHead = 0;
+static int drawCalls = 0;
+static int pendingDrawCalls = 0;   // The game's share of this frame
+static int pendingTextureBinds = 0;
+static int shownDrawCalls = 0;     // Totals of the previous frame
+static int shownTextureBinds = 0;
+
+int overlayInit(void) {
+    GLubyte pixels[ATLAS_HEIGHT][ATLAS_WIDTH][4];
+    memset(pixels, 0, sizeof(pixels));
+
+    // Texel row 0 is v = 0, the bottom of a quad, so glyphs go in upside down
+    for (int glyph = 0; glyph < GLYPH_COUNT; glyph++) {
+        for (int row = 0; row < 5; row++) {
+            for (int col = 0; col < 3; col++) {
+                if (glyphRows[glyph][row] & (4 >> col)) {
+                    memset(pixels[4 - row][glyph * 4 + col], 255, 4);
+                }
+            }
+        }
+    }
+    for (int swatch = 0; swatch < SWATCH_COUNT; swatch++) {
+        for (int y = SWATCH_Y; y < SWATCH_Y + 2; y++) {
+            memcpy(pixels[y][SWATCH_X + swatch * 2], swatchColors[swatch], 4);
+            memcpy(pixels[y][SWATCH_X + swatch * 2 + 1], swatchColors[swatch], 4);
+        }
+    }
+
+    glGenTextures(1, &atlasTexture);
+    glStateBindTexture(GL_TEXTURE_2D, atlasTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, ATLAS_WIDTH, ATLAS_HEIGHT, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+
+    glGenBuffers(1, &overlayVBO);
+    return 0;
+}
+
+void overlayToggle(void) {
+    visible = !visible;
+}
+
+int overlayVisible(void) {
+    return visible;
+}
+
+void overlayCountDraw(void) {
+    drawCalls++;
+}
+
+// Two triangles from the top-left corner (y grows upwards on screen)
+static void emitQuad(float x, float top, float width, float height,
+                     float u0, float v0, float u1, float v1) {
+    if (vertexCount + 6 > MAX_QUADS * 6) return;
+
+    const float corners[6][4] = {
+        {x, top - height, u0, v0}, {x + width, top - height, u1, v0}, {x + width, top, u1, v1},
+        {x, top - height, u0, v0}, {x + width, top, u1, v1}, {x, top, u0, v1}
+    };
+    for (int i = 0; i < 6; i++) {
+        GLfloat* vertex = &vertices[vertexCount++ * 5];
+        vertex[0] = corners[i][0];
+        vertex[1] = corners[i][1];
+        vertex[2] = 0.0f;
+        vertex[3] = corners[i][2];
+        vertex[4] = corners[i][3];
+    }
+}
+
+static void emitRect(float x, float top, float width, float height, Swatch swatch) {
+    // Sample the middle of the swatch so nearest filtering stays inside it
+    float u = (SWATCH_X + swatch * 2 + 1) / (float)ATLAS_WIDTH;
+    float v = (SWATCH_Y + 1) / (float)ATLAS_HEIGHT;
+    emitQuad(x, top, width, height, u, v, u, v);
+}
+
+static void emitNumber(float value, int decimals, float x, float top) {
+    char text[16];
+    snprintf(text, sizeof(text), "%.*f", decimals, value);
+    for (const char* c = text; *c != '\0'; c++) {
+        int glyph = *c == '.' ? GLYPH_DOT : *c - '0';
+        if (glyph < 0 || glyph >= GLYPH_COUNT) continue;
+
+        emitQuad(x, top, 3 * PIXEL_SIZE, 5 * PIXEL_SIZE,
+                 glyph * 4 / (float)ATLAS_WIDTH, 0.0f,
+                 (glyph * 4 + 3) / (float)ATLAS_WIDTH, 5 / (float)ATLAS_HEIGHT);
+        x += DIGIT_ADVANCE;
+    }
+}
+
+// Uploads the quads emitted since vertexCount was reset and draws them in one call
+static void drawQuads(GLint positionAttrib, GLint texCoordAttrib, GLint modelUniform) {
+    static const float identity[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+    glStateUniformMatrix4fv(modelUniform, 1, GL_FALSE, identity);
+    glStateBindBuffer(GL_ARRAY_BUFFER, overlayVBO);
+    glBufferData(GL_ARRAY_BUFFER, vertexCount * 5 * sizeof(GLfloat), vertices, GL_STREAM_DRAW);
+    glEnableVertexAttribArray(positionAttrib);
+    glVertexAttribPointer(positionAttrib, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (void*)0);
+    glEnableVertexAttribArray(texCoordAttrib);
+    glVertexAttribPointer(texCoordAttrib, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
+    glStateBindTexture(GL_TEXTURE_2D, atlasTexture);
+    glDrawArrays(GL_TRIANGLES, 0, vertexCount);
+    glDisableVertexAttribArray(positionAttrib);
+    glDisableVertexAttribArray(texCoordAttrib);
+}
+
+void overlayDraw(GLint positionAttrib, GLint texCoordAttrib, GLint modelUniform) {
+    // Taken before drawing, so the overlay's own calls aren't included
+    pendingDrawCalls = drawCalls;
+    pendingTextureBinds = glStateCurrentFrame()->issued[GLSTATE_TEXTURE];
+    if (!visible) return;
+
+    const float left = 10.0f, top = 470.0f;
+    const float graphWidth = OVERLAY_HISTORY * GRAPH_BAR_WIDTH;
+    vertexCount = 0;
+
+    emitRect(left, top, graphWidth + 12.0f, 5 * ROW_HEIGHT + GRAPH_HEIGHT + 18.0f, SWATCH_PANEL);
+
+    float total = 0.0f;
+    int count = 0;
+    for (int i = 0; i < OVERLAY_HISTORY; i++) {
+        if (frameTimes[i] > 0.0f) {
+            total += frameTimes[i];
+            count++;
+        }
+    }
+    float fps = total > 0.0f ? count * 1000.0f / total : 0.0f;
+    float latest = frameTimes[(frameHead + OVERLAY_HISTORY - 1) % OVERLAY_HISTORY];
+
+    // Rows: green FPS, yellow frame ms, cyan sim ms, magenta render ms,
+    // white draw calls and orange texture binds
+    float x = left + 6.0f, y = top - 6.0f;
+    emitRect(x, y - 1, 8, 8, SWATCH_GREEN);
+    emitNumber(fps, 1, x + 14, y);
+    y -= ROW_HEIGHT;
+    emitRect(x, y - 1, 8, 8, SWATCH_YELLOW);
+    emitNumber(latest, 2, x + 14, y);
+    y -= ROW_HEIGHT;
+    emitRect(x, y - 1, 8, 8, SWATCH_CYAN);
+    emitNumber(profilerLastMs(PROF_UPDATE) + profilerLastMs(PROF_COLLISION), 2, x + 14, y);
+    y -= ROW_HEIGHT;
+    emitRect(x, y - 1, 8, 8, SWATCH_MAGENTA);
+    emitNumber(profilerLastMs(PROF_RENDER), 2, x + 14, y);
+    y -= ROW_HEIGHT;
+    emitRect(x, y - 1, 8, 8, SWATCH_WHITE);
+    emitNumber(shownDrawCalls, 0, x + 14, y);
+    emitRect(x + 120, y - 1, 8, 8, SWATCH_ORANGE);
+    emitNumber(shownTextureBinds, 0, x + 134, y);
+    y -= ROW_HEIGHT + 4;
+
+    // Frame-time graph, oldest on the left, red when over the 60 Hz budget
+    float graphBottom = y - GRAPH_HEIGHT;
+    for (int i = 0; i < OVERLAY_HISTORY; i++) {
+        float ms = frameTimes[(frameHead + i) % OVERLAY_HISTORY];
+        float height = ms * GRAPH_PX_PER_MS;
+        if (height > GRAPH_HEIGHT) height = GRAPH_HEIGHT;
+        if (height <= 0.0f) continue;
+        emitRect(x + i * GRAPH_BAR_WIDTH, graphBottom + height, GRAPH_BAR_WIDTH, height,
+                 ms > FRAME_BUDGET_MS + 1.0f ? SWATCH_RED : SWATCH_GREEN);
+    }
+    emitRect(x, graphBottom + FRAME_BUDGET_MS * GRAPH_PX_PER_MS + 1, graphWidth, 1, SWATCH_WHITE);
+
+    // One upload and one draw for the whole overlay
+    drawQuads(positionAttrib, texCoordAttrib, modelUniform);
+}
+
+// Runs on every swap, shown or not, so the graph is full when toggled on
+void overlayFrameEnd(void) {
+    frameTimes[frameHead] = profilerLastMs(PROF_FRAME);
+    frameHead = (frameHead + 1) % OVERLAY_HISTORY;
+    shownDrawCalls = pendingDrawCalls;
+    shownTextureBinds = pendingTextureBinds;
+    drawCalls = 0;
+}
+
+void overlayDrawNumber(int value, float x, float top,
+                       GLint positionAttrib, GLint texCoordAttrib, GLint modelUniform) {
+    vertexCount = 0;
+    emitNumber((float)value, 0, x, top);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    drawQuads(positionAttrib, texCoordAttrib, modelUniform);
+    glDisable(GL_BLEND);
+    overlayCountDraw();
+}
+
+int overlayLastDrawCalls(void) {
+    return shownDrawCalls;
+}
+
+void overlayCleanup(void) {
+    glStateDeleteBuffers(1, &overlayVBO);
+    glStateDeleteTextures(1, &atlasTexture);
+}
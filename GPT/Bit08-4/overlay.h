@@ -0,0 +1,34 @@
+#ifndef OVERLAY_H
+#define OVERLAY_H
+
+#include <GL/glew.h>
+
+// Performance overlay, toggled with F1: FPS, the last OVERLAY_HISTORY
+// frame times, sim and render time, and the previous frame's draw calls
+// and texture binds. Everything is one textured VBO drawn with the game's
+// shader, using a small generated atlas of 3x5 digits and colour swatches
+// (the game has no font). Each row is keyed by its swatch colour.
+
+#define OVERLAY_HISTORY 120  // Frames shown in the graph
+
+int overlayInit(void);
+void overlayToggle(void);
+int overlayVisible(void);
+
+// Called next to the game's own glDrawArrays calls. Texture binds come
+// from the glstate counters (the ones actually issued).
+void overlayCountDraw(void);
+
+// Draw after the frame's render time has been recorded, right before the
+// swap; overlayFrameEnd goes right after it
+void overlayDraw(GLint positionAttrib, GLint texCoordAttrib, GLint modelUniform);
+void overlayFrameEnd(void);
+// A whole number in the overlay's digit glyphs, blended over the frame in
+// one draw that counts as the game's; top-left corner at (x, top)
+void overlayDrawNumber(int value, float x, float top,
+                       GLint positionAttrib, GLint texCoordAttrib, GLint modelUniform);
+
+int overlayLastDrawCalls(void);  // The game's draws in the frame just swapped
+void overlayCleanup(void);
+
+#endif // OVERLAY_H
@@ -0,0 +1,101 @@
+#include "particlebench.h"
+#include "particles.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static const int particleBenchSizes[] = {5000, 10000, 20000, 30000};
+#define SIZE_COUNT (int)(sizeof(particleBenchSizes) / sizeof(particleBenchSizes[0]))
+
+#define BURST 256
+
+static const GLubyte burstColours[3][3] = {{210, 60, 50}, {60, 100, 220}, {240, 200, 50}};
+
+static int active = 0;
+static int framesPerSize = PARTICLE_BENCH_DEFAULT_FRAMES;
+static int sizeIndex = 0;
+static int frame = 0;
+static int burstCount = 0;
+
+static double updateSamples[PARTICLE_BENCH_MAX_FRAMES];
+static double submitSamples[PARTICLE_BENCH_MAX_FRAMES];
+static double frameSamples[PARTICLE_BENCH_MAX_FRAMES];
+static int sampleCount = 0;
+
+void particleBenchInit(int frames) {
+    active = 1;
+    if (frames > PARTICLE_BENCH_WARMUP_FRAMES && frames <= PARTICLE_BENCH_MAX_FRAMES) {
+        framesPerSize = frames;
+    }
+    sizeIndex = 0;
+    frame = 0;
+    particlesFixCap(particleBenchSizes[0]);
+    printf("%-14s %9s %6s %9s %10s %9s %10s %8s %9s %7s %5s\n", "particle_bench", "particles", "frames",
+           "update_ms", "update_p95", "submit_ms", "submit_p95", "frame_ms", "frame_p95", "fps", "60hz");
+}
+
+int particleBenchActive(void) {
+    return active;
+}
+
+void particleBenchEmit(void) {
+    // Bursts land all over the 800x480 playfield, every kind and colour
+    while (particlesLive() < particlesCap()) {
+        int k = burstCount++;
+        float x = (float)(40 + (k * 97) % 720);
+        float y = (float)(160 + (k * 53) % 300);
+        particlesBurst(k % 4 == 0 ? PARTICLE_SPARK : PARTICLE_DEBRIS, x, y, 79.0f, 34.0f, BURST,
+                       burstColours[k % 3]);
+    }
+}
+
+static int compareDoubles(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static void stats(double* samples, int count, double* mean, double* p95) {
+    double total = 0.0;
+    for (int i = 0; i < count; i++) {
+        total += samples[i];
+    }
+    qsort(samples, count, sizeof(double), compareDoubles);
+    *mean = total / count;
+    *p95 = samples[(count * 95) / 100];
+}
+
+static void reportSize(void) {
+    double updateMean, updateP95, submitMean, submitP95, frameMean, frameP95;
+    stats(updateSamples, sampleCount, &updateMean, &updateP95);
+    stats(submitSamples, sampleCount, &submitMean, &submitP95);
+    stats(frameSamples, sampleCount, &frameMean, &frameP95);
+    printf("%-14s %9d %6d %9.3f %10.3f %9.3f %10.3f %8.3f %9.3f %7.1f %5s\n", "particle_bench",
+           particleBenchSizes[sizeIndex], sampleCount, updateMean, updateP95, submitMean, submitP95,
+           frameMean, frameP95, frameMean > 0.0 ? 1000.0 / frameMean : 0.0,
+           frameP95 <= 1000.0 / 60.0 ? "yes" : "no");
+    fflush(stdout);
+}
+
+int particleBenchFrameEnd(double updateMs, double submitMs, double frameMs) {
+    if (!active) return 1;
+
+    if (frame >= PARTICLE_BENCH_WARMUP_FRAMES) {
+        updateSamples[sampleCount] = updateMs;
+        submitSamples[sampleCount] = submitMs;
+        frameSamples[sampleCount] = frameMs;
+        sampleCount++;
+    }
+
+    frame++;
+    if (frame < framesPerSize) {
+        return 1;
+    }
+
+    reportSize();
+    sampleCount = 0;
+    frame = 0;
+    if (++sizeIndex == SIZE_COUNT) {
+        return 0;
+    }
+    particlesFixCap(particleBenchSizes[sizeIndex]);
+    return 1;
+}
@@ -0,0 +1,24 @@
+#ifndef PARTICLEBENCH_H
+#define PARTICLEBENCH_H
+
+// Particle benchmark for --bench-particles. The pool is kept topped up to
+// each of particleBenchSizes in turn with a mix of debris and sparks over
+// the playfield, with the cap pinned and vsync off. Each size runs for a
+// fixed number of frames. One line per size reports the update time, the
+// CPU submit time (scene start to swap), the frame time, and whether the
+// 95th percentile frame fits 60 Hz.
+
+#define PARTICLE_BENCH_WARMUP_FRAMES 30   // Dropped from each size's stats
+#define PARTICLE_BENCH_MAX_FRAMES 2000
+#define PARTICLE_BENCH_DEFAULT_FRAMES 300
+
+void particleBenchInit(int framesPerSize);
+int particleBenchActive(void);
+
+// Spawns whatever the last update let die, up to the current size
+void particleBenchEmit(void);
+
+// Records the frame just swapped; returns 0 once every size is done
+int particleBenchFrameEnd(double updateMs, double submitMs, double frameMs);
+
+#endif // PARTICLEBENCH_H
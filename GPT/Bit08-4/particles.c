@@ -0,0 +1,393 @@
+#include "particles.h"
+#include "dynres.h"
+#include "glstate.h"
+#include "overlay.h"
+#include "trace.h"
+#include "utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define PARTICLES_USE_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define PARTICLES_USE_SSE2 1
+#endif
+
+#define OVER_BUDGET 1.05        // Mean over target by this much scales down
+#define FLOOR_Y -8.0f           // Particles below the playfield are dead
+#define DRAG 0.98f              // Velocity kept per 1/60 s
+#define MAX_STEP 0.1f           // Longest step, so a stall doesn't fling them
+
+static ParticleConfig config = {20000, 2000, 1000.0 / 60.0, 30, 120};
+static int cap = 20000;
+static int governed = 1;
+
+// The pool, one array per field; [0, live) are the live particles
+static float posX[PARTICLE_CAPACITY];
+static float posY[PARTICLE_CAPACITY];
+static float velX[PARTICLE_CAPACITY];
+static float velY[PARTICLE_CAPACITY];
+static float gravity[PARTICLE_CAPACITY];
+static float life[PARTICLE_CAPACITY];      // Seconds left
+static Uint32 look[PARTICLE_CAPACITY];     // Red, green, blue bytes and size in pixels
+static int live = 0;
+static Uint32 rng = 0x2545F491u;           // Own generator, so rand() sequences don't change
+
+static GLuint program = 0;
+static GLuint restoreProgram = 0;
+static GLuint streamVBO = 0;
+static GLint xAttrib, yAttrib, lifeAttrib, lookAttrib;
+static GLint pointScaleUniform;
+
+static double samples[PARTICLE_MAX_WINDOW];
+static int sampleCount = 0;
+static int sampleHead = 0;
+static double sampleSum = 0.0;
+static int framesAtCap = 0;
+
+static int parseOption(const char* key, const char* value) {
+    char* end;
+    double number = strtod(value, &end);
+    if (end == value || *end != '\0') {
+        return 0;
+    } else if (strcmp(key, "max") == 0) {
+        config.maxParticles = (int)number;
+    } else if (strcmp(key, "min") == 0) {
+        config.minParticles = (int)number;
+    } else if (strcmp(key, "target") == 0) {
+        config.targetMs = number;
+    } else if (strcmp(key, "window") == 0) {
+        config.window = (int)number;
+    } else if (strcmp(key, "probe") == 0) {
+        config.probeFrames = (int)number;
+    } else {
+        return 0;
+    }
+    return 1;
+}
+
+int particlesConfigure(const char* spec) {
+    if (spec != NULL) {
+        char buffer[256];
+        snprintf(buffer, sizeof(buffer), "%s", spec);
+        for (char* option = strtok(buffer, ","); option != NULL; option = strtok(NULL, ",")) {
+            char* equals = strchr(option, '=');
+            if (equals == NULL) {
+                printf("particles: expected key=value, got \"%s\"\n", option);
+                return 0;
+            }
+            *equals = '\0';
+            if (!parseOption(option, equals + 1)) {
+                printf("particles: bad option %s=%s\n", option, equals + 1);
+                return 0;
+            }
+        }
+    }
+
+    if (config.maxParticles < 0 || config.maxParticles > PARTICLE_CAPACITY ||
+        config.minParticles < 0 || config.minParticles > config.maxParticles ||
+        config.targetMs <= 0.0 || config.window < 1 || config.window > PARTICLE_MAX_WINDOW ||
+        config.probeFrames < 1) {
+        printf("particles: need 0 <= min <= max <= %d, target > 0, 1 <= window <= %d and probe >= 1\n",
+               PARTICLE_CAPACITY, PARTICLE_MAX_WINDOW);
+        return 0;
+    }
+    cap = config.maxParticles;
+    return 1;
+}
+
+int particlesInit(GLuint gameProgram, int width, int height) {
+    // Each field arrives as its own stream; size rides in look's alpha,
+    // and a particle fades out over its last third of a second
+    const GLchar* vertexSource = R"(
+        attribute float x;
+        attribute float y;
+        attribute float life;
+        attribute vec4 look;
+        uniform mat4 projection;
+        uniform float pointScale;
+        varying vec4 colour;
+
+        void main()
+        {
+            gl_Position = projection * vec4(x, y, 0.0, 1.0);
+            gl_PointSize = look.a * 255.0 * pointScale;
+            colour = vec4(look.rgb, clamp(life * 3.0, 0.0, 1.0));
+        }
+    )";
+
+    const GLchar* fragmentSource = R"(
+        precision mediump float;
+        varying vec4 colour;
+
+        void main()
+        {
+            gl_FragColor = colour;
+        }
+    )";
+
+    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexSource);
+    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSource);
+    if (vertexShader == 0 || fragmentShader == 0) {
+        printf("particles: shaders didn't compile, running without particles\n");
+        return 0;
+    }
+
+    program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    glLinkProgram(program);
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+
+    GLint linked;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        GLchar infoLog[512];
+        glGetProgramInfoLog(program, sizeof(infoLog), NULL, infoLog);
+        printf("particles: program didn't link: %s\n", infoLog);
+        glDeleteProgram(program);
+        program = 0;
+        return 0;
+    }
+
+    xAttrib = glGetAttribLocation(program, "x");
+    yAttrib = glGetAttribLocation(program, "y");
+    lifeAttrib = glGetAttribLocation(program, "life");
+    lookAttrib = glGetAttribLocation(program, "look");
+    pointScaleUniform = glGetUniformLocation(program, "pointScale");
+
+    float projection[16];
+    createOrthoProjectionMatrix(projection, (float)width, (float)height);
+    glStateUseProgram(program);
+    glStateUniformMatrix4fv(glGetUniformLocation(program, "projection"), 1, GL_FALSE, projection);
+    restoreProgram = gameProgram;
+    glStateUseProgram(restoreProgram);
+
+    glGenBuffers(1, &streamVBO);
+    return 1;
+}
+
+static inline Uint32 nextRandom(void) {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+// Uniform in [low, high)
+static inline float randomRange(float low, float high) {
+    return low + (high - low) * (nextRandom() >> 8) * (1.0f / 16777216.0f);
+}
+
+static inline GLubyte shade(int value, int spread) {
+    value += (int)(nextRandom() % (2 * spread + 1)) - spread;
+    return (GLubyte)(value < 0 ? 0 : value > 255 ? 255 : value);
+}
+
+void particlesBurst(ParticleKind kind, float x, float y, float width, float height,
+                    int count, const GLubyte rgb[3]) {
+    int room = cap - live;
+    if (count > room) count = room;
+
+    for (int i = 0; i < count; i++) {
+        int p = live++;
+        int size;
+        if (kind == PARTICLE_SPARK) {
+            // Out of the contact point in every direction, barely falling
+            float speedX = randomRange(-1.0f, 1.0f), speedY = randomRange(-1.0f, 1.0f);
+            float speed = randomRange(150.0f, 420.0f);
+            posX[p] = x;
+            posY[p] = y;
+            velX[p] = speedX * speed;
+            velY[p] = speedY * speed;
+            gravity[p] = 150.0f;
+            life[p] = randomRange(0.2f, 0.55f);
+            size = 2 + (int)(nextRandom() & 1);
+        } else {
+            // Chips from all over the brick, kicked up a little, then falling
+            posX[p] = x + randomRange(-0.5f, 0.5f) * width;
+            posY[p] = y + randomRange(-0.5f, 0.5f) * height;
+            velX[p] = (posX[p] - x) * 3.0f + randomRange(-60.0f, 60.0f);
+            velY[p] = randomRange(-40.0f, 220.0f);
+            gravity[p] = 900.0f;
+            life[p] = randomRange(0.8f, 1.6f);
+            size = 3 + (int)(nextRandom() % 3);
+        }
+        look[p] = (Uint32)shade(rgb[0], 24) | (Uint32)shade(rgb[1], 24) << 8 |
+                  (Uint32)shade(rgb[2], 24) << 16 | (Uint32)size << 24;
+    }
+}
+
+// Moves every live particle one step and zeroes the life of those that
+// fell off the bottom
+static void integrate(float dt) {
+    float keep = 1.0f - (1.0f - DRAG) * dt * 60.0f;
+    int i = 0;
+#if defined(PARTICLES_USE_NEON)
+    float32x4_t step = vdupq_n_f32(dt), drag = vdupq_n_f32(keep), floorY = vdupq_n_f32(FLOOR_Y);
+    float32x4_t zero = vdupq_n_f32(0.0f);
+    for (; i + 4 <= live; i += 4) {
+        float32x4_t vx = vmulq_f32(vld1q_f32(&velX[i]), drag);
+        float32x4_t vy = vmlsq_f32(vmulq_f32(vld1q_f32(&velY[i]), drag), vld1q_f32(&gravity[i]), step);
+        float32x4_t y = vmlaq_f32(vld1q_f32(&posY[i]), vy, step);
+        float32x4_t left = vsubq_f32(vld1q_f32(&life[i]), step);
+        vst1q_f32(&velX[i], vx);
+        vst1q_f32(&velY[i], vy);
+        vst1q_f32(&posX[i], vmlaq_f32(vld1q_f32(&posX[i]), vx, step));
+        vst1q_f32(&posY[i], y);
+        vst1q_f32(&life[i], vbslq_f32(vcltq_f32(y, floorY), zero, left));
+    }
+#elif defined(PARTICLES_USE_SSE2)
+    __m128 step = _mm_set1_ps(dt), drag = _mm_set1_ps(keep), floorY = _mm_set1_ps(FLOOR_Y);
+    for (; i + 4 <= live; i += 4) {
+        __m128 vx = _mm_mul_ps(_mm_loadu_ps(&velX[i]), drag);
+        __m128 vy = _mm_sub_ps(_mm_mul_ps(_mm_loadu_ps(&velY[i]), drag),
+                               _mm_mul_ps(_mm_loadu_ps(&gravity[i]), step));
+        __m128 y = _mm_add_ps(_mm_loadu_ps(&posY[i]), _mm_mul_ps(vy, step));
+        __m128 left = _mm_sub_ps(_mm_loadu_ps(&life[i]), step);
+        _mm_storeu_ps(&velX[i], vx);
+        _mm_storeu_ps(&velY[i], vy);
+        _mm_storeu_ps(&posX[i], _mm_add_ps(_mm_loadu_ps(&posX[i]), _mm_mul_ps(vx, step)));
+        _mm_storeu_ps(&posY[i], y);
+        _mm_storeu_ps(&life[i], _mm_andnot_ps(_mm_cmplt_ps(y, floorY), left));
+    }
+#endif
+    for (; i < live; i++) {
+        velX[i] *= keep;
+        velY[i] = velY[i] * keep - gravity[i] * dt;
+        posX[i] += velX[i] * dt;
+        posY[i] += velY[i] * dt;
+        life[i] = posY[i] < FLOOR_Y ? 0.0f : life[i] - dt;
+    }
+}
+
+void particlesUpdate(float seconds) {
+    TRACE_ZONE("particlesUpdate");
+    if (live == 0) return;
+    integrate(seconds < MAX_STEP ? seconds : MAX_STEP);
+
+    // The last live particle fills each gap, so the pool stays packed
+    for (int i = 0; i < live;) {
+        if (life[i] > 0.0f) {
+            i++;
+            continue;
+        }
+        int last = --live;
+        posX[i] = posX[last];
+        posY[i] = posY[last];
+        velX[i] = velX[last];
+        velY[i] = velY[last];
+        gravity[i] = gravity[last];
+        life[i] = life[last];
+        look[i] = look[last];
+    }
+}
+
+void particlesDraw(void) {
+    if (program == 0 || live == 0) return;
+    TRACE_ZONE("particlesDraw");
+
+    // Orphan last frame's storage, then one upload per field stream
+    GLsizeiptr floats = (GLsizeiptr)live * sizeof(float);
+    glStateBindBuffer(GL_ARRAY_BUFFER, streamVBO);
+    glBufferData(GL_ARRAY_BUFFER, floats * 4, NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, floats, posX);
+    glBufferSubData(GL_ARRAY_BUFFER, floats, floats, posY);
+    glBufferSubData(GL_ARRAY_BUFFER, floats * 2, floats, life);
+    glBufferSubData(GL_ARRAY_BUFFER, floats * 3, floats, look);
+
+    glStateUseProgram(program);
+    // Points are sized in window pixels; --dynres draws into a smaller viewport
+    glUniform1f(pointScaleUniform, dynResScale());
+    glEnableVertexAttribArray(xAttrib);
+    glEnableVertexAttribArray(yAttrib);
+    glEnableVertexAttribArray(lifeAttrib);
+    glEnableVertexAttribArray(lookAttrib);
+    glVertexAttribPointer(xAttrib, 1, GL_FLOAT, GL_FALSE, 0, (void*)0);
+    glVertexAttribPointer(yAttrib, 1, GL_FLOAT, GL_FALSE, 0, (void*)floats);
+    glVertexAttribPointer(lifeAttrib, 1, GL_FLOAT, GL_FALSE, 0, (void*)(floats * 2));
+    glVertexAttribPointer(lookAttrib, 4, GL_UNSIGNED_BYTE, GL_TRUE, 0, (void*)(floats * 3));
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDrawArrays(GL_POINTS, 0, live);
+    overlayCountDraw();
+    glDisable(GL_BLEND);
+
+    glDisableVertexAttribArray(xAttrib);
+    glDisableVertexAttribArray(yAttrib);
+    glDisableVertexAttribArray(lifeAttrib);
+    glDisableVertexAttribArray(lookAttrib);
+    glStateUseProgram(restoreProgram);
+}
+
+static void changeCap(int wanted, double mean, const char* reason) {
+    if (wanted < config.minParticles) wanted = config.minParticles;
+    if (wanted > config.maxParticles) wanted = config.maxParticles;
+    if (wanted == cap) return;
+
+    printf("particles cap %d -> %d, mean %.2f ms, target %.2f ms, %s\n",
+           cap, wanted, mean, config.targetMs, reason);
+    fflush(stdout);
+    cap = wanted;
+    sampleCount = 0;
+    sampleHead = 0;
+    sampleSum = 0.0;
+    framesAtCap = 0;
+}
+
+void particlesFrameEnd(double frameMs) {
+    if (!governed || config.maxParticles == 0) return;
+
+    if (sampleCount == config.window) {
+        sampleSum -= samples[sampleHead];
+    } else {
+        sampleCount++;
+    }
+    samples[sampleHead] = frameMs;
+    sampleSum += frameMs;
+    sampleHead = (sampleHead + 1) % config.window;
+    framesAtCap++;
+
+    // Nothing is decided until a whole window has run at this cap. A slow
+    // window with the pool mostly empty isn't the particles' doing.
+    if (sampleCount < config.window) return;
+    double mean = sampleSum / sampleCount;
+
+    if (mean > config.targetMs * OVER_BUDGET) {
+        if (live > cap / 2) {
+            changeCap((int)(cap * config.targetMs / mean), mean, "over budget");
+        }
+    } else if (cap < config.maxParticles && framesAtCap >= config.probeFrames) {
+        changeCap(cap + config.maxParticles / 8, mean, "probe");
+    }
+}
+
+void particlesFixCap(int fixed) {
+    governed = 0;
+    cap = fixed < PARTICLE_CAPACITY ? fixed : PARTICLE_CAPACITY;
+}
+
+int particlesLive(void) {
+    return live;
+}
+
+int particlesCap(void) {
+    return cap;
+}
+
+void particlesCleanup(void) {
+    if (streamVBO != 0) {
+        glStateDeleteBuffers(1, &streamVBO);
+        streamVBO = 0;
+    }
+    if (program != 0) {
+        glDeleteProgram(program);
+        program = 0;
+    }
+    live = 0;
+}
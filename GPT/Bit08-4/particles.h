@@ -0,0 +1,66 @@
+#ifndef PARTICLES_H
+#define PARTICLES_H
+
+#include <GL/glew.h>
+
+// Brick hit sparks and break debris. Particles live in a fixed pool laid
+// out as one array per field (struct of arrays), so nothing is allocated
+// per particle. Live ones are kept packed at the front: the update runs
+// over them four at a time with SSE2 or NEON, and dead ones are swapped
+// out with the last. Each field array is uploaded as its own attribute
+// stream, and the lot is drawn as GL_POINTS in one draw call with a small
+// program of its own.
+//
+// The cap on live particles is the quality knob. --particles takes
+// "key=value,..." with keys max, min, target (ms), window and probe. A
+// governor watches the same render plus present time as dynres. When the
+// mean over a window goes over target, it scales the cap down in
+// proportion, since particle cost is linear in the count. After probe
+// frames on budget, it raises the cap an eighth of max at a time. Bursts
+// past the cap are cut short. max=0 turns particles off.
+
+#define PARTICLE_CAPACITY 32768     // Multiple of 4
+#define PARTICLE_MAX_WINDOW 240
+
+typedef enum {
+    PARTICLE_SPARK,     // Every hit: small, fast, short-lived, white-yellow
+    PARTICLE_DEBRIS     // A break: brick-coloured chips that fall
+} ParticleKind;
+
+typedef struct {
+    int maxParticles;
+    int minParticles;   // The governor never goes below this
+    double targetMs;    // Budget for render plus present
+    int window;         // Frames in the rolling mean, and held after a change
+    int probeFrames;    // Frames on budget before a step up
+} ParticleConfig;
+
+// NULL keeps the defaults; prints the problem and returns 0 on a bad spec
+int particlesConfigure(const char* spec);
+
+// Builds the point program and the stream buffer. gameProgram is made
+// current again after each draw, as the rest of the frame expects it.
+// Returns 0, leaving particles off, if the program doesn't build.
+int particlesInit(GLuint gameProgram, int width, int height);
+
+// Spawns up to count particles around (x, y); debris spreads over a
+// width x height rectangle centred there. rgb is the base colour.
+void particlesBurst(ParticleKind kind, float x, float y, float width, float height,
+                    int count, const GLubyte rgb[3]);
+
+void particlesUpdate(float seconds);
+
+// One draw for every live particle, with the projection's y-up playfield
+void particlesDraw(void);
+
+// Feeds the governor; call once per frame with the frame's work time
+void particlesFrameEnd(double frameMs);
+
+// Pins the cap and stops the governor, for the benchmark
+void particlesFixCap(int cap);
+
+int particlesLive(void);
+int particlesCap(void);
+void particlesCleanup(void);
+
+#endif // PARTICLES_H
@@ -0,0 +1,146 @@
+#include "powerups.h"
+#include "glstate.h"
+#include "overlay.h"
+#include <string.h>
+
+// 64x8 atlas: a 12x7 capsule per kind, 14 texels apart, then the bolt
+#define ATLAS_WIDTH 64
+#define ATLAS_HEIGHT 8
+#define CAPSULE_TEXELS_X 12
+#define CAPSULE_TEXELS_Y 7
+#define CAPSULE_STRIDE 14
+#define BOLT_TEXEL_X 58
+#define BOLT_TEXELS_X 2
+#define BOLT_TEXELS_Y 7
+
+static const GLubyte capsuleColours[POWERUP_KIND_COUNT][3] = {
+    {60, 120, 230},    // Wide: blue
+    {70, 200, 90},     // Multi-ball: green
+    {240, 150, 40},    // Slow: orange
+    {220, 50, 50}      // Laser: red
+};
+
+// W, M, S and L in 3x5, one row per entry from the top, leftmost pixel in bit 2
+static const unsigned char capsuleLetters[POWERUP_KIND_COUNT][5] = {
+    {5, 5, 5, 7, 5}, {5, 7, 5, 5, 5}, {7, 4, 7, 1, 7}, {4, 4, 4, 4, 7}
+};
+
+static GLuint program = 0;
+static GLuint atlasTexture = 0;
+static GLuint powerupVBO = 0;
+static GLfloat vertices[(MAX_CAPSULES + MAX_LASER_BOLTS) * 6 * 5];
+static int vertexCount = 0;
+
+int powerupsInit(GLuint gameProgram) {
+    GLubyte pixels[ATLAS_HEIGHT][ATLAS_WIDTH][4];
+    memset(pixels, 0, sizeof(pixels));
+
+    // Texel row 0 is v = 0, the bottom of a quad, so art goes in upside
+    // down. Capsules are a dark rim around the colour with rounded
+    // corners and a white letter.
+    for (int kind = 0; kind < POWERUP_KIND_COUNT; kind++) {
+        int left = kind * CAPSULE_STRIDE;
+        for (int y = 0; y < CAPSULE_TEXELS_Y; y++) {
+            for (int x = 0; x < CAPSULE_TEXELS_X; x++) {
+                int edgeX = x == 0 || x == CAPSULE_TEXELS_X - 1;
+                int edgeY = y == 0 || y == CAPSULE_TEXELS_Y - 1;
+                if (edgeX && edgeY) continue;
+
+                GLubyte* texel = pixels[y][left + x];
+                for (int c = 0; c < 3; c++) {
+                    texel[c] = edgeX || edgeY ? capsuleColours[kind][c] / 2 : capsuleColours[kind][c];
+                }
+                texel[3] = 255;
+            }
+        }
+        for (int row = 0; row < 5; row++) {
+            for (int col = 0; col < 3; col++) {
+                if (capsuleLetters[kind][row] & (4 >> col)) {
+                    memset(pixels[5 - row][left + 5 + col], 255, 4);
+                }
+            }
+        }
+    }
+    // Bolts are hot red with a white tip
+    for (int y = 0; y < BOLT_TEXELS_Y; y++) {
+        for (int x = 0; x < BOLT_TEXELS_X; x++) {
+            GLubyte* texel = pixels[y][BOLT_TEXEL_X + x];
+            texel[0] = 255;
+            texel[1] = y >= BOLT_TEXELS_Y - 2 ? 255 : 90;
+            texel[2] = y >= BOLT_TEXELS_Y - 2 ? 255 : 70;
+            texel[3] = 255;
+        }
+    }
+
+    glGenTextures(1, &atlasTexture);
+    glStateBindTexture(GL_TEXTURE_2D, atlasTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, ATLAS_WIDTH, ATLAS_HEIGHT, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+
+    glGenBuffers(1, &powerupVBO);
+    program = gameProgram;
+    return 1;
+}
+
+// Two triangles centred on (x, y); u0 and u1 are atlas texel columns
+static void emitQuad(float x, float y, float width, float height, int u0, int u1, int rows) {
+    const float left = x - width / 2, right = x + width / 2;
+    const float bottom = y - height / 2, top = y + height / 2;
+    const float s0 = u0 / (float)ATLAS_WIDTH, s1 = u1 / (float)ATLAS_WIDTH;
+    const float t1 = rows / (float)ATLAS_HEIGHT;
+    const float corners[6][4] = {
+        {left, bottom, s0, 0.0f}, {right, bottom, s1, 0.0f}, {right, top, s1, t1},
+        {left, bottom, s0, 0.0f}, {right, top, s1, t1}, {left, top, s0, t1}
+    };
+    for (int i = 0; i < 6; i++) {
+        GLfloat* vertex = &vertices[vertexCount++ * 5];
+        vertex[0] = corners[i][0];
+        vertex[1] = corners[i][1];
+        vertex[2] = 0.0f;
+        vertex[3] = corners[i][2];
+        vertex[4] = corners[i][3];
+    }
+}
+
+void powerupsDraw(const SimState* view, GLint positionAttrib, GLint texCoordAttrib, GLint modelUniform) {
+    if (view->capsuleCount + view->boltCount == 0) return;
+
+    vertexCount = 0;
+    for (int i = 0; i < view->capsuleCount; i++) {
+        const Capsule* capsule = &view->capsules[i];
+        int left = capsule->kind * CAPSULE_STRIDE;
+        emitQuad(fxToFloat(capsule->x), fxToFloat(capsule->y), CAPSULE_WIDTH, CAPSULE_HEIGHT,
+                 left, left + CAPSULE_TEXELS_X, CAPSULE_TEXELS_Y);
+    }
+    for (int i = 0; i < view->boltCount; i++) {
+        emitQuad(fxToFloat(view->bolts[i].x), fxToFloat(view->bolts[i].y), BOLT_WIDTH, BOLT_HEIGHT,
+                 BOLT_TEXEL_X, BOLT_TEXEL_X + BOLT_TEXELS_X, BOLT_TEXELS_Y);
+    }
+
+    // One upload and one draw for every capsule and bolt
+    static const float identity[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+    glStateUseProgram(program);
+    glStateUniformMatrix4fv(modelUniform, 1, GL_FALSE, identity);
+    glStateBindBuffer(GL_ARRAY_BUFFER, powerupVBO);
+    glBufferData(GL_ARRAY_BUFFER, vertexCount * 5 * sizeof(GLfloat), vertices, GL_STREAM_DRAW);
+    glEnableVertexAttribArray(positionAttrib);
+    glVertexAttribPointer(positionAttrib, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (void*)0);
+    glEnableVertexAttribArray(texCoordAttrib);
+    glVertexAttribPointer(texCoordAttrib, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
+    glStateBindTexture(GL_TEXTURE_2D, atlasTexture);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDrawArrays(GL_TRIANGLES, 0, vertexCount);
+    glDisable(GL_BLEND);
+    overlayCountDraw();
+    glDisableVertexAttribArray(positionAttrib);
+    glDisableVertexAttribArray(texCoordAttrib);
+}
+
+void powerupsCleanup(void) {
+    glStateDeleteBuffers(1, &powerupVBO);
+    glStateDeleteTextures(1, &atlasTexture);
+}
@@ -0,0 +1,20 @@
+#ifndef POWERUPS_H
+#define POWERUPS_H
+
+#include <GL/glew.h>
+#include "sim.h"
+
+// Drawing for the power-up capsules and laser bolts; their rules and
+// pools are the simulation's (sim.h). All of them are drawn with the
+// game program from one streamed buffer and a small generated atlas: one
+// draw call whatever the count.
+
+// Builds the atlas and the stream buffer; gameProgram draws them
+int powerupsInit(GLuint gameProgram);
+
+// Every capsule and bolt in view in one draw; call after the sprites
+void powerupsDraw(const SimState* view, GLint positionAttrib, GLint texCoordAttrib, GLint modelUniform);
+
+void powerupsCleanup(void);
+
+#endif // POWERUPS_H
@@ -0,0 +1,32 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+
+// Frame phase profiler. Each phase keeps its most recent durations in a
+// fixed ring, so recording never allocates. The p50/p95/p99/max report and
+// CSV dump happen on exit (with --profile) or whenever the process gets
+// SIGUSR1.
+
+#define PROFILER_RING_SIZE 4096  // Samples kept per phase (power of two)
+
+typedef enum {
+    PROF_INPUT,
+    PROF_UPDATE,
+    PROF_COLLISION,
+    PROF_RENDER,
+    PROF_PRESENT,
+    PROF_FRAME,
+    PROF_PHASE_COUNT
+} ProfPhase;
+
+void profilerInit(bool reportOnExit, const char* csvPath);
+Uint64 profilerNow(void);
+void profilerRecord(ProfPhase phase, Uint64 start);
+double profilerLastMs(ProfPhase phase);  // Newest sample, 0 before any
+void profilerPoll(void);
+void profilerReport(void);
+void profilerShutdown(void);
+
+#endif // PROFILER_H
@@ -0,0 +1,342 @@
+#include "record.h"
+#include <GL/glew.h>
+#include <SDL2/SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define RECORD_USE_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define RECORD_USE_SSE2 1
+#endif
+
+#define RECORD_FILE_BUFFER (1 << 20)
+
+static FILE* file = NULL;
+static const char* output = NULL;
+static int width = 0;
+static int height = 0;
+static int active = 0;
+
+// The buffers are used in turn. freeSlots counts the ones the game may
+// fill and queuedSlots wakes the writer, so the game only ever tries the
+// first and the writer sleeps on the second.
+static GLubyte* frames[RECORD_BUFFERS];
+static int nextFill = 0;            // Game thread only
+static int nextWrite = 0;           // Writer thread only
+static SDL_sem* freeSlots = NULL;
+static SDL_sem* queuedSlots = NULL;
+static SDL_Thread* writer = NULL;
+static SDL_atomic_t queued;         // Filled and not yet written
+
+static int framesSubmitted = 0;     // Game thread only
+static int framesDropped = 0;
+static int framesWritten = 0;       // Writer thread only until it is joined
+static int writeFailed = 0;
+
+// BT.601 limited range, 8 fractional bits, as most encoders expect
+static inline Uint8 luma(int r, int g, int b) {
+    return (Uint8)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+}
+
+static inline Uint8 chromaU(int r, int g, int b) {
+    return (Uint8)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+}
+
+static inline Uint8 chromaV(int r, int g, int b) {
+    return (Uint8)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+}
+
+// Rounds up, like the SIMD byte averages
+static inline int average(int a, int b) {
+    return (a + b + 1) >> 1;
+}
+
+// Two rows of RGBA bytes from column x on: a luma byte per pixel, and one
+// chroma pair per 2x2 block, taken from the block's average colour
+static void convertScalar(const GLubyte* top, const GLubyte* bottom, int x, int count,
+                          Uint8* yTop, Uint8* yBottom, Uint8* u, Uint8* v) {
+    for (; x < count; x += 2) {
+        const GLubyte* a = top + x * 4;
+        const GLubyte* b = a + 4;
+        const GLubyte* c = bottom + x * 4;
+        const GLubyte* d = c + 4;
+        yTop[x] = luma(a[0], a[1], a[2]);
+        yTop[x + 1] = luma(b[0], b[1], b[2]);
+        yBottom[x] = luma(c[0], c[1], c[2]);
+        yBottom[x + 1] = luma(d[0], d[1], d[2]);
+
+        int rgb[3];
+        for (int i = 0; i < 3; i++) {
+            rgb[i] = average(average(a[i], c[i]), average(b[i], d[i]));
+        }
+        u[x / 2] = chromaU(rgb[0], rgb[1], rgb[2]);
+        v[x / 2] = chromaV(rgb[0], rgb[1], rgb[2]);
+    }
+}
+
+#if defined(RECORD_USE_NEON)
+
+static inline void storeLuma(uint8x8_t r, uint8x8_t g, uint8x8_t b, Uint8* out) {
+    uint16x8_t y = vmull_u8(r, vdup_n_u8(66));
+    y = vmlal_u8(y, g, vdup_n_u8(129));
+    y = vmlal_u8(y, b, vdup_n_u8(25));
+    y = vaddq_u16(y, vdupq_n_u16(128));
+    vst1_u8(out, vadd_u8(vshrn_n_u16(y, 8), vdup_n_u8(16)));
+}
+
+// Average of each 2x2 block, widened: lanes 0 to 3 hold the four blocks
+static inline int16x8_t blockAverage(uint8x8_t top, uint8x8_t bottom) {
+    uint8x8_t vertical = vrhadd_u8(top, bottom);
+    uint8x8x2_t columns = vuzp_u8(vertical, vertical);
+    return vreinterpretq_s16_u16(vmovl_u8(vrhadd_u8(columns.val[0], columns.val[1])));
+}
+
+static inline void storeChroma(int16x8_t c, Uint8* out) {
+    c = vshrq_n_s16(vaddq_s16(c, vdupq_n_s16(128)), 8);
+    uint8x8_t bytes = vqmovun_s16(vaddq_s16(c, vdupq_n_s16(128)));
+    vst1_lane_u32((uint32_t*)out, vreinterpret_u32_u8(bytes), 0);
+}
+
+// Eight pixels a step; vld4 splits the RGBA bytes into planes
+static int convertSimd(const GLubyte* top, const GLubyte* bottom, int count,
+                       Uint8* yTop, Uint8* yBottom, Uint8* u, Uint8* v) {
+    int x = 0;
+    for (; x + 8 <= count; x += 8) {
+        uint8x8x4_t t = vld4_u8(top + x * 4);
+        uint8x8x4_t b = vld4_u8(bottom + x * 4);
+        storeLuma(t.val[0], t.val[1], t.val[2], yTop + x);
+        storeLuma(b.val[0], b.val[1], b.val[2], yBottom + x);
+
+        int16x8_t red = blockAverage(t.val[0], b.val[0]);
+        int16x8_t green = blockAverage(t.val[1], b.val[1]);
+        int16x8_t blue = blockAverage(t.val[2], b.val[2]);
+        int16x8_t cu = vsubq_s16(vmulq_n_s16(blue, 112),
+                                 vaddq_s16(vmulq_n_s16(red, 38), vmulq_n_s16(green, 74)));
+        int16x8_t cv = vsubq_s16(vmulq_n_s16(red, 112),
+                                 vaddq_s16(vmulq_n_s16(green, 94), vmulq_n_s16(blue, 18)));
+        storeChroma(cu, u + x / 2);
+        storeChroma(cv, v + x / 2);
+    }
+    return x;
+}
+
+#elif defined(RECORD_USE_SSE2)
+
+// One channel of eight pixels as 16-bit lanes; a pixel loads as
+// 0xAABBGGRR, so red is at shift 0 and blue at 16
+static inline __m128i channel(__m128i lo, __m128i hi, int shift) {
+    const __m128i mask = _mm_set1_epi32(0xff);
+    return _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(lo, shift), mask),
+                           _mm_and_si128(_mm_srli_epi32(hi, shift), mask));
+}
+
+// Sums stay under 65536, so the 16-bit lanes can be treated as unsigned
+static inline void storeLuma(__m128i lo, __m128i hi, Uint8* out) {
+    __m128i y = _mm_add_epi16(_mm_mullo_epi16(channel(lo, hi, 0), _mm_set1_epi16(66)),
+                              _mm_mullo_epi16(channel(lo, hi, 8), _mm_set1_epi16(129)));
+    y = _mm_add_epi16(y, _mm_mullo_epi16(channel(lo, hi, 16), _mm_set1_epi16(25)));
+    y = _mm_srli_epi16(_mm_add_epi16(y, _mm_set1_epi16(128)), 8);
+    y = _mm_add_epi16(y, _mm_set1_epi16(16));
+    _mm_storel_epi64((__m128i*)out, _mm_packus_epi16(y, y));
+}
+
+// Average pixel of the two 2x2 blocks in four columns, in lanes 0 and 1
+static inline __m128i blockAverage(__m128i top, __m128i bottom) {
+    __m128i vertical = _mm_avg_epu8(top, bottom);
+    __m128i pairs = _mm_avg_epu8(vertical, _mm_srli_epi64(vertical, 32));
+    return _mm_shuffle_epi32(pairs, _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+static inline void storeChroma(__m128i c, Uint8* out) {
+    c = _mm_srai_epi16(_mm_add_epi16(c, _mm_set1_epi16(128)), 8);
+    c = _mm_packus_epi16(_mm_add_epi16(c, _mm_set1_epi16(128)), c);
+    int bytes = _mm_cvtsi128_si32(c);
+    memcpy(out, &bytes, sizeof(bytes));
+}
+
+static int convertSimd(const GLubyte* top, const GLubyte* bottom, int count,
+                       Uint8* yTop, Uint8* yBottom, Uint8* u, Uint8* v) {
+    int x = 0;
+    for (; x + 8 <= count; x += 8) {
+        __m128i t0 = _mm_loadu_si128((const __m128i*)(top + x * 4));
+        __m128i t1 = _mm_loadu_si128((const __m128i*)(top + x * 4 + 16));
+        __m128i b0 = _mm_loadu_si128((const __m128i*)(bottom + x * 4));
+        __m128i b1 = _mm_loadu_si128((const __m128i*)(bottom + x * 4 + 16));
+        storeLuma(t0, t1, yTop + x);
+        storeLuma(b0, b1, yBottom + x);
+
+        __m128i blocks = _mm_unpacklo_epi64(blockAverage(t0, b0), blockAverage(t1, b1));
+        __m128i red = channel(blocks, blocks, 0);
+        __m128i green = channel(blocks, blocks, 8);
+        __m128i blue = channel(blocks, blocks, 16);
+        __m128i cu = _mm_sub_epi16(_mm_mullo_epi16(blue, _mm_set1_epi16(112)),
+                                   _mm_add_epi16(_mm_mullo_epi16(red, _mm_set1_epi16(38)),
+                                                 _mm_mullo_epi16(green, _mm_set1_epi16(74))));
+        __m128i cv = _mm_sub_epi16(_mm_mullo_epi16(red, _mm_set1_epi16(112)),
+                                   _mm_add_epi16(_mm_mullo_epi16(green, _mm_set1_epi16(94)),
+                                                 _mm_mullo_epi16(blue, _mm_set1_epi16(18))));
+        storeChroma(cu, u + x / 2);
+        storeChroma(cv, v + x / 2);
+    }
+    return x;
+}
+
+#else
+
+static int convertSimd(const GLubyte* top, const GLubyte* bottom, int count,
+                       Uint8* yTop, Uint8* yBottom, Uint8* u, Uint8* v) {
+    (void)top; (void)bottom; (void)count; (void)yTop; (void)yBottom; (void)u; (void)v;
+    return 0;
+}
+
+#endif
+
+// A whole frame into the planar Y, U, V layout y4m wants. GL rows run
+// bottom to top, so the source is walked backwards.
+static void convertFrame(const GLubyte* pixels, Uint8* yuv) {
+    Uint8* yPlane = yuv;
+    Uint8* uPlane = yPlane + width * height;
+    Uint8* vPlane = uPlane + (width / 2) * (height / 2);
+    size_t rowBytes = (size_t)width * 4;
+    for (int row = 0; row < height; row += 2) {
+        const GLubyte* top = pixels + (size_t)(height - 1 - row) * rowBytes;
+        const GLubyte* bottom = top - rowBytes;
+        Uint8* yTop = yPlane + (size_t)row * width;
+        Uint8* u = uPlane + (size_t)(row / 2) * (width / 2);
+        Uint8* v = vPlane + (size_t)(row / 2) * (width / 2);
+        int done = convertSimd(top, bottom, width, yTop, yTop + width, u, v);
+        convertScalar(top, bottom, done, width, yTop, yTop + width, u, v);
+    }
+}
+
+static int writerMain(void* data) {
+    (void)data;
+    size_t frameSize = (size_t)width * height * 3 / 2;
+    Uint8* yuv = malloc(frameSize);
+    if (yuv == NULL) {
+        writeFailed = 1;
+    }
+
+    // One wake per queued frame, and one more from recordStop after the
+    // game's last; that one is the only wake that finds nothing queued
+    for (;;) {
+        SDL_SemWait(queuedSlots);
+        if (SDL_AtomicGet(&queued) == 0) {
+            break;
+        }
+        if (!writeFailed) {
+            convertFrame(frames[nextWrite], yuv);
+            if (fwrite("FRAME\n", 1, 6, file) != 6 || fwrite(yuv, 1, frameSize, file) != frameSize) {
+                writeFailed = 1;
+            } else {
+                framesWritten++;
+            }
+        }
+        SDL_AtomicAdd(&queued, -1);
+        nextWrite = (nextWrite + 1) % RECORD_BUFFERS;
+        SDL_SemPost(freeSlots);
+    }
+    free(yuv);
+    return 0;
+}
+
+int recordStart(const char* path, int windowWidth, int windowHeight) {
+    width = windowWidth & ~1;
+    height = windowHeight & ~1;
+    if (width <= 0 || height <= 0) {
+        printf("Can't record a %dx%d frame\n", windowWidth, windowHeight);
+        return 0;
+    }
+
+    file = fopen(path, "wb");
+    if (file == NULL) {
+        printf("Can't open %s for recording\n", path);
+        return 0;
+    }
+    // Big writes, so the disk sees few of them
+    setvbuf(file, NULL, _IOFBF, RECORD_FILE_BUFFER);
+    // C420jpeg is centred chroma, which the 2x2 averages are
+    fprintf(file, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg XCOLORRANGE=LIMITED\n",
+            width, height, RECORD_FPS);
+
+    for (int i = 0; i < RECORD_BUFFERS; i++) {
+        frames[i] = malloc((size_t)width * height * 4);
+        if (frames[i] == NULL) {
+            printf("Out of memory for recording buffers\n");
+            recordStop();
+            return 0;
+        }
+    }
+
+    output = path;
+    SDL_AtomicSet(&queued, 0);
+    freeSlots = SDL_CreateSemaphore(RECORD_BUFFERS);
+    queuedSlots = SDL_CreateSemaphore(0);
+    if (freeSlots != NULL && queuedSlots != NULL) {
+        writer = SDL_CreateThread(writerMain, "record", NULL);
+    }
+    if (writer == NULL) {
+        printf("Can't start the recording thread: %s\n", SDL_GetError());
+        recordStop();
+        return 0;
+    }
+    active = 1;
+    return 1;
+}
+
+int recordActive(void) {
+    return active;
+}
+
+void recordFrame(void) {
+    if (!active) return;
+
+    framesSubmitted++;
+    if (SDL_SemTryWait(freeSlots) != 0) {
+        framesDropped++;
+        return;
+    }
+
+    // The window's own framebuffer, whatever --dynres drew the scene at
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, frames[nextFill]);
+    nextFill = (nextFill + 1) % RECORD_BUFFERS;
+    SDL_AtomicAdd(&queued, 1);
+    SDL_SemPost(queuedSlots);
+}
+
+void recordStop(void) {
+    if (writer != NULL) {
+        SDL_SemPost(queuedSlots);
+        SDL_WaitThread(writer, NULL);
+        writer = NULL;
+    }
+    if (freeSlots != NULL) {
+        SDL_DestroySemaphore(freeSlots);
+        freeSlots = NULL;
+    }
+    if (queuedSlots != NULL) {
+        SDL_DestroySemaphore(queuedSlots);
+        queuedSlots = NULL;
+    }
+    if (file != NULL) {
+        if (fclose(file) != 0) {
+            writeFailed = 1;
+        }
+        file = NULL;
+    }
+    for (int i = 0; i < RECORD_BUFFERS; i++) {
+        free(frames[i]);
+        frames[i] = NULL;
+    }
+
+    if (active) {
+        printf("Recorded %d of %d frames to %s (%d dropped)%s\n", framesWritten, framesSubmitted,
+               output, framesDropped, writeFailed ? ", stopped by a write error" : "");
+    }
+    active = 0;
+}
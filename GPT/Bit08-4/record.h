@@ -0,0 +1,28 @@
+#ifndef RECORD_H
+#define RECORD_H
+
+// Gameplay recording for --record <out.y4m>. Each frame is read back with
+// glReadPixels into one of RECORD_BUFFERS rotating buffers and handed to
+// a writer thread, which flips it, converts it to YUV 4:2:0 (BT.601,
+// limited range) with SSE2 or NEON and streams it to a YUV4MPEG2 file.
+// GLES 2 has no pixel buffer objects, so the read itself is synchronous;
+// only the conversion and the disk are off the game thread. When no
+// buffer is free the frame is dropped and counted, never waited for.
+// The file is stamped at RECORD_FPS, one video frame per swap.
+// SDL_API_BRICK/07 carries the same recorder over SDL_RenderReadPixels.
+
+#define RECORD_BUFFERS 4
+#define RECORD_FPS 60
+
+// Opens the file and starts the writer; width and height are the
+// window's, rounded down to even for the chroma planes
+int recordStart(const char* path, int width, int height);
+int recordActive(void);
+
+// Call after the frame is drawn, before the overlay and the swap
+void recordFrame(void);
+
+// Lets the writer finish the queued frames, closes the file and reports
+void recordStop(void);
+
+#endif // RECORD_H
@@ -0,0 +1,45 @@
+#ifndef RENDERBENCH_H
+#define RENDERBENCH_H
+
+// Synthetic render benchmark for --bench-render. SDL_API_BRICK/07 and
+// the claude build carry the same module, so all three stacks draw the
+// same scene: a 640x480 background, N bricks tiled over it (16x8 each,
+// wrapping into further offset layers past 2400), RENDER_BENCH_BALLS
+// bouncing balls and a HUD score line. This build has no background art
+// or font, so its background is a generated texture of the same size and
+// its score is drawn in the overlay's digit glyphs. N steps through
+// renderBenchSizes; each
+// size runs for a fixed number of frames with vsync off, and one line per
+// size reports CPU submit time (scene start to present), present-to-
+// present frame time and draw calls.
+
+#define RENDER_BENCH_AREA_WIDTH 640
+#define RENDER_BENCH_AREA_HEIGHT 480
+#define RENDER_BENCH_BRICK_WIDTH 16
+#define RENDER_BENCH_BRICK_HEIGHT 8
+#define RENDER_BENCH_BALL_SIZE 15
+#define RENDER_BENCH_BALLS 16
+#define RENDER_BENCH_WARMUP_FRAMES 30   // Dropped from each size's stats
+#define RENDER_BENCH_MAX_FRAMES 2000
+#define RENDER_BENCH_DEFAULT_FRAMES 300
+
+typedef struct {
+    int x, y, w, h;  // Top-left corner, y down
+} BenchRect;
+
+typedef struct {
+    int bricks;
+    int balls;
+    int frame;       // Within this size, from 0
+} RenderBenchScene;
+
+void renderBenchInit(const char* backend, int framesPerSize);
+int renderBenchActive(void);
+const RenderBenchScene* renderBenchScene(void);
+BenchRect renderBenchBrick(int index);  // Texture is index % 3 (full health)
+BenchRect renderBenchBall(int index, int frame);
+
+// Records the frame just presented; returns 0 once every size is done
+int renderBenchFrameEnd(double submitMs, double frameMs, int drawCalls);
+
+#endif // RENDERBENCH_H
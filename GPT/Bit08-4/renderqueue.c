@@ -0,0 +1,143 @@
+#include "renderqueue.h"
+#include "glstate.h"
+#include "overlay.h"
+#include "trace.h"
+#include <stdio.h>
+
+typedef struct {
+    GLuint program;
+    GLint positionAttrib;
+    GLint texCoordAttrib;
+    GLint modelUniform;
+} RenderShader;
+
+typedef struct {
+    int shader;
+    RenderSprite sprite;
+} RenderCommand;
+
+// What gets sorted: the key and where its command sits in the arena
+typedef struct {
+    Uint64 key;
+    Uint32 command;
+} SortEntry;
+
+static RenderShader shaders[RENDER_QUEUE_MAX_SHADERS];
+static int shaderCount = 0;
+
+static RenderCommand arena[RENDER_QUEUE_CAPACITY];
+static SortEntry entries[RENDER_QUEUE_CAPACITY];
+static SortEntry scratch[RENDER_QUEUE_CAPACITY];
+static int commandCount = 0;
+static int warnedFull = 0;
+
+int renderQueueAddShader(GLuint program, GLint positionAttrib, GLint texCoordAttrib, GLint modelUniform) {
+    if (shaderCount == RENDER_QUEUE_MAX_SHADERS) return -1;
+    shaders[shaderCount] = (RenderShader){program, positionAttrib, texCoordAttrib, modelUniform};
+    return shaderCount++;
+}
+
+void renderQueueBegin(void) {
+    commandCount = 0;
+}
+
+void renderQueuePush(RenderLayer layer, int shader, Uint16 depth, const RenderSprite* sprite) {
+    if (commandCount == RENDER_QUEUE_CAPACITY) {
+        if (!warnedFull) {
+            printf("renderqueue: more than %d commands in a frame, dropping the rest\n", RENDER_QUEUE_CAPACITY);
+            warnedFull = 1;
+        }
+        return;
+    }
+
+    RenderCommand* command = &arena[commandCount];
+    command->shader = shader;
+    command->sprite = *sprite;
+    entries[commandCount].key = ((Uint64)layer << 56) | ((Uint64)(shader & 0xFF) << 48) |
+                                ((Uint64)(sprite->textureID & 0xFFFF) << 32) |
+                                ((Uint64)(sprite->VBO & 0xFFFF) << 16) | depth;
+    entries[commandCount].command = commandCount;
+    commandCount++;
+}
+
+// LSD radix sort, a byte per pass. It's stable, and a pass where every key
+// has the same byte (most of them: a frame has few layers, shaders and
+// textures) is skipped without moving anything.
+static SortEntry* radixSort(SortEntry* keys, SortEntry* spare, int count) {
+    for (int shift = 0; shift < 64; shift += 8) {
+        int offsets[256] = {0};
+        for (int i = 0; i < count; i++) {
+            offsets[(keys[i].key >> shift) & 0xFF]++;
+        }
+        if (offsets[(keys[0].key >> shift) & 0xFF] == count) {
+            continue;
+        }
+
+        int total = 0;
+        for (int b = 0; b < 256; b++) {
+            int bucket = offsets[b];
+            offsets[b] = total;
+            total += bucket;
+        }
+        for (int i = 0; i < count; i++) {
+            spare[offsets[(keys[i].key >> shift) & 0xFF]++] = keys[i];
+        }
+
+        SortEntry* sorted = spare;
+        spare = keys;
+        keys = sorted;
+    }
+    return keys;
+}
+
+void renderQueueExecute(void) {
+    TRACE_ZONE("renderQueueExecute");
+    if (commandCount == 0) return;
+
+    const SortEntry* sorted = radixSort(entries, scratch, commandCount);
+
+    const RenderShader* shader = NULL;
+    GLuint boundVBO = 0;
+    int attribsSet = 0;
+    float modelMatrix[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+
+    for (int i = 0; i < commandCount; i++) {
+        const RenderCommand* command = &arena[sorted[i].command];
+        const RenderSprite* sprite = &command->sprite;
+
+        if (shader != &shaders[command->shader]) {
+            if (shader != NULL) {
+                glDisableVertexAttribArray(shader->positionAttrib);
+                glDisableVertexAttribArray(shader->texCoordAttrib);
+            }
+            shader = &shaders[command->shader];
+            glStateUseProgram(shader->program);
+            glEnableVertexAttribArray(shader->positionAttrib);
+            glEnableVertexAttribArray(shader->texCoordAttrib);
+            attribsSet = 0;
+        }
+        // Attribute pointers capture the bound buffer, so they're redone
+        // with every VBO change
+        if (!attribsSet || sprite->VBO != boundVBO) {
+            glStateBindBuffer(GL_ARRAY_BUFFER, sprite->VBO);
+            glVertexAttribPointer(shader->positionAttrib, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (void*)0);
+            glVertexAttribPointer(shader->texCoordAttrib, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat),
+                                  (void*)(3 * sizeof(GLfloat)));
+            boundVBO = sprite->VBO;
+            attribsSet = 1;
+        }
+        glStateBindTexture(GL_TEXTURE_2D, sprite->textureID);
+
+        modelMatrix[0] = sprite->scaleX;
+        modelMatrix[5] = sprite->scaleY;
+        modelMatrix[12] = sprite->x;
+        modelMatrix[13] = sprite->y;
+        glStateUniformMatrix4fv(shader->modelUniform, 1, GL_FALSE, modelMatrix);
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+        overlayCountDraw();
+    }
+
+    glDisableVertexAttribArray(shader->positionAttrib);
+    glDisableVertexAttribArray(shader->texCoordAttrib);
+    commandCount = 0;
+}
@@ -0,0 +1,51 @@
+#ifndef RENDERQUEUE_H
+#define RENDERQUEUE_H
+
+#include <SDL2/SDL.h>
+#include <GL/glew.h>
+
+// Sorted render-command queue. Game code pushes one command per sprite
+// into a per-frame arena instead of drawing in hand-picked order; each
+// command carries a 64-bit key
+//
+//   layer (8) | shader (8) | texture (16) | VBO (16) | depth (16)
+//
+// and renderQueueExecute radix-sorts the keys and draws them in order,
+// switching program, VBO and attributes, or texture only where the
+// command's own values change between neighbours. Layers keep the paint
+// order; within a layer, sprites sharing state end up next to each other.
+// GL names past 16 bits share key bits with others, which only costs
+// batching, never correctness, since transitions compare the real names.
+
+#define RENDER_QUEUE_CAPACITY 16384  // Commands per frame; more are dropped
+#define RENDER_QUEUE_MAX_SHADERS 8
+
+typedef enum {
+    RENDER_LAYER_WORLD,     // Bricks
+    RENDER_LAYER_ACTORS,    // Paddle and ball
+    RENDER_LAYER_EFFECTS,   // Particles and the like
+    RENDER_LAYER_COUNT
+} RenderLayer;
+
+typedef struct {
+    GLuint VBO;              // Six vertices of position (3) and texcoord (2)
+    GLuint textureID;
+    float x, y;              // Centre, in projection units
+    float scaleX, scaleY;
+} RenderSprite;
+
+// Registers a program with its attribute and model-matrix locations;
+// returns the id that goes in each command, or -1 when full
+int renderQueueAddShader(GLuint program, GLint positionAttrib, GLint texCoordAttrib, GLint modelUniform);
+
+// Start a frame's commands; the arena from the previous frame is reused
+void renderQueueBegin(void);
+
+// Depth orders sprites within a layer that share shader, texture and VBO
+void renderQueuePush(RenderLayer layer, int shader, Uint16 depth, const RenderSprite* sprite);
+
+// Sorts and draws everything pushed since renderQueueBegin, counting each
+// draw for the overlay; the queue is left empty
+void renderQueueExecute(void);
+
+#endif // RENDERQUEUE_H
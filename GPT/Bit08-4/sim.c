@@ -0,0 +1,425 @@
+#include "sim.h"
+#include "broadphase.h"
+#include <string.h>
+
+#define CAPSULE_FALL_SPEED (FX(110) / SIM_HZ)   // 16.16 pixels per step
+#define BOLT_SPEED (FX(520) / SIM_HZ)
+#define BOLT_INTERVAL_STEPS (SIM_HZ / 5)        // Between pairs of bolts
+
+#define WIDE_STEPS (10 * SIM_HZ)
+#define SLOW_STEPS (8 * SIM_HZ)
+#define SLOW_SPEED 39322                        // 0.6 in 16.16
+#define LASER_STEPS (8 * SIM_HZ)
+#define PADDLE_BOUNCE 68813                     // 1.05 in 16.16
+
+// What a collision did to the brick
+#define BRICK_MISSED 0
+#define BRICK_HIT 1
+#define BRICK_BROKEN 2
+
+static uint32_t nextRandom(uint32_t* state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+// Signed division truncates toward zero by the standard, unlike a right
+// shift of a negative number, which is up to the compiler
+static int32_t fxMul(int32_t a, int32_t b) {
+    return (int32_t)((int64_t)a * b / FX_ONE);
+}
+
+// Broadphase boxes in whole pixels, rounded outward so nothing is missed
+static float pixelsBelow(int32_t value) {
+    return (float)fxFloor(value);
+}
+
+static float pixelsAbove(int32_t value) {
+    return (float)(fxFloor(value) + 1);
+}
+
+static void addHit(SimEvents* events, int brick, int broken, int32_t x, int32_t y) {
+    if (events->hitCount == SIM_MAX_HITS) return;
+    SimHit* hit = &events->hits[events->hitCount++];
+    hit->brick = brick;
+    hit->broken = broken;
+    hit->x = fxFloor(x);
+    hit->y = fxFloor(y);
+}
+
+// Rows from the top down, two rows to a colour
+static void layoutBricks(SimState* sim) {
+    const int paddingY = 5;      // Vertical padding
+    const int startX = 5;
+    const int startY = 460;      // Start near the top of the window
+
+    for (int row = 0; row < BRICK_ROWS; row++) {
+        for (int col = 0; col < BRICK_COLS; col++) {
+            Brick* brick = &sim->bricks[row * BRICK_COLS + col];
+            brick->x = FX(startX + col * BRICK_WIDTH) + FX(BRICK_WIDTH) / 2;
+            brick->y = FX(startY - row * (BRICK_HEIGHT + paddingY));
+            brick->health = 3;
+            brick->isActive = 1;
+        }
+    }
+}
+
+// Files the bricks in the broadphase grid by their drawn rectangles; the
+// grid is redone with each level's bricks
+static void fileBricks(const SimState* sim) {
+    broadphaseClear();
+    for (int i = 0; i < BRICK_COUNT; i++) {
+        const Brick* brick = &sim->bricks[i];
+        broadphaseInsert(i, pixelsBelow(brick->x - FX(BRICK_WIDTH) / 2), pixelsBelow(brick->y - FX(BRICK_HEIGHT) / 2),
+                         pixelsAbove(brick->x + FX(BRICK_WIDTH) / 2), pixelsAbove(brick->y + FX(BRICK_HEIGHT) / 2));
+    }
+}
+
+void simInit(SimState* sim, uint32_t seed) {
+    memset(sim, 0, sizeof(*sim));
+    sim->rng = seed != 0 ? seed : 0x9E3779B9u;
+    sim->dropRng = 0x9E3779B9u;
+    sim->ball.x = FX(PLAYFIELD_WIDTH / 2);
+    sim->ball.y = FX(PLAYFIELD_HEIGHT / 2);
+    sim->ball.vx = FX(2);
+    sim->ball.vy = FX(3) / 2;
+    sim->paddleX = FX(PLAYFIELD_WIDTH / 2);
+    sim->levelClearSteps = -1;
+    layoutBricks(sim);
+    fileBricks(sim);
+}
+
+float simPaddleScale(const SimState* sim) {
+    return sim->wideSteps > 0 ? 1.5f : 1.0f;
+}
+
+uint32_t simHash(const SimState* sim) {
+    const unsigned char* bytes = (const unsigned char*)sim;
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < sizeof(*sim); i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+// 16.16, half as wide again while the wide effect lasts
+static int32_t paddleWidth(const SimState* sim) {
+    return sim->wideSteps > 0 ? FX(PADDLE_WIDTH) * 3 / 2 : FX(PADDLE_WIDTH);
+}
+
+// Moves a ball a step and bounces it off the walls. With bounceBottom
+// clear, a ball going out the bottom is lost instead and 0 comes back.
+static int moveBall(SimBall* ball, int32_t step, int bounceBottom) {
+    ball->x += fxMul(ball->vx, step);
+    ball->y += fxMul(ball->vy, step);
+
+    // Collision with window edges (bounce back)
+    if (ball->x + FX(BALL_RADIUS) > FX(PLAYFIELD_WIDTH) || ball->x - FX(BALL_RADIUS) < 0) {
+        ball->vx = -ball->vx;  // Reverse horizontal direction
+    }
+    if (!bounceBottom && ball->y - FX(BALL_RADIUS) < 0) {
+        return 0;
+    }
+    if (ball->y + FX(BALL_RADIUS) > FX(PLAYFIELD_HEIGHT) || ball->y - FX(BALL_RADIUS) < 0) {
+        ball->vy = -ball->vy;  // Reverse vertical direction
+    }
+    return 1;
+}
+
+static int checkPaddleCollision(const SimBall* ball, int32_t paddleX, int32_t width) {
+    return ball->x < paddleX + width &&
+           ball->x + FX(BALL_RADIUS) > paddleX &&
+           ball->y < FX(PADDLE_Y + PADDLE_HEIGHT) &&
+           ball->y + FX(BALL_RADIUS) > FX(PADDLE_Y);
+}
+
+// Function to check collision between ball and brick
+static int checkBrickCollision(const SimBall* ball, const Brick* brick) {
+    // If the brick is not active, skip collision check
+    if (!brick->isActive) return 0;
+
+    // Simple AABB collision detection
+    return ball->x < brick->x + FX(BRICK_WIDTH) &&
+           ball->x + FX(BALL_RADIUS) > brick->x &&
+           ball->y < brick->y + FX(BRICK_HEIGHT) &&
+           ball->y + FX(BALL_RADIUS) > brick->y;
+}
+
+// Function to handle ball and brick collision
+static int handleBallBrickCollision(SimState* sim, SimBall* ball, Brick* brick) {
+    if (checkBrickCollision(ball, brick)) {
+        // Reverse the ball's vertical velocity
+        ball->vy = -ball->vy;
+        brick->health--;
+
+        // If the brick has full health (health == 3), there's a 25% chance of double break
+        if (brick->health == 2) {
+            int randomChance = nextRandom(&sim->rng) % 100;  // Generate a number between 0 and 99
+
+            if (randomChance < 25) {
+                brick->health--;
+            }
+        } else if (brick->health == 1) {
+            int randomChance = nextRandom(&sim->rng) % 100;  // Generate a number between 0 and 99
+
+            if (randomChance < 75) {
+                // 75% chance: Set brick's health to 0, break it instantly
+                brick->health--;
+            }
+        }
+
+        // Update brick's state based on health
+        if (brick->health <= 0) {
+            brick->isActive = 0;  // Deactivate the brick if health is 0
+            return BRICK_BROKEN;
+        }
+        return BRICK_HIT;
+    }
+    return BRICK_MISSED;
+}
+
+static void spawnCapsule(SimState* sim, int32_t x, int32_t y, int kind) {
+    if (sim->capsuleCount == MAX_CAPSULES) return;
+    Capsule* capsule = &sim->capsules[sim->capsuleCount++];
+    capsule->x = x;
+    capsule->y = y;
+    capsule->kind = kind;
+}
+
+static void spawnBolt(SimState* sim, int32_t x, int32_t y) {
+    if (sim->boltCount == MAX_LASER_BOLTS) return;
+    LaserBolt* bolt = &sim->bolts[sim->boltCount++];
+    bolt->x = x;
+    bolt->y = y;
+}
+
+// Rolls for a capsule where a brick broke
+static void brickBroken(SimState* sim, const Brick* brick) {
+    if (nextRandom(&sim->dropRng) % POWERUP_DROP_ODDS == 0) {
+        spawnCapsule(sim, brick->x, brick->y, (int)(nextRandom(&sim->dropRng) % POWERUP_KIND_COUNT));
+    }
+}
+
+// Paddle and brick collisions for one ball. checkBrickCollision measures
+// from the brick's centre, so a ball reaches bricks up to a brick and a
+// half to its left and below; only those grid candidates are tested, in
+// brick order, which hits the same bricks as testing them all.
+static void collideBall(SimState* sim, SimBall* ball, int32_t width, SimEvents* events) {
+    if (checkPaddleCollision(ball, sim->paddleX, width)) {
+        ball->vy = fxMul(ball->vy, -PADDLE_BOUNCE);
+        if (ball->vy > FX(2)) {
+            ball->vy = FX(2);
+        } else if (ball->vy < -FX(2)) {
+            ball->vy = -FX(2);
+        }
+    }
+
+    // Check ball-brick collisions and deactivate the bricks that are hit
+    const int32_t reachX = FX(BRICK_WIDTH) * 3 / 2, reachY = FX(BRICK_HEIGHT) * 3 / 2;
+    int candidates[BROADPHASE_MAX_ITEMS];
+    int count = broadphaseQuery(pixelsBelow(ball->x - reachX), pixelsBelow(ball->y - reachY),
+                                pixelsAbove(ball->x + FX(BALL_RADIUS) + reachX / 3),
+                                pixelsAbove(ball->y + FX(BALL_RADIUS) + reachY / 3),
+                                candidates, BROADPHASE_MAX_ITEMS);
+    for (int c = 0; c < count; c++) {
+        int i = candidates[c];
+        if (i >= BRICK_COUNT) continue;
+
+        int result = handleBallBrickCollision(sim, ball, &sim->bricks[i]);
+        if (result != BRICK_MISSED) {
+            addHit(events, i, result == BRICK_BROKEN, ball->x, ball->y);
+        }
+        if (result == BRICK_BROKEN) {
+            brickBroken(sim, &sim->bricks[i]);
+        }
+    }
+}
+
+// a is sized in whole pixels, b in 16.16; halving either is exact
+static int overlaps(int32_t ax, int32_t ay, int aw, int ah, int32_t bx, int32_t by, int32_t bw, int32_t bh) {
+    return ax - FX(aw) / 2 < bx + bw / 2 && ax + FX(aw) / 2 > bx - bw / 2 &&
+           ay - FX(ah) / 2 < by + bh / 2 && ay + FX(ah) / 2 > by - bh / 2;
+}
+
+// Returns the multi-ball capsules caught
+static int startEffect(SimState* sim, int kind) {
+    switch (kind) {
+        case POWERUP_WIDE:      sim->wideSteps = WIDE_STEPS; break;
+        case POWERUP_MULTIBALL: return 1;
+        case POWERUP_SLOW:      sim->slowSteps = SLOW_STEPS; break;
+        case POWERUP_LASER:     sim->laserSteps = LASER_STEPS; break;
+    }
+    return 0;
+}
+
+// First live brick the bolt touches, in brick order, or -1
+static int boltTarget(const SimState* sim, const LaserBolt* bolt) {
+    int candidates[BROADPHASE_MAX_ITEMS];
+    int count = broadphaseQuery(pixelsBelow(bolt->x - FX(BOLT_WIDTH) / 2), pixelsBelow(bolt->y - FX(BOLT_HEIGHT) / 2),
+                                pixelsAbove(bolt->x + FX(BOLT_WIDTH) / 2), pixelsAbove(bolt->y + FX(BOLT_HEIGHT) / 2),
+                                candidates, BROADPHASE_MAX_ITEMS);
+    for (int i = 0; i < count; i++) {
+        const Brick* brick = &sim->bricks[candidates[i]];
+        if (candidates[i] < BRICK_COUNT && brick->isActive &&
+            overlaps(bolt->x, bolt->y, BOLT_WIDTH, BOLT_HEIGHT, brick->x, brick->y, FX(BRICK_WIDTH), FX(BRICK_HEIGHT))) {
+            return candidates[i];
+        }
+    }
+    return -1;
+}
+
+// Moves capsules and bolts, catches capsules with the paddle and runs the
+// timed effects. Bolts damage the bricks they hit and may break them.
+// Returns the multi-ball capsules caught.
+static int updatePowerUps(SimState* sim, int32_t width, SimEvents* events) {
+    int multiBall = 0;
+    int laserHits = 0;
+
+    if (sim->wideSteps > 0) sim->wideSteps--;
+    if (sim->slowSteps > 0) sim->slowSteps--;
+    if (sim->laserSteps > 0) sim->laserSteps--;
+
+    // The stress test rains capsules from the top and bolts from the bottom
+    for (int i = sim->capsuleCount; i < sim->stressCount && i < MAX_CAPSULES; i++) {
+        spawnCapsule(sim, FX(nextRandom(&sim->dropRng) % 800), FX(480 + nextRandom(&sim->dropRng) % 480),
+                     (int)(nextRandom(&sim->dropRng) % POWERUP_KIND_COUNT));
+    }
+    for (int i = sim->boltCount; i < sim->stressCount && i < MAX_LASER_BOLTS; i++) {
+        spawnBolt(sim, FX(nextRandom(&sim->dropRng) % 800), -FX(nextRandom(&sim->dropRng) % 480));
+    }
+
+    // A pair from the paddle's ends every interval while the laser lasts
+    if (sim->boltCooldown > 0) sim->boltCooldown--;
+    if (sim->laserSteps > 0 && sim->boltCooldown == 0) {
+        int32_t top = FX(PADDLE_Y + PADDLE_HEIGHT / 2 + BOLT_HEIGHT / 2);
+        spawnBolt(sim, sim->paddleX - width / 2 + FX(6), top);
+        spawnBolt(sim, sim->paddleX + width / 2 - FX(6), top);
+        sim->boltCooldown = BOLT_INTERVAL_STEPS;
+    }
+
+    for (int i = 0; i < sim->capsuleCount; ) {
+        Capsule* capsule = &sim->capsules[i];
+        capsule->y -= CAPSULE_FALL_SPEED;
+
+        int caught = overlaps(capsule->x, capsule->y, CAPSULE_WIDTH, CAPSULE_HEIGHT,
+                              sim->paddleX, FX(PADDLE_Y), width, FX(PADDLE_HEIGHT));
+        if (caught) {
+            multiBall += startEffect(sim, capsule->kind);
+        }
+        if (caught || capsule->y < -FX(CAPSULE_HEIGHT)) {
+            sim->capsules[i] = sim->capsules[--sim->capsuleCount];
+            continue;
+        }
+        i++;
+    }
+
+    for (int i = 0; i < sim->boltCount; ) {
+        LaserBolt* bolt = &sim->bolts[i];
+        bolt->y += BOLT_SPEED;
+
+        int target = -1;
+        if (laserHits < MAX_LASER_HITS) {
+            target = boltTarget(sim, bolt);
+        }
+        if (target >= 0) {
+            // A bolt takes one step of health, with no chance of more
+            Brick* brick = &sim->bricks[target];
+            brick->health--;
+            if (brick->health <= 0) {
+                brick->isActive = 0;
+                brickBroken(sim, brick);
+            }
+            addHit(events, target, !brick->isActive, bolt->x, bolt->y + FX(BOLT_HEIGHT) / 2);
+            laserHits++;
+        }
+        if (target >= 0 || bolt->y > FX(480 + BOLT_HEIGHT)) {
+            sim->bolts[i] = sim->bolts[--sim->boltCount];
+            continue;
+        }
+        i++;
+    }
+    return multiBall;
+}
+
+static int allBricksCleared(const SimState* sim) {
+    for (int i = 0; i < BRICK_COUNT; i++) {
+        if (sim->bricks[i].isActive) return 0;
+    }
+    return 1;
+}
+
+void simAdvance(SimState* sim, uint32_t input, SimEvents* events) {
+    simMove(sim, input, events);
+    simCollide(sim, events);
+}
+
+void simMove(SimState* sim, uint32_t input, SimEvents* events) {
+    events->hitCount = 0;
+    events->levelCleared = 0;
+    sim->frame++;
+
+    // Update ball positions based on velocity; the main ball always
+    // bounces, extra balls are lost out the bottom
+    int32_t ballStep = sim->slowSteps > 0 ? fxMul(SIM_STEP_UNITS, SLOW_SPEED) : SIM_STEP_UNITS;
+    moveBall(&sim->ball, ballStep, 1);
+    for (int i = 0; i < sim->extraBallCount; ) {
+        if (!moveBall(&sim->extraBalls[i], ballStep, 0)) {
+            sim->extraBalls[i] = sim->extraBalls[--sim->extraBallCount];
+            continue;
+        }
+        i++;
+    }
+
+    // Move the paddle based on user input
+    if (input & INPUT_LEFT) {
+        sim->paddleX -= PADDLE_SPEED * SIM_STEP_UNITS;
+    }
+    if (input & INPUT_RIGHT) {
+        sim->paddleX += PADDLE_SPEED * SIM_STEP_UNITS;
+    }
+
+    // Keep the paddle within the window bounds
+    int32_t width = paddleWidth(sim);
+    if (sim->paddleX - width / 2 < 0) {
+        sim->paddleX = width / 2;
+    }
+    if (sim->paddleX + width / 2 > FX(PLAYFIELD_WIDTH)) {
+        sim->paddleX = FX(PLAYFIELD_WIDTH) - width / 2;
+    }
+}
+
+void simCollide(SimState* sim, SimEvents* events) {
+    int32_t width = paddleWidth(sim);
+    collideBall(sim, &sim->ball, width, events);
+    for (int i = 0; i < sim->extraBallCount; i++) {
+        collideBall(sim, &sim->extraBalls[i], width, events);
+    }
+
+    // Capsules, bolts and their effects; each multi-ball catch splits two
+    // more balls off the main one
+    int multiBall = updatePowerUps(sim, width, events);
+    for (int i = 0; i < multiBall * 2 && sim->extraBallCount < MAX_EXTRA_BALLS; i++) {
+        SimBall* extra = &sim->extraBalls[sim->extraBallCount++];
+        *extra = sim->ball;
+        if (i % 2 == 0) {
+            extra->vx = -sim->ball.vx;
+        } else {
+            extra->vx = sim->ball.vx / 2;
+            extra->vy = sim->ball.vy > 0 ? FX(2) : -FX(2);
+        }
+    }
+
+    // An empty field for a moment, then the next level's bricks
+    if (sim->levelClearSteps < 0 && allBricksCleared(sim)) {
+        sim->levelClearSteps = 0;
+        events->levelCleared = 1;
+    } else if (sim->levelClearSteps >= 0 && ++sim->levelClearSteps >= LEVEL_CLEAR_STEPS) {
+        sim->level++;
+        sim->levelClearSteps = -1;
+        layoutBricks(sim);
+        fileBricks(sim);
+    }
+}
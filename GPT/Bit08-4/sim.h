@@ -0,0 +1,165 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+
+// The game's rules, apart from SDL and GL: balls, paddle, bricks, the
+// pause between levels, and the power-up capsules and laser bolts.
+// Everything a step reads and writes is one SimState of fixed-size
+// fields with no pointers, so the simulation thread hands the renderer a
+// copy of it after every step (main.c). The state counts levels; which
+// art a level gets is up to the renderer.
+//
+// A broken brick drops a capsule one time in POWERUP_DROP_ODDS; it falls,
+// and catching it with the paddle starts its effect. Capsules and bolts
+// sit in fixed pools kept packed (a dead one is swapped with the last),
+// so nothing is allocated while playing, and balls and bolts find their
+// bricks through the broadphase grid (broadphase.h) rather than testing
+// every brick. --powerup-stress N keeps N capsules and N bolts in flight,
+// for checking the frame budget with --profile.
+//
+// Positions and speeds are 16.16 fixed point and the effect timers count
+// steps, so a seed and an input sequence give the same states bit for
+// bit on x86 and ARM, whatever the compiler; simcheck.c compares the
+// hashes. The broadphase still works in floats, but it's only ever asked
+// about whole pixels, which floats hold exactly. SDL_API_BRICK/07's
+// simulation works the same way.
+
+#define FX_SHIFT 16
+#define FX_ONE (1 << FX_SHIFT)
+#define FX(n) ((int32_t)(n) * FX_ONE)
+
+// Whole part, rounded down. Dividing after clearing the fraction is exact,
+// where a right shift of a negative number is up to the compiler.
+static inline int32_t fxFloor(int32_t value) {
+    return (value - (value & (FX_ONE - 1))) / FX_ONE;
+}
+
+// For drawing only; nothing in the simulation goes back through a float
+static inline float fxToFloat(int32_t value) {
+    return value / (float)FX_ONE;
+}
+
+#define SIM_HZ 60
+#define SIM_STEP_UNITS (FX(100) / SIM_HZ)  // A step in the 10 ms units speeds are given in, 16.16
+#define PLAYFIELD_WIDTH 800
+#define PLAYFIELD_HEIGHT 480
+
+#define BRICK_ROWS 6
+#define BRICK_COLS 10
+#define BRICK_COUNT (BRICK_ROWS * BRICK_COLS)
+// Sizes in whole pixels
+#define BRICK_WIDTH 79
+#define BRICK_HEIGHT 34
+#define BALL_RADIUS 15
+#define PADDLE_WIDTH 100
+#define PADDLE_HEIGHT 20
+#define PADDLE_Y 40
+#define PADDLE_SPEED 15                    // Pixels per 10 ms
+#define MAX_EXTRA_BALLS 16                 // Multi-ball pool, on top of the main ball
+#define LEVEL_CLEAR_STEPS (SIM_HZ * 3 / 2) // Empty field between levels
+
+#define MAX_CAPSULES 512
+#define MAX_LASER_BOLTS 512
+#define MAX_LASER_HITS 64                  // Per step; more bolts wait a step
+#define SIM_MAX_HITS (MAX_LASER_HITS + 64) // Ball and bolt hits reported per step
+#define POWERUP_DROP_ODDS 5
+#define CAPSULE_WIDTH 36
+#define CAPSULE_HEIGHT 21
+#define BOLT_WIDTH 4
+#define BOLT_HEIGHT 14
+
+typedef enum {
+    POWERUP_WIDE,        // Wider paddle for a while
+    POWERUP_MULTIBALL,   // Two more balls
+    POWERUP_SLOW,        // Slower balls for a while
+    POWERUP_LASER,       // The paddle fires bolts for a while
+    POWERUP_KIND_COUNT
+} PowerUpKind;
+
+// Input bits for simAdvance
+#define INPUT_LEFT 1
+#define INPUT_RIGHT 2
+
+// Every field is 32 bits, so SimState has no padding for simHash to trip on
+typedef struct {
+    int32_t x, y;       // Position of the ball, 16.16
+    int32_t vx, vy;     // Velocity of the ball, 16.16 pixels per 10 ms
+} SimBall;
+
+// Positions are centres, like the sprites'
+typedef struct {
+    int32_t x, y;       // Position of the brick, 16.16
+    int32_t isActive;   // Whether the brick is still active (not hit)
+    int32_t health;     // Brick health (3 = full, 2 = cracked, 1 = more cracked)
+} Brick;
+
+typedef struct {
+    int32_t x, y;       // Position of the capsule, 16.16
+    int32_t kind;       // A PowerUpKind
+} Capsule;
+
+typedef struct {
+    int32_t x, y;       // Position of the bolt, 16.16
+} LaserBolt;
+
+// A brick hit by a ball or a bolt, for the particles
+typedef struct {
+    int brick;          // Index into SimState.bricks
+    int broken;
+    int x, y;           // Where the hit landed, whole pixels
+} SimHit;
+
+typedef struct {
+    int hitCount;
+    SimHit hits[SIM_MAX_HITS];
+    int levelCleared;   // The last brick of the level went this step
+} SimEvents;
+
+typedef struct {
+    SimBall ball;                       // Always bounces
+    SimBall extraBalls[MAX_EXTRA_BALLS];// Lost out the bottom
+    int32_t extraBallCount;
+    int32_t paddleX;                    // Centre, 16.16
+    Brick bricks[BRICK_COUNT];
+    int32_t level;
+    int32_t levelClearSteps;            // Steps since the level was cleared, -1 while bricks stand
+
+    Capsule capsules[MAX_CAPSULES];
+    int32_t capsuleCount;
+    LaserBolt bolts[MAX_LASER_BOLTS];
+    int32_t boltCount;
+    int32_t wideSteps;                  // Steps left of each effect
+    int32_t slowSteps;
+    int32_t laserSteps;
+    int32_t boltCooldown;               // Steps until the next pair of bolts
+    int32_t stressCount;                // --powerup-stress
+
+    uint32_t rng;                       // xorshift32, brick double breaks
+    uint32_t dropRng;                   // Capsule drops, with a stream of their own
+    uint32_t frame;                     // Steps since simInit
+} SimState;
+
+// The first level, with the random generator seeded (0 is replaced)
+void simInit(SimState* sim, uint32_t seed);
+
+// One fixed step. Bricks the balls and bolts hit are reported in events.
+// It's simMove then simCollide, which main.c calls apart so the profiler
+// can time collision on its own.
+void simAdvance(SimState* sim, uint32_t input, SimEvents* events);
+
+// The first half of a step: the balls move and bounce off the walls, and
+// the paddle moves. Clears events.
+void simMove(SimState* sim, uint32_t input, SimEvents* events);
+
+// The second half: ball hits on the paddle and bricks, the capsules and
+// bolts, multi-ball and the level clear
+void simCollide(SimState* sim, SimEvents* events);
+
+// Current paddle width multiplier, for drawing
+float simPaddleScale(const SimState* sim);
+
+// FNV-1a over the state bytes, so x86 and ARM runs can be compared
+uint32_t simHash(const SimState* sim);
+
+#endif // SIM_H
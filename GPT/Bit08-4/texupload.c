@@ -0,0 +1,209 @@
+#include "texupload.h"
+#include "glstate.h"
+#include "startup.h"
+#include "trace.h"
+#include <SDL2/SDL_image.h>
+#include <stdio.h>
+
+typedef struct {
+    GLuint textureID;
+    char filePath[TEXTURE_UPLOAD_MAX_PATH];
+    SDL_Surface* pixels;    // RGBA32, so rows are width * 4 bytes; NULL if decoding failed
+    SDL_atomic_t decoded;   // Set by the decoder once pixels is filled in
+    int rowsDone;           // -1 until storage has been allocated
+} PendingUpload;
+
+// A ring, decoded and uploaded oldest first. The decoder thread takes the
+// slots in the same order the game fills them, one wake per slot.
+static PendingUpload pending[TEXTURE_UPLOAD_MAX_PENDING];
+static int pendingHead = 0;
+static int pendingCount = 0;
+static size_t budget = TEXTURE_UPLOAD_DEFAULT_BUDGET;
+
+static SDL_Thread* decoder = NULL;
+static SDL_sem* queuedDecodes = NULL;
+static SDL_atomic_t stopping;
+static int nextDecode = 0;          // Decoder thread only
+static int decoderFailed = 0;       // Decode on the game thread instead
+
+void textureUploadSetBudget(size_t bytesPerFrame) {
+    budget = bytesPerFrame;
+}
+
+static void decode(PendingUpload* upload) {
+    TRACE_ZONE_DETAIL("decodeTexture", upload->filePath);
+    upload->pixels = NULL;
+    SDL_Surface* surface = IMG_Load(upload->filePath);
+    if (!surface) {
+        printf("Error: Unable to load image %s! SDL_image Error: %s\n", upload->filePath, IMG_GetError());
+    } else {
+        upload->pixels = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA32, 0);
+        SDL_FreeSurface(surface);
+        if (!upload->pixels) {
+            printf("Error: Unable to convert image %s! SDL Error: %s\n", upload->filePath, SDL_GetError());
+        }
+    }
+
+    // The pixels have to be visible before the flag is
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&upload->decoded, 1);
+}
+
+static int decoderMain(void* data) {
+    (void)data;
+    traceThreadName("texture decode");
+
+    // One wake per queued image, and one more from textureUploadCleanup
+    for (;;) {
+        SDL_SemWait(queuedDecodes);
+        if (SDL_AtomicGet(&stopping)) {
+            break;
+        }
+        decode(&pending[nextDecode]);
+        nextDecode = (nextDecode + 1) % TEXTURE_UPLOAD_MAX_PENDING;
+    }
+    return 0;
+}
+
+static int startDecoder(void) {
+    SDL_AtomicSet(&stopping, 0);
+    queuedDecodes = SDL_CreateSemaphore(0);
+    if (queuedDecodes != NULL) {
+        decoder = SDL_CreateThread(decoderMain, "texture decode", NULL);
+    }
+    if (decoder == NULL) {
+        printf("Can't start the texture decode thread, decoding inline: %s\n", SDL_GetError());
+        decoderFailed = 1;
+        return 0;
+    }
+    return 1;
+}
+
+GLuint textureUploadQueue(const char* filePath) {
+    TRACE_ZONE_DETAIL("textureUploadQueue", filePath);
+    if (pendingCount == TEXTURE_UPLOAD_MAX_PENDING) {
+        printf("Error: texture upload queue full, can't queue %s\n", filePath);
+        return 0;
+    }
+
+    PendingUpload* upload = &pending[(pendingHead + pendingCount) % TEXTURE_UPLOAD_MAX_PENDING];
+    glGenTextures(1, &upload->textureID);
+    snprintf(upload->filePath, sizeof(upload->filePath), "%s", filePath);
+    upload->pixels = NULL;
+    upload->rowsDone = -1;
+    SDL_AtomicSet(&upload->decoded, 0);
+    pendingCount++;
+
+    if (decoder != NULL || (!decoderFailed && startDecoder())) {
+        SDL_SemPost(queuedDecodes);
+    } else {
+        decode(upload);
+    }
+    return upload->textureID;
+}
+
+// Uploads rows of the oldest image until it's done or the byte allowance
+// runs out; returns the bytes moved
+static size_t uploadStrip(PendingUpload* upload, size_t allowance) {
+    SDL_Surface* image = upload->pixels;
+    size_t rowBytes = (size_t)image->w * 4;
+    int rows = image->h - (upload->rowsDone < 0 ? 0 : upload->rowsDone);
+    if ((size_t)rows * rowBytes > allowance) {
+        rows = (int)(allowance / rowBytes);
+        if (rows == 0) rows = 1;
+    }
+
+    glStateBindTexture(GL_TEXTURE_2D, upload->textureID);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    if (upload->rowsDone < 0 && rows == image->h) {
+        // The whole image fits, so one call allocates and fills it
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image->w, image->h, 0, GL_RGBA, GL_UNSIGNED_BYTE, image->pixels);
+        upload->rowsDone = image->h;
+    } else {
+        if (upload->rowsDone < 0) {
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image->w, image->h, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+            upload->rowsDone = 0;
+        }
+        const Uint8* strip = (const Uint8*)image->pixels + (size_t)upload->rowsDone * image->pitch;
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, upload->rowsDone, image->w, rows, GL_RGBA, GL_UNSIGNED_BYTE, strip);
+        upload->rowsDone += rows;
+    }
+    return (size_t)rows * rowBytes;
+}
+
+static void finishOldest(void) {
+    PendingUpload* upload = &pending[pendingHead];
+    if (upload->pixels != NULL) {
+        SDL_FreeSurface(upload->pixels);
+        upload->pixels = NULL;
+        startupBenchMark(upload->filePath);
+    }
+    pendingHead = (pendingHead + 1) % TEXTURE_UPLOAD_MAX_PENDING;
+    pendingCount--;
+}
+
+// With wait clear, stops at the first image still being decoded, so the
+// frame never waits on the decoder
+static void pump(size_t allowance, int wait) {
+    size_t moved = 0;
+    while (pendingCount > 0 && (moved == 0 || moved < allowance)) {
+        PendingUpload* upload = &pending[pendingHead];
+        if (!SDL_AtomicGet(&upload->decoded)) {
+            if (!wait) break;
+            SDL_Delay(1);
+            continue;
+        }
+        SDL_MemoryBarrierAcquire();
+
+        // An image that failed to decode keeps its name with no storage
+        if (upload->pixels == NULL) {
+            finishOldest();
+            continue;
+        }
+        moved += uploadStrip(upload, allowance > moved ? allowance - moved : 0);
+        if (upload->rowsDone == upload->pixels->h) {
+            finishOldest();
+        }
+    }
+}
+
+void textureUploadPump(void) {
+    if (pendingCount == 0) return;
+    TRACE_ZONE("textureUploadPump");
+    pump(budget, 0);
+}
+
+void textureUploadFlush(void) {
+    pump((size_t)-1, 1);
+}
+
+int textureUploadPending(void) {
+    return pendingCount;
+}
+
+void textureUploadCleanup(void) {
+    if (decoder != NULL) {
+        SDL_AtomicSet(&stopping, 1);
+        SDL_SemPost(queuedDecodes);
+        SDL_WaitThread(decoder, NULL);
+        decoder = NULL;
+    }
+    if (queuedDecodes != NULL) {
+        SDL_DestroySemaphore(queuedDecodes);
+        queuedDecodes = NULL;
+    }
+
+    // Whatever was still queued is dropped, decoded or not
+    for (; pendingCount > 0; pendingCount--) {
+        PendingUpload* upload = &pending[pendingHead];
+        if (SDL_AtomicGet(&upload->decoded) && upload->pixels != NULL) {
+            SDL_FreeSurface(upload->pixels);
+        }
+        upload->pixels = NULL;
+        pendingHead = (pendingHead + 1) % TEXTURE_UPLOAD_MAX_PENDING;
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef TEXUPLOAD_H
+#define TEXUPLOAD_H
+
+#include <GL/glew.h>
+#include <stddef.h>
+
+// Budgeted texture uploads. textureUploadQueue hands back a texture name
+// straight away and passes the file to a decoder thread, so the PNG decode
+// and format conversion never land on a frame. The pixels only reach GL
+// from textureUploadPump, which moves at most a byte budget per call, of
+// images the decoder has finished: small images go up whole with
+// glTexImage2D, and an image bigger than what's left of the budget goes
+// up in row strips with glTexSubImage2D, carrying on next frame. Queue
+// the next level's art well ahead of the level clear and the transition
+// never has a frame that decodes or uploads it all.
+
+#define TEXTURE_UPLOAD_MAX_PENDING 64
+#define TEXTURE_UPLOAD_MAX_PATH 128
+#define TEXTURE_UPLOAD_DEFAULT_BUDGET (256 * 1024)  // Bytes per frame
+
+void textureUploadSetBudget(size_t bytesPerFrame);
+
+// Returns the texture name, or 0 if the queue is full. The texture has no
+// storage until its upload starts, and none at all if the image can't be
+// decoded.
+GLuint textureUploadQueue(const char* filePath);
+
+// Uploads up to the budget (at least one strip, so a tiny budget still
+// makes progress) without waiting on the decoder; call once per frame
+void textureUploadPump(void);
+
+// Waits for the decoder and uploads everything queued regardless of the
+// budget, e.g. at startup
+void textureUploadFlush(void);
+
+int textureUploadPending(void);  // Images not fully uploaded yet
+
+// Stops the decoder thread and drops anything still queued
+void textureUploadCleanup(void);
+
+#endif // TEXUPLOAD_H
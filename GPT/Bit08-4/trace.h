@@ -0,0 +1,58 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+// Scoped profiling zones, written out in Chrome trace-event format for
+// chrome://tracing or Perfetto. Zones only exist when the build defines
+// TRACE_ENABLED (make TRACE=1); otherwise TRACE_ZONE compiles to
+// nothing.
+//
+//     void loadLevel() {
+//         TRACE_ZONE("loadLevel");
+//         ...
+//     }   // zone ends when the enclosing block exits
+
+#ifdef TRACE_ENABLED
+
+#include <SDL2/SDL.h>
+
+#define TRACE_MAX_THREADS 8
+#define TRACE_EVENTS_PER_THREAD 32768
+#define TRACE_DETAIL_SIZE 40    // Longer details are cut short
+
+typedef struct {
+    const char* name;     // Must outlive the trace (string literals)
+    Uint64 start;
+    char detail[TRACE_DETAIL_SIZE];   // Copied, so any string will do; "" for none
+} TraceZone;
+
+bool traceInit(const char* path);
+void traceThreadName(const char* name);
+TraceZone traceZoneBegin(const char* name, const char* detail);
+void traceZoneEnd(TraceZone* zone);
+void traceShutdown(void);
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_ZONE_DETAIL(name, detail) \
+    TraceZone TRACE_CONCAT(traceZone, __LINE__) \
+        __attribute__((cleanup(traceZoneEnd))) = traceZoneBegin(name, detail)
+#define TRACE_ZONE(name) TRACE_ZONE_DETAIL(name, NULL)
+
+#else
+
+#define TRACE_ZONE(name) do {} while (0)
+#define TRACE_ZONE_DETAIL(name, detail) do {} while (0)
+#define traceThreadName(name) do {} while (0)
+#define traceShutdown() do {} while (0)
+
+static inline bool traceInit(const char* path) {
+    printf("Built without TRACE_ENABLED, not writing %s\n", path);
+    return false;
+}
+
+#endif // TRACE_ENABLED
+
+#endif // TRACE_H
@@ -1,5 +1,8 @@
 #include "utils.h"
+#include "trace.h"
 #include <SDL2/SDL_image.h>
+#include "glstate.h"
+#include "startup.h"
 #include <stdio.h>
 
 void createOrthoProjectionMatrix(float* matrix, float width, float height) {
@@ -32,6 +35,7 @@ void createOrthoProjectionMatrix(float* matrix, float width, float height) {
 }
 
 GLuint loadTexture(const char* filePath) {
+    TRACE_ZONE_DETAIL("loadTexture", filePath);
     SDL_Surface* surface = IMG_Load(filePath);
     if (!surface) {
         printf("Error: Unable to load image %s! SDL_image Error: %s\n", filePath, IMG_GetError());
@@ -40,7 +44,7 @@ GLuint loadTexture(const char* filePath) {
 
     GLuint textureID;
     glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_2D, textureID);
+    glStateBindTexture(GL_TEXTURE_2D, textureID);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -48,10 +52,12 @@ GLuint loadTexture(const char* filePath) {
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, surface->w, surface->h, 0, GL_RGBA, GL_UNSIGNED_BYTE, surface->pixels);
 
     SDL_FreeSurface(surface);
+    startupBenchMark(filePath);
     return textureID;
 }
 
 GLuint compileShader(GLenum type, const GLchar* source) {
+    TRACE_ZONE_DETAIL("compileShader", type == GL_VERTEX_SHADER ? "vertex" : "fragment");
     GLuint shader = glCreateShader(type);
     glShaderSource(shader, 1, &source, NULL);
     glCompileShader(shader);
@@ -69,6 +75,7 @@ GLuint compileShader(GLenum type, const GLchar* source) {
 }
 
 GLuint createShaderProgram() {
+    TRACE_ZONE("createShaderProgram");
     const GLchar* vertexShaderSource = R"(
         attribute vec4 position;
         attribute vec2 texCoord;
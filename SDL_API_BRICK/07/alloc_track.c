@@ -0,0 +1,138 @@
+#include "alloc_track.h"
+
+#ifdef ALLOC_TRACK
+
+#include <SDL2/SDL.h>
+#include <execinfo.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// glibc's own allocator entry points, so the wrappers below don't need
+// dlsym (which allocates) to find the real functions
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t count, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+extern void __libc_free(void* ptr);
+
+static __thread bool watched = false;
+static __thread bool in_hook = false;   // Backtraces may allocate themselves
+
+static AllocCheckMode check_mode = ALLOC_CHECK_LOG;
+static bool initialized = false;
+static SDL_atomic_t armed;              // Set once play has warmed up
+static SDL_atomic_t frame_count;        // Allocations this frame
+static SDL_atomic_t frame_bytes;
+static SDL_atomic_t steady_count;       // Allocations after warm-up
+static SDL_atomic_t backtraces_logged;  // From the main and simulation threads
+
+// Main thread only
+static int playing_frames = 0;
+static int last_count = 0;
+static size_t last_bytes = 0;
+static int frames_tracked = 0;
+static int worst_count = 0;
+static size_t worst_bytes = 0;
+
+static void report_steady_allocation(size_t size) {
+    in_hook = true;
+    SDL_AtomicAdd(&steady_count, 1);
+
+    // stdio may allocate, so write straight to stderr. SDL_AtomicAdd hands
+    // each thread its own slot, so the cap holds with both logging at once.
+    if (SDL_AtomicAdd(&backtraces_logged, 1) < ALLOC_TRACK_MAX_BACKTRACES || check_mode == ALLOC_CHECK_ABORT) {
+        char line[96];
+        int length = snprintf(line, sizeof(line), "Allocated %zu bytes while playing:\n", size);
+        if (write(STDERR_FILENO, line, length) < 0) {
+            // Nothing else to report to
+        }
+        void* frames[32];
+        int depth = backtrace(frames, 32);
+        backtrace_symbols_fd(frames, depth, STDERR_FILENO);
+    }
+    in_hook = false;
+
+    if (check_mode == ALLOC_CHECK_ABORT) {
+        abort();
+    }
+}
+
+static void note_allocation(size_t size) {
+    if (!watched || in_hook) return;
+
+    SDL_AtomicAdd(&frame_count, 1);
+    SDL_AtomicAdd(&frame_bytes, (int)size);
+    if (SDL_AtomicGet(&armed)) {
+        report_steady_allocation(size);
+    }
+}
+
+void* malloc(size_t size) {
+    note_allocation(size);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+    note_allocation(count * size);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+    if (size > 0) {
+        note_allocation(size);
+    }
+    return __libc_realloc(ptr, size);
+}
+
+void free(void* ptr) {
+    __libc_free(ptr);
+}
+
+void alloc_track_init(AllocCheckMode mode) {
+    check_mode = mode;
+    initialized = true;
+
+    // The first backtrace loads libgcc, which allocates; get that over with
+    void* frames[4];
+    backtrace(frames, 4);
+    printf("Checking for allocations after %d frames of play (%s)\n",
+           ALLOC_TRACK_WARMUP_FRAMES, mode == ALLOC_CHECK_ABORT ? "abort" : "log");
+}
+
+void alloc_track_watch_thread(void) {
+    watched = initialized;
+}
+
+void alloc_track_frame_end(bool playing) {
+    if (!initialized) return;
+
+    // SDL_AtomicSet hands back the old value, so nothing is lost in between
+    last_count = SDL_AtomicSet(&frame_count, 0);
+    last_bytes = (size_t)(unsigned)SDL_AtomicSet(&frame_bytes, 0);
+
+    if (playing) {
+        playing_frames++;
+        frames_tracked++;
+        if (last_count > worst_count) {
+            worst_count = last_count;
+            worst_bytes = last_bytes;
+        }
+    } else {
+        playing_frames = 0;
+    }
+    SDL_AtomicSet(&armed, playing_frames >= ALLOC_TRACK_WARMUP_FRAMES);
+}
+
+void alloc_track_last_frame(int* count, size_t* bytes) {
+    *count = last_count;
+    *bytes = last_bytes;
+}
+
+void alloc_track_report(void) {
+    if (!initialized) return;
+
+    printf("Allocation check: %d playing frames, worst frame %d allocations (%zu bytes), "
+           "%d allocations after warm-up\n",
+           frames_tracked, worst_count, worst_bytes, SDL_AtomicGet(&steady_count));
+}
+
+#endif // ALLOC_TRACK
@@ -0,0 +1,51 @@
+#ifndef ALLOC_TRACK_H
+#define ALLOC_TRACK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+// Allocation tracker for holding the game loop to zero heap allocations.
+// Only exists when the build defines ALLOC_TRACK (ALLOC_TRACK=1 ./make.sh),
+// which replaces malloc/calloc/realloc/free with wrappers around glibc's
+// __libc_* functions. Calls and bytes are counted per frame on the watched
+// threads (render and simulation; the audio callback and driver threads
+// are left alone). Once the game has presented ALLOC_TRACK_WARMUP_FRAMES
+// frames in a row while playing, every allocation on a watched thread is
+// logged with a backtrace, or aborts with ALLOC_CHECK_ABORT.
+
+#define ALLOC_TRACK_WARMUP_FRAMES 120
+#define ALLOC_TRACK_MAX_BACKTRACES 16   // Later hits are only counted
+
+typedef enum {
+    ALLOC_CHECK_LOG,
+    ALLOC_CHECK_ABORT
+} AllocCheckMode;
+
+#ifdef ALLOC_TRACK
+
+void alloc_track_init(AllocCheckMode mode);
+void alloc_track_watch_thread(void);
+void alloc_track_frame_end(bool playing);
+void alloc_track_last_frame(int* count, size_t* bytes);
+void alloc_track_report(void);
+
+#else
+
+#define alloc_track_watch_thread() do {} while (0)
+#define alloc_track_frame_end(playing) do {} while (0)
+#define alloc_track_report() do {} while (0)
+
+static inline void alloc_track_init(AllocCheckMode mode) {
+    (void)mode;
+    printf("Built without ALLOC_TRACK, allocations are not checked\n");
+}
+
+static inline void alloc_track_last_frame(int* count, size_t* bytes) {
+    *count = 0;
+    *bytes = 0;
+}
+
+#endif // ALLOC_TRACK
+
+#endif // ALLOC_TRACK_H
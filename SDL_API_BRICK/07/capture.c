@@ -0,0 +1,184 @@
+#include "capture.h"
+#include <SDL2/SDL_image.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef enum {
+    CAPTURE_PRESS,
+    CAPTURE_RELEASE,
+    CAPTURE_FRAME,
+    CAPTURE_QUIT
+} CaptureAction;
+
+typedef struct {
+    int frame;
+    CaptureAction action;
+    char key[CAPTURE_KEY_NAME_LENGTH];
+} CaptureEvent;
+
+static CaptureEvent events[CAPTURE_MAX_EVENTS];
+static int event_count = 0;
+static int next_event = 0;          // First event not yet reached
+static int frame = 0;               // Current frame, 0 before the first
+static unsigned seed = 1;
+static bool active = false;
+static const char* output = NULL;
+
+static Uint32* pixels = NULL;       // Readback buffer, sized on first use
+static int pixels_size = 0;
+static int frames_written = 0;
+
+bool capture_load(const char* script_path, const char* output_dir) {
+    FILE* file = fopen(script_path, "r");
+    if (file == NULL) {
+        printf("Can't open capture script %s\n", script_path);
+        return false;
+    }
+
+    char line[128];
+    int line_number = 0;
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), file) != NULL) {
+        line_number++;
+        line[strcspn(line, "\r\n")] = '\0';
+        char* comment = strchr(line, '#');
+        if (comment != NULL) *comment = '\0';
+
+        char word[16];
+        char key[CAPTURE_KEY_NAME_LENGTH] = "";
+        int at;
+        unsigned value;
+        if (sscanf(line, " %15s", word) != 1) {
+            continue;
+        }
+        if (strcmp(word, "seed") == 0 && sscanf(line, " seed %u", &value) == 1) {
+            seed = value;
+            continue;
+        }
+
+        int fields = sscanf(line, " %d %15s %23s", &at, word, key);
+        CaptureEvent event = {at, CAPTURE_FRAME, ""};
+        if (fields == 3 && strcmp(word, "press") == 0) {
+            event.action = CAPTURE_PRESS;
+        } else if (fields == 3 && strcmp(word, "release") == 0) {
+            event.action = CAPTURE_RELEASE;
+        } else if (fields == 2 && strcmp(word, "capture") == 0) {
+            event.action = CAPTURE_FRAME;
+        } else if (fields == 2 && strcmp(word, "quit") == 0) {
+            event.action = CAPTURE_QUIT;
+        } else {
+            printf("%s:%d: can't parse \"%s\"\n", script_path, line_number, line);
+            ok = false;
+            break;
+        }
+        if (at < 1 || (event_count > 0 && at < events[event_count - 1].frame)) {
+            printf("%s:%d: frames must start at 1 and never go back\n", script_path, line_number);
+            ok = false;
+        } else if (event_count == CAPTURE_MAX_EVENTS) {
+            printf("%s:%d: more than %d events\n", script_path, line_number, CAPTURE_MAX_EVENTS);
+            ok = false;
+        } else {
+            memcpy(event.key, key, sizeof(event.key));
+            events[event_count++] = event;
+        }
+    }
+    fclose(file);
+
+    output = output_dir;
+    active = ok;
+    return ok;
+}
+
+bool capture_active(void) {
+    return active;
+}
+
+unsigned capture_seed(void) {
+    return seed;
+}
+
+static void push_key(SDL_EventType type, const char* name) {
+    SDL_Keycode key = SDL_GetKeyFromName(name);
+    if (key == SDLK_UNKNOWN) {
+        printf("Capture script: unknown key \"%s\"\n", name);
+        return;
+    }
+
+    SDL_Event e = {0};
+    e.type = type;
+    e.key.state = type == SDL_KEYDOWN ? SDL_PRESSED : SDL_RELEASED;
+    e.key.keysym.sym = key;
+    e.key.keysym.scancode = SDL_GetScancodeFromKey(key);
+    SDL_PushEvent(&e);
+}
+
+bool capture_begin_frame(void) {
+    if (!active) return true;
+
+    frame++;
+    for (int i = next_event; i < event_count && events[i].frame == frame; i++) {
+        if (events[i].action == CAPTURE_PRESS) {
+            push_key(SDL_KEYDOWN, events[i].key);
+        } else if (events[i].action == CAPTURE_RELEASE) {
+            push_key(SDL_KEYUP, events[i].key);
+        } else if (events[i].action == CAPTURE_QUIT) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void capture_read_frame(SDL_Renderer* renderer) {
+    if (!active) return;
+
+    bool wanted = false;
+    while (next_event < event_count && events[next_event].frame <= frame) {
+        wanted |= events[next_event].frame == frame && events[next_event].action == CAPTURE_FRAME;
+        next_event++;
+    }
+    if (!wanted) return;
+
+    int width, height;
+    if (SDL_GetRendererOutputSize(renderer, &width, &height) != 0) {
+        printf("SDL_GetRendererOutputSize Error: %s\n", SDL_GetError());
+        return;
+    }
+    if (width * height > pixels_size) {
+        free(pixels);
+        pixels = malloc((size_t)width * height * sizeof(Uint32));
+        pixels_size = pixels != NULL ? width * height : 0;
+        if (pixels == NULL) return;
+    }
+
+    const int pitch = width * (int)sizeof(Uint32);
+    if (SDL_RenderReadPixels(renderer, NULL, SDL_PIXELFORMAT_ARGB8888, pixels, pitch) != 0) {
+        printf("SDL_RenderReadPixels Error: %s\n", SDL_GetError());
+        return;
+    }
+
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormatFrom(pixels, width, height, 32, pitch,
+                                                              SDL_PIXELFORMAT_ARGB8888);
+    if (surface == NULL) {
+        printf("SDL_CreateRGBSurfaceWithFormatFrom Error: %s\n", SDL_GetError());
+        return;
+    }
+    char path[512];
+    snprintf(path, sizeof(path), "%s/frame_%05d.png", output, frame);
+    if (IMG_SavePNG(surface, path) != 0) {
+        printf("IMG_SavePNG Error for %s: %s\n", path, IMG_GetError());
+    } else {
+        frames_written++;
+    }
+    SDL_FreeSurface(surface);
+}
+
+void capture_shutdown(void) {
+    if (!active) return;
+
+    printf("Captured %d frames to %s over %d frames\n", frames_written, output, frame);
+    free(pixels);
+    pixels = NULL;
+    pixels_size = 0;
+    active = false;
+}
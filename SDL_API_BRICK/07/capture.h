@@ -0,0 +1,36 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+
+// Golden-frame capture for --capture <script> <dir>. The script fixes the
+// random seed and lists key presses by frame; the game then runs
+// single-threaded with one simulation step and one present per frame, so
+// a script always produces the same frames. The frames it asks for are
+// read back before the overlay is drawn and written to
+// <dir>/frame_NNNNN.png, for frame_diff to check against stored goldens.
+//
+// Script lines (# starts a comment, frames count from 1):
+//   seed <n>
+//   <frame> press <SDL key name>      e.g. "30 press 9", "90 press Left"
+//   <frame> release <SDL key name>
+//   <frame> capture
+//   <frame> quit
+
+#define CAPTURE_MAX_EVENTS 512
+#define CAPTURE_KEY_NAME_LENGTH 24
+
+bool capture_load(const char* script_path, const char* output_dir);
+bool capture_active(void);
+unsigned capture_seed(void);
+
+// Starts the next frame: pushes its key events and returns false once the
+// script's quit frame is reached
+bool capture_begin_frame(void);
+
+// Call after the frame is drawn, before the overlay and the present
+void capture_read_frame(SDL_Renderer* renderer);
+void capture_shutdown(void);
+
+#endif // CAPTURE_H
@@ -0,0 +1,210 @@
+#include "dyn_res.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define OVER_BUDGET 1.05    // Mean over target by this much scales down
+
+static DynResConfig config = {0.5f, 1.0f, 0.1f, 1000.0 / 60.0, 0.75, 30, 300, false};
+static bool enabled = false;
+
+static SDL_Texture* target = NULL;
+static int full_width, full_height;
+static int scaled_width, scaled_height;
+static float scale = 1.0f;
+static bool redirected = false;     // The current scene went to the target
+
+static double samples[DYN_RES_MAX_WINDOW];
+static int sample_count = 0;
+static int sample_head = 0;
+static double sample_sum = 0.0;
+static int frames_at_scale = 0;
+static int probe_wait;
+static bool probing = false;
+
+static bool parse_option(const char* key, const char* value) {
+    char* end;
+    double number = strtod(value, &end);
+    bool numeric = end != value && *end == '\0';
+
+    if (strcmp(key, "filter") == 0) {
+        if (strcmp(value, "linear") != 0 && strcmp(value, "nearest") != 0) return false;
+        config.linear = strcmp(value, "linear") == 0;
+    } else if (!numeric) {
+        return false;
+    } else if (strcmp(key, "min") == 0) {
+        config.min_scale = (float)number;
+    } else if (strcmp(key, "max") == 0) {
+        config.max_scale = (float)number;
+    } else if (strcmp(key, "step") == 0) {
+        config.step = (float)number;
+    } else if (strcmp(key, "target") == 0) {
+        config.target_ms = number;
+    } else if (strcmp(key, "headroom") == 0) {
+        config.headroom = number;
+    } else if (strcmp(key, "window") == 0) {
+        config.window = (int)number;
+    } else if (strcmp(key, "probe") == 0) {
+        config.probe_frames = (int)number;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool dyn_res_configure(const char* spec) {
+    enabled = true;
+    if (spec != NULL) {
+        char options[256];
+        snprintf(options, sizeof(options), "%s", spec);
+        for (char* option = strtok(options, ","); option != NULL; option = strtok(NULL, ",")) {
+            char* value = strchr(option, '=');
+            if (value == NULL) {
+                printf("dyn_res: expected key=value, got %s\n", option);
+                return false;
+            }
+            *value++ = '\0';
+            if (!parse_option(option, value)) {
+                printf("dyn_res: bad option %s=%s\n", option, value);
+                return false;
+            }
+        }
+    }
+
+    if (config.min_scale <= 0.0f || config.min_scale > config.max_scale || config.max_scale > 1.0f ||
+        config.step <= 0.0f || config.target_ms <= 0.0 || config.headroom <= 0.0 || config.headroom >= 1.0 ||
+        config.window < 1 || config.window > DYN_RES_MAX_WINDOW || config.probe_frames < config.window) {
+        printf("dyn_res: need 0 < min <= max <= 1, step and target over 0, 0 < headroom < 1, "
+               "1 <= window <= %d and probe >= window\n", DYN_RES_MAX_WINDOW);
+        return false;
+    }
+    return true;
+}
+
+bool dyn_res_enabled(void) {
+    return enabled;
+}
+
+static void reset_samples(void) {
+    sample_count = 0;
+    sample_head = 0;
+    sample_sum = 0.0;
+    frames_at_scale = 0;
+}
+
+static void resize(float wanted) {
+    if (wanted < config.min_scale) wanted = config.min_scale;
+    if (wanted > config.max_scale) wanted = config.max_scale;
+    scale = wanted;
+    scaled_width = (int)(full_width * scale + 0.5f);
+    scaled_height = (int)(full_height * scale + 0.5f);
+    reset_samples();
+}
+
+bool dyn_res_init(SDL_Renderer* renderer, int width, int height) {
+    if (!enabled) return true;
+
+    // The filter is picked from the hint when a texture is created
+    const char* previous = SDL_GetHint(SDL_HINT_RENDER_SCALE_QUALITY);
+    SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, config.linear ? "linear" : "nearest");
+    target = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, width, height);
+    SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, previous != NULL ? previous : "nearest");
+    if (target == NULL) {
+        printf("dyn_res: no render target (%s), staying at native resolution\n", SDL_GetError());
+        return false;
+    }
+
+    full_width = width;
+    full_height = height;
+    probe_wait = config.probe_frames;
+    resize(config.max_scale);
+    printf("dyn_res %dx%d, scale %.2f to %.2f, target %.2f ms, %s filter\n", width, height,
+           config.min_scale, config.max_scale, config.target_ms, config.linear ? "linear" : "nearest");
+    return true;
+}
+
+float dyn_res_scale(void) {
+    return target != NULL ? scale : 1.0f;
+}
+
+void dyn_res_begin_scene(SDL_Renderer* renderer) {
+    // Full size draws straight to the window and skips the extra copy
+    redirected = target != NULL && (scaled_width != full_width || scaled_height != full_height);
+    if (!redirected) return;
+
+    SDL_SetRenderTarget(renderer, target);
+    // Setting a target resets the renderer scale, so this goes after it
+    SDL_RenderSetScale(renderer, (float)scaled_width / full_width, (float)scaled_height / full_height);
+}
+
+void dyn_res_end_scene(SDL_Renderer* renderer) {
+    if (!redirected) return;
+
+    SDL_SetRenderTarget(renderer, NULL);
+    SDL_Rect scene = {0, 0, scaled_width, scaled_height};
+    SDL_RenderCopy(renderer, target, &scene, NULL);
+    redirected = false;
+}
+
+static void change_scale(float wanted, double mean, const char* reason) {
+    if (wanted < config.min_scale) wanted = config.min_scale;
+    if (wanted > config.max_scale) wanted = config.max_scale;
+    if ((int)(full_width * wanted + 0.5f) == scaled_width && (int)(full_height * wanted + 0.5f) == scaled_height) {
+        return;
+    }
+
+    float from = scale;
+    resize(wanted);
+    printf("dyn_res %.2f -> %.2f (%dx%d), mean %.2f ms, target %.2f ms, %s\n",
+           from, scale, scaled_width, scaled_height, mean, config.target_ms, reason);
+    fflush(stdout);
+}
+
+void dyn_res_frame_end(double frame_ms) {
+    if (target == NULL) return;
+
+    if (sample_count == config.window) {
+        sample_sum -= samples[sample_head];
+    } else {
+        sample_count++;
+    }
+    samples[sample_head] = frame_ms;
+    sample_sum += frame_ms;
+    sample_head = (sample_head + 1) % config.window;
+    frames_at_scale++;
+
+    // Nothing is decided until a whole window has run at this scale
+    if (sample_count < config.window) return;
+    double mean = sample_sum / sample_count;
+
+    if (mean > config.target_ms * OVER_BUDGET) {
+        if (probing) {
+            probe_wait = probe_wait * 2 < DYN_RES_MAX_PROBE_FRAMES ? probe_wait * 2 : DYN_RES_MAX_PROBE_FRAMES;
+            probing = false;
+        }
+        // Fill cost goes with the area, so the side goes with its root
+        float wanted = scale * (float)sqrt(config.target_ms / mean);
+        change_scale(wanted < scale - config.step ? scale - config.step : wanted, mean, "over budget");
+        return;
+    }
+
+    if (probing) {
+        probing = false;
+        probe_wait = config.probe_frames;
+    }
+    if (scale >= config.max_scale) return;
+    if (mean < config.target_ms * config.headroom) {
+        change_scale(scale + config.step, mean, "headroom");
+    } else if (frames_at_scale >= probe_wait) {
+        probing = true;
+        change_scale(scale + config.step / 2, mean, "probe");
+    }
+}
+
+void dyn_res_cleanup(void) {
+    if (target != NULL) {
+        SDL_DestroyTexture(target);
+        target = NULL;
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef DYN_RES_H
+#define DYN_RES_H
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+
+// Dynamic resolution for --dynres. The playing scene is drawn into an
+// offscreen target at a fraction of the window size and stretched back
+// over the window; the HUD and overlay then go on top at native
+// resolution. A governor keeps a rolling mean of each frame's render and
+// present time and moves the fraction between min and max: down in
+// proportion to the overrun (fill cost goes with the area), up a step when
+// there's clear headroom, and up a probing half step after a long run on
+// budget, since with vsync on frames never look faster than the refresh.
+// A probe that drops back straight away doubles the wait before the next.
+// Every change is logged as a "dyn_res" line. The claude and GPT builds
+// carry the same governor.
+
+#define DYN_RES_MAX_WINDOW 240
+#define DYN_RES_MAX_PROBE_FRAMES 3600
+
+typedef struct {
+    float min_scale;     // Fraction of the window on each axis
+    float max_scale;
+    float step;          // Largest change per decision
+    double target_ms;    // Budget for render plus present
+    double headroom;     // Step up while the mean is under target * headroom
+    int window;          // Frames in the rolling mean, and held after a change
+    int probe_frames;    // Frames on budget before probing a step up
+    bool linear;         // Upscale filter; nearest keeps pixel art sharp
+} DynResConfig;
+
+// Takes "key=value,..." with keys min, max, step, target (ms), headroom,
+// window, probe and filter (nearest or linear); NULL or "" keeps the
+// defaults. Prints the problem and returns false on a bad spec.
+bool dyn_res_configure(const char* spec);
+bool dyn_res_enabled(void);
+
+// Creates the offscreen target; without render target support the game
+// carries on at native resolution
+bool dyn_res_init(SDL_Renderer* renderer, int width, int height);
+float dyn_res_scale(void);
+
+// Bracket the scene: between these, draws use window coordinates and land
+// in the scaled target. dyn_res_end_scene leaves the window as the target
+// with the upscaled scene on it.
+void dyn_res_begin_scene(SDL_Renderer* renderer);
+void dyn_res_end_scene(SDL_Renderer* renderer);
+
+// Feeds one frame's render plus present time to the governor
+void dyn_res_frame_end(double frame_ms);
+void dyn_res_cleanup(void);
+
+#endif // DYN_RES_H
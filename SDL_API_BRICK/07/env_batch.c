@@ -0,0 +1,231 @@
+#include "env_batch.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Below this the ball can't touch a brick
+#define BRICK_ZONE_BOTTOM (SCORE_HEIGHT + BRICK_ROWS * BRICK_HEIGHT)
+
+struct EnvBatch {
+    int count;
+    EnvObsMode mode;
+
+    // One entry per game in each; every game is always playing
+    uint64_t* brick_mask;
+    int32_t* ball_x;
+    int32_t* ball_y;
+    int32_t* ball_dx;
+    int32_t* ball_dy;
+    int32_t* paddle_x;
+    int32_t* score;
+    int32_t* lives;
+    int32_t* combo;
+    uint32_t* rng;
+    uint32_t* frame;
+    uint8_t* near;      // Scratch: needs sim_collide this step
+};
+
+static void load_game(const EnvBatch* batch, int i, SimState* sim) {
+    *sim = (SimState){
+        .brick_mask = batch->brick_mask[i],
+        .ball_x = batch->ball_x[i],
+        .ball_y = batch->ball_y[i],
+        .ball_dx = batch->ball_dx[i],
+        .ball_dy = batch->ball_dy[i],
+        .frame = batch->frame[i],
+        .rng = batch->rng[i],
+        .state = GAME_STATE_PLAYING,
+        .paddle_x = batch->paddle_x[i],
+        .score = batch->score[i],
+        .lives = batch->lives[i],
+        .combo = batch->combo[i]
+    };
+}
+
+static void store_game(EnvBatch* batch, int i, const SimState* sim) {
+    batch->brick_mask[i] = sim->brick_mask;
+    batch->ball_x[i] = sim->ball_x;
+    batch->ball_y[i] = sim->ball_y;
+    batch->ball_dx[i] = sim->ball_dx;
+    batch->ball_dy[i] = sim->ball_dy;
+    batch->frame[i] = sim->frame;
+    batch->rng[i] = sim->rng;
+    batch->paddle_x[i] = sim->paddle_x;
+    batch->score[i] = sim->score;
+    batch->lives[i] = sim->lives;
+    batch->combo[i] = sim->combo;
+}
+
+EnvBatch* env_batch_create(int count, uint32_t seed, EnvObsMode mode) {
+    if (count <= 0) {
+        return NULL;
+    }
+
+    EnvBatch* batch = calloc(1, sizeof(EnvBatch));
+    if (batch == NULL) {
+        return NULL;
+    }
+    batch->count = count;
+    batch->mode = mode;
+    batch->brick_mask = calloc(count, sizeof(uint64_t));
+    batch->ball_x = calloc(count, sizeof(int32_t));
+    batch->ball_y = calloc(count, sizeof(int32_t));
+    batch->ball_dx = calloc(count, sizeof(int32_t));
+    batch->ball_dy = calloc(count, sizeof(int32_t));
+    batch->paddle_x = calloc(count, sizeof(int32_t));
+    batch->score = calloc(count, sizeof(int32_t));
+    batch->lives = calloc(count, sizeof(int32_t));
+    batch->combo = calloc(count, sizeof(int32_t));
+    batch->rng = calloc(count, sizeof(uint32_t));
+    batch->frame = calloc(count, sizeof(uint32_t));
+    batch->near = calloc(count, sizeof(uint8_t));
+    if (batch->brick_mask == NULL || batch->ball_x == NULL || batch->ball_y == NULL ||
+        batch->ball_dx == NULL || batch->ball_dy == NULL || batch->paddle_x == NULL ||
+        batch->score == NULL || batch->lives == NULL || batch->combo == NULL ||
+        batch->rng == NULL || batch->frame == NULL || batch->near == NULL) {
+        env_batch_destroy(batch);
+        return NULL;
+    }
+
+    for (int i = 0; i < count; i++) {
+        SimState sim;
+        sim_init(&sim, seed ^ ((uint32_t)(i + 1) * 2654435761u));
+        sim_reset(&sim);
+        store_game(batch, i, &sim);
+    }
+    return batch;
+}
+
+void env_batch_destroy(EnvBatch* batch) {
+    if (batch == NULL) {
+        return;
+    }
+    free(batch->brick_mask);
+    free(batch->ball_x);
+    free(batch->ball_y);
+    free(batch->ball_dx);
+    free(batch->ball_dy);
+    free(batch->paddle_x);
+    free(batch->score);
+    free(batch->lives);
+    free(batch->combo);
+    free(batch->rng);
+    free(batch->frame);
+    free(batch->near);
+    free(batch);
+}
+
+int env_batch_count(const EnvBatch* batch) {
+    return batch->count;
+}
+
+int env_batch_obs_size(const EnvBatch* batch) {
+    return batch->mode == ENV_OBS_FRAME ? ENV_FRAME_WIDTH * ENV_FRAME_HEIGHT : ENV_STATE_OBS_SIZE;
+}
+
+// Marks every cell a rectangle touches, clipped to the frame
+static void fill_cells(float* frame, int x, int y, int w, int h, float value) {
+    int left = x < 0 ? 0 : x / ENV_FRAME_SCALE;
+    int top = y < 0 ? 0 : y / ENV_FRAME_SCALE;
+    int right = (x + w - 1) / ENV_FRAME_SCALE;
+    int bottom = (y + h - 1) / ENV_FRAME_SCALE;
+    if (right >= ENV_FRAME_WIDTH) right = ENV_FRAME_WIDTH - 1;
+    if (bottom >= ENV_FRAME_HEIGHT) bottom = ENV_FRAME_HEIGHT - 1;
+
+    for (int row = top; row <= bottom; row++) {
+        for (int col = left; col <= right; col++) {
+            frame[row * ENV_FRAME_WIDTH + col] = value;
+        }
+    }
+}
+
+void env_batch_observe(const EnvBatch* batch, float obs[]) {
+    int size = env_batch_obs_size(batch);
+    for (int i = 0; i < batch->count; i++) {
+        float* out = obs + (size_t)i * size;
+        int ball_x = fx_floor(batch->ball_x[i]);
+        int ball_y = fx_floor(batch->ball_y[i]);
+
+        if (batch->mode == ENV_OBS_STATE) {
+            out[0] = (float)batch->paddle_x[i] / SCREEN_WIDTH;
+            out[1] = (float)ball_x / SCREEN_WIDTH;
+            out[2] = (float)ball_y / SCREEN_HEIGHT;
+            out[3] = (float)batch->ball_dx[i] / FX(MIN_BALL_SPEED);
+            out[4] = (float)batch->ball_dy[i] / FX(MIN_BALL_SPEED);
+            out[5] = (float)batch->lives[i] / INITIAL_LIVES;
+            for (int brick = 0; brick < BRICK_ROWS * BRICK_COLS; brick++) {
+                out[6 + brick] = (float)((batch->brick_mask[i] >> brick) & 1);
+            }
+            continue;
+        }
+
+        memset(out, 0, size * sizeof(float));
+        for (int row = 0; row < BRICK_ROWS; row++) {
+            for (int col = 0; col < BRICK_COLS; col++) {
+                if (batch->brick_mask[i] & ((uint64_t)1 << (row * BRICK_COLS + col))) {
+                    fill_cells(out, sim_brick_x(col), sim_brick_y(row), BRICK_WIDTH, BRICK_HEIGHT, 0.5f);
+                }
+            }
+        }
+        fill_cells(out, batch->paddle_x[i], PADDLE_Y, PADDLE_WIDTH, PADDLE_HEIGHT, 1.0f);
+        fill_cells(out, ball_x, ball_y, BALL_SIZE, BALL_SIZE, 1.0f);
+    }
+}
+
+// The first half of sim_advance for every game, written as selects so the
+// loop vectorizes. restrict on the parameters is what lets GCC drop the
+// overlap checks between the arrays.
+static void move_games(int count, const uint8_t* restrict input, int32_t* restrict paddle_x,
+                       int32_t* restrict ball_x, int32_t* restrict ball_y,
+                       int32_t* restrict ball_dx, int32_t* restrict ball_dy,
+                       uint32_t* restrict frame, uint8_t* restrict near) {
+    for (int i = 0; i < count; i++) {
+        int32_t paddle = paddle_x[i] - ((input[i] & INPUT_LEFT) ? PADDLE_SPEED : 0) +
+                         ((input[i] & INPUT_RIGHT) ? PADDLE_SPEED : 0);
+        paddle = paddle < 0 ? 0 : paddle;
+        paddle = paddle > SCREEN_WIDTH - PADDLE_WIDTH ? SCREEN_WIDTH - PADDLE_WIDTH : paddle;
+        paddle_x[i] = paddle;
+
+        int32_t x = ball_x[i] + ball_dx[i];
+        int32_t y = ball_y[i] + ball_dy[i];
+        ball_x[i] = x;
+        ball_y[i] = y;
+        int32_t pixel_x = fx_floor(x);
+        int32_t pixel_y = fx_floor(y);
+        ball_dx[i] = (pixel_x <= 0 || pixel_x + BALL_SIZE >= SCREEN_WIDTH) ? -ball_dx[i] : ball_dx[i];
+        ball_dy[i] = pixel_y <= SCORE_HEIGHT ? -ball_dy[i] : ball_dy[i];
+
+        frame[i]++;
+        near[i] = pixel_y < BRICK_ZONE_BOTTOM || pixel_y + BALL_SIZE >= PADDLE_Y;
+    }
+}
+
+void env_batch_step(EnvBatch* batch, const uint8_t actions[], float obs[],
+                    float rewards[], uint8_t dones[]) {
+    int count = batch->count;
+    move_games(count, actions, batch->paddle_x, batch->ball_x, batch->ball_y,
+               batch->ball_dx, batch->ball_dy, batch->frame, batch->near);
+
+    uint8_t* near = batch->near;
+    // The rest only where the ball can hit something or be lost
+    for (int i = 0; i < count; i++) {
+        rewards[i] = 0.0f;
+        dones[i] = 0;
+        if (!near[i]) {
+            continue;
+        }
+
+        SimState sim;
+        load_game(batch, i, &sim);
+        sim_collide(&sim, fx_floor(sim.ball_x), fx_floor(sim.ball_y));
+        rewards[i] = (float)(sim.score - batch->score[i]);
+        if (sim.state != GAME_STATE_PLAYING) {
+            dones[i] = 1;
+            sim_reset(&sim);
+        }
+        store_game(batch, i, &sim);
+    }
+
+    if (obs != NULL) {
+        env_batch_observe(batch, obs);
+    }
+}
@@ -0,0 +1,52 @@
+#ifndef ENV_BATCH_H
+#define ENV_BATCH_H
+
+#include "sim.h"
+#include <stdint.h>
+
+// Batched training environments: N independent games under the rules in
+// sim.c, stepped together with one call and no SDL or GL anywhere. The
+// state is kept as one array per field, so the move-and-bounce half of a
+// step runs as plain loops the compiler vectorizes; only games with the
+// ball by the paddle or in the brick rows go through sim_collide for the
+// rest. A game that ends reports done and starts over at once, and the
+// observation it returns is the new game's first.
+//
+// Actions are INPUT_* bits: 0 stay, 1 left, 2 right. The reward is the
+// score gained that step, which is sim.c's brick score, so an episode's
+// return is its final score.
+
+typedef enum {
+    ENV_OBS_STATE,  // ENV_STATE_OBS_SIZE floats, see below
+    ENV_OBS_FRAME   // ENV_FRAME_WIDTH x ENV_FRAME_HEIGHT floats, row major
+} EnvObsMode;
+
+// State vector: paddle x, ball x and y (over the screen size), ball dx and
+// dy (over the launch speed), lives (over the starting lives), then 1 or
+// 0 for each brick in row-major order
+#define ENV_STATE_OBS_SIZE (6 + BRICK_ROWS * BRICK_COLS)
+
+// Frame: the playfield at one cell per ENV_FRAME_SCALE pixels square,
+// 0 empty, 0.5 brick, 1 paddle or ball
+#define ENV_FRAME_SCALE 8
+#define ENV_FRAME_WIDTH (SCREEN_WIDTH / ENV_FRAME_SCALE)
+#define ENV_FRAME_HEIGHT (SCREEN_HEIGHT / ENV_FRAME_SCALE)
+
+typedef struct EnvBatch EnvBatch;
+
+// Game i is seeded from seed and i. NULL if count isn't positive or the
+// arrays can't be allocated.
+EnvBatch* env_batch_create(int count, uint32_t seed, EnvObsMode mode);
+void env_batch_destroy(EnvBatch* batch);
+int env_batch_count(const EnvBatch* batch);
+int env_batch_obs_size(const EnvBatch* batch);  // Floats per game
+
+// Fills obs (count * env_batch_obs_size floats) for the current games
+void env_batch_observe(const EnvBatch* batch, float obs[]);
+
+// One step of every game. actions, rewards and dones hold count entries;
+// obs may be NULL to skip building observations.
+void env_batch_step(EnvBatch* batch, const uint8_t actions[], float obs[],
+                    float rewards[], uint8_t dones[]);
+
+#endif // ENV_BATCH_H
@@ -0,0 +1,133 @@
+// Throughput check for the batched environments: steps N games on random
+// actions and prints env steps per second with no observations, with
+// state vectors and with frames. Before timing, a few games are stepped
+// next to plain sim_advance and compared field by field, so the batched
+// step can't drift from the game's rules unnoticed.
+//
+// Usage: ./env_bench [games] [steps]
+
+#include "env_batch.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define DEFAULT_GAMES 4096
+#define DEFAULT_STEPS 2000
+#define CHECK_GAMES 16
+#define CHECK_STEPS 20000
+
+static uint32_t next_action(uint32_t* rng) {
+    *rng ^= *rng << 13;
+    *rng ^= *rng >> 17;
+    *rng ^= *rng << 5;
+    return *rng % 3;
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Steps a batch next to one SimState per game, built the way
+// env_batch_create builds them, and reports the first difference
+static bool check_against_sim(void) {
+    EnvBatch* batch = env_batch_create(CHECK_GAMES, 1234, ENV_OBS_STATE);
+    SimState sims[CHECK_GAMES];
+    for (int i = 0; i < CHECK_GAMES; i++) {
+        sim_init(&sims[i], 1234 ^ ((uint32_t)(i + 1) * 2654435761u));
+        sim_reset(&sims[i]);
+    }
+
+    static float obs[CHECK_GAMES * ENV_STATE_OBS_SIZE];
+    uint8_t actions[CHECK_GAMES], dones[CHECK_GAMES];
+    float rewards[CHECK_GAMES];
+    uint32_t rng = 99;
+    for (int step = 0; step < CHECK_STEPS; step++) {
+        for (int i = 0; i < CHECK_GAMES; i++) {
+            actions[i] = (uint8_t)next_action(&rng);
+        }
+        env_batch_step(batch, actions, obs, rewards, dones);
+
+        for (int i = 0; i < CHECK_GAMES; i++) {
+            int score_before = sims[i].score;
+            sim_advance(&sims[i], actions[i]);
+            bool done = sims[i].state != GAME_STATE_PLAYING;
+            float reward = (float)(sims[i].score - score_before);
+            if (done) {
+                sim_reset(&sims[i]);
+            }
+
+            const float* out = obs + i * ENV_STATE_OBS_SIZE;
+            if (done != (dones[i] != 0) || reward != rewards[i] ||
+                out[0] != (float)sims[i].paddle_x / SCREEN_WIDTH ||
+                out[1] != (float)sim_ball_x(&sims[i]) / SCREEN_WIDTH ||
+                out[2] != (float)sim_ball_y(&sims[i]) / SCREEN_HEIGHT ||
+                out[3] != (float)sims[i].ball_dx / FX(MIN_BALL_SPEED) ||
+                out[4] != (float)sims[i].ball_dy / FX(MIN_BALL_SPEED) ||
+                out[5] != (float)sims[i].lives / INITIAL_LIVES) {
+                printf("env_bench: game %d differs from sim_advance at step %d\n", i, step);
+                env_batch_destroy(batch);
+                return false;
+            }
+        }
+    }
+    env_batch_destroy(batch);
+    return true;
+}
+
+static void bench(int games, int steps, EnvObsMode mode, bool observe, const char* name) {
+    EnvBatch* batch = env_batch_create(games, 42, mode);
+    uint8_t* actions = malloc(games);
+    float* rewards = malloc(games * sizeof(float));
+    uint8_t* dones = malloc(games);
+    float* obs = observe ? malloc((size_t)games * env_batch_obs_size(batch) * sizeof(float)) : NULL;
+    if (batch == NULL || actions == NULL || rewards == NULL || dones == NULL || (observe && obs == NULL)) {
+        printf("env_bench: out of memory for %d games\n", games);
+        exit(1);
+    }
+
+    uint32_t rng = 7;
+    long episodes = 0;
+    double start = now_seconds();
+    for (int step = 0; step < steps; step++) {
+        // Actions change every few steps, as a policy's would
+        if (step % 4 == 0) {
+            for (int i = 0; i < games; i++) {
+                actions[i] = (uint8_t)next_action(&rng);
+            }
+        }
+        env_batch_step(batch, actions, obs, rewards, dones);
+        for (int i = 0; i < games; i++) {
+            episodes += dones[i];
+        }
+    }
+    double seconds = now_seconds() - start;
+
+    printf("env_bench %-6s %6d games: %8.2f M steps/s (%ld episodes)\n",
+           name, games, (double)games * steps / seconds / 1e6, episodes);
+    free(obs);
+    free(dones);
+    free(rewards);
+    free(actions);
+    env_batch_destroy(batch);
+}
+
+int main(int argc, char* argv[]) {
+    int games = argc > 1 ? atoi(argv[1]) : DEFAULT_GAMES;
+    int steps = argc > 2 ? atoi(argv[2]) : DEFAULT_STEPS;
+    if (games <= 0 || steps <= 0) {
+        printf("Usage: %s [games] [steps]\n", argv[0]);
+        return 1;
+    }
+
+    if (!check_against_sim()) {
+        return 1;
+    }
+    printf("env_bench: %d games match sim_advance over %d steps\n", CHECK_GAMES, CHECK_STEPS);
+
+    bench(games, steps, ENV_OBS_STATE, false, "none");
+    bench(games, steps, ENV_OBS_STATE, true, "state");
+    bench(games, steps / 10 > 0 ? steps / 10 : 1, ENV_OBS_FRAME, true, "frame");
+    return 0;
+}
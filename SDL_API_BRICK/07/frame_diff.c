@@ -0,0 +1,139 @@
+// Golden-frame compare: checks every PNG in a golden directory against the
+// file of the same name in a capture directory (see --capture). A pixel
+// differs when any channel is off by more than the tolerance; a frame
+// fails when more than max-pixels pixels differ. With a diff directory,
+// failing frames are also written there with the differing pixels in red
+// over a dimmed copy of the golden.
+//
+// Usage: ./frame_diff [-t tolerance] [-n max-pixels] <golden dir> <capture dir> [diff dir]
+// Exits 0 when every golden frame matches, 1 otherwise.
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#include <dirent.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    int differing;   // Pixels over the tolerance
+    int max_delta;   // Largest channel difference anywhere
+} FrameDiff;
+
+static SDL_Surface* load_argb(const char* path) {
+    SDL_Surface* loaded = IMG_Load(path);
+    if (loaded == NULL) {
+        return NULL;
+    }
+    SDL_Surface* converted = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_ARGB8888, 0);
+    SDL_FreeSurface(loaded);
+    return converted;
+}
+
+static int channel_delta(Uint32 a, Uint32 b, int shift) {
+    return abs((int)((a >> shift) & 0xFF) - (int)((b >> shift) & 0xFF));
+}
+
+// Marks differing pixels in golden, which is only used for the diff image
+// afterwards
+static FrameDiff compare(SDL_Surface* golden, const SDL_Surface* capture, int tolerance) {
+    FrameDiff diff = {0, 0};
+    for (int y = 0; y < golden->h; y++) {
+        Uint32* golden_row = (Uint32*)((Uint8*)golden->pixels + y * golden->pitch);
+        const Uint32* capture_row = (const Uint32*)((const Uint8*)capture->pixels + y * capture->pitch);
+        for (int x = 0; x < golden->w; x++) {
+            int delta = 0;
+            for (int shift = 0; shift < 32; shift += 8) {
+                int channel = channel_delta(golden_row[x], capture_row[x], shift);
+                if (channel > delta) delta = channel;
+            }
+            if (delta > diff.max_delta) diff.max_delta = delta;
+
+            if (delta > tolerance) {
+                diff.differing++;
+                golden_row[x] = 0xFFFF0000;
+            } else {
+                // Dim to a quarter so the red stands out
+                golden_row[x] = 0xFF000000 | ((golden_row[x] >> 2) & 0x003F3F3F);
+            }
+        }
+    }
+    return diff;
+}
+
+int main(int argc, char* argv[]) {
+    int tolerance = 0;
+    int max_pixels = 0;
+    int arg = 1;
+    for (; arg + 1 < argc && argv[arg][0] == '-'; arg += 2) {
+        if (strcmp(argv[arg], "-t") == 0) {
+            tolerance = atoi(argv[arg + 1]);
+        } else if (strcmp(argv[arg], "-n") == 0) {
+            max_pixels = atoi(argv[arg + 1]);
+        } else {
+            break;
+        }
+    }
+    if (argc - arg < 2) {
+        printf("Usage: %s [-t tolerance] [-n max-pixels] <golden dir> <capture dir> [diff dir]\n", argv[0]);
+        return 1;
+    }
+    const char* golden_dir = argv[arg];
+    const char* capture_dir = argv[arg + 1];
+    const char* diff_dir = argc - arg > 2 ? argv[arg + 2] : NULL;
+
+    DIR* dir = opendir(golden_dir);
+    if (dir == NULL) {
+        printf("Can't open %s\n", golden_dir);
+        return 1;
+    }
+    IMG_Init(IMG_INIT_PNG);
+
+    int frames = 0;
+    int failed = 0;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        size_t length = strlen(entry->d_name);
+        if (length < 4 || strcmp(entry->d_name + length - 4, ".png") != 0) {
+            continue;
+        }
+        frames++;
+
+        char golden_path[1024], capture_path[1024];
+        snprintf(golden_path, sizeof(golden_path), "%s/%s", golden_dir, entry->d_name);
+        snprintf(capture_path, sizeof(capture_path), "%s/%s", capture_dir, entry->d_name);
+        SDL_Surface* golden = load_argb(golden_path);
+        SDL_Surface* capture = load_argb(capture_path);
+
+        if (golden == NULL || capture == NULL) {
+            printf("FAIL %s: can't load %s\n", entry->d_name, golden == NULL ? golden_path : capture_path);
+            failed++;
+        } else if (golden->w != capture->w || golden->h != capture->h) {
+            printf("FAIL %s: %dx%d, golden is %dx%d\n", entry->d_name,
+                   capture->w, capture->h, golden->w, golden->h);
+            failed++;
+        } else {
+            FrameDiff diff = compare(golden, capture, tolerance);
+            bool ok = diff.differing <= max_pixels;
+            printf("%s %s: %d pixels differ, max delta %d\n",
+                   ok ? "ok  " : "FAIL", entry->d_name, diff.differing, diff.max_delta);
+            if (!ok) {
+                failed++;
+                if (diff_dir != NULL) {
+                    char diff_path[1024];
+                    snprintf(diff_path, sizeof(diff_path), "%s/%s", diff_dir, entry->d_name);
+                    IMG_SavePNG(golden, diff_path);
+                }
+            }
+        }
+        SDL_FreeSurface(golden);
+        SDL_FreeSurface(capture);
+    }
+    closedir(dir);
+    IMG_Quit();
+
+    printf("%d of %d frames match (tolerance %d, up to %d pixels)\n",
+           frames - failed, frames, tolerance, max_pixels);
+    return failed == 0 && frames > 0 ? 0 : 1;
+}
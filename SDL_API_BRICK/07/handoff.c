@@ -0,0 +1,61 @@
+#include "handoff.h"
+
+void triple_buffer_init(TripleBuffer* tb, void* slot0, void* slot1, void* slot2) {
+    tb->slots[0] = slot0;
+    tb->slots[1] = slot1;
+    tb->slots[2] = slot2;
+    tb->back = 0;
+    tb->front = 2;
+    SDL_AtomicSet(&tb->middle, 1);
+}
+
+void* triple_buffer_write_slot(TripleBuffer* tb) {
+    return tb->slots[tb->back];
+}
+
+void triple_buffer_publish(TripleBuffer* tb) {
+    // Writes to the back slot must land before the swap makes it visible
+    SDL_MemoryBarrierRelease();
+    int old = SDL_AtomicSet(&tb->middle, tb->back | TRIPLE_BUFFER_FRESH);
+    tb->back = old & 3;
+}
+
+const void* triple_buffer_read(TripleBuffer* tb) {
+    if (SDL_AtomicGet(&tb->middle) & TRIPLE_BUFFER_FRESH) {
+        int old = SDL_AtomicSet(&tb->middle, tb->front);
+        SDL_MemoryBarrierAcquire();
+        tb->front = old & 3;
+    }
+    return tb->slots[tb->front];
+}
+
+void spsc_init(SpscQueue* queue) {
+    SDL_AtomicSet(&queue->head, 0);
+    SDL_AtomicSet(&queue->tail, 0);
+}
+
+bool spsc_push(SpscQueue* queue, Uint8 item) {
+    int head = SDL_AtomicGet(&queue->head);
+    int next = (head + 1) & (SPSC_QUEUE_SIZE - 1);
+    if (next == SDL_AtomicGet(&queue->tail)) {
+        return false;  // Full
+    }
+
+    queue->items[head] = item;
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&queue->head, next);
+    return true;
+}
+
+bool spsc_pop(SpscQueue* queue, Uint8* item) {
+    int tail = SDL_AtomicGet(&queue->tail);
+    if (tail == SDL_AtomicGet(&queue->head)) {
+        return false;  // Empty
+    }
+
+    SDL_MemoryBarrierAcquire();
+    *item = queue->items[tail];
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&queue->tail, (tail + 1) & (SPSC_QUEUE_SIZE - 1));
+    return true;
+}
@@ -0,0 +1,41 @@
+#ifndef HANDOFF_H
+#define HANDOFF_H
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+
+// Lock-free primitives for passing data between threads. Neither side
+// ever blocks or allocates.
+
+// Triple buffer: one writer publishes whole snapshots, one reader always
+// gets the newest complete one. The writer never waits for the reader and
+// the reader never sees a half-written slot.
+#define TRIPLE_BUFFER_FRESH 4   // Set in `middle` when the writer published
+
+typedef struct {
+    void* slots[3];
+    int back;                   // Writer-owned slot
+    int front;                  // Reader-owned slot
+    SDL_atomic_t middle;        // Slot in flight, plus TRIPLE_BUFFER_FRESH
+} TripleBuffer;
+
+void triple_buffer_init(TripleBuffer* tb, void* slot0, void* slot1, void* slot2);
+void* triple_buffer_write_slot(TripleBuffer* tb);
+void triple_buffer_publish(TripleBuffer* tb);
+const void* triple_buffer_read(TripleBuffer* tb);
+
+// Single-producer/single-consumer queue of one-byte events. One slot is
+// kept empty to tell full from empty.
+#define SPSC_QUEUE_SIZE 64      // Power of two
+
+typedef struct {
+    Uint8 items[SPSC_QUEUE_SIZE];
+    SDL_atomic_t head;          // Next slot the producer writes
+    SDL_atomic_t tail;          // Next slot the consumer reads
+} SpscQueue;
+
+void spsc_init(SpscQueue* queue);
+bool spsc_push(SpscQueue* queue, Uint8 item);
+bool spsc_pop(SpscQueue* queue, Uint8* item);
+
+#endif // HANDOFF_H
@@ -3,96 +3,118 @@
 #include <SDL2/SDL_ttf.h>
 #include <SDL2/SDL_mixer.h>
 #include <stdio.h>
+#include <string.h>
 #include <stdbool.h>
 #include <math.h>
 #include <time.h>
-
-#define SCREEN_WIDTH 640
-#define SCREEN_HEIGHT 480
-#define PADDLE_WIDTH 100
-#define PADDLE_HEIGHT 20
-#define BALL_SIZE 15
-#define BRICK_ROWS 6
-#define BRICK_COLS 8
-#define BRICK_WIDTH (SCREEN_WIDTH / BRICK_COLS)
-#define BRICK_HEIGHT 30
-#define SCORE_HEIGHT 40
-#define INITIAL_LIVES 3
-#define MIN_BALL_SPEED 4
-#define MAX_BALL_SPEED 8
+#include "sfx.h"
+#include "handoff.h"
+#include "profiler.h"
+#include "trace.h"
+#include "overlay.h"
+#include "text_atlas.h"
+#include "alloc_track.h"
+#include "startup.h"
+#include "capture.h"
+#include "record.h"
+#include "render_bench.h"
+#include "dyn_res.h"
+#include "sim.h"
+#include "snapshot_ring.h"
+#include "save_state.h"
+#include "swraster.h"
+#include "spectate.h"
+#include "versus.h"
 
 // Controller button mappings
 #define START_BUTTON 8
-#define A_BUTTON 0
+#define A_BUTTON 0      // Held to rewind, as is Backspace
 #define B_BUTTON 1
 #define LEFT_BUTTON 12
 #define RIGHT_BUTTON 13
+#define SELECT_BUTTON 9  // Toggles the performance overlay, as does F1
 
 #define HUD_FONT_SIZE 24  // Smaller font size for HUD
 #define MENU_FONT_SIZE 36  // Larger font size for menus
 
-typedef enum {
-    GAME_STATE_START_SCREEN,
-    GAME_STATE_PLAYING,
-    GAME_STATE_WIN_SCREEN,
-    GAME_STATE_GAME_OVER
-} GameState;
-
-typedef enum {
-    BRICK_RED,
-    BRICK_BLUE,
-    BRICK_YELLOW
-} BrickType;
-
-typedef struct {
-    int x, y;
-    int width, height;
-    SDL_Texture* texture;
-} Paddle;
-
-typedef struct {
-    int x, y;
-    double dx, dy;
-    int size;
-    SDL_Texture* texture;
-} Ball;
-
-typedef struct {
-    int x, y;
-    bool destroyed;
-    BrickType type;
-    SDL_Texture* texture;
-} Brick;
+#define SIM_HZ 60               // Fixed simulation rate
+#define SIM_MAX_LAG_STEPS 5     // Resync instead of catching up past this
+#define FRAME_MS 16             // Render pacing when vsync doesn't block
+#define IDLE_REDRAW_MS 1000     // Keepalive present on a static screen
+#define SIM_IDLE_MS 250         // Simulation wakeup check when not playing
+#define PRESENT_REPORT_MS 60000 // Presented-frame counter interval
 
 typedef struct {
     Mix_Music* background_music;
-    Mix_Chunk* brick_hit;
-    Mix_Chunk* paddle_hit;
 } AudioAssets;
 
+// Everything the render thread needs for one frame. The simulation fills
+// one in after every step and hands it over through a triple buffer.
 typedef struct {
+    GameState state;
+    int paddle_x;
+    int ball_x, ball_y;
+    Uint64 brick_mask;  // Bit (row * BRICK_COLS + col) set while standing
     int score;
     int lives;
-    int combo;
-    SDL_Texture* score_text;
-    SDL_Texture* lives_text;
-} GameStats;
+    bool versus;        // The rival's score and lives go in the HUD
+    int rival_score;
+    int rival_lives;
+} RenderSnapshot;
+
+typedef enum {
+    SIM_CMD_RESET
+} SimCommand;
+
+#define INPUT_REWIND 4  // Not a sim_advance input; steps the history back instead
 
 // Global Variables
-Paddle paddle;
-Ball ball;
-Brick bricks[BRICK_ROWS][BRICK_COLS];
-AudioAssets audio = {NULL, NULL, NULL};
-GameStats stats = {0};
+SimState sim;
+AudioAssets audio = {NULL};
 SDL_Window* win = NULL;
 SDL_Renderer* renderer = NULL;
+SDL_Surface* headless_target = NULL;   // Render target with --headless
 TTF_Font* font_hud = NULL;      // Smaller font for HUD
+TextAtlas hud_text;             // font_hud glyphs for the score and lives
 TTF_Font* font_menu = NULL;     // Larger font for menus
 SDL_Joystick* joystick = NULL;  // Global joystick handle
-GameState game_state = GAME_STATE_START_SCREEN;
 bool running = true;
 bool move_left = false;
 bool move_right = false;
+bool rewind_held = false;
+
+// Simulation/render handoff. sim belongs to the simulation; the render
+// thread only sees snapshots.
+RenderSnapshot snapshot_slots[3];
+TripleBuffer snapshots;
+SpscQueue sim_commands;          // Render thread -> simulation
+SDL_atomic_t input_state;        // INPUT_LEFT | INPUT_RIGHT | INPUT_REWIND
+SDL_atomic_t sim_running;
+SDL_Thread* sim_thread = NULL;
+SDL_sem* sim_wakeup = NULL;      // Posted when a command is queued
+Uint32 sim_event_type = (Uint32)-1; // Pushed when the game state changes
+bool threaded = true;
+const char* resume_path = NULL;  // --resume: save on exit, load at boot
+bool menus_pending = false;      // Resumed; menu screens not loaded yet
+
+// --versus: sim shows this machine's board and rival the other; both come
+// from the session, which only the simulation touches
+bool versus_mode = false;
+VersusSession versus;
+SimState rival;
+
+// Idle mode: static screens are presented once and then the loop blocks
+// in SDL_WaitEventTimeout until something can have changed
+bool idle_mode = true;
+int presented_state = -1;        // State shown by the last present
+int music_state = -1;            // Snapshot state update_music last saw
+Uint32 last_present_ticks = 0;
+int presented_frames = 0;        // Since the last report
+Uint32 present_report_ticks = 0;
+
+// Profiler timestamps for the render side of the current frame
+Uint64 render_start_counter = 0;
+Uint64 last_present_counter = 0;
 
 // Textures
 SDL_Texture* background_texture = NULL;
@@ -103,88 +125,75 @@ SDL_Texture* youwin_texture = NULL;
 SDL_Texture* restart_text_texture = NULL;
 SDL_Texture* quit_text_texture = NULL;
 SDL_Texture* brick_textures[3] = {NULL};  // Red, Blue, Yellow
+SDL_Texture* paddle_texture = NULL;
+SDL_Texture* ball_texture = NULL;
+
+// --swraster: the playing scene comes from swraster.c and is uploaded as
+// one streaming texture
+int sw_raster_request = -1;      // Thread count asked for, -1 when off
+SDL_Texture* sw_texture = NULL;
+SDL_Surface* sw_surfaces[SW_SPRITE_COUNT] = {NULL};
+SwImage sw_sprites[SW_SPRITE_COUNT];
 
 // Function declarations
 bool init_audio();
 void cleanup_audio();
 SDL_Texture* load_texture(SDL_Renderer* renderer, const char* path);
 SDL_Texture* create_text_texture(SDL_Renderer* renderer, TTF_Font* font, const char* text, SDL_Color color);
-bool init_game_objects();
+bool init_game_objects(Uint32 seed);
+bool load_menu_textures();
 void cleanup_game_objects();
-void reset_game();
 void handle_start_screen_events(SDL_Event* e);
 void handle_end_screen_events(SDL_Event* e);
 void render_start_screen();
 void render_end_screen(bool is_win);
 void main_loop();
-void update_score_display();
-void update_lives_display();
-void randomize_ball_velocity();
-void reset_ball();
-void handle_paddle_collision();
-void handle_brick_collisions();
-void handle_ball_loss();
-void render_game_stats();
-
-int calculate_brick_score(int combo) {
-    return (combo == 0) ? 50 : (combo >= 5) ? 100 : 50 + (combo * 10);
-}
-
-void update_score_display() {
-    if (stats.score_text != NULL) {
-        SDL_DestroyTexture(stats.score_text);
-    }
-    char score_str[32];
-    snprintf(score_str, sizeof(score_str), "Score: %d", stats.score);
-    SDL_Color white = {255, 255, 255, 255};
-    stats.score_text = create_text_texture(renderer, font_hud, score_str, white);
-}
-
-void update_lives_display() {
-    if (stats.lives_text != NULL) {
-        SDL_DestroyTexture(stats.lives_text);
-    }
-    char lives_str[32];
-    snprintf(lives_str, sizeof(lives_str), "Lives: %d", stats.lives);
-    SDL_Color white = {255, 255, 255, 255};
-    stats.lives_text = create_text_texture(renderer, font_hud, lives_str, white);
-}
-
-void randomize_ball_velocity() {
-    float angle = ((float)rand() / RAND_MAX * 90.0f - 45.0f) * M_PI / 180.0f;
-    float speed = MIN_BALL_SPEED;
-    ball.dx = speed * sin(angle);
-    ball.dy = -speed * cos(angle);
-}
-
-void reset_ball() {
-    ball.x = SCREEN_WIDTH / 2;
-    ball.y = SCREEN_HEIGHT / 2;
-    randomize_ball_velocity();
-}
+void update_music(const RenderSnapshot* view);
+void render_game_stats(const RenderSnapshot* view);
+void request_reset();
+void sim_step();
+void publish_snapshot();
+bool resume_game(const char* path);
+void suspend_game(const char* path);
+void render_game(const RenderSnapshot* view);
+bool render_game_software(const RenderSnapshot* view);
+bool init_sw_raster();
+void cleanup_sw_raster();
+void present_frame(GameState state);
+void draw_texture(SDL_Texture* texture, const SDL_Rect* src, const SDL_Rect* dst);
+void draw_text(int x, int y, const char* text);
+void render_bench_step();
 
 bool init_audio() {
     if (Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048) < 0) {
         printf("SDL_mixer Init Error: %s\n", Mix_GetError());
         return false;
     }
+    startup_bench_mark("Mix_OpenAudio");
 
     audio.background_music = Mix_LoadMUS("sound/background_music.ogg");
     if (audio.background_music == NULL) {
         printf("Failed to load background music: %s\n", Mix_GetError());
         return false;
     }
-
-    audio.brick_hit = Mix_LoadWAV("sound/brick_hit.ogg");
-    if (audio.brick_hit == NULL) {
-        printf("Failed to load brick hit sound: %s\n", Mix_GetError());
-        return false;
-    }
-
-    audio.paddle_hit = Mix_LoadWAV("sound/paddle_hit.ogg");
-    if (audio.paddle_hit == NULL) {
-        printf("Failed to load paddle hit sound: %s\n", Mix_GetError());
-        return false;
+    startup_bench_mark("sound/background_music.ogg");
+
+    // Sound effects are mixed by sfx.c; music stays on Mix_Music
+    static const struct {
+        SfxId id;
+        const char* path;
+    } effects[] = {
+        {SFX_BRICK_HIT, "sound/brick_hit.ogg"},
+        {SFX_PADDLE_HIT, "sound/paddle_hit.ogg"},
+        {SFX_GAME_OVER, "sound/game_over.ogg"},
+        {SFX_GAME_WON, "sound/game_won.ogg"}
+    };
+    sfx_init();
+    for (size_t i = 0; i < sizeof(effects) / sizeof(effects[0]); i++) {
+        if (!sfx_load(effects[i].id, effects[i].path)) {
+            return false;
+        }
+        startup_bench_mark(effects[i].path);
     }
 
     return true;
@@ -194,16 +203,12 @@ void cleanup_audio() {
     if (audio.background_music != NULL) {
         Mix_FreeMusic(audio.background_music);
     }
-    if (audio.brick_hit != NULL) {
-        Mix_FreeChunk(audio.brick_hit);
-    }
-    if (audio.paddle_hit != NULL) {
-        Mix_FreeChunk(audio.paddle_hit);
-    }
+    sfx_cleanup();
     Mix_CloseAudio();
 }
 
 SDL_Texture* load_texture(SDL_Renderer* renderer, const char* path) {
+    TRACE_ZONE_DETAIL("load_texture", path);
     SDL_Surface* surface = IMG_Load(path);
     if (surface == NULL) {
         printf("IMG_Load Error for %s: %s\n", path, IMG_GetError());
@@ -218,11 +223,16 @@ SDL_Texture* load_texture(SDL_Renderer* renderer, const char* path) {
         return NULL;
     }
 
+    startup_bench_mark(path);
     return texture;
 }
 
 SDL_Texture* create_text_texture(SDL_Renderer* renderer, TTF_Font* font, const char* text, SDL_Color color) {
-    SDL_Surface* surface = TTF_RenderText_Blended(font, text, color);
+    SDL_Surface* surface;
+    {
+        TRACE_ZONE_DETAIL("TTF_RenderText_Blended", text);
+        surface = TTF_RenderText_Blended(font, text, color);
+    }
     if (surface == NULL) {
         printf("TTF_RenderText_Blended Error: %s\n", TTF_GetError());
         return NULL;
@@ -239,20 +249,11 @@ SDL_Texture* create_text_texture(SDL_Renderer* renderer, TTF_Font* font, const c
     return texture;
 }
 
-bool init_game_objects() {
-    // Load all screen textures
-    startscreen_texture = load_texture(renderer, "sprites/startscreen.png");
-    if (startscreen_texture == NULL) return false;
-
+bool init_game_objects(Uint32 seed) {
+    // Everything the playing screen draws
     background_texture = load_texture(renderer, "sprites/background.png");
     if (background_texture == NULL) return false;
 
-    gameover_texture = load_texture(renderer, "sprites/gameover.png");
-    if (gameover_texture == NULL) return false;
-
-    youwin_texture = load_texture(renderer, "sprites/youwin.png");
-    if (youwin_texture == NULL) return false;
-
     // Load brick textures
     brick_textures[BRICK_RED] = load_texture(renderer, "sprites/brick-red.png");
     brick_textures[BRICK_BLUE] = load_texture(renderer, "sprites/brick-blue.png");
@@ -262,6 +263,35 @@ bool init_game_objects() {
         if (brick_textures[i] == NULL) return false;
     }
 
+    // The HUD draws its numbers from this every frame instead of
+    // rendering new text textures when they change
+    SDL_Color white = {255, 255, 255, 255};
+    if (!text_atlas_create(&hud_text, renderer, font_hud, white)) return false;
+    startup_bench_mark("hud_atlas");
+
+    paddle_texture = load_texture(renderer, "sprites/paddle.png");
+    if (paddle_texture == NULL) return false;
+
+    ball_texture = load_texture(renderer, "sprites/ball.png");
+    if (ball_texture == NULL) return false;
+
+    sim_init(&sim, seed);
+    snapshot_ring_reset(&sim);
+    return true;
+}
+
+// The start, win and game over screens. A resumed game goes straight into
+// play, so it loads these after its first frame instead of before it.
+bool load_menu_textures() {
+    startscreen_texture = load_texture(renderer, "sprites/startscreen.png");
+    if (startscreen_texture == NULL) return false;
+
+    gameover_texture = load_texture(renderer, "sprites/gameover.png");
+    if (gameover_texture == NULL) return false;
+
+    youwin_texture = load_texture(renderer, "sprites/youwin.png");
+    if (youwin_texture == NULL) return false;
+
     // Create text textures
     SDL_Color white = {255, 255, 255, 255};
     start_text_texture = create_text_texture(renderer, font_menu, "Press START Button", white);
@@ -272,56 +302,55 @@ bool init_game_objects() {
 
     quit_text_texture = create_text_texture(renderer, font_menu, "Press B to Quit", white);
     if (quit_text_texture == NULL) return false;
+    startup_bench_mark("menu_text");
+    return true;
+}
 
-    // Initialize paddle
-    paddle = (Paddle){
-        .x = SCREEN_WIDTH / 2 - PADDLE_WIDTH / 2,
-        .y = SCREEN_HEIGHT - 40,
-        .width = PADDLE_WIDTH,
-        .height = PADDLE_HEIGHT,
-        .texture = load_texture(renderer, "sprites/paddle.png")
-    };
-    if (paddle.texture == NULL) return false;
-
-    // Initialize ball
-    ball = (Ball){
-        .x = SCREEN_WIDTH / 2,
-        .y = SCREEN_HEIGHT / 2,
-        .size = BALL_SIZE,
-        .texture = load_texture(renderer, "sprites/ball.png")
-    };
-    if (ball.texture == NULL) return false;
-
-    // Initialize bricks
-    for (int i = 0; i < BRICK_ROWS; i++) {
-        BrickType type;
-        if (i < 2) type = BRICK_RED;
-        else if (i < 4) type = BRICK_BLUE;
-        else type = BRICK_YELLOW;
-
-        for (int j = 0; j < BRICK_COLS; j++) {
-            bricks[i][j].x = j * BRICK_WIDTH;
-            bricks[i][j].y = i * BRICK_HEIGHT + SCORE_HEIGHT;
-            bricks[i][j].destroyed = false;
-            bricks[i][j].type = type;
-            bricks[i][j].texture = brick_textures[type];
+// Sprites as ARGB8888 surfaces for --swraster, which reads their pixels.
+// Without it the game carries on through the renderer.
+bool init_sw_raster() {
+    for (int i = 0; i < SW_SPRITE_COUNT; i++) {
+        SDL_Surface* loaded = IMG_Load(sw_sprite_paths[i]);
+        if (loaded == NULL) {
+            printf("IMG_Load Error for %s: %s\n", sw_sprite_paths[i], IMG_GetError());
+            return false;
         }
+        sw_surfaces[i] = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_ARGB8888, 0);
+        SDL_FreeSurface(loaded);
+        if (sw_surfaces[i] == NULL) {
+            printf("SDL_ConvertSurfaceFormat Error: %s\n", SDL_GetError());
+            return false;
+        }
+        sw_sprites[i] = sw_image_init(sw_surfaces[i]->w, sw_surfaces[i]->h, sw_surfaces[i]->pitch / 4,
+                                      sw_surfaces[i]->pixels);
     }
 
-    // Initialize stats
-    stats.score = 0;
-    stats.lives = INITIAL_LIVES;
-    stats.combo = 0;
-    update_score_display();
-    update_lives_display();
-
-    randomize_ball_velocity();
+    sw_texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING,
+                                   SCREEN_WIDTH, SCREEN_HEIGHT);
+    if (sw_texture == NULL) {
+        printf("SDL_CreateTexture Error: %s\n", SDL_GetError());
+        return false;
+    }
+    sw_raster_init(sw_raster_request);
+    printf("swraster: drawing the scene on %d threads\n", sw_raster_threads());
     return true;
 }
 
+void cleanup_sw_raster() {
+    sw_raster_shutdown();
+    if (sw_texture != NULL) {
+        SDL_DestroyTexture(sw_texture);
+        sw_texture = NULL;
+    }
+    for (int i = 0; i < SW_SPRITE_COUNT; i++) {
+        SDL_FreeSurface(sw_surfaces[i]);
+        sw_surfaces[i] = NULL;
+    }
+}
+
 void cleanup_game_objects() {
-    SDL_DestroyTexture(paddle.texture);
-    SDL_DestroyTexture(ball.texture);
+    SDL_DestroyTexture(paddle_texture);
+    SDL_DestroyTexture(ball_texture);
     SDL_DestroyTexture(background_texture);
     SDL_DestroyTexture(startscreen_texture);
     SDL_DestroyTexture(start_text_texture);
@@ -329,8 +358,7 @@ void cleanup_game_objects() {
     SDL_DestroyTexture(youwin_texture);
     SDL_DestroyTexture(restart_text_texture);
     SDL_DestroyTexture(quit_text_texture);
-    SDL_DestroyTexture(stats.score_text);
-    SDL_DestroyTexture(stats.lives_text);
+    text_atlas_destroy(&hud_text);
 
     for (int i = 0; i < 3; i++) {
         if (brick_textures[i] != NULL) {
@@ -339,123 +367,16 @@ void cleanup_game_objects() {
     }
 }
 
-bool check_all_bricks_destroyed() {
-    for (int i = 0; i < BRICK_ROWS; i++) {
-        for (int j = 0; j < BRICK_COLS; j++) {
-            if (!bricks[i][j].destroyed) {
-                return false;
-            }
-        }
-    }
-    return true;
-}
-
-void reset_game() {
-    // Reset ball and paddle
-    paddle.x = SCREEN_WIDTH / 2 - PADDLE_WIDTH / 2;
-    reset_ball();
-
-    // Reset bricks
-    for (int i = 0; i < BRICK_ROWS; i++) {
-        BrickType type;
-        if (i < 2) type = BRICK_RED;
-        else if (i < 4) type = BRICK_BLUE;
-        else type = BRICK_YELLOW;
-
-        for (int j = 0; j < BRICK_COLS; j++) {
-            bricks[i][j].destroyed = false;
-            bricks[i][j].type = type;
-            bricks[i][j].texture = brick_textures[type];
-        }
-    }
-
-    // Reset stats
-    stats.score = 0;
-    stats.lives = INITIAL_LIVES;
-    stats.combo = 0;
-    update_score_display();
-    update_lives_display();
-
-    // Ensure music is playing
-    if (!Mix_PlayingMusic()) {
-        Mix_PlayMusic(audio.background_music, -1);
-    }
-
-    game_state = GAME_STATE_PLAYING;
-}
-
-void handle_paddle_collision() {
-    if (ball.y + ball.size >= paddle.y &&
-        ball.x + ball.size >= paddle.x &&
-        ball.x <= paddle.x + paddle.width) {
-
-        // Calculate where on the paddle the ball hit (0 to 1)
-        float hit_position = (ball.x + ball.size/2 - paddle.x) / paddle.width;
-
-        // Adjust angle based on hit position (-60 to 60 degrees)
-        float angle = (hit_position - 0.5f) * M_PI * 2/3;  // Convert to radians
-
-        // Maintain speed but change direction
-        float current_speed = sqrt(ball.dx * ball.dx + ball.dy * ball.dy);
-        ball.dx = current_speed * sin(angle);
-        ball.dy = -current_speed * cos(angle);
-
-        Mix_PlayChannel(-1, audio.paddle_hit, 0);
-        stats.combo = 0;
-    }
-}
-
-void handle_brick_collisions() {
-    bool hit = false;
-    for (int i = 0; i < BRICK_ROWS; i++) {
-        for (int j = 0; j < BRICK_COLS; j++) {
-            Brick* brick = &bricks[i][j];
-            if (!brick->destroyed &&
-                ball.x + ball.size > brick->x &&
-                ball.x < brick->x + BRICK_WIDTH &&
-                ball.y + ball.size > brick->y &&
-                ball.y < brick->y + BRICK_HEIGHT) {
-
-                brick->destroyed = true;
-                ball.dy = -ball.dy;
-
-                stats.score += calculate_brick_score(stats.combo);
-                stats.combo++;
-
-                update_score_display();
-                Mix_PlayChannel(-1, audio.brick_hit, 0);
-                hit = true;
-                break;
-            }
-        }
-        if (hit) break;
-    }
-}
-
-void handle_ball_loss() {
-    if (ball.y > SCREEN_HEIGHT) {
-        stats.lives--;
-        update_lives_display();
-
-        if (stats.lives <= 0) {
-            game_state = GAME_STATE_GAME_OVER;
-        } else {
-            reset_ball();
-            paddle.x = SCREEN_WIDTH / 2 - PADDLE_WIDTH / 2;
-        }
-    }
-}
-
 void handle_start_screen_events(SDL_Event* e) {
     if (e->type == SDL_QUIT) {
         running = false;
     } else if (e->type == SDL_KEYDOWN) {
         if (e->key.keysym.sym == SDLK_9) {
-            reset_game();
+            request_reset();
         }
     } else if (e->type == SDL_JOYBUTTONDOWN) {
         if (e->jbutton.button == START_BUTTON) {
-            reset_game();
+            request_reset();
         }
     }
 }
@@ -466,7 +387,7 @@ void handle_end_screen_events(SDL_Event* e) {
     } else if (e->type == SDL_KEYDOWN) {
         switch (e->key.keysym.sym) {
             case SDLK_r:
-                reset_game();
+                request_reset();
                 break;
             case SDLK_q:
                 running = false;
@@ -474,7 +395,7 @@ void handle_end_screen_events(SDL_Event* e) {
         }
     } else if (e->type == SDL_JOYBUTTONDOWN) {
         if (e->jbutton.button == START_BUTTON) {
-            reset_game();
+            request_reset();
         } else if (e->jbutton.button == B_BUTTON) {
             running = false;
         }
@@ -483,7 +404,7 @@ void handle_end_screen_events(SDL_Event* e) {
 
 void render_start_screen() {
     SDL_RenderClear(renderer);
-    SDL_RenderCopy(renderer, startscreen_texture, NULL, NULL);
+    draw_texture(startscreen_texture, NULL, NULL);
 
     int text_width, text_height;
     SDL_QueryTexture(start_text_texture, NULL, NULL, &text_width, &text_height);
@@ -493,14 +414,14 @@ void render_start_screen() {
         text_width,
         text_height
     };
-    SDL_RenderCopy(renderer, start_text_texture, NULL, &text_rect);
+    draw_texture(start_text_texture, NULL, &text_rect);
 
-    SDL_RenderPresent(renderer);
+    present_frame(GAME_STATE_START_SCREEN);
 }
 
 void render_end_screen(bool is_win) {
     SDL_RenderClear(renderer);
-    SDL_RenderCopy(renderer, is_win ? youwin_texture : gameover_texture, NULL, NULL);
+    draw_texture(is_win ? youwin_texture : gameover_texture, NULL, NULL);
 
     int text_width, text_height;
 
@@ -511,7 +432,7 @@ void render_end_screen(bool is_win) {
         text_width,
         text_height
     };
-    SDL_RenderCopy(renderer, restart_text_texture, NULL, &restart_rect);
+    draw_texture(restart_text_texture, NULL, &restart_rect);
 
     SDL_QueryTexture(quit_text_texture, NULL, NULL, &text_width, &text_height);
     SDL_Rect quit_rect = {
@@ -520,30 +441,410 @@ void render_end_screen(bool is_win) {
         text_width,
         text_height
     };
-    SDL_RenderCopy(renderer, quit_text_texture, NULL, &quit_rect);
+    draw_texture(quit_text_texture, NULL, &quit_rect);
+
+    present_frame(is_win ? GAME_STATE_WIN_SCREEN : GAME_STATE_GAME_OVER);
+}
+
+void render_game_stats(const RenderSnapshot* view) {
+    char text[32];
+    snprintf(text, sizeof(text), "Score: %d", view->score);
+    draw_text(10, 10, text);
+
+    snprintf(text, sizeof(text), "Lives: %d", view->lives);
+    draw_text(SCREEN_WIDTH - 150, 10, text);
+
+    if (view->versus) {
+        snprintf(text, sizeof(text), "Rival: %d x%d", view->rival_score, view->rival_lives);
+        draw_text(SCREEN_WIDTH / 2 - 80, 10, text);
+    }
+}
+
+void request_reset() {
+    spsc_push(&sim_commands, SIM_CMD_RESET);
+    if (sim_wakeup != NULL) {
+        SDL_SemPost(sim_wakeup);
+    }
+}
+
+// Every game sprite goes through here so the overlay can count draws
+void draw_texture(SDL_Texture* texture, const SDL_Rect* src, const SDL_Rect* dst) {
+    overlay_count_draw(texture);
+    SDL_RenderCopy(renderer, texture, src, dst);
+}
+
+// HUD text from the glyph atlas: a copy per character, nothing allocated
+void draw_text(int x, int y, const char* text) {
+    for (const char* c = text; *c != '\0'; c++) {
+        const SDL_Rect* glyph = text_atlas_glyph(&hud_text, *c);
+        if (glyph == NULL) {
+            continue;
+        }
+        SDL_Rect dst = {x, y, glyph->w, glyph->h};
+        draw_texture(hud_text.texture, glyph, &dst);
+        x += glyph->w;
+    }
+}
+
+void present_frame(GameState state) {
+    profiler_record(PROF_RENDER, render_start_counter);
+    capture_read_frame(renderer);
+    record_frame(renderer);
+
+    // After the render time is taken, so the overlay doesn't count itself
+    overlay_draw(renderer, 10, SCORE_HEIGHT + 10);
+
+    Uint64 present_start = profiler_now();
+    {
+        TRACE_ZONE("present");
+        SDL_RenderPresent(renderer);
+    }
+    profiler_record(PROF_PRESENT, present_start);
+
+    // --bench-startup stops at the first frame on screen
+    if (startup_bench_enabled()) {
+        startup_bench_mark("first_present");
+        running = false;
+    }
+
+    // Frame time is present to present, so it includes vsync and idle waits
+    if (last_present_counter != 0) {
+        profiler_record(PROF_FRAME, last_present_counter);
+    }
+    last_present_counter = profiler_now();
+    if (state == GAME_STATE_PLAYING) {
+        // The governor sees the work of the frame, not pacing sleeps
+        dyn_res_frame_end(profiler_last_ms(PROF_RENDER) + profiler_last_ms(PROF_PRESENT));
+    }
+    overlay_frame_end();
+    alloc_track_frame_end(state == GAME_STATE_PLAYING);
+    presented_state = state;
+    last_present_ticks = SDL_GetTicks();
+    presented_frames++;
+}
+
+bool is_static_screen(GameState state) {
+    return state != GAME_STATE_PLAYING;
+}
+
+// True while the static screen on display is still accurate
+bool idle_screen_current(const RenderSnapshot* view) {
+    return idle_mode && is_static_screen(view->state) &&
+           (int)view->state == presented_state &&
+           SDL_GetTicks() - last_present_ticks < IDLE_REDRAW_MS;
+}
 
-    SDL_RenderPresent(renderer);
+// Blocks until an event arrives (input, expose, or a state change pushed
+// by the simulation) or the keepalive redraw is due
+void wait_while_idle(const RenderSnapshot* view) {
+    if (!idle_screen_current(view)) {
+        return;
+    }
+
+    Uint32 since_present = SDL_GetTicks() - last_present_ticks;
+    if (since_present < IDLE_REDRAW_MS) {
+        SDL_WaitEventTimeout(NULL, IDLE_REDRAW_MS - since_present);
+    }
+}
+
+void report_presented_frames() {
+    Uint32 now = SDL_GetTicks();
+    if (now - present_report_ticks >= PRESENT_REPORT_MS) {
+        printf("Presented %d frames in the last minute (idle mode %s)\n",
+               presented_frames, idle_mode ? "on" : "off");
+        presented_frames = 0;
+        present_report_ticks = now;
+    }
 }
 
-void render_game_stats() {
-    if (stats.score_text != NULL) {
-        SDL_Rect score_rect = {10, 10, 0, 0};
-        SDL_QueryTexture(stats.score_text, NULL, NULL, &score_rect.w, &score_rect.h);
-        SDL_RenderCopy(renderer, stats.score_text, NULL, &score_rect);
+// One fixed simulation step. Runs on the simulation thread, or inline in
+// main_loop with --single-thread. With rewind held the step goes back
+// through the history instead of forward.
+void sim_step() {
+    TRACE_ZONE("sim_step");
+    int state_before = sim.state;
+
+    Uint8 command;
+    while (spsc_pop(&sim_commands, &command)) {
+        if (spectate_watching()) {
+            // The game shown is someone else's; keys don't start one
+        } else if (command == SIM_CMD_RESET && versus_mode) {
+            versus_request_match(&versus);
+        } else if (command == SIM_CMD_RESET) {
+            sim_reset(&sim);
+            snapshot_ring_reset(&sim);
+        }
+    }
+
+    Uint32 input = (Uint32)SDL_AtomicGet(&input_state);
+    if (spectate_watching()) {
+        Uint32 events = spectate_watch_step(&sim);
+        if (events & SIM_EVENT_BRICK_HIT) sfx_play(SFX_BRICK_HIT);
+        if (events & SIM_EVENT_GAME_OVER) sfx_play(SFX_GAME_OVER);
+        if (events & SIM_EVENT_GAME_WON) sfx_play(SFX_GAME_WON);
+    } else if (versus_mode) {
+        // No rewind against another player; rollback keeps its own history
+        Uint64 update_start = profiler_now();
+        Uint32 events = versus_step(&versus, input & (INPUT_LEFT | INPUT_RIGHT), SDL_GetTicks());
+        if (versus.phase == VERSUS_PLAYING || versus.phase == VERSUS_OVER) {
+            versus_boards(&versus, &sim, &rival);
+        }
+        if (versus.phase == VERSUS_PLAYING) {
+            profiler_record(PROF_UPDATE, update_start);
+        }
+
+        if (events & SIM_EVENT_PADDLE_HIT) sfx_play(SFX_PADDLE_HIT);
+        if (events & SIM_EVENT_BRICK_HIT) sfx_play(SFX_BRICK_HIT);
+        if (sim.state != state_before && sim.state == GAME_STATE_GAME_OVER) sfx_play(SFX_GAME_OVER);
+        if (sim.state != state_before && sim.state == GAME_STATE_WIN_SCREEN) sfx_play(SFX_GAME_WON);
+    } else if (input & INPUT_REWIND) {
+        snapshot_ring_step_back(&sim);
+    } else {
+        // sim_advance's two halves, called apart so movement and
+        // collision are timed as phases of their own
+        Uint32 events = 0;
+        Uint64 update_start = profiler_now();
+        if (sim_move(&sim, input & (INPUT_LEFT | INPUT_RIGHT))) {
+            profiler_record(PROF_UPDATE, update_start);
+
+            Uint64 collision_start = profiler_now();
+            {
+                TRACE_ZONE("collision");
+                events = sim_collide(&sim, sim_ball_x(&sim), sim_ball_y(&sim));
+            }
+            profiler_record(PROF_COLLISION, collision_start);
+        }
+
+        if (events & SIM_EVENT_PADDLE_HIT) sfx_play(SFX_PADDLE_HIT);
+        if (events & SIM_EVENT_BRICK_HIT) sfx_play(SFX_BRICK_HIT);
+        if (events & SIM_EVENT_GAME_OVER) sfx_play(SFX_GAME_OVER);
+        if (events & SIM_EVENT_GAME_WON) sfx_play(SFX_GAME_WON);
+        snapshot_ring_record(&sim);
     }
+    spectate_publish(&sim, SDL_GetTicks());
 
-    if (stats.lives_text != NULL) {
-        SDL_Rect lives_rect = {SCREEN_WIDTH - 150, 10, 0, 0};
-        SDL_QueryTexture(stats.lives_text, NULL, NULL, &lives_rect.w, &lives_rect.h);
-        SDL_RenderCopy(renderer, stats.lives_text, NULL, &lives_rect);
+    // Wake the render loop in case it's idling on a static screen
+    if (sim.state != state_before && sim_event_type != (Uint32)-1) {
+        SDL_Event e = {0};
+        e.type = sim_event_type;
+        SDL_PushEvent(&e);
+    }
+}
+
+void publish_snapshot() {
+    RenderSnapshot* snap = triple_buffer_write_slot(&snapshots);
+    snap->state = (GameState)sim.state;
+    snap->paddle_x = sim.paddle_x;
+    snap->ball_x = sim_ball_x(&sim);
+    snap->ball_y = sim_ball_y(&sim);
+    snap->brick_mask = sim.brick_mask;
+    snap->score = sim.score;
+    snap->lives = sim.lives;
+    snap->versus = versus_mode;
+    snap->rival_score = rival.score;
+    snap->rival_lives = rival.lives;
+    triple_buffer_publish(&snapshots);
+}
+
+// Loads a --resume save into the simulation. Only a game in play is
+// resumed; anything else boots to the start screen as usual.
+bool resume_game(const char* path) {
+    SimState saved;
+    if (!save_state_read(path, &saved) || saved.state != GAME_STATE_PLAYING) {
+        return false;
+    }
+
+    sim = saved;
+    snapshot_ring_reset(&sim);
+    startup_bench_mark("resume");
+    printf("Resumed from %s: score %d, lives %d\n", path, sim.score, sim.lives);
+    return true;
+}
+
+// Called on the way out, which is where the handheld's power switch lands
+// (SDL turns SIGTERM into SDL_QUIT). A game in play is saved; otherwise
+// the old save goes, so the next boot doesn't resume a finished game.
+void suspend_game(const char* path) {
+    if (sim.state != GAME_STATE_PLAYING) {
+        remove(path);
+        return;
+    }
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    if (save_state_write(path, &sim)) {
+        printf("Saved to %s in %.2f ms\n", path,
+               (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency());
+    }
+}
+
+int sim_thread_main(void* data) {
+    (void)data;
+    trace_thread_name("simulation");
+    alloc_track_watch_thread();
+    Uint64 freq = SDL_GetPerformanceFrequency();
+    Uint64 step = freq / SIM_HZ;
+    Uint64 next = SDL_GetPerformanceCounter();
+
+    while (SDL_AtomicGet(&sim_running)) {
+        sim_step();
+        publish_snapshot();
+
+        // Nothing moves on the menus; sleep until a command is queued or
+        // rewind is held. Versus keeps ticking to talk to the peer, and a
+        // spectator to keep up with the stream.
+        if (sim.state != GAME_STATE_PLAYING && !(SDL_AtomicGet(&input_state) & INPUT_REWIND) && !versus_mode &&
+            !spectate_watching()) {
+            SDL_SemWaitTimeout(sim_wakeup, SIM_IDLE_MS);
+            next = SDL_GetPerformanceCounter();
+            continue;
+        }
+
+        // Sleep to the next tick on an absolute schedule, so a late wakeup
+        // shortens the following sleep instead of slowing the game down
+        next += step;
+        Uint64 now = SDL_GetPerformanceCounter();
+        if (now < next) {
+            SDL_Delay((Uint32)((next - now) * 1000 / freq));
+        } else if (now - next > step * SIM_MAX_LAG_STEPS) {
+            next = now;
+        }
+    }
+
+    return 0;
+}
+
+// The scene drawn on the CPU into sw_texture. False if the texture can't
+// be locked, and the caller draws it the usual way.
+bool render_game_software(const RenderSnapshot* view) {
+    TRACE_ZONE("swraster");
+    void* pixels;
+    int pitch;
+    if (SDL_LockTexture(sw_texture, NULL, &pixels, &pitch) != 0) {
+        return false;
+    }
+    SwTarget target = {SCREEN_WIDTH, SCREEN_HEIGHT, pitch / 4, pixels};
+    SwScene scene = {view->brick_mask, view->paddle_x, view->ball_x, view->ball_y,
+                     view->score, view->lives, false};
+    sw_raster_draw(sw_sprites, &scene, &target);
+    SDL_UnlockTexture(sw_texture);
+    draw_texture(sw_texture, NULL, NULL);
+    return true;
+}
+
+void render_game(const RenderSnapshot* view) {
+    TRACE_ZONE("render_game");
+    dyn_res_begin_scene(renderer);
+    SDL_RenderClear(renderer);
+    if (sw_texture != NULL && render_game_software(view)) {
+        dyn_res_end_scene(renderer);
+        render_game_stats(view);
+        present_frame(GAME_STATE_PLAYING);
+        return;
+    }
+    draw_texture(background_texture, NULL, NULL);
+
+    // Draw bricks. Layout and textures never change, only which stand.
+    for (int i = 0; i < BRICK_ROWS; i++) {
+        for (int j = 0; j < BRICK_COLS; j++) {
+            if (view->brick_mask & ((Uint64)1 << (i * BRICK_COLS + j))) {
+                SDL_Rect brickRect = {sim_brick_x(j), sim_brick_y(i), BRICK_WIDTH, BRICK_HEIGHT};
+                draw_texture(brick_textures[sim_brick_type(i)], NULL, &brickRect);
+            }
+        }
+    }
+
+    // Draw paddle
+    SDL_Rect paddleRect = {view->paddle_x, PADDLE_Y, PADDLE_WIDTH, PADDLE_HEIGHT};
+    draw_texture(paddle_texture, NULL, &paddleRect);
+
+    // Draw ball
+    SDL_Rect ballRect = {view->ball_x, view->ball_y, BALL_SIZE, BALL_SIZE};
+    draw_texture(ball_texture, NULL, &ballRect);
+    dyn_res_end_scene(renderer);
+
+    // Draw stats at native resolution
+    render_game_stats(view);
+
+    present_frame(GAME_STATE_PLAYING);
+}
+
+// One --bench-render frame: the synthetic scene through the game's own
+// draw and present path
+void render_bench_step() {
+    SDL_Event e;
+    while (SDL_PollEvent(&e)) {
+        if (e.type == SDL_QUIT) {
+            running = false;
+        }
+    }
+
+    const RenderBenchScene* scene = render_bench_scene();
+    render_start_counter = profiler_now();
+    dyn_res_begin_scene(renderer);
+    SDL_RenderClear(renderer);
+    draw_texture(background_texture, NULL, NULL);
+    for (int i = 0; i < scene->bricks; i++) {
+        BenchRect brick = render_bench_brick(i);
+        SDL_Rect rect = {brick.x, brick.y, brick.w, brick.h};
+        draw_texture(brick_textures[i % 3], NULL, &rect);
+    }
+    for (int i = 0; i < scene->balls; i++) {
+        BenchRect bench_ball = render_bench_ball(i, scene->frame);
+        SDL_Rect rect = {bench_ball.x, bench_ball.y, bench_ball.w, bench_ball.h};
+        draw_texture(ball_texture, NULL, &rect);
+    }
+    dyn_res_end_scene(renderer);
+    char hud[32];
+    snprintf(hud, sizeof(hud), "Score: %d", scene->frame * 10);
+    draw_text(10, 10, hud);
+    present_frame(GAME_STATE_PLAYING);
+
+    if (!render_bench_frame_end(profiler_last_ms(PROF_RENDER), profiler_last_ms(PROF_FRAME),
+                                overlay_last_draw_calls())) {
+        running = false;
+    }
+}
+
+// SDL_mixer isn't called from the simulation thread, so the music is
+// restarted here when a snapshot shows a game has just started
+void update_music(const RenderSnapshot* view) {
+    if ((int)view->state == music_state) {
+        return;
+    }
+    music_state = view->state;
+    if (view->state == GAME_STATE_PLAYING && !Mix_PlayingMusic()) {
+        Mix_PlayMusic(audio.background_music, -1);
     }
 }
 
 void main_loop() {
+    wait_while_idle(triple_buffer_read(&snapshots));
+
+    profiler_poll();
+
+    Uint64 input_start = profiler_now();
+    const RenderSnapshot* view = triple_buffer_read(&snapshots);
     SDL_Event e;
+    bool had_events = false;
 
     while (SDL_PollEvent(&e)) {
-        switch (game_state) {
+        had_events = true;
+        if ((e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_F1 && !e.key.repeat) ||
+            (e.type == SDL_JOYBUTTONDOWN && e.jbutton.button == SELECT_BUTTON)) {
+            overlay_toggle();
+            continue;
+        }
+        // Rewind works on every screen with history behind it, so a lost
+        // ball or a game over can be taken back
+        if (((e.type == SDL_KEYDOWN || e.type == SDL_KEYUP) && e.key.keysym.sym == SDLK_BACKSPACE) ||
+            ((e.type == SDL_JOYBUTTONDOWN || e.type == SDL_JOYBUTTONUP) && e.jbutton.button == A_BUTTON)) {
+            rewind_held = e.type == SDL_KEYDOWN || e.type == SDL_JOYBUTTONDOWN;
+            if (rewind_held && sim_wakeup != NULL) {
+                SDL_SemPost(sim_wakeup);
+            }
+            continue;
+        }
+        switch (view->state) {
             case GAME_STATE_START_SCREEN:
                 handle_start_screen_events(&e);
                 break;
@@ -604,95 +905,183 @@ void main_loop() {
         }
     }
 
-    switch (game_state) {
+    SDL_AtomicSet(&input_state, (move_left ? INPUT_LEFT : 0) | (move_right ? INPUT_RIGHT : 0) |
+                                (rewind_held ? INPUT_REWIND : 0));
+    profiler_record(PROF_INPUT, input_start);
+
+    if (!threaded) {
+        sim_step();
+        publish_snapshot();
+        view = triple_buffer_read(&snapshots);
+    }
+    update_music(view);
+
+    render_start_counter = profiler_now();
+
+    report_presented_frames();
+
+    // A static screen that's already up only needs presenting again after
+    // an event or when the keepalive redraw is due
+    if (!had_events && idle_screen_current(view)) {
+        return;
+    }
+
+    switch (view->state) {
         case GAME_STATE_START_SCREEN:
             render_start_screen();
-            return;
+            break;
         case GAME_STATE_WIN_SCREEN:
             render_end_screen(true);
-            return;
+            break;
         case GAME_STATE_GAME_OVER:
             render_end_screen(false);
-            return;
-        default:
+            break;
+        case GAME_STATE_PLAYING:
+            render_game(view);
             break;
     }
+}
 
-    // Game logic
-    if (game_state == GAME_STATE_PLAYING) {
-        // Update paddle position
-        if (move_left) {
-            paddle.x -= 10;
-        }
-        if (move_right) {
-            paddle.x += 10;
-        }
-
-        // Keep paddle within screen bounds
-        if (paddle.x < 0) paddle.x = 0;
-        if (paddle.x + paddle.width > SCREEN_WIDTH) paddle.x = SCREEN_WIDTH - paddle.width;
-
-        // Update ball position
-        ball.x += ball.dx;
-        ball.y += ball.dy;
-
-        // Ball collision with walls
-        if (ball.x <= 0 || ball.x + ball.size >= SCREEN_WIDTH) {
-            ball.dx = -ball.dx;
+int main(int argc, char* argv[]) {
+    startup_bench_begin();
+    bool profile_at_exit = false;
+    bool show_overlay = false;
+    bool headless = false;
+    const char* profile_csv = NULL;
+    int versus_port = 0;
+    const char* versus_peer = NULL;
+    const char* broadcast_target = NULL;
+    const char* spectate_source = NULL;
+    NetConditions net_conditions = {0};
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--single-thread") == 0) {
+            threaded = false;
+        } else if (strcmp(argv[i], "--no-idle") == 0) {
+            idle_mode = false;
+        } else if (strcmp(argv[i], "--overlay") == 0) {
+            show_overlay = true;
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace_init(argv[++i]);
+        } else if (strcmp(argv[i], "--bench-startup") == 0) {
+            startup_bench_enable();
+        } else if (strcmp(argv[i], "--capture") == 0 && i + 2 < argc) {
+            if (!capture_load(argv[i + 1], argv[i + 2])) {
+                return 1;
+            }
+            i += 2;
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            // The window isn't high-DPI, so the output is always this size
+            if (!record_start(argv[++i], SCREEN_WIDTH, SCREEN_HEIGHT)) {
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--bench-render") == 0) {
+            int frames = RENDER_BENCH_DEFAULT_FRAMES;
+            if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0) {
+                frames = atoi(argv[++i]);
+            }
+            render_bench_init("sdl_renderer", frames);
+        } else if (strcmp(argv[i], "--dynres") == 0) {
+            const char* spec = NULL;
+            if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0) {
+                spec = argv[++i];
+            }
+            if (!dyn_res_configure(spec)) {
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--swraster") == 0) {
+            sw_raster_request = 0;
+            if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0) {
+                sw_raster_request = atoi(argv[++i]);
+            }
+        } else if (strcmp(argv[i], "--versus") == 0 && i + 2 < argc) {
+            // --versus <local port> <peer host:port>
+            versus_port = atoi(argv[i + 1]);
+            versus_peer = argv[i + 2];
+            i += 2;
+        } else if (strcmp(argv[i], "--netsim") == 0 && i + 1 < argc) {
+            if (!net_conditions_parse(argv[++i], &net_conditions)) {
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--broadcast") == 0 && i + 1 < argc) {
+            broadcast_target = argv[++i];
+        } else if (strcmp(argv[i], "--spectate") == 0 && i + 1 < argc) {
+            spectate_source = argv[++i];
+        } else if (strcmp(argv[i], "--resume") == 0) {
+            resume_path = SAVE_STATE_DEFAULT_PATH;
+            if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0) {
+                resume_path = argv[++i];
+            }
+        } else if (strcmp(argv[i], "--headless") == 0) {
+            // The offscreen video driver keeps windows and events working
+            // without a display, and the dummy audio driver without a sound
+            // card; both have to be picked before SDL_Init
+            SDL_setenv("SDL_VIDEODRIVER", "offscreen", 1);
+            SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+            headless = true;
+        } else if (strcmp(argv[i], "--alloc-check") == 0) {
+            AllocCheckMode mode = ALLOC_CHECK_LOG;
+            if (i + 1 < argc && strcmp(argv[i + 1], "abort") == 0) {
+                mode = ALLOC_CHECK_ABORT;
+                i++;
+            }
+            alloc_track_init(mode);
+        } else if (strcmp(argv[i], "--profile") == 0) {
+            profile_at_exit = true;
+            if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0) {
+                profile_csv = argv[++i];
+            }
         }
-        if (ball.y <= SCORE_HEIGHT) {
-            ball.dy = -ball.dy;
+    }
+    profiler_init(profile_at_exit, profile_csv);
+
+    // Seed for the simulation's random generator. Captures replay a script
+    // frame by frame, so they run the simulation inline and present every
+    // frame
+    Uint32 seed;
+    if (capture_active()) {
+        seed = capture_seed();
+        threaded = false;
+        idle_mode = false;
+    } else {
+        seed = (Uint32)time(NULL);
+    }
+    if (render_bench_active()) {
+        threaded = false;
+        idle_mode = false;
+    }
+    // A recording gets a frame per present, menus included
+    if (record_active()) {
+        idle_mode = false;
+    }
+    // Each machine picks a nonce; the pair of them makes the match seed
+    // and decides who plays board 1
+    if (versus_peer != NULL) {
+        Uint32 nonce = (Uint32)SDL_GetPerformanceCounter() ^ (Uint32)time(NULL) * 2654435761u;
+        if (!versus_open(&versus, versus_port, versus_peer, &net_conditions, nonce)) {
+            return 1;
         }
-
-        // Handle collisions
-        handle_paddle_collision();
-        handle_brick_collisions();
-        handle_ball_loss();
-
-        // Check win condition
-        if (check_all_bricks_destroyed()) {
-            game_state = GAME_STATE_WIN_SCREEN;
-            return;
+        versus_mode = true;
+    }
+    if (broadcast_target != NULL && !spectate_publish_open(broadcast_target)) {
+        return 1;
+    }
+    spectate_publish_loss(net_conditions.loss_percent);
+    if (spectate_source != NULL) {
+        if (versus_mode || broadcast_target != NULL) {
+            printf("--spectate only shows a game; it can't play or broadcast one\n");
+            return 1;
         }
-
-        // Render game
-        SDL_RenderClear(renderer);
-        SDL_RenderCopy(renderer, background_texture, NULL, NULL);
-
-        // Draw bricks
-        for (int i = 0; i < BRICK_ROWS; i++) {
-            for (int j = 0; j < BRICK_COLS; j++) {
-                if (!bricks[i][j].destroyed) {
-                    SDL_Rect brickRect = {bricks[i][j].x, bricks[i][j].y, BRICK_WIDTH, BRICK_HEIGHT};
-                    SDL_RenderCopy(renderer, bricks[i][j].texture, NULL, &brickRect);
-                }
-            }
+        if (!spectate_watch_open(spectate_source)) {
+            return 1;
         }
-
-        // Draw paddle
-        SDL_Rect paddleRect = {paddle.x, paddle.y, paddle.width, paddle.height};
-        SDL_RenderCopy(renderer, paddle.texture, NULL, &paddleRect);
-
-        // Draw ball
-        SDL_Rect ballRect = {ball.x, ball.y, ball.size, ball.size};
-        SDL_RenderCopy(renderer, ball.texture, NULL, &ballRect);
-
-        // Draw stats
-        render_game_stats();
-
-        SDL_RenderPresent(renderer);
     }
-}
-
-int main(void) {
-    // Seed random number generator
-    srand(time(NULL));
 
     // Initialize SDL
     if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_JOYSTICK) != 0) {
         printf("SDL_Init Error: %s\n", SDL_GetError());
         return 1;
     }
+    startup_bench_mark("SDL_Init");
 
     // Initialize SDL_image
     int imgFlags = IMG_INIT_PNG;
@@ -701,6 +1090,7 @@ int main(void) {
         SDL_Quit();
         return 1;
     }
+    startup_bench_mark("IMG_Init");
 
     // Initialize SDL_ttf
     if (TTF_Init() == -1) {
@@ -709,6 +1099,7 @@ int main(void) {
         SDL_Quit();
         return 1;
     }
+    startup_bench_mark("TTF_Init");
 
     // Initialize audio
     if (!init_audio()) {
@@ -740,6 +1131,7 @@ int main(void) {
         SDL_Quit();
         return 1;
     }
+    startup_bench_mark("fonts/arial.ttf");
 
     // Create window
     win = SDL_CreateWindow("BrickCrush",
@@ -757,10 +1149,23 @@ int main(void) {
         return 1;
     }
 
-    // Create renderer
-    renderer = SDL_CreateRenderer(win, -1,
-        SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+    startup_bench_mark("SDL_CreateWindow");
+
+    // Create renderer. Headless runs draw with the software renderer into
+    // a surface of their own, so presenting never touches a display
+    if (headless) {
+        headless_target = SDL_CreateRGBSurfaceWithFormat(0, SCREEN_WIDTH, SCREEN_HEIGHT,
+                                                         32, SDL_PIXELFORMAT_ARGB8888);
+        if (headless_target != NULL) {
+            renderer = SDL_CreateSoftwareRenderer(headless_target);
+        }
+    } else {
+        // Benchmarks measure how fast frames can go, so no vsync there
+        renderer = SDL_CreateRenderer(win, -1,
+            SDL_RENDERER_ACCELERATED | (render_bench_active() ? 0 : SDL_RENDERER_PRESENTVSYNC));
+    }
     if (renderer == NULL) {
+        if (headless_target != NULL) SDL_FreeSurface(headless_target);
         SDL_DestroyWindow(win);
         printf("SDL_CreateRenderer Error: %s\n", SDL_GetError());
         TTF_CloseFont(font_menu);
@@ -773,10 +1178,20 @@ int main(void) {
         return 1;
     }
 
-    // Initialize game objects and load textures
-    if (!init_game_objects()) {
+    startup_bench_mark("SDL_CreateRenderer");
+
+    // Initialize game objects and load textures. A suspended game comes
+    // back straight into play and leaves the menu screens for later.
+    bool loaded = init_game_objects(seed);
+    if (loaded && resume_path != NULL && !capture_active() && !versus_mode && !spectate_watching() && resume_game(resume_path)) {
+        menus_pending = true;
+    } else if (loaded) {
+        loaded = load_menu_textures();
+    }
+    if (!loaded) {
         cleanup_game_objects();
         SDL_DestroyRenderer(renderer);
+        if (headless_target != NULL) SDL_FreeSurface(headless_target);
         SDL_DestroyWindow(win);
         TTF_CloseFont(font_menu);
         TTF_CloseFont(font_hud);
@@ -788,18 +1203,109 @@ int main(void) {
         return 1;
     }
 
+    // Without render targets the game just stays at native resolution
+    dyn_res_init(renderer, SCREEN_WIDTH, SCREEN_HEIGHT);
+
+    if (sw_raster_request >= 0 && !init_sw_raster()) {
+        printf("swraster: falling back to the renderer\n");
+        cleanup_sw_raster();
+    }
+
+    // The overlay is a debugging aid, so the game runs without it
+    if (overlay_init(renderer, "fonts/arial.ttf") && show_overlay) {
+        overlay_toggle();
+    }
+    startup_bench_mark("overlay");
+
     // Start background music
     Mix_PlayMusic(audio.background_music, -1);
 
+    // Hand the first snapshot over before anyone reads one
+    triple_buffer_init(&snapshots, &snapshot_slots[0], &snapshot_slots[1], &snapshot_slots[2]);
+    spsc_init(&sim_commands);
+    publish_snapshot();
+
+    sim_event_type = SDL_RegisterEvents(1);
+    present_report_ticks = SDL_GetTicks();
+
+    if (threaded) {
+        sim_wakeup = SDL_CreateSemaphore(0);
+        SDL_AtomicSet(&sim_running, 1);
+        sim_thread = SDL_CreateThread(sim_thread_main, "simulation", NULL);
+        if (sim_thread == NULL) {
+            printf("SDL_CreateThread Error: %s, running single-threaded\n", SDL_GetError());
+            threaded = false;
+        }
+    }
+
+    // Startup allocations are expected; only the loop is watched
+    alloc_track_watch_thread();
+
     // Main game loop
     while (running) {
-        main_loop();
-        SDL_Delay(16);  // Cap to roughly 60 FPS
+        // A resumed game loads the menu screens once its first frame is up
+        if (menus_pending && presented_state != -1) {
+            menus_pending = false;
+            if (!load_menu_textures()) {
+                break;
+            }
+        }
+        if (threaded) {
+            // The simulation keeps its own clock; just don't spin if
+            // vsync isn't throttling the present
+            Uint32 frame_start = SDL_GetTicks();
+            main_loop();
+            Uint32 frame_time = SDL_GetTicks() - frame_start;
+            if (frame_time < FRAME_MS) {
+                SDL_Delay(FRAME_MS - frame_time);
+            }
+        } else if (render_bench_active()) {
+            render_bench_step();
+        } else if (capture_active()) {
+            // Frames are counted, not timed, so don't wait between them
+            if (!capture_begin_frame()) {
+                break;
+            }
+            main_loop();
+        } else {
+            main_loop();
+            SDL_Delay(16);  // Cap to roughly 60 FPS
+        }
+    }
+
+    if (sim_thread != NULL) {
+        SDL_AtomicSet(&sim_running, 0);
+        SDL_SemPost(sim_wakeup);
+        SDL_WaitThread(sim_thread, NULL);
+    }
+    if (sim_wakeup != NULL) {
+        SDL_DestroySemaphore(sim_wakeup);
     }
 
+    // The simulation has stopped, so its state can be saved as it stands
+    if (resume_path != NULL && !versus_mode && !spectate_watching()) {
+        suspend_game(resume_path);
+    }
+    spectate_publish_close();
+    spectate_watch_close();
+    if (versus_mode) {
+        versus_report(&versus);
+        versus_close(&versus);
+    }
+
+    profiler_shutdown();
+    trace_shutdown();
+    alloc_track_report();
+    capture_shutdown();
+    record_stop();
+
     // Cleanup everything
+    cleanup_sw_raster();
+    dyn_res_cleanup();
+    overlay_cleanup();
     cleanup_game_objects();
     SDL_DestroyRenderer(renderer);
+    if (headless_target != NULL) SDL_FreeSurface(headless_target);
     SDL_DestroyWindow(win);
     TTF_CloseFont(font_menu);
     TTF_CloseFont(font_hud);
@@ -809,5 +1315,7 @@ int main(void) {
     IMG_Quit();
     SDL_Quit();
 
+    startup_bench_mark("exit");
+    startup_bench_report();
     return 0;
 }
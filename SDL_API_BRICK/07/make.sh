@@ -1 +1,9 @@
-gcc -o brickout main.c -Wall -Wextra -O2 -lSDL2 -lSDL2_image -lSDL2_ttf -lSDL2_mixer -lm
+gcc -o brickout main.c sfx.c handoff.c profiler.c trace.c overlay.c text_atlas.c alloc_track.c startup.c capture.c record.c render_bench.c dyn_res.c sim.c snapshot_ring.c save_state.c swraster.c versus.c net_link.c spectate.c -Wall -Wextra -O2 ${TRACE:+-DTRACE_ENABLED} ${ALLOC_TRACK:+-DALLOC_TRACK -rdynamic} -lSDL2 -lSDL2_image -lSDL2_ttf -lSDL2_mixer -lm -pthread
+gcc -o sfx_bench sfx_bench.c sfx.c handoff.c -Wall -Wextra -O2 -lSDL2 -lSDL2_mixer -lm
+gcc -o frame_diff frame_diff.c -Wall -Wextra -O2 -lSDL2 -lSDL2_image
+gcc -o sim_check sim_check.c sim.c -Wall -Wextra -O2
+gcc -o env_bench env_bench.c env_batch.c sim.c -Wall -Wextra -O3
+gcc -shared -fPIC -o libbrickenv.so env_batch.c sim.c -Wall -Wextra -O3
+gcc -o sw_bench sw_bench.c swraster.c sim.c -Wall -Wextra -O3 -lSDL2 -lSDL2_image -pthread
+gcc -o versus_check versus_check.c versus.c net_link.c sim.c -Wall -Wextra -O2 -lSDL2
+gcc -o spectate_check spectate_check.c spectate.c sim.c -Wall -Wextra -O2 -lSDL2
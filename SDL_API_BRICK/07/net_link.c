@@ -0,0 +1,173 @@
+#include "net_link.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static bool parse_option(NetConditions* conditions, const char* key, const char* value) {
+    char* end;
+    long number = strtol(value, &end, 10);
+    if (*end != '\0' || number < 0) return false;
+
+    if (strcmp(key, "latency") == 0) {
+        conditions->latency_ms = (int)number;
+    } else if (strcmp(key, "jitter") == 0) {
+        conditions->jitter_ms = (int)number;
+    } else if (strcmp(key, "loss") == 0 && number <= 100) {
+        conditions->loss_percent = (int)number;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool net_conditions_parse(const char* spec, NetConditions* conditions) {
+    char options[256];
+    snprintf(options, sizeof(options), "%s", spec);
+    for (char* option = strtok(options, ","); option != NULL; option = strtok(NULL, ",")) {
+        char* value = strchr(option, '=');
+        if (value == NULL) {
+            printf("net_link: expected key=value, got %s\n", option);
+            return false;
+        }
+        *value++ = '\0';
+        if (!parse_option(conditions, option, value)) {
+            printf("net_link: bad option %s=%s\n", option, value);
+            return false;
+        }
+    }
+    if (conditions->jitter_ms > conditions->latency_ms) {
+        printf("net_link: jitter can't be more than latency\n");
+        return false;
+    }
+    return true;
+}
+
+static bool resolve_peer(const char* peer, struct sockaddr_in* address) {
+    char host[128];
+    snprintf(host, sizeof(host), "%s", peer);
+    char* port = strrchr(host, ':');
+    if (port == NULL) {
+        printf("net_link: expected host:port, got %s\n", peer);
+        return false;
+    }
+    *port++ = '\0';
+
+    struct addrinfo hints = {0};
+    struct addrinfo* found = NULL;
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    int error = getaddrinfo(host, port, &hints, &found);
+    if (error != 0) {
+        printf("net_link: can't resolve %s: %s\n", peer, gai_strerror(error));
+        return false;
+    }
+    memcpy(address, found->ai_addr, sizeof(*address));
+    freeaddrinfo(found);
+    return true;
+}
+
+bool net_link_open(NetLink* link, int local_port, const char* peer, const NetConditions* conditions) {
+    memset(link, 0, sizeof(*link));
+    link->socket = -1;
+    link->conditions = *conditions;
+    link->rng = 0x2545F491u ^ (uint32_t)local_port;
+    if (!resolve_peer(peer, &link->peer)) {
+        return false;
+    }
+
+    link->socket = socket(AF_INET, SOCK_DGRAM, 0);
+    if (link->socket < 0) {
+        printf("net_link: socket: %s\n", strerror(errno));
+        return false;
+    }
+    struct sockaddr_in local = {0};
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    local.sin_port = htons((uint16_t)local_port);
+    if (bind(link->socket, (struct sockaddr*)&local, sizeof(local)) != 0 ||
+        fcntl(link->socket, F_SETFL, fcntl(link->socket, F_GETFL) | O_NONBLOCK) != 0) {
+        printf("net_link: can't use port %d: %s\n", local_port, strerror(errno));
+        net_link_close(link);
+        return false;
+    }
+    return true;
+}
+
+void net_link_close(NetLink* link) {
+    if (link->socket >= 0) {
+        close(link->socket);
+        link->socket = -1;
+    }
+}
+
+static uint32_t next_random(NetLink* link) {
+    link->rng ^= link->rng << 13;
+    link->rng ^= link->rng >> 17;
+    link->rng ^= link->rng << 5;
+    return link->rng;
+}
+
+static void send_now(NetLink* link, const void* bytes, int size) {
+    // A full socket buffer is just one more lost datagram to the protocol
+    sendto(link->socket, bytes, (size_t)size, 0, (const struct sockaddr*)&link->peer, sizeof(link->peer));
+}
+
+void net_link_send(NetLink* link, const void* bytes, int size, uint32_t now_ms) {
+    if (size > NET_LINK_MAX_PACKET) return;
+    link->sent++;
+
+    const NetConditions* conditions = &link->conditions;
+    if (conditions->loss_percent > 0 && (int)(next_random(link) % 100) < conditions->loss_percent) {
+        link->dropped++;
+        return;
+    }
+    if (conditions->latency_ms == 0) {
+        send_now(link, bytes, size);
+        return;
+    }
+    if (link->delayed_count == NET_LINK_DELAY_SLOTS) {
+        link->dropped++;
+        return;
+    }
+
+    int delay = conditions->latency_ms;
+    if (conditions->jitter_ms > 0) {
+        delay += (int)(next_random(link) % (uint32_t)(2 * conditions->jitter_ms + 1)) - conditions->jitter_ms;
+    }
+    DelayedPacket* packet = &link->delayed[link->delayed_count++];
+    packet->due_ms = now_ms + (uint32_t)delay;
+    packet->size = (uint16_t)size;
+    memcpy(packet->bytes, bytes, (size_t)size);
+}
+
+int net_link_receive(NetLink* link, void* buffer, int capacity, uint32_t now_ms) {
+    // Due datagrams go out in slot order, which jitter has already shuffled
+    for (int i = 0; i < link->delayed_count; ) {
+        DelayedPacket* packet = &link->delayed[i];
+        if ((int32_t)(now_ms - packet->due_ms) >= 0) {
+            send_now(link, packet->bytes, packet->size);
+            *packet = link->delayed[--link->delayed_count];
+            continue;
+        }
+        i++;
+    }
+
+    for (;;) {
+        struct sockaddr_in from;
+        socklen_t from_size = sizeof(from);
+        ssize_t size = recvfrom(link->socket, buffer, (size_t)capacity, 0, (struct sockaddr*)&from, &from_size);
+        if (size <= 0) {
+            return 0;
+        }
+        if (from.sin_addr.s_addr == link->peer.sin_addr.s_addr && from.sin_port == link->peer.sin_port) {
+            link->received++;
+            return (int)size;
+        }
+    }
+}
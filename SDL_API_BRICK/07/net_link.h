@@ -0,0 +1,60 @@
+#ifndef NET_LINK_H
+#define NET_LINK_H
+
+#include <netinet/in.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// One non-blocking UDP socket talking to one peer, with a built-in
+// network-condition simulator for trying the versus mode between two
+// processes on loopback. With --netsim latency=ms,jitter=ms,loss=percent
+// every outgoing datagram is dropped with the loss odds or held in a
+// delay line for latency plus or minus jitter (so they can arrive out of
+// order). Each side delays only what it sends, so the same settings on
+// both give a round trip of twice the latency. Times are the caller's
+// milliseconds, so a test can run on a clock of its own.
+
+#define NET_LINK_MAX_PACKET 256
+#define NET_LINK_DELAY_SLOTS 256    // Datagrams in flight in the delay line
+
+typedef struct {
+    int latency_ms;
+    int jitter_ms;
+    int loss_percent;
+} NetConditions;
+
+typedef struct {
+    uint32_t due_ms;
+    uint16_t size;
+    uint8_t bytes[NET_LINK_MAX_PACKET];
+} DelayedPacket;
+
+typedef struct {
+    int socket;
+    struct sockaddr_in peer;
+    NetConditions conditions;
+    uint32_t rng;
+    DelayedPacket delayed[NET_LINK_DELAY_SLOTS];
+    int delayed_count;
+
+    uint32_t sent;          // Datagrams handed to the link
+    uint32_t received;
+    uint32_t dropped;       // By the simulated loss, or a full delay line
+} NetLink;
+
+// "latency=ms,jitter=ms,loss=percent"; prints the problem and returns
+// false on a bad spec
+bool net_conditions_parse(const char* spec, NetConditions* conditions);
+
+// Binds local_port on every interface and aims at peer, "host:port".
+// Datagrams from anywhere else are ignored.
+bool net_link_open(NetLink* link, int local_port, const char* peer, const NetConditions* conditions);
+void net_link_close(NetLink* link);
+
+void net_link_send(NetLink* link, const void* bytes, int size, uint32_t now_ms);
+
+// Sends whatever the delay line has due, then returns the size of the
+// next datagram from the peer copied into buffer, or 0 when none is waiting
+int net_link_receive(NetLink* link, void* buffer, int capacity, uint32_t now_ms);
+
+#endif // NET_LINK_H
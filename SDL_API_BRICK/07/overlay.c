@@ -0,0 +1,168 @@
+#include "overlay.h"
+#include "profiler.h"
+#include "text_atlas.h"
+#include <stdio.h>
+
+#define PANEL_PADDING 6
+#define GRAPH_BAR_WIDTH 2
+#define GRAPH_HEIGHT 60
+#define GRAPH_PX_PER_MS 2       // 30 ms fills the graph
+#define FRAME_BUDGET_MS (1000.0 / 60.0)
+
+static TextAtlas font_atlas;
+static bool visible = false;
+
+static double frame_ms[OVERLAY_HISTORY];
+static int frame_head = 0;      // Next slot to write
+
+static SDL_Texture* last_texture = NULL;
+static int draw_calls = 0;
+static int texture_binds = 0;
+static int shown_draw_calls = 0;    // Totals of the previous frame
+static int shown_texture_binds = 0;
+
+bool overlay_init(SDL_Renderer* renderer, const char* font_path) {
+    TTF_Font* font = TTF_OpenFont(font_path, OVERLAY_FONT_SIZE);
+    if (font == NULL) {
+        printf("TTF_OpenFont Error for the overlay: %s\n", TTF_GetError());
+        return false;
+    }
+
+    SDL_Color white = {255, 255, 255, 255};
+    bool created = text_atlas_create(&font_atlas, renderer, font, white);
+    TTF_CloseFont(font);
+    return created;
+}
+
+void overlay_toggle(void) {
+    visible = !visible && font_atlas.texture != NULL;
+}
+
+bool overlay_visible(void) {
+    return visible;
+}
+
+void overlay_count_draw(SDL_Texture* texture) {
+    draw_calls++;
+    if (texture != last_texture) {
+        texture_binds++;
+        last_texture = texture;
+    }
+}
+
+static void draw_text(SDL_Renderer* renderer, int x, int y, const char* text) {
+    for (const char* c = text; *c != '\0'; c++) {
+        const SDL_Rect* glyph = text_atlas_glyph(&font_atlas, *c);
+        if (glyph == NULL) {
+            continue;
+        }
+        SDL_Rect dst = {x, y, glyph->w, glyph->h};
+        SDL_RenderCopy(renderer, font_atlas.texture, glyph, &dst);
+        x += glyph->w;
+    }
+}
+
+static double average_fps(void) {
+    double total = 0.0;
+    int count = 0;
+    for (int i = 0; i < OVERLAY_HISTORY; i++) {
+        if (frame_ms[i] > 0.0) {
+            total += frame_ms[i];
+            count++;
+        }
+    }
+    return total > 0.0 ? count * 1000.0 / total : 0.0;
+}
+
+void overlay_draw(SDL_Renderer* renderer, int x, int y) {
+    if (!visible) {
+        return;
+    }
+
+    Uint8 r, g, b, a;
+    SDL_BlendMode blend;
+    SDL_GetRenderDrawColor(renderer, &r, &g, &b, &a);
+    SDL_GetRenderDrawBlendMode(renderer, &blend);
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+
+    const int graph_width = OVERLAY_HISTORY * GRAPH_BAR_WIDTH;
+    const int text_lines = 4;
+    SDL_Rect panel = {
+        x, y,
+        graph_width + 2 * PANEL_PADDING,
+        text_lines * font_atlas.line_height + GRAPH_HEIGHT + 3 * PANEL_PADDING
+    };
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 160);
+    SDL_RenderFillRect(renderer, &panel);
+
+    char line[64];
+    int text_x = x + PANEL_PADDING;
+    int text_y = y + PANEL_PADDING;
+    double latest = frame_ms[(frame_head + OVERLAY_HISTORY - 1) % OVERLAY_HISTORY];
+    snprintf(line, sizeof(line), "FPS %.1f  frame %.2f ms", average_fps(), latest);
+    draw_text(renderer, text_x, text_y, line);
+    text_y += font_atlas.line_height;
+    snprintf(line, sizeof(line), "sim %.2f ms",
+             profiler_last_ms(PROF_UPDATE) + profiler_last_ms(PROF_COLLISION));
+    draw_text(renderer, text_x, text_y, line);
+    text_y += font_atlas.line_height;
+    snprintf(line, sizeof(line), "render %.2f ms", profiler_last_ms(PROF_RENDER));
+    draw_text(renderer, text_x, text_y, line);
+    text_y += font_atlas.line_height;
+    snprintf(line, sizeof(line), "draws %d  binds %d", shown_draw_calls, shown_texture_binds);
+    draw_text(renderer, text_x, text_y, line);
+    text_y += font_atlas.line_height + PANEL_PADDING;
+
+    // Oldest frame on the left; frames over budget go in a second batch
+    SDL_Rect bars[OVERLAY_HISTORY];
+    SDL_Rect slow_bars[OVERLAY_HISTORY];
+    int bar_count = 0;
+    int slow_count = 0;
+    int graph_bottom = text_y + GRAPH_HEIGHT;
+    for (int i = 0; i < OVERLAY_HISTORY; i++) {
+        double ms = frame_ms[(frame_head + i) % OVERLAY_HISTORY];
+        int height = (int)(ms * GRAPH_PX_PER_MS);
+        if (height > GRAPH_HEIGHT) height = GRAPH_HEIGHT;
+        if (height <= 0) continue;
+
+        SDL_Rect bar = {text_x + i * GRAPH_BAR_WIDTH, graph_bottom - height, GRAPH_BAR_WIDTH, height};
+        if (ms > FRAME_BUDGET_MS + 1.0) {
+            slow_bars[slow_count++] = bar;
+        } else {
+            bars[bar_count++] = bar;
+        }
+    }
+    SDL_SetRenderDrawColor(renderer, 80, 220, 80, 255);
+    SDL_RenderFillRects(renderer, bars, bar_count);
+    SDL_SetRenderDrawColor(renderer, 230, 60, 60, 255);
+    SDL_RenderFillRects(renderer, slow_bars, slow_count);
+
+    // 60 Hz budget line
+    SDL_Rect budget = {text_x, graph_bottom - (int)(FRAME_BUDGET_MS * GRAPH_PX_PER_MS), graph_width, 1};
+    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 128);
+    SDL_RenderFillRect(renderer, &budget);
+
+    SDL_SetRenderDrawColor(renderer, r, g, b, a);
+    SDL_SetRenderDrawBlendMode(renderer, blend);
+}
+
+void overlay_frame_end(void) {
+    // Kept while hidden too, so the graph is full as soon as it's shown
+    frame_ms[frame_head] = profiler_last_ms(PROF_FRAME);
+    frame_head = (frame_head + 1) % OVERLAY_HISTORY;
+
+    shown_draw_calls = draw_calls;
+    shown_texture_binds = texture_binds;
+    draw_calls = 0;
+    texture_binds = 0;
+    last_texture = NULL;
+}
+
+int overlay_last_draw_calls(void) {
+    return shown_draw_calls;
+}
+
+void overlay_cleanup(void) {
+    text_atlas_destroy(&font_atlas);
+    visible = false;
+}
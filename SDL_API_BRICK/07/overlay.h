@@ -0,0 +1,31 @@
+#ifndef OVERLAY_H
+#define OVERLAY_H
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+
+// Performance overlay: FPS, a graph of the last OVERLAY_HISTORY frame
+// times, simulation and render time from the profiler, and the draw calls
+// and texture binds of the previous frame. Text comes from a TextAtlas
+// built once at startup, so drawing the overlay never touches SDL_ttf and
+// goes through the same renderer batch as the game.
+
+#define OVERLAY_HISTORY 120     // Frames shown in the graph
+#define OVERLAY_FONT_SIZE 14
+
+bool overlay_init(SDL_Renderer* renderer, const char* font_path);
+void overlay_toggle(void);
+bool overlay_visible(void);
+
+// Call for every sprite the game draws; the overlay's own draws aren't
+// counted
+void overlay_count_draw(SDL_Texture* texture);
+
+// Draw after the frame's render time has been recorded, right before the
+// present; overlay_frame_end goes right after it
+void overlay_draw(SDL_Renderer* renderer, int x, int y);
+void overlay_frame_end(void);
+int overlay_last_draw_calls(void);  // The game's draws in the frame just presented
+void overlay_cleanup(void);
+
+#endif // OVERLAY_H
@@ -0,0 +1,144 @@
+#include "profiler.h"
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef struct {
+    Uint32 samples[PROFILER_RING_SIZE];  // Nanoseconds
+    Uint32 head;                         // Total recorded; wraps the ring
+} PhaseRing;
+
+static const char* phase_names[PROF_PHASE_COUNT] = {
+    "input", "update", "collision", "render", "present", "frame"
+};
+
+// Each ring has a single writer thread; reports read them from the main
+// thread, so a report taken mid-game may see a sample being replaced
+static PhaseRing rings[PROF_PHASE_COUNT];
+static Uint32 sort_scratch[PROFILER_RING_SIZE];
+static Uint64 counter_frequency = 1;
+static bool report_at_exit = false;
+static const char* csv_output = "profile.csv";
+static volatile sig_atomic_t report_requested = 0;
+
+static void handle_report_signal(int sig) {
+    (void)sig;
+    report_requested = 1;
+}
+
+void profiler_init(bool report_on_exit, const char* csv_path) {
+    counter_frequency = SDL_GetPerformanceFrequency();
+    report_at_exit = report_on_exit;
+    if (csv_path != NULL) {
+        csv_output = csv_path;
+    }
+    memset(rings, 0, sizeof(rings));
+    signal(SIGUSR1, handle_report_signal);
+}
+
+Uint64 profiler_now(void) {
+    return SDL_GetPerformanceCounter();
+}
+
+void profiler_record(ProfPhase phase, Uint64 start) {
+    Uint64 ticks = SDL_GetPerformanceCounter() - start;
+    // Split so the multiply can't overflow on nanosecond counters
+    Uint64 ns = ticks / counter_frequency * 1000000000ull +
+                ticks % counter_frequency * 1000000000ull / counter_frequency;
+
+    PhaseRing* ring = &rings[phase];
+    ring->samples[ring->head % PROFILER_RING_SIZE] = ns > 0xFFFFFFFFull ? 0xFFFFFFFFu : (Uint32)ns;
+    ring->head++;
+}
+
+double profiler_last_ms(ProfPhase phase) {
+    const PhaseRing* ring = &rings[phase];
+    Uint32 head = ring->head;
+    if (head == 0) {
+        return 0.0;
+    }
+    return ring->samples[(head - 1) % PROFILER_RING_SIZE] / 1000000.0;
+}
+
+static int ring_count(const PhaseRing* ring) {
+    return ring->head < PROFILER_RING_SIZE ? (int)ring->head : PROFILER_RING_SIZE;
+}
+
+// Shell sort in place: no allocation, unlike glibc's qsort
+static void sort_samples(Uint32* values, int count) {
+    for (int gap = count / 2; gap > 0; gap /= 2) {
+        for (int i = gap; i < count; i++) {
+            Uint32 value = values[i];
+            int j = i;
+            while (j >= gap && values[j - gap] > value) {
+                values[j] = values[j - gap];
+                j -= gap;
+            }
+            values[j] = value;
+        }
+    }
+}
+
+static double percentile_ms(const Uint32* sorted, int count, int percent) {
+    return sorted[(count - 1) * percent / 100] / 1000000.0;
+}
+
+void profiler_report(void) {
+    printf("Frame phase timings (ms), last %d samples per phase:\n", PROFILER_RING_SIZE);
+    printf("%-10s %8s %8s %8s %8s %8s\n", "phase", "samples", "p50", "p95", "p99", "max");
+
+    for (int phase = 0; phase < PROF_PHASE_COUNT; phase++) {
+        int count = ring_count(&rings[phase]);
+        if (count == 0) {
+            printf("%-10s %8d %8s %8s %8s %8s\n", phase_names[phase], 0, "-", "-", "-", "-");
+            continue;
+        }
+
+        memcpy(sort_scratch, rings[phase].samples, count * sizeof(Uint32));
+        sort_samples(sort_scratch, count);
+        printf("%-10s %8d %8.3f %8.3f %8.3f %8.3f\n", phase_names[phase], count,
+               percentile_ms(sort_scratch, count, 50),
+               percentile_ms(sort_scratch, count, 95),
+               percentile_ms(sort_scratch, count, 99),
+               sort_scratch[count - 1] / 1000000.0);
+    }
+}
+
+static bool dump_csv(const char* path) {
+    FILE* file = fopen(path, "w");
+    if (file == NULL) {
+        printf("Failed to open %s for the profile dump\n", path);
+        return false;
+    }
+
+    // One row per sample, oldest first within each phase
+    fprintf(file, "phase,sample,ms\n");
+    for (int phase = 0; phase < PROF_PHASE_COUNT; phase++) {
+        const PhaseRing* ring = &rings[phase];
+        int count = ring_count(ring);
+        Uint32 first = ring->head - count;
+        for (int i = 0; i < count; i++) {
+            Uint32 sample = ring->samples[(first + i) % PROFILER_RING_SIZE];
+            fprintf(file, "%s,%u,%.6f\n", phase_names[phase], first + i, sample / 1000000.0);
+        }
+    }
+
+    fclose(file);
+    printf("Wrote frame profile to %s\n", path);
+    return true;
+}
+
+void profiler_poll(void) {
+    if (report_requested) {
+        report_requested = 0;
+        profiler_report();
+        dump_csv(csv_output);
+    }
+}
+
+void profiler_shutdown(void) {
+    if (report_at_exit) {
+        profiler_report();
+        dump_csv(csv_output);
+    }
+}
@@ -0,0 +1,32 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+
+// Frame phase profiler. Each phase keeps its most recent durations in a
+// fixed ring, so recording never allocates. The p50/p95/p99/max report and
+// CSV dump happen on exit (with --profile) or whenever the process gets
+// SIGUSR1.
+
+#define PROFILER_RING_SIZE 4096  // Samples kept per phase (power of two)
+
+typedef enum {
+    PROF_INPUT,
+    PROF_UPDATE,
+    PROF_COLLISION,
+    PROF_RENDER,
+    PROF_PRESENT,
+    PROF_FRAME,
+    PROF_PHASE_COUNT
+} ProfPhase;
+
+void profiler_init(bool report_on_exit, const char* csv_path);
+Uint64 profiler_now(void);
+void profiler_record(ProfPhase phase, Uint64 start);
+double profiler_last_ms(ProfPhase phase);  // Newest sample, 0 before any
+void profiler_poll(void);
+void profiler_report(void);
+void profiler_shutdown(void);
+
+#endif // PROFILER_H
@@ -0,0 +1,340 @@
+#include "record.h"
+#include "handoff.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define RECORD_USE_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define RECORD_USE_SSE2 1
+#endif
+
+#define RECORD_FILE_BUFFER (1 << 20)
+
+static FILE* file = NULL;
+static const char* output = NULL;
+static int width = 0;
+static int height = 0;
+static bool active = false;
+
+// Readback buffers go round: free_frames holds the ones the game may fill,
+// full_frames the ones waiting for the writer
+static Uint32* frames[RECORD_BUFFERS];
+static SpscQueue free_frames;
+static SpscQueue full_frames;
+static SDL_sem* wakeup = NULL;
+static SDL_Thread* writer = NULL;
+static SDL_atomic_t writing;
+
+static int frames_submitted = 0;    // Game thread only
+static int frames_dropped = 0;
+static int frames_written = 0;      // Writer thread only until it is joined
+static bool write_failed = false;
+
+// BT.601 limited range, 8 fractional bits, as most encoders expect
+static inline Uint8 luma(int r, int g, int b) {
+    return (Uint8)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+}
+
+static inline Uint8 chroma_u(int r, int g, int b) {
+    return (Uint8)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+}
+
+static inline Uint8 chroma_v(int r, int g, int b) {
+    return (Uint8)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+}
+
+// Rounds up, like the SIMD byte averages
+static inline int average(int a, int b) {
+    return (a + b + 1) >> 1;
+}
+
+#define RED(p) ((int)((p) >> 16) & 0xff)
+#define GREEN(p) ((int)((p) >> 8) & 0xff)
+#define BLUE(p) ((int)(p) & 0xff)
+
+// Two rows from column x on: a luma byte per pixel, and one chroma pair
+// per 2x2 block, taken from the block's average colour
+static void convert_scalar(const Uint32* top, const Uint32* bottom, int x, int count,
+                           Uint8* y_top, Uint8* y_bottom, Uint8* u, Uint8* v) {
+    for (; x < count; x += 2) {
+        Uint32 a = top[x], b = top[x + 1], c = bottom[x], d = bottom[x + 1];
+        y_top[x] = luma(RED(a), GREEN(a), BLUE(a));
+        y_top[x + 1] = luma(RED(b), GREEN(b), BLUE(b));
+        y_bottom[x] = luma(RED(c), GREEN(c), BLUE(c));
+        y_bottom[x + 1] = luma(RED(d), GREEN(d), BLUE(d));
+
+        int r = average(average(RED(a), RED(c)), average(RED(b), RED(d)));
+        int g = average(average(GREEN(a), GREEN(c)), average(GREEN(b), GREEN(d)));
+        int bl = average(average(BLUE(a), BLUE(c)), average(BLUE(b), BLUE(d)));
+        u[x / 2] = chroma_u(r, g, bl);
+        v[x / 2] = chroma_v(r, g, bl);
+    }
+}
+
+#if defined(RECORD_USE_NEON)
+
+static inline void store_luma(uint8x8_t r, uint8x8_t g, uint8x8_t b, Uint8* out) {
+    uint16x8_t y = vmull_u8(r, vdup_n_u8(66));
+    y = vmlal_u8(y, g, vdup_n_u8(129));
+    y = vmlal_u8(y, b, vdup_n_u8(25));
+    y = vaddq_u16(y, vdupq_n_u16(128));
+    vst1_u8(out, vadd_u8(vshrn_n_u16(y, 8), vdup_n_u8(16)));
+}
+
+// Average of each 2x2 block, widened: lanes 0 to 3 hold the four blocks
+static inline int16x8_t block_average(uint8x8_t top, uint8x8_t bottom) {
+    uint8x8_t vertical = vrhadd_u8(top, bottom);
+    uint8x8x2_t columns = vuzp_u8(vertical, vertical);
+    return vreinterpretq_s16_u16(vmovl_u8(vrhadd_u8(columns.val[0], columns.val[1])));
+}
+
+static inline void store_chroma(int16x8_t c, Uint8* out) {
+    c = vshrq_n_s16(vaddq_s16(c, vdupq_n_s16(128)), 8);
+    uint8x8_t bytes = vqmovun_s16(vaddq_s16(c, vdupq_n_s16(128)));
+    vst1_lane_u32((uint32_t*)out, vreinterpret_u32_u8(bytes), 0);
+}
+
+// Eight pixels a step; vld4 splits ARGB8888 into B, G, R and A planes
+static int convert_simd(const Uint32* top, const Uint32* bottom, int count,
+                        Uint8* y_top, Uint8* y_bottom, Uint8* u, Uint8* v) {
+    int x = 0;
+    for (; x + 8 <= count; x += 8) {
+        uint8x8x4_t t = vld4_u8((const uint8_t*)(top + x));
+        uint8x8x4_t b = vld4_u8((const uint8_t*)(bottom + x));
+        store_luma(t.val[2], t.val[1], t.val[0], y_top + x);
+        store_luma(b.val[2], b.val[1], b.val[0], y_bottom + x);
+
+        int16x8_t red = block_average(t.val[2], b.val[2]);
+        int16x8_t green = block_average(t.val[1], b.val[1]);
+        int16x8_t blue = block_average(t.val[0], b.val[0]);
+        int16x8_t cu = vsubq_s16(vmulq_n_s16(blue, 112),
+                                 vaddq_s16(vmulq_n_s16(red, 38), vmulq_n_s16(green, 74)));
+        int16x8_t cv = vsubq_s16(vmulq_n_s16(red, 112),
+                                 vaddq_s16(vmulq_n_s16(green, 94), vmulq_n_s16(blue, 18)));
+        store_chroma(cu, u + x / 2);
+        store_chroma(cv, v + x / 2);
+    }
+    return x;
+}
+
+#elif defined(RECORD_USE_SSE2)
+
+// One channel of eight pixels as 16-bit lanes
+static inline __m128i channel(__m128i lo, __m128i hi, int shift) {
+    const __m128i mask = _mm_set1_epi32(0xff);
+    return _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(lo, shift), mask),
+                           _mm_and_si128(_mm_srli_epi32(hi, shift), mask));
+}
+
+// Sums stay under 65536, so the 16-bit lanes can be treated as unsigned
+static inline void store_luma(__m128i lo, __m128i hi, Uint8* out) {
+    __m128i y = _mm_add_epi16(_mm_mullo_epi16(channel(lo, hi, 16), _mm_set1_epi16(66)),
+                              _mm_mullo_epi16(channel(lo, hi, 8), _mm_set1_epi16(129)));
+    y = _mm_add_epi16(y, _mm_mullo_epi16(channel(lo, hi, 0), _mm_set1_epi16(25)));
+    y = _mm_srli_epi16(_mm_add_epi16(y, _mm_set1_epi16(128)), 8);
+    y = _mm_add_epi16(y, _mm_set1_epi16(16));
+    _mm_storel_epi64((__m128i*)out, _mm_packus_epi16(y, y));
+}
+
+// Average pixel of the two 2x2 blocks in four columns, in lanes 0 and 1
+static inline __m128i block_average(__m128i top, __m128i bottom) {
+    __m128i vertical = _mm_avg_epu8(top, bottom);
+    __m128i pairs = _mm_avg_epu8(vertical, _mm_srli_epi64(vertical, 32));
+    return _mm_shuffle_epi32(pairs, _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+static inline void store_chroma(__m128i c, Uint8* out) {
+    c = _mm_srai_epi16(_mm_add_epi16(c, _mm_set1_epi16(128)), 8);
+    c = _mm_packus_epi16(_mm_add_epi16(c, _mm_set1_epi16(128)), c);
+    int bytes = _mm_cvtsi128_si32(c);
+    memcpy(out, &bytes, sizeof(bytes));
+}
+
+static int convert_simd(const Uint32* top, const Uint32* bottom, int count,
+                        Uint8* y_top, Uint8* y_bottom, Uint8* u, Uint8* v) {
+    int x = 0;
+    for (; x + 8 <= count; x += 8) {
+        __m128i t0 = _mm_loadu_si128((const __m128i*)(top + x));
+        __m128i t1 = _mm_loadu_si128((const __m128i*)(top + x + 4));
+        __m128i b0 = _mm_loadu_si128((const __m128i*)(bottom + x));
+        __m128i b1 = _mm_loadu_si128((const __m128i*)(bottom + x + 4));
+        store_luma(t0, t1, y_top + x);
+        store_luma(b0, b1, y_bottom + x);
+
+        __m128i blocks = _mm_unpacklo_epi64(block_average(t0, b0), block_average(t1, b1));
+        __m128i red = channel(blocks, blocks, 16);
+        __m128i green = channel(blocks, blocks, 8);
+        __m128i blue = channel(blocks, blocks, 0);
+        __m128i cu = _mm_sub_epi16(_mm_mullo_epi16(blue, _mm_set1_epi16(112)),
+                                   _mm_add_epi16(_mm_mullo_epi16(red, _mm_set1_epi16(38)),
+                                                 _mm_mullo_epi16(green, _mm_set1_epi16(74))));
+        __m128i cv = _mm_sub_epi16(_mm_mullo_epi16(red, _mm_set1_epi16(112)),
+                                   _mm_add_epi16(_mm_mullo_epi16(green, _mm_set1_epi16(94)),
+                                                 _mm_mullo_epi16(blue, _mm_set1_epi16(18))));
+        store_chroma(cu, u + x / 2);
+        store_chroma(cv, v + x / 2);
+    }
+    return x;
+}
+
+#else
+
+static int convert_simd(const Uint32* top, const Uint32* bottom, int count,
+                        Uint8* y_top, Uint8* y_bottom, Uint8* u, Uint8* v) {
+    (void)top; (void)bottom; (void)count; (void)y_top; (void)y_bottom; (void)u; (void)v;
+    return 0;
+}
+
+#endif
+
+// A whole frame into the planar Y, U, V layout y4m wants
+static void convert_frame(const Uint32* pixels, Uint8* yuv) {
+    Uint8* y_plane = yuv;
+    Uint8* u_plane = y_plane + width * height;
+    Uint8* v_plane = u_plane + (width / 2) * (height / 2);
+    for (int row = 0; row < height; row += 2) {
+        const Uint32* top = pixels + (size_t)row * width;
+        const Uint32* bottom = top + width;
+        Uint8* y_top = y_plane + (size_t)row * width;
+        Uint8* u = u_plane + (size_t)(row / 2) * (width / 2);
+        Uint8* v = v_plane + (size_t)(row / 2) * (width / 2);
+        int done = convert_simd(top, bottom, width, y_top, y_top + width, u, v);
+        convert_scalar(top, bottom, done, width, y_top, y_top + width, u, v);
+    }
+}
+
+static int writer_main(void* data) {
+    (void)data;
+    size_t frame_size = (size_t)width * height * 3 / 2;
+    Uint8* yuv = malloc(frame_size);
+    if (yuv == NULL) {
+        write_failed = true;
+    }
+
+    for (;;) {
+        SDL_SemWait(wakeup);
+        // Read before draining, so frames queued ahead of the stop still go out
+        bool stopping = SDL_AtomicGet(&writing) == 0;
+        Uint8 slot;
+        while (spsc_pop(&full_frames, &slot)) {
+            if (!write_failed) {
+                convert_frame(frames[slot], yuv);
+                if (fwrite("FRAME\n", 1, 6, file) != 6 || fwrite(yuv, 1, frame_size, file) != frame_size) {
+                    write_failed = true;
+                } else {
+                    frames_written++;
+                }
+            }
+            spsc_push(&free_frames, slot);
+        }
+        if (stopping) {
+            break;
+        }
+    }
+    free(yuv);
+    return 0;
+}
+
+bool record_start(const char* path, int output_width, int output_height) {
+    width = output_width & ~1;
+    height = output_height & ~1;
+    if (width <= 0 || height <= 0) {
+        printf("Can't record a %dx%d frame\n", output_width, output_height);
+        return false;
+    }
+
+    file = fopen(path, "wb");
+    if (file == NULL) {
+        printf("Can't open %s for recording\n", path);
+        return false;
+    }
+    // Big writes, so the disk sees few of them
+    setvbuf(file, NULL, _IOFBF, RECORD_FILE_BUFFER);
+    // C420jpeg is centred chroma, which the 2x2 averages are
+    fprintf(file, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg XCOLORRANGE=LIMITED\n",
+            width, height, RECORD_FPS);
+
+    spsc_init(&free_frames);
+    spsc_init(&full_frames);
+    for (int i = 0; i < RECORD_BUFFERS; i++) {
+        frames[i] = malloc((size_t)width * height * sizeof(Uint32));
+        if (frames[i] == NULL) {
+            printf("Out of memory for recording buffers\n");
+            record_stop();
+            return false;
+        }
+        spsc_push(&free_frames, (Uint8)i);
+    }
+
+    output = path;
+    SDL_AtomicSet(&writing, 1);
+    wakeup = SDL_CreateSemaphore(0);
+    writer = wakeup != NULL ? SDL_CreateThread(writer_main, "record", NULL) : NULL;
+    if (writer == NULL) {
+        printf("Can't start the recording thread: %s\n", SDL_GetError());
+        record_stop();
+        return false;
+    }
+    active = true;
+    return true;
+}
+
+bool record_active(void) {
+    return active;
+}
+
+void record_frame(SDL_Renderer* renderer) {
+    if (!active) return;
+
+    Uint8 slot;
+    if (!spsc_pop(&free_frames, &slot)) {
+        frames_dropped++;
+        return;
+    }
+
+    SDL_Rect area = {0, 0, width, height};
+    if (SDL_RenderReadPixels(renderer, &area, SDL_PIXELFORMAT_ARGB8888, frames[slot],
+                             width * (int)sizeof(Uint32)) != 0) {
+        printf("SDL_RenderReadPixels Error: %s\n", SDL_GetError());
+        spsc_push(&free_frames, slot);
+        frames_dropped++;
+        return;
+    }
+    spsc_push(&full_frames, slot);
+    frames_submitted++;
+    SDL_SemPost(wakeup);
+}
+
+void record_stop(void) {
+    if (writer != NULL) {
+        SDL_AtomicSet(&writing, 0);
+        SDL_SemPost(wakeup);
+        SDL_WaitThread(writer, NULL);
+        writer = NULL;
+    }
+    if (wakeup != NULL) {
+        SDL_DestroySemaphore(wakeup);
+        wakeup = NULL;
+    }
+    if (file != NULL) {
+        if (fclose(file) != 0) {
+            write_failed = true;
+        }
+        file = NULL;
+    }
+    for (int i = 0; i < RECORD_BUFFERS; i++) {
+        free(frames[i]);
+        frames[i] = NULL;
+    }
+
+    if (active) {
+        printf("Recorded %d of %d frames to %s (%d dropped)%s\n", frames_written,
+               frames_submitted + frames_dropped, output, frames_dropped,
+               write_failed ? ", stopped by a write error" : "");
+    }
+    active = false;
+}
@@ -0,0 +1,32 @@
+#ifndef RECORD_H
+#define RECORD_H
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+
+// Gameplay recording for --record <out.y4m>. Every presented frame is read
+// back into one of RECORD_BUFFERS rotating buffers and handed to a writer
+// thread, which converts it to YUV 4:2:0 (BT.601, limited range) with
+// SSE2 or NEON and streams it to a YUV4MPEG2 file. The game never waits
+// on the disk: when no buffer is free the frame is dropped and counted.
+// The file is stamped at RECORD_FPS with one video frame per present, so
+// idle presenting is turned off while recording.
+//
+// Play it with "ffplay out.y4m" or convert it with
+// "ffmpeg -i out.y4m -c:v libx264 out.mp4".
+
+#define RECORD_BUFFERS 4
+#define RECORD_FPS 60
+
+// Opens the file and starts the writer; width and height are the
+// renderer's output size, rounded down to even for the chroma planes
+bool record_start(const char* path, int width, int height);
+bool record_active(void);
+
+// Call after the frame is drawn, before the overlay and the present
+void record_frame(SDL_Renderer* renderer);
+
+// Lets the writer finish the queued frames, closes the file and reports
+void record_stop(void);
+
+#endif // RECORD_H
@@ -0,0 +1,116 @@
+#include "render_bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static const int render_bench_sizes[] = {100, 1000, 2500, 5000, 10000};
+#define SIZE_COUNT (int)(sizeof(render_bench_sizes) / sizeof(render_bench_sizes[0]))
+
+#define GRID_COLUMNS (RENDER_BENCH_AREA_WIDTH / RENDER_BENCH_BRICK_WIDTH)
+#define GRID_ROWS (RENDER_BENCH_AREA_HEIGHT / RENDER_BENCH_BRICK_HEIGHT)
+
+static const char* backend_name = NULL;
+static int frames_per_size = RENDER_BENCH_DEFAULT_FRAMES;
+static int size_index = 0;
+static RenderBenchScene scene;
+
+static double submit_samples[RENDER_BENCH_MAX_FRAMES];
+static double frame_samples[RENDER_BENCH_MAX_FRAMES];
+static int sample_count = 0;
+static long long draw_call_total = 0;
+
+void render_bench_init(const char* backend, int frames) {
+    backend_name = backend;
+    if (frames > RENDER_BENCH_WARMUP_FRAMES && frames <= RENDER_BENCH_MAX_FRAMES) {
+        frames_per_size = frames;
+    }
+    size_index = 0;
+    scene = (RenderBenchScene){render_bench_sizes[0], RENDER_BENCH_BALLS, 0};
+    printf("%-12s %-14s %6s %5s %6s %10s %10s %10s %10s %8s %7s\n", "render_bench", "backend",
+           "bricks", "balls", "frames", "submit_ms", "submit_p95", "frame_ms", "frame_p95", "fps", "draws");
+}
+
+bool render_bench_active(void) {
+    return backend_name != NULL;
+}
+
+const RenderBenchScene* render_bench_scene(void) {
+    return &scene;
+}
+
+BenchRect render_bench_brick(int index) {
+    int cell = index % (GRID_COLUMNS * GRID_ROWS);
+    int layer = index / (GRID_COLUMNS * GRID_ROWS);
+    return (BenchRect){
+        (cell % GRID_COLUMNS) * RENDER_BENCH_BRICK_WIDTH + layer * 3 % RENDER_BENCH_BRICK_WIDTH,
+        (cell / GRID_COLUMNS) * RENDER_BENCH_BRICK_HEIGHT + layer * 2 % RENDER_BENCH_BRICK_HEIGHT,
+        RENDER_BENCH_BRICK_WIDTH,
+        RENDER_BENCH_BRICK_HEIGHT
+    };
+}
+
+// Position along a bouncing path of the given length
+static int bounce(int travelled, int length) {
+    int period = travelled % (2 * length);
+    return period < length ? period : 2 * length - period;
+}
+
+BenchRect render_bench_ball(int index, int frame) {
+    const int range_x = RENDER_BENCH_AREA_WIDTH - RENDER_BENCH_BALL_SIZE;
+    const int range_y = RENDER_BENCH_AREA_HEIGHT - RENDER_BENCH_BALL_SIZE;
+    return (BenchRect){
+        bounce(index * 37 + frame * (3 + index % 4), range_x),
+        bounce(index * 53 + frame * (2 + index % 3), range_y),
+        RENDER_BENCH_BALL_SIZE,
+        RENDER_BENCH_BALL_SIZE
+    };
+}
+
+static int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static void stats(double* samples, int count, double* mean, double* p95) {
+    double total = 0.0;
+    for (int i = 0; i < count; i++) {
+        total += samples[i];
+    }
+    qsort(samples, count, sizeof(double), compare_doubles);
+    *mean = total / count;
+    *p95 = samples[(count * 95) / 100];
+}
+
+static void report_size(void) {
+    double submit_mean, submit_p95, frame_mean, frame_p95;
+    stats(submit_samples, sample_count, &submit_mean, &submit_p95);
+    stats(frame_samples, sample_count, &frame_mean, &frame_p95);
+    printf("%-12s %-14s %6d %5d %6d %10.3f %10.3f %10.3f %10.3f %8.1f %7lld\n", "render_bench", backend_name,
+           scene.bricks, scene.balls, sample_count, submit_mean, submit_p95, frame_mean, frame_p95,
+           frame_mean > 0.0 ? 1000.0 / frame_mean : 0.0, draw_call_total / sample_count);
+    fflush(stdout);
+}
+
+bool render_bench_frame_end(double submit_ms, double frame_ms, int draw_calls) {
+    if (!render_bench_active()) return true;
+
+    if (scene.frame >= RENDER_BENCH_WARMUP_FRAMES) {
+        submit_samples[sample_count] = submit_ms;
+        frame_samples[sample_count] = frame_ms;
+        draw_call_total += draw_calls;
+        sample_count++;
+    }
+
+    scene.frame++;
+    if (scene.frame < frames_per_size) {
+        return true;
+    }
+
+    report_size();
+    sample_count = 0;
+    draw_call_total = 0;
+    if (++size_index == SIZE_COUNT) {
+        return false;
+    }
+    scene = (RenderBenchScene){render_bench_sizes[size_index], RENDER_BENCH_BALLS, 0};
+    return true;
+}
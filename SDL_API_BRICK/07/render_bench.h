@@ -0,0 +1,44 @@
+#ifndef RENDER_BENCH_H
+#define RENDER_BENCH_H
+
+#include <stdbool.h>
+
+// Synthetic render benchmark for --bench-render. The claude and GPT builds
+// carry the same module, so all three stacks draw the same scene: a
+// background, N bricks tiled over a 640x480 area (16x8 each, wrapping
+// into further offset layers past 2400), RENDER_BENCH_BALLS bouncing
+// balls and a HUD line where the build has text. N steps through
+// render_bench_sizes; each size runs for a fixed number of frames with
+// vsync off, and one line per size reports CPU submit time (scene start
+// to present), present-to-present frame time and draw calls.
+
+#define RENDER_BENCH_AREA_WIDTH 640
+#define RENDER_BENCH_AREA_HEIGHT 480
+#define RENDER_BENCH_BRICK_WIDTH 16
+#define RENDER_BENCH_BRICK_HEIGHT 8
+#define RENDER_BENCH_BALL_SIZE 15
+#define RENDER_BENCH_BALLS 16
+#define RENDER_BENCH_WARMUP_FRAMES 30   // Dropped from each size's stats
+#define RENDER_BENCH_MAX_FRAMES 2000
+#define RENDER_BENCH_DEFAULT_FRAMES 300
+
+typedef struct {
+    int x, y, w, h;  // Top-left corner, y down
+} BenchRect;
+
+typedef struct {
+    int bricks;
+    int balls;
+    int frame;       // Within this size, from 0
+} RenderBenchScene;
+
+void render_bench_init(const char* backend, int frames_per_size);
+bool render_bench_active(void);
+const RenderBenchScene* render_bench_scene(void);
+BenchRect render_bench_brick(int index);  // Texture is index % 3
+BenchRect render_bench_ball(int index, int frame);
+
+// Records the frame just presented; returns false once every size is done
+bool render_bench_frame_end(double submit_ms, double frame_ms, int draw_calls);
+
+#endif // RENDER_BENCH_H
@@ -0,0 +1,102 @@
+#include "save_state.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+static const char save_magic[4] = {'B', 'R', 'K', 'S'};
+
+// The rename lives in the directory, so the directory is synced too, or a
+// power cut can undo it even though the file's data made it to disk
+static void sync_parent_directory(const char* path) {
+    char directory[512];
+    snprintf(directory, sizeof(directory), "%s", path);
+    char* slash = strrchr(directory, '/');
+    if (slash == NULL) {
+        snprintf(directory, sizeof(directory), ".");
+    } else if (slash == directory) {
+        slash[1] = '\0';
+    } else {
+        *slash = '\0';
+    }
+
+    int fd = open(directory, O_RDONLY | O_DIRECTORY);
+    if (fd < 0 || fsync(fd) != 0) {
+        printf("save_state: can't sync %s: %s\n", directory, strerror(errno));
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t size;      // sizeof(SimState) when written
+    uint32_t checksum;  // sim_hash of the payload
+} SaveHeader;
+
+bool save_state_write(const char* path, const SimState* sim) {
+    char temp_path[512];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+
+    SaveHeader header;
+    memcpy(header.magic, save_magic, sizeof(header.magic));
+    header.version = SAVE_STATE_VERSION;
+    header.size = sizeof(SimState);
+    header.checksum = sim_hash(sim);
+
+    FILE* file = fopen(temp_path, "wb");
+    if (file == NULL) {
+        printf("save_state: can't write %s: %s\n", temp_path, strerror(errno));
+        return false;
+    }
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   fwrite(sim, sizeof(SimState), 1, file) == 1 &&
+                   fflush(file) == 0 &&
+                   fsync(fileno(file)) == 0;
+    written = fclose(file) == 0 && written;
+
+    // The rename is what makes the new save visible, so it only happens
+    // once the data is on disk
+    if (!written || rename(temp_path, path) != 0) {
+        printf("save_state: writing %s failed: %s\n", path, strerror(errno));
+        remove(temp_path);
+        return false;
+    }
+    sync_parent_directory(path);
+    return true;
+}
+
+bool save_state_read(const char* path, SimState* sim) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        if (errno != ENOENT) {
+            printf("save_state: can't read %s: %s\n", path, strerror(errno));
+        }
+        return false;
+    }
+
+    SaveHeader header;
+    SimState loaded;
+    bool complete = fread(&header, sizeof(header), 1, file) == 1 &&
+                    memcmp(header.magic, save_magic, sizeof(save_magic)) == 0 &&
+                    header.version == SAVE_STATE_VERSION &&
+                    header.size == sizeof(SimState) &&
+                    fread(&loaded, sizeof(loaded), 1, file) == 1;
+    fclose(file);
+
+    if (!complete) {
+        printf("save_state: %s isn't a version %d save, ignoring it\n", path, SAVE_STATE_VERSION);
+        return false;
+    }
+    if (sim_hash(&loaded) != header.checksum) {
+        printf("save_state: %s fails its checksum, ignoring it\n", path);
+        return false;
+    }
+
+    *sim = loaded;
+    return true;
+}
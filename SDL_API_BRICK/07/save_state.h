@@ -0,0 +1,24 @@
+#ifndef SAVE_STATE_H
+#define SAVE_STATE_H
+
+#include "sim.h"
+#include <stdbool.h>
+
+// Suspend/resume file for --resume. A small header (magic, format
+// version, payload size, FNV-1a checksum) followed by the SimState bytes
+// in host order, which x86 and the Pi's ARM share, so a save moves
+// between them. Writes go to "<path>.tmp", are synced and then renamed over the
+// old file, and the directory is synced after the rename, so a power cut
+// leaves either the old save or the new one.
+// Bump SAVE_STATE_VERSION whenever SimState changes shape.
+
+#define SAVE_STATE_VERSION 2
+#define SAVE_STATE_DEFAULT_PATH "suspend.sav"
+
+bool save_state_write(const char* path, const SimState* sim);
+
+// False, with the reason printed, when the file is missing, damaged or
+// from another version; sim is only written on success
+bool save_state_read(const char* path, SimState* sim);
+
+#endif // SAVE_STATE_H
@@ -0,0 +1,231 @@
+#include "sfx.h"
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SFX_USE_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define SFX_USE_SSE2 1
+#endif
+
+// MIX_MAX_VOLUME is 128, so volumes are 7-bit fixed point
+#define SFX_VOLUME_SHIFT 7
+
+typedef struct {
+    Mix_Chunk* chunk;    // Owns the PCM, already converted to the device format
+    const Sint16* pcm;
+    int samples;
+} SfxSample;
+
+typedef struct {
+    const Sint16* pcm;   // NULL when the voice is free
+    int samples;
+    int pos;
+    int volume;
+} SfxVoice;
+
+static SfxSample sfx_samples[SFX_COUNT];
+static bool mixer_active = false;
+
+// Only touched from the audio callback
+static SfxVoice voices[SFX_MAX_VOICES];
+static Sint32 mix_acc[SFX_MIX_MAX_SAMPLES];
+
+// sfx_play pushes, the audio callback pops
+static SpscQueue triggers;
+
+static Sint16 clamp_s16(Sint32 value) {
+    if (value > 32767) return 32767;
+    if (value < -32768) return -32768;
+    return (Sint16)value;
+}
+
+void sfx_mix_accumulate(Sint32* acc, const Sint16* src, int samples, int volume) {
+    int i = 0;
+#if defined(SFX_USE_NEON)
+    for (; i + 8 <= samples; i += 8) {
+        int16x8_t s = vld1q_s16(src + i);
+        int32x4_t a0 = vmlal_n_s16(vld1q_s32(acc + i), vget_low_s16(s), (int16_t)volume);
+        int32x4_t a1 = vmlal_n_s16(vld1q_s32(acc + i + 4), vget_high_s16(s), (int16_t)volume);
+        vst1q_s32(acc + i, a0);
+        vst1q_s32(acc + i + 4, a1);
+    }
+#elif defined(SFX_USE_SSE2)
+    __m128i vol = _mm_set1_epi16((short)volume);
+    for (; i + 8 <= samples; i += 8) {
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i lo = _mm_mullo_epi16(s, vol);
+        __m128i hi = _mm_mulhi_epi16(s, vol);
+        __m128i a0 = _mm_loadu_si128((const __m128i*)(acc + i));
+        __m128i a1 = _mm_loadu_si128((const __m128i*)(acc + i + 4));
+        a0 = _mm_add_epi32(a0, _mm_unpacklo_epi16(lo, hi));
+        a1 = _mm_add_epi32(a1, _mm_unpackhi_epi16(lo, hi));
+        _mm_storeu_si128((__m128i*)(acc + i), a0);
+        _mm_storeu_si128((__m128i*)(acc + i + 4), a1);
+    }
+#endif
+    for (; i < samples; i++) {
+        acc[i] += src[i] * volume;
+    }
+}
+
+void sfx_mix_resolve(Sint16* stream, const Sint32* acc, int samples) {
+    int i = 0;
+#if defined(SFX_USE_NEON)
+    for (; i + 8 <= samples; i += 8) {
+        int16x8_t fx = vcombine_s16(vqshrn_n_s32(vld1q_s32(acc + i), SFX_VOLUME_SHIFT),
+                                    vqshrn_n_s32(vld1q_s32(acc + i + 4), SFX_VOLUME_SHIFT));
+        vst1q_s16(stream + i, vqaddq_s16(vld1q_s16(stream + i), fx));
+    }
+#elif defined(SFX_USE_SSE2)
+    for (; i + 8 <= samples; i += 8) {
+        __m128i a0 = _mm_srai_epi32(_mm_loadu_si128((const __m128i*)(acc + i)), SFX_VOLUME_SHIFT);
+        __m128i a1 = _mm_srai_epi32(_mm_loadu_si128((const __m128i*)(acc + i + 4)), SFX_VOLUME_SHIFT);
+        __m128i fx = _mm_packs_epi32(a0, a1);
+        __m128i s = _mm_loadu_si128((const __m128i*)(stream + i));
+        _mm_storeu_si128((__m128i*)(stream + i), _mm_adds_epi16(s, fx));
+    }
+#endif
+    // Same two saturation steps as the vector paths, so results match
+    for (; i < samples; i++) {
+        Sint16 fx = clamp_s16(acc[i] >> SFX_VOLUME_SHIFT);
+        stream[i] = clamp_s16(stream[i] + fx);
+    }
+}
+
+static void start_voice(SfxId id) {
+    SfxVoice* slot = NULL;
+    for (int i = 0; i < SFX_MAX_VOICES; i++) {
+        if (voices[i].pcm == NULL) {
+            slot = &voices[i];
+            break;
+        }
+    }
+
+    // All voices busy: steal the one closest to finishing
+    if (slot == NULL) {
+        slot = &voices[0];
+        for (int i = 1; i < SFX_MAX_VOICES; i++) {
+            if (voices[i].samples - voices[i].pos < slot->samples - slot->pos) {
+                slot = &voices[i];
+            }
+        }
+    }
+
+    slot->pcm = sfx_samples[id].pcm;
+    slot->samples = sfx_samples[id].samples;
+    slot->pos = 0;
+    slot->volume = sfx_samples[id].chunk->volume;
+}
+
+static void mix_block(Sint16* stream, int samples) {
+    bool cleared = false;
+
+    for (int i = 0; i < SFX_MAX_VOICES; i++) {
+        SfxVoice* voice = &voices[i];
+        if (voice->pcm == NULL) continue;
+
+        if (!cleared) {
+            memset(mix_acc, 0, samples * sizeof(Sint32));
+            cleared = true;
+        }
+
+        int count = voice->samples - voice->pos;
+        if (count > samples) count = samples;
+        sfx_mix_accumulate(mix_acc, voice->pcm + voice->pos, count, voice->volume);
+
+        voice->pos += count;
+        if (voice->pos >= voice->samples) {
+            voice->pcm = NULL;
+        }
+    }
+
+    if (cleared) {
+        sfx_mix_resolve(stream, mix_acc, samples);
+    }
+}
+
+// Runs on the audio thread after SDL_mixer has written the music
+static void sfx_postmix(void* udata, Uint8* stream, int len) {
+    (void)udata;
+
+    Uint8 id;
+    while (spsc_pop(&triggers, &id)) {
+        start_voice((SfxId)id);
+    }
+
+    Sint16* out = (Sint16*)stream;
+    int remaining = len / (int)sizeof(Sint16);
+    while (remaining > 0) {
+        int count = remaining < SFX_MIX_MAX_SAMPLES ? remaining : SFX_MIX_MAX_SAMPLES;
+        mix_block(out, count);
+        out += count;
+        remaining -= count;
+    }
+}
+
+bool sfx_init(void) {
+    int frequency, channels;
+    Uint16 format;
+    if (Mix_QuerySpec(&frequency, &format, &channels) == 0) {
+        printf("Mix_QuerySpec Error: %s\n", Mix_GetError());
+        return false;
+    }
+
+    if (format != AUDIO_S16SYS) {
+        printf("Audio format 0x%x not supported by the SFX mixer, using SDL_mixer channels\n", format);
+        return false;
+    }
+
+    memset(voices, 0, sizeof(voices));
+    spsc_init(&triggers);
+
+    // Effects no longer go through SDL_mixer's channels
+    Mix_AllocateChannels(0);
+    Mix_SetPostMix(sfx_postmix, NULL);
+    mixer_active = true;
+    return true;
+}
+
+bool sfx_load(SfxId id, const char* path) {
+    // Mix_LoadWAV decodes and converts to the device format up front, so
+    // the callback only ever sees ready-to-mix int16 PCM
+    Mix_Chunk* chunk = Mix_LoadWAV(path);
+    if (chunk == NULL) {
+        printf("Failed to load %s: %s\n", path, Mix_GetError());
+        return false;
+    }
+
+    sfx_samples[id].chunk = chunk;
+    sfx_samples[id].pcm = (const Sint16*)chunk->abuf;
+    sfx_samples[id].samples = chunk->alen / sizeof(Sint16);
+    return true;
+}
+
+void sfx_play(SfxId id) {
+    if (sfx_samples[id].chunk == NULL) return;
+
+    if (!mixer_active) {
+        Mix_PlayChannel(-1, sfx_samples[id].chunk, 0);
+        return;
+    }
+
+    // Dropped if the queue is full; the callback drains it every few ms
+    spsc_push(&triggers, (Uint8)id);
+}
+
+void sfx_cleanup(void) {
+    if (mixer_active) {
+        Mix_SetPostMix(NULL, NULL);
+        mixer_active = false;
+    }
+
+    for (int i = 0; i < SFX_COUNT; i++) {
+        if (sfx_samples[i].chunk != NULL) {
+            Mix_FreeChunk(sfx_samples[i].chunk);
+        }
+        sfx_samples[i] = (SfxSample){0};
+    }
+}
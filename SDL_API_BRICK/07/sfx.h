@@ -0,0 +1,36 @@
+#ifndef SFX_H
+#define SFX_H
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_mixer.h>
+#include <stdbool.h>
+#include "handoff.h"
+
+// Software mixer for the short sound effects. SDL_mixer keeps streaming
+// the background Mix_Music; the effects are added on top of it from the
+// post-mix hook, which runs inside the SDL audio callback.
+
+#define SFX_MAX_VOICES 16       // Effects playing at the same time
+#define SFX_MIX_MAX_SAMPLES 8192 // Samples mixed per pass of the callback
+
+typedef enum {
+    SFX_BRICK_HIT,
+    SFX_PADDLE_HIT,
+    SFX_GAME_OVER,
+    SFX_GAME_WON,
+    SFX_COUNT
+} SfxId;
+
+// Call after Mix_OpenAudio. Returns false if the device format can't be
+// mixed directly, in which case sfx_play falls back to Mix_PlayChannel.
+bool sfx_init(void);
+bool sfx_load(SfxId id, const char* path);
+void sfx_play(SfxId id);
+void sfx_cleanup(void);
+
+// Mixing kernels, exposed for sfx_bench. Samples are interleaved int16,
+// volume is 0..MIX_MAX_VOLUME like the rest of SDL_mixer.
+void sfx_mix_accumulate(Sint32* acc, const Sint16* src, int samples, int volume);
+void sfx_mix_resolve(Sint16* stream, const Sint32* acc, int samples);
+
+#endif // SFX_H
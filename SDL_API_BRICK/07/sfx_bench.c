@@ -0,0 +1,96 @@
+// Mixing microbenchmark: the SFX kernels against SDL_MixAudioFormat, which
+// SDL_mixer calls once per playing channel in its own callback.
+//
+// Usage: ./sfx_bench [iterations]
+
+#include "sfx.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define BENCH_FRAMES 2048               // Same chunk size as Mix_OpenAudio
+#define BENCH_SAMPLES (BENCH_FRAMES * 2) // Stereo
+#define BENCH_EFFECT_SAMPLES (44100 * 2)
+
+static Sint16 effect_pcm[BENCH_EFFECT_SAMPLES];
+static Sint16 music[BENCH_SAMPLES];
+static Sint16 stream[BENCH_SAMPLES];
+static Sint32 acc[BENCH_SAMPLES];
+
+static const int voice_counts[] = {1, 4, 8, 16};
+
+// Keeps the compiler from dropping the mixing work
+static volatile Uint32 sink;
+
+static double seconds_since(Uint64 start) {
+    return (double)(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+}
+
+static Uint32 checksum(const Sint16* data, int samples) {
+    Uint32 sum = 0;
+    for (int i = 0; i < samples; i++) {
+        sum = sum * 31 + (Uint16)data[i];
+    }
+    return sum;
+}
+
+static double bench_sfx(int voices, int iterations) {
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (int it = 0; it < iterations; it++) {
+        memcpy(stream, music, sizeof(stream));
+        memset(acc, 0, sizeof(acc));
+        for (int v = 0; v < voices; v++) {
+            int offset = ((it + v * 7) * BENCH_SAMPLES) % (BENCH_EFFECT_SAMPLES - BENCH_SAMPLES);
+            sfx_mix_accumulate(acc, effect_pcm + offset, BENCH_SAMPLES, MIX_MAX_VOLUME);
+        }
+        sfx_mix_resolve(stream, acc, BENCH_SAMPLES);
+    }
+    double elapsed = seconds_since(start);
+    sink += checksum(stream, BENCH_SAMPLES);
+    return elapsed;
+}
+
+static double bench_sdl_mixer(int voices, int iterations) {
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (int it = 0; it < iterations; it++) {
+        memcpy(stream, music, sizeof(stream));
+        for (int v = 0; v < voices; v++) {
+            int offset = ((it + v * 7) * BENCH_SAMPLES) % (BENCH_EFFECT_SAMPLES - BENCH_SAMPLES);
+            SDL_MixAudioFormat((Uint8*)stream, (const Uint8*)(effect_pcm + offset),
+                               AUDIO_S16SYS, sizeof(stream), MIX_MAX_VOLUME);
+        }
+    }
+    double elapsed = seconds_since(start);
+    sink += checksum(stream, BENCH_SAMPLES);
+    return elapsed;
+}
+
+int main(int argc, char* argv[]) {
+    int iterations = (argc > 1) ? atoi(argv[1]) : 2000;
+    if (iterations <= 0) iterations = 2000;
+
+    // Loud enough that the clamp actually kicks in with many voices
+    srand(1);
+    for (int i = 0; i < BENCH_EFFECT_SAMPLES; i++) {
+        effect_pcm[i] = (Sint16)(sin(i * 0.031) * 12000.0 + (rand() % 2001 - 1000));
+    }
+    for (int i = 0; i < BENCH_SAMPLES; i++) {
+        music[i] = (Sint16)(sin(i * 0.007) * 8000.0);
+    }
+
+    printf("%d iterations of %d stereo frames\n", iterations, BENCH_FRAMES);
+    printf("%-7s %16s %16s %8s\n", "voices", "sfx frames/s", "SDL frames/s", "speedup");
+
+    for (size_t i = 0; i < sizeof(voice_counts) / sizeof(voice_counts[0]); i++) {
+        int voices = voice_counts[i];
+        double sfx_time = bench_sfx(voices, iterations);
+        double sdl_time = bench_sdl_mixer(voices, iterations);
+
+        double frames = (double)iterations * BENCH_FRAMES;
+        printf("%-7d %16.0f %16.0f %7.2fx\n",
+               voices, frames / sfx_time, frames / sdl_time, sdl_time / sfx_time);
+    }
+
+    return 0;
+}
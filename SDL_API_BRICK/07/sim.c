@@ -0,0 +1,246 @@
+#include "sim.h"
+#include <string.h>
+
+#define ALL_BRICKS (BRICK_ROWS * BRICK_COLS == 64 ? ~(uint64_t)0 : ((uint64_t)1 << (BRICK_ROWS * BRICK_COLS)) - 1)
+
+static uint32_t next_random(SimState* sim) {
+    uint32_t x = sim->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    sim->rng = x;
+    return x;
+}
+
+// sin of 0 to 90 degrees in 16.16, whole degrees. Written out rather than
+// filled from sin() at startup, since libm results differ between
+// platforms.
+static const int32_t sin_table[91] = {
+    0, 1144, 2287, 3430, 4572, 5712, 6850, 7987,
+    9121, 10252, 11380, 12505, 13626, 14742, 15855, 16962,
+    18064, 19161, 20252, 21336, 22415, 23486, 24550, 25607,
+    26656, 27697, 28729, 29753, 30767, 31772, 32768, 33754,
+    34729, 35693, 36647, 37590, 38521, 39441, 40348, 41243,
+    42126, 42995, 43852, 44695, 45525, 46341, 47143, 47930,
+    48703, 49461, 50203, 50931, 51643, 52339, 53020, 53684,
+    54332, 54963, 55578, 56175, 56756, 57319, 57865, 58393,
+    58903, 59396, 59870, 60326, 60764, 61183, 61584, 61966,
+    62328, 62672, 62997, 63303, 63589, 63856, 64104, 64332,
+    64540, 64729, 64898, 65048, 65177, 65287, 65376, 65446,
+    65496, 65526, 65536,
+};
+
+// Degrees from -90 to 90
+static int32_t fx_sin(int degrees) {
+    return degrees < 0 ? -sin_table[-degrees] : sin_table[degrees];
+}
+
+static int32_t fx_cos(int degrees) {
+    return sin_table[90 - (degrees < 0 ? -degrees : degrees)];
+}
+
+// Signed division truncates toward zero by the standard, unlike a right
+// shift of a negative number, which is up to the compiler
+static int32_t fx_mul(int32_t a, int32_t b) {
+    return (int32_t)((int64_t)a * b / FX_ONE);
+}
+
+// Bit-by-bit integer square root, exact on every platform
+static uint32_t isqrt64(uint64_t value) {
+    uint64_t root = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+    while (bit > value) bit >>= 2;
+    while (bit != 0) {
+        if (value >= root + bit) {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)root;
+}
+
+static int calculate_brick_score(int combo) {
+    return (combo == 0) ? 50 : (combo >= 5) ? 100 : 50 + (combo * 10);
+}
+
+static void set_ball_direction(SimState* sim, int degrees, int32_t speed) {
+    sim->ball_dx = fx_mul(speed, fx_sin(degrees));
+    sim->ball_dy = -fx_mul(speed, fx_cos(degrees));
+}
+
+static void reset_ball(SimState* sim) {
+    sim->ball_x = FX(SCREEN_WIDTH / 2);
+    sim->ball_y = FX(SCREEN_HEIGHT / 2);
+    // Up at -45 to 45 degrees
+    set_ball_direction(sim, (int)(next_random(sim) % 91) - 45, FX(MIN_BALL_SPEED));
+}
+
+void sim_init(SimState* sim, uint32_t seed) {
+    *sim = (SimState){0};
+    sim->rng = seed != 0 ? seed : 0x9E3779B9u;
+    sim->state = GAME_STATE_START_SCREEN;
+    sim->paddle_x = SCREEN_WIDTH / 2 - PADDLE_WIDTH / 2;
+    sim->brick_mask = ALL_BRICKS;
+    sim->lives = INITIAL_LIVES;
+    reset_ball(sim);
+}
+
+void sim_reset(SimState* sim) {
+    sim->paddle_x = SCREEN_WIDTH / 2 - PADDLE_WIDTH / 2;
+    reset_ball(sim);
+    sim->brick_mask = ALL_BRICKS;
+    sim->score = 0;
+    sim->lives = INITIAL_LIVES;
+    sim->combo = 0;
+    sim->state = GAME_STATE_PLAYING;
+}
+
+int sim_ball_x(const SimState* sim) {
+    return fx_floor(sim->ball_x);
+}
+
+int sim_ball_y(const SimState* sim) {
+    return fx_floor(sim->ball_y);
+}
+
+uint32_t sim_hash(const SimState* sim) {
+    unsigned char bytes[sizeof(SimState)];
+    memcpy(bytes, sim, sizeof(bytes));
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < sizeof(bytes); i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+BrickType sim_brick_type(int row) {
+    if (row < 2) return BRICK_RED;
+    if (row < 4) return BRICK_BLUE;
+    return BRICK_YELLOW;
+}
+
+int sim_brick_x(int col) {
+    return col * BRICK_WIDTH;
+}
+
+int sim_brick_y(int row) {
+    return row * BRICK_HEIGHT + SCORE_HEIGHT;
+}
+
+static uint32_t handle_paddle_collision(SimState* sim, int ball_x, int ball_y) {
+    if (ball_y + BALL_SIZE >= PADDLE_Y &&
+        ball_x + BALL_SIZE >= sim->paddle_x &&
+        ball_x <= sim->paddle_x + PADDLE_WIDTH) {
+
+        // Where on the paddle the ball hit, 0 to 1 in 16.16, turned into
+        // -60 to 60 degrees
+        int32_t hit_position = FX(ball_x + BALL_SIZE / 2 - sim->paddle_x) / PADDLE_WIDTH;
+        int angle = (int)(((int64_t)hit_position - FX_ONE / 2) * 120 / FX_ONE);
+        if (angle < -60) angle = -60;
+        if (angle > 60) angle = 60;
+
+        // Maintain speed but change direction
+        uint64_t dx = (uint64_t)((int64_t)sim->ball_dx * sim->ball_dx);
+        uint64_t dy = (uint64_t)((int64_t)sim->ball_dy * sim->ball_dy);
+        set_ball_direction(sim, angle, (int32_t)isqrt64(dx + dy));
+
+        sim->combo = 0;
+        return SIM_EVENT_PADDLE_HIT;
+    }
+    return 0;
+}
+
+static uint32_t handle_brick_collisions(SimState* sim, int ball_x, int ball_y) {
+    for (int i = 0; i < BRICK_ROWS; i++) {
+        for (int j = 0; j < BRICK_COLS; j++) {
+            uint64_t bit = (uint64_t)1 << (i * BRICK_COLS + j);
+            int x = sim_brick_x(j), y = sim_brick_y(i);
+            if ((sim->brick_mask & bit) &&
+                ball_x + BALL_SIZE > x &&
+                ball_x < x + BRICK_WIDTH &&
+                ball_y + BALL_SIZE > y &&
+                ball_y < y + BRICK_HEIGHT) {
+
+                sim->brick_mask &= ~bit;
+                sim->ball_dy = -sim->ball_dy;
+
+                sim->score += calculate_brick_score(sim->combo);
+                sim->combo++;
+                return SIM_EVENT_BRICK_HIT;
+            }
+        }
+    }
+    return 0;
+}
+
+static uint32_t handle_ball_loss(SimState* sim, int ball_y) {
+    if (ball_y > SCREEN_HEIGHT) {
+        sim->lives--;
+
+        if (sim->lives <= 0) {
+            sim->state = GAME_STATE_GAME_OVER;
+            return SIM_EVENT_GAME_OVER;
+        }
+        reset_ball(sim);
+        sim->paddle_x = SCREEN_WIDTH / 2 - PADDLE_WIDTH / 2;
+    }
+    return 0;
+}
+
+uint32_t sim_advance(SimState* sim, uint32_t input) {
+    if (!sim_move(sim, input)) {
+        return 0;
+    }
+    return sim_collide(sim, sim_ball_x(sim), sim_ball_y(sim));
+}
+
+bool sim_move(SimState* sim, uint32_t input) {
+    if (sim->state != GAME_STATE_PLAYING) {
+        return false;
+    }
+    sim->frame++;
+    sim->input = input;
+
+    // Update paddle position
+    if (input & INPUT_LEFT) {
+        sim->paddle_x -= PADDLE_SPEED;
+    }
+    if (input & INPUT_RIGHT) {
+        sim->paddle_x += PADDLE_SPEED;
+    }
+
+    // Keep paddle within screen bounds
+    if (sim->paddle_x < 0) sim->paddle_x = 0;
+    if (sim->paddle_x + PADDLE_WIDTH > SCREEN_WIDTH) sim->paddle_x = SCREEN_WIDTH - PADDLE_WIDTH;
+
+    // Update ball position. Collisions are tested on whole pixels.
+    sim->ball_x += sim->ball_dx;
+    sim->ball_y += sim->ball_dy;
+    int ball_x = fx_floor(sim->ball_x);
+    int ball_y = fx_floor(sim->ball_y);
+
+    // Ball collision with walls
+    if (ball_x <= 0 || ball_x + BALL_SIZE >= SCREEN_WIDTH) {
+        sim->ball_dx = -sim->ball_dx;
+    }
+    if (ball_y <= SCORE_HEIGHT) {
+        sim->ball_dy = -sim->ball_dy;
+    }
+    return true;
+}
+
+uint32_t sim_collide(SimState* sim, int ball_x, int ball_y) {
+    uint32_t events = handle_paddle_collision(sim, ball_x, ball_y);
+    events |= handle_brick_collisions(sim, ball_x, ball_y);
+    events |= handle_ball_loss(sim, ball_y);
+
+    // Check win condition
+    if (sim->brick_mask == 0) {
+        sim->state = GAME_STATE_WIN_SCREEN;
+        events |= SIM_EVENT_GAME_WON;
+    }
+    return events;
+}
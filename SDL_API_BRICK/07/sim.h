@@ -0,0 +1,116 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// The game simulation, apart from everything SDL. All of its state is one
+// SimState: plain fixed-size fields with no pointers (textures and sounds
+// stay with the renderer and mixer, the random generator is a field), so
+// a snapshot is a memcpy and two equal states step identically.
+//
+// The ball runs in 16.16 fixed point with table-driven trig and no
+// floating point anywhere, so a seed and an input sequence give the same
+// states bit for bit on x86 and ARM, whatever the compiler or libm.
+
+#define SCREEN_WIDTH 640
+#define SCREEN_HEIGHT 480
+#define PADDLE_WIDTH 100
+#define PADDLE_HEIGHT 20
+#define PADDLE_Y (SCREEN_HEIGHT - 40)
+#define PADDLE_SPEED 10
+#define BALL_SIZE 15
+#define BRICK_ROWS 6
+#define BRICK_COLS 8
+#define BRICK_WIDTH (SCREEN_WIDTH / BRICK_COLS)
+#define BRICK_HEIGHT 30
+#define SCORE_HEIGHT 40
+#define INITIAL_LIVES 3
+#define MIN_BALL_SPEED 4
+
+#define FX_SHIFT 16
+#define FX_ONE (1 << FX_SHIFT)
+#define FX(n) ((int32_t)(n) * FX_ONE)
+
+// Whole part, rounded down. Dividing after clearing the fraction is exact,
+// where a right shift of a negative number is up to the compiler.
+static inline int32_t fx_floor(int32_t value) {
+    return (value - (value & (FX_ONE - 1))) / FX_ONE;
+}
+
+#if BRICK_ROWS * BRICK_COLS > 64
+#error "SimState.brick_mask holds at most 64 bricks"
+#endif
+
+typedef enum {
+    GAME_STATE_START_SCREEN,
+    GAME_STATE_PLAYING,
+    GAME_STATE_WIN_SCREEN,
+    GAME_STATE_GAME_OVER
+} GameState;
+
+typedef enum {
+    BRICK_RED,
+    BRICK_BLUE,
+    BRICK_YELLOW
+} BrickType;
+
+// Input bits for sim_advance
+#define INPUT_LEFT 1
+#define INPUT_RIGHT 2
+
+// What a step did, for the caller to turn into sound
+#define SIM_EVENT_PADDLE_HIT 1
+#define SIM_EVENT_BRICK_HIT 2
+#define SIM_EVENT_GAME_OVER 4
+#define SIM_EVENT_GAME_WON 8
+
+typedef struct {
+    uint64_t brick_mask;    // Bit (row * BRICK_COLS + col) set while standing
+    int32_t ball_x, ball_y; // 16.16 pixels
+    int32_t ball_dx, ball_dy; // 16.16 pixels per step
+    uint32_t frame;         // Steps since sim_init
+    uint32_t rng;           // xorshift32 state
+    int32_t state;          // GameState
+    int32_t paddle_x;
+    int32_t score;
+    int32_t lives;
+    int32_t combo;
+    uint32_t input;         // INPUT_* bits the last step ran with
+} SimState;
+
+// Start screen, with the random generator seeded (0 is replaced)
+void sim_init(SimState* sim, uint32_t seed);
+
+// A new game from the top: bricks, ball, paddle, score and lives
+void sim_reset(SimState* sim);
+
+// One fixed step; does nothing off the playing screen. Returns the
+// SIM_EVENT_* bits for what happened. It's sim_move then sim_collide,
+// which main.c calls apart so the profiler can time collision on its own.
+uint32_t sim_advance(SimState* sim, uint32_t input);
+
+// The first half of a step: the paddle and ball move and the ball
+// bounces off the walls. Returns false off the playing screen, where
+// nothing moved and sim_collide shouldn't run.
+bool sim_move(SimState* sim, uint32_t input);
+
+// The second half of a step, after the paddle and ball have moved and
+// bounced off the walls: paddle, bricks, ball loss and the win, tested at
+// the ball's whole-pixel position. env_batch.c does the first half for
+// many games at once and comes here only for the ones near something.
+uint32_t sim_collide(SimState* sim, int ball_x, int ball_y);
+
+// Whole pixels, rounded down, for drawing
+int sim_ball_x(const SimState* sim);
+int sim_ball_y(const SimState* sim);
+
+// FNV-1a over the state bytes, so x86 and ARM runs can be compared
+uint32_t sim_hash(const SimState* sim);
+
+// Brick layout never changes, only which stand
+BrickType sim_brick_type(int row);
+int sim_brick_x(int col);
+int sim_brick_y(int row);
+
+#endif // SIM_H
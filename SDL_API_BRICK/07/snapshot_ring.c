@@ -0,0 +1,56 @@
+#include "snapshot_ring.h"
+#include <string.h>
+
+#define STATE_WORDS (sizeof(SimState) / sizeof(uint64_t))
+
+_Static_assert(sizeof(SimState) % sizeof(uint64_t) == 0, "SimState is XORed a uint64_t at a time");
+
+typedef struct {
+    uint64_t words[STATE_WORDS];
+} StateWords;
+
+static StateWords deltas[SNAPSHOT_RING_FRAMES];
+static int head = 0;        // Slot the next delta goes in
+static int depth = 0;       // Deltas that can still be undone
+static StateWords previous; // The last recorded state
+
+void snapshot_ring_reset(const SimState* start) {
+    memcpy(&previous, start, sizeof(previous));
+    head = 0;
+    depth = 0;
+}
+
+void snapshot_ring_record(const SimState* sim) {
+    StateWords current;
+    memcpy(&current, sim, sizeof(current));
+
+    uint64_t changed = 0;
+    StateWords* delta = &deltas[head];
+    for (size_t i = 0; i < STATE_WORDS; i++) {
+        delta->words[i] = current.words[i] ^ previous.words[i];
+        changed |= delta->words[i];
+    }
+    if (changed == 0) {
+        return;
+    }
+
+    previous = current;
+    head = (head + 1) % SNAPSHOT_RING_FRAMES;
+    if (depth < SNAPSHOT_RING_FRAMES) {
+        depth++;
+    }
+}
+
+bool snapshot_ring_step_back(SimState* sim) {
+    if (depth == 0) {
+        return false;
+    }
+
+    head = (head + SNAPSHOT_RING_FRAMES - 1) % SNAPSHOT_RING_FRAMES;
+    depth--;
+    for (size_t i = 0; i < STATE_WORDS; i++) {
+        previous.words[i] ^= deltas[head].words[i];
+    }
+    memcpy(sim, &previous, sizeof(*sim));
+    return true;
+}
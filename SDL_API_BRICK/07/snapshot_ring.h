@@ -0,0 +1,24 @@
+#ifndef SNAPSHOT_RING_H
+#define SNAPSHOT_RING_H
+
+#include "sim.h"
+#include <stdbool.h>
+
+// Rewind history: after every simulation step the state is XORed against
+// the previous one and the difference goes into a ring, so stepping back
+// is an XOR of the newest entry into the state. Steps that changed
+// nothing (the menus) store nothing. Recording is a memcpy and a few word
+// XORs of a 56-byte SimState, well under a microsecond, so it runs every
+// step whether anyone rewinds or not.
+
+#define SNAPSHOT_RING_FRAMES (60 * 10)  // Ten seconds at SIM_HZ
+
+// Forget the history; start is the state the next delta is taken against
+void snapshot_ring_reset(const SimState* start);
+void snapshot_ring_record(const SimState* sim);
+
+// Undoes the newest recorded step into sim; false once the history is used
+// up. Recording afterwards carries on from the rewound state.
+bool snapshot_ring_step_back(SimState* sim);
+
+#endif // SNAPSHOT_RING_H
@@ -0,0 +1,545 @@
+#include "spectate.h"
+#include <SDL2/SDL.h>
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define PACKET_MAGIC 0xB5
+#define PACKET_VERSION 1
+#define PACKET_HEADER 4             // Magic, version, 16-bit sequence
+#define UDP_OVERHEAD 28             // IPv4 and UDP headers, for the report
+#define VARINT_MAX_BYTES 5          // A 32-bit value at 7 bits a byte
+
+// Worst cases: a keyframe is flags, state, lives, score, paddle and the
+// ball's position and step, then the brick mask. A delta is flags, both
+// ball step changes, paddle, every brick broken at once, score and lives.
+#define KEY_FRAME_BYTES (3 + 6 * VARINT_MAX_BYTES + 8)
+#define DELTA_FRAME_BYTES (1 + 2 * VARINT_MAX_BYTES + VARINT_MAX_BYTES + 1 + BRICK_ROWS * BRICK_COLS + \
+                           VARINT_MAX_BYTES + 1)
+#define MAX_FRAME_BYTES (KEY_FRAME_BYTES > DELTA_FRAME_BYTES ? KEY_FRAME_BYTES : DELTA_FRAME_BYTES)
+
+#if PACKET_HEADER + MAX_FRAME_BYTES > SPECTATE_MAX_PACKET
+#error "SPECTATE_MAX_PACKET can't hold the largest frame"
+#endif
+
+// Frame flags
+#define FRAME_BALL 1        // Change in the ball's step, x then y
+#define FRAME_PADDLE 2      // Paddle step
+#define FRAME_BRICKS 4      // Count, then the bit index of each broken brick
+#define FRAME_SCORE 8       // Score change
+#define FRAME_LIVES 16      // New lives
+#define FRAME_KEY 128       // Everything, in full
+
+// What both ends know of the game after the last frame
+typedef struct {
+    uint64_t bricks;
+    int32_t score;
+    int32_t paddle_x;
+    int32_t ball_x, ball_y;
+    int32_t ball_dx, ball_dy;   // The last step, which the next is predicted to repeat
+    uint8_t state;
+    uint8_t lives;
+} StreamState;
+
+typedef struct {
+    uint64_t bricks;
+    int32_t score;
+    int32_t paddle_x;
+    int32_t ball_x, ball_y;
+    uint8_t state;
+    uint8_t lives;
+    uint32_t events;
+} ShownFrame;
+
+typedef struct {
+    const uint8_t* at;
+    const uint8_t* end;
+    bool failed;
+} Reader;
+
+// Publisher
+static int publish_socket = -1;
+static struct sockaddr_storage publish_address;
+static socklen_t publish_address_size = 0;
+static uint8_t packet[SPECTATE_MAX_PACKET];
+static int packet_size = 0;
+static int packet_frames = 0;
+static uint32_t packet_started_ms = 0;
+static uint16_t publish_sequence = 0;
+static StreamState published;
+static bool key_sent = false;
+static uint32_t last_key_ms = 0;
+static uint32_t first_publish_ms = 0, last_publish_ms = 0;
+static uint32_t published_frames = 0, published_packets = 0, published_bytes = 0;
+static Uint64 encode_ticks = 0;
+static int loss_percent = 0;
+static uint32_t loss_rng = 0x2545F491u;
+static uint32_t dropped_packets = 0;
+
+// Spectator
+static int watch_socket = -1;
+static char watch_path[108] = "";
+static StreamState received;
+static bool synced = false;
+static uint16_t expected_sequence = 0;
+static ShownFrame queue[SPECTATE_QUEUE_FRAMES];
+static int queue_head = 0, queue_count = 0;
+static bool playing = false;
+static int last_packet_frames = 1;
+static uint32_t lost_packets = 0;
+
+// Zigzag keeps small negative numbers small: 0, -1, 1, -2 become 0, 1, 2, 3
+static uint32_t zigzag(int32_t value) {
+    return value < 0 ? ((uint32_t)(-(value + 1)) << 1) | 1 : (uint32_t)value << 1;
+}
+
+static int32_t unzigzag(uint32_t value) {
+    return (value & 1) ? -(int32_t)(value >> 1) - 1 : (int32_t)(value >> 1);
+}
+
+static uint8_t* put_varint(uint8_t* at, uint32_t value) {
+    while (value >= 0x80) {
+        *at++ = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    *at++ = (uint8_t)value;
+    return at;
+}
+
+static uint8_t read_byte(Reader* reader) {
+    if (reader->at >= reader->end) {
+        reader->failed = true;
+        return 0;
+    }
+    return *reader->at++;
+}
+
+static uint32_t read_varint(Reader* reader) {
+    uint32_t value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        uint8_t byte = read_byte(reader);
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return value;
+    }
+    reader->failed = true;
+    return 0;
+}
+
+// "unix:<path>" or "host:port"; a receiving end gives just the port
+static bool make_address(const char* spec, bool receiving, struct sockaddr_storage* address, socklen_t* size) {
+    memset(address, 0, sizeof(*address));
+    if (strncmp(spec, "unix:", 5) == 0) {
+        struct sockaddr_un* unix_address = (struct sockaddr_un*)address;
+        if (strlen(spec + 5) >= sizeof(unix_address->sun_path)) {
+            printf("spectate: socket path too long: %s\n", spec + 5);
+            return false;
+        }
+        unix_address->sun_family = AF_UNIX;
+        strcpy(unix_address->sun_path, spec + 5);
+        *size = sizeof(*unix_address);
+        return true;
+    }
+
+    struct sockaddr_in* inet_address = (struct sockaddr_in*)address;
+    *size = sizeof(*inet_address);
+    if (receiving) {
+        inet_address->sin_family = AF_INET;
+        inet_address->sin_addr.s_addr = htonl(INADDR_ANY);
+        inet_address->sin_port = htons((uint16_t)atoi(spec));
+        return true;
+    }
+
+    char host[128];
+    snprintf(host, sizeof(host), "%s", spec);
+    char* port = strrchr(host, ':');
+    if (port == NULL) {
+        printf("spectate: expected host:port or unix:<path>, got %s\n", spec);
+        return false;
+    }
+    *port++ = '\0';
+    struct addrinfo hints = {0};
+    struct addrinfo* found = NULL;
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    int error = getaddrinfo(host, port, &hints, &found);
+    if (error != 0) {
+        printf("spectate: can't resolve %s: %s\n", spec, gai_strerror(error));
+        return false;
+    }
+    memcpy(inet_address, found->ai_addr, sizeof(*inet_address));
+    freeaddrinfo(found);
+    return true;
+}
+
+static int open_socket(int family) {
+    int fd = socket(family, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        printf("spectate: socket: %s\n", strerror(errno));
+        return -1;
+    }
+    int on = 1;
+    if (family == AF_INET) {
+        setsockopt(fd, SOL_SOCKET, SO_BROADCAST, &on, sizeof(on));
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return fd;
+}
+
+bool spectate_publish_open(const char* target) {
+    if (!make_address(target, false, &publish_address, &publish_address_size)) {
+        return false;
+    }
+    publish_socket = open_socket(publish_address.ss_family);
+
+    // A new stream starts from a keyframe with fresh counts
+    packet_size = 0;
+    packet_frames = 0;
+    publish_sequence = 0;
+    key_sent = false;
+    published_frames = published_packets = published_bytes = dropped_packets = 0;
+    encode_ticks = 0;
+    return publish_socket >= 0;
+}
+
+void spectate_publish_loss(int percent) {
+    loss_percent = percent;
+}
+
+bool spectate_publishing(void) {
+    return publish_socket >= 0;
+}
+
+static void flush_packet(void) {
+    if (packet_frames == 0) return;
+
+    packet[0] = PACKET_MAGIC;
+    packet[1] = PACKET_VERSION;
+    packet[2] = (uint8_t)publish_sequence;
+    packet[3] = (uint8_t)(publish_sequence >> 8);
+    publish_sequence++;
+
+    loss_rng ^= loss_rng << 13;
+    loss_rng ^= loss_rng >> 17;
+    loss_rng ^= loss_rng << 5;
+    if ((int)(loss_rng % 100) < loss_percent) {
+        dropped_packets++;
+    } else {
+        // Nobody listening yet is fine; the stream just goes nowhere
+        sendto(publish_socket, packet, (size_t)packet_size, 0,
+               (const struct sockaddr*)&publish_address, publish_address_size);
+    }
+    published_packets++;
+    published_bytes += (uint32_t)packet_size;
+    packet_size = PACKET_HEADER;
+    packet_frames = 0;
+}
+
+static uint8_t* encode_key(uint8_t* at, const StreamState* now) {
+    *at++ = FRAME_KEY;
+    *at++ = now->state;
+    *at++ = now->lives;
+    at = put_varint(at, (uint32_t)now->score);
+    at = put_varint(at, zigzag(now->paddle_x));
+    at = put_varint(at, zigzag(now->ball_x));
+    at = put_varint(at, zigzag(now->ball_y));
+    at = put_varint(at, zigzag(now->ball_dx));
+    at = put_varint(at, zigzag(now->ball_dy));
+    for (int i = 0; i < 8; i++) {
+        *at++ = (uint8_t)(now->bricks >> (8 * i));
+    }
+    return at;
+}
+
+static uint8_t* encode_delta(uint8_t* at, const StreamState* now) {
+    uint8_t* flags = at++;
+    *flags = 0;
+    if (now->ball_dx != published.ball_dx || now->ball_dy != published.ball_dy) {
+        *flags |= FRAME_BALL;
+        at = put_varint(at, zigzag(now->ball_dx - published.ball_dx));
+        at = put_varint(at, zigzag(now->ball_dy - published.ball_dy));
+    }
+    if (now->paddle_x != published.paddle_x) {
+        *flags |= FRAME_PADDLE;
+        at = put_varint(at, zigzag(now->paddle_x - published.paddle_x));
+    }
+    uint64_t broken = published.bricks & ~now->bricks;
+    if (broken != 0) {
+        *flags |= FRAME_BRICKS;
+        uint8_t* count = at++;
+        *count = 0;
+        for (int bit = 0; bit < 64; bit++) {
+            if (broken & ((uint64_t)1 << bit)) {
+                *at++ = (uint8_t)bit;
+                (*count)++;
+            }
+        }
+    }
+    if (now->score != published.score) {
+        *flags |= FRAME_SCORE;
+        at = put_varint(at, zigzag(now->score - published.score));
+    }
+    if (now->lives != published.lives) {
+        *flags |= FRAME_LIVES;
+        *at++ = now->lives;
+    }
+    return at;
+}
+
+void spectate_publish(const SimState* sim, uint32_t now_ms) {
+    if (publish_socket < 0) return;
+    Uint64 start = SDL_GetPerformanceCounter();
+
+    StreamState now;
+    now.bricks = sim->brick_mask;
+    now.score = sim->score;
+    now.paddle_x = sim->paddle_x;
+    now.ball_x = sim_ball_x(sim);
+    now.ball_y = sim_ball_y(sim);
+    now.ball_dx = key_sent ? now.ball_x - published.ball_x : 0;
+    now.ball_dy = key_sent ? now.ball_y - published.ball_y : 0;
+    now.state = (uint8_t)sim->state;
+    now.lives = (uint8_t)sim->lives;
+
+    if (packet_size == 0) {
+        packet_size = PACKET_HEADER;
+        first_publish_ms = now_ms;
+    }
+    if (packet_size + MAX_FRAME_BYTES > SPECTATE_MAX_PACKET) {
+        flush_packet();
+    }
+    if (packet_frames == 0) {
+        packet_started_ms = now_ms;
+    }
+
+    // Bricks only come back with a new game or a rewind; both get a key
+    uint8_t* at = packet + packet_size;
+    bool key = !key_sent || now.state != published.state || (now.bricks & ~published.bricks) != 0 ||
+               now_ms - last_key_ms >= SPECTATE_KEYFRAME_MS;
+    if (key) {
+        at = encode_key(at, &now);
+        key_sent = true;
+        last_key_ms = now_ms;
+    } else {
+        at = encode_delta(at, &now);
+    }
+    packet_size = (int)(at - packet);
+    packet_frames++;
+    published = now;
+    published_frames++;
+    last_publish_ms = now_ms;
+
+    if (packet_frames >= SPECTATE_BATCH_FRAMES || now_ms - packet_started_ms >= SPECTATE_FLUSH_MS) {
+        flush_packet();
+    }
+    encode_ticks += SDL_GetPerformanceCounter() - start;
+}
+
+void spectate_publish_close(void) {
+    if (publish_socket < 0) return;
+    flush_packet();
+    close(publish_socket);
+    publish_socket = -1;
+
+    double seconds = (last_publish_ms - first_publish_ms) / 1000.0;
+    if (seconds <= 0.0) seconds = 1.0;
+    printf("spectate: %u frames in %u packets, %.0f B/s, %.0f B/s with UDP/IP headers, "
+           "%.3f us per frame to encode\n",
+           published_frames, published_packets, published_bytes / seconds,
+           (published_bytes + published_packets * UDP_OVERHEAD) / seconds,
+           published_frames > 0 ? encode_ticks * 1e6 / SDL_GetPerformanceFrequency() / published_frames : 0.0);
+    if (dropped_packets > 0) {
+        printf("spectate: %u packets dropped by the simulated loss\n", dropped_packets);
+    }
+}
+
+bool spectate_watch_open(const char* source) {
+    struct sockaddr_storage address;
+    socklen_t size;
+    if (!make_address(source, true, &address, &size)) {
+        return false;
+    }
+    watch_socket = open_socket(address.ss_family);
+    if (watch_socket < 0) {
+        return false;
+    }
+    synced = false;
+    playing = false;
+    queue_head = queue_count = 0;
+    last_packet_frames = 1;
+    lost_packets = 0;
+    if (address.ss_family == AF_UNIX) {
+        // A socket file left by an earlier run would block the bind
+        snprintf(watch_path, sizeof(watch_path), "%s", source + 5);
+        unlink(watch_path);
+    }
+    if (bind(watch_socket, (struct sockaddr*)&address, size) != 0) {
+        printf("spectate: can't listen on %s: %s\n", source, strerror(errno));
+        spectate_watch_close();
+        return false;
+    }
+    return true;
+}
+
+bool spectate_watching(void) {
+    return watch_socket >= 0;
+}
+
+static void queue_frame(uint32_t events) {
+    if (queue_count == SPECTATE_QUEUE_FRAMES) {
+        queue_head = (queue_head + 1) % SPECTATE_QUEUE_FRAMES;
+        queue_count--;
+    }
+    ShownFrame* frame = &queue[(queue_head + queue_count++) % SPECTATE_QUEUE_FRAMES];
+    frame->bricks = received.bricks;
+    frame->score = received.score;
+    frame->paddle_x = received.paddle_x;
+    frame->ball_x = received.ball_x;
+    frame->ball_y = received.ball_y;
+    frame->state = received.state;
+    frame->lives = received.lives;
+    frame->events = events;
+}
+
+// Deltas are still read through while out of sync, to find the next key
+static bool decode_frame(Reader* reader) {
+    uint8_t flags = read_byte(reader);
+    uint32_t events = 0;
+
+    if (flags & FRAME_KEY) {
+        uint8_t state_before = received.state;
+        received.state = read_byte(reader);
+        received.lives = read_byte(reader);
+        received.score = (int32_t)read_varint(reader);
+        received.paddle_x = unzigzag(read_varint(reader));
+        received.ball_x = unzigzag(read_varint(reader));
+        received.ball_y = unzigzag(read_varint(reader));
+        received.ball_dx = unzigzag(read_varint(reader));
+        received.ball_dy = unzigzag(read_varint(reader));
+        received.bricks = 0;
+        for (int i = 0; i < 8; i++) {
+            received.bricks |= (uint64_t)read_byte(reader) << (8 * i);
+        }
+        if (synced && received.state != state_before) {
+            if (received.state == GAME_STATE_GAME_OVER) events |= SIM_EVENT_GAME_OVER;
+            if (received.state == GAME_STATE_WIN_SCREEN) events |= SIM_EVENT_GAME_WON;
+        }
+        synced = !reader->failed;
+    } else {
+        int32_t ball_ddx = 0, ball_ddy = 0, paddle_dx = 0, score_change = 0;
+        uint64_t broken = 0;
+        uint8_t lives = received.lives;
+        if (flags & FRAME_BALL) {
+            ball_ddx = unzigzag(read_varint(reader));
+            ball_ddy = unzigzag(read_varint(reader));
+        }
+        if (flags & FRAME_PADDLE) {
+            paddle_dx = unzigzag(read_varint(reader));
+        }
+        if (flags & FRAME_BRICKS) {
+            for (int count = read_byte(reader); count > 0; count--) {
+                broken |= (uint64_t)1 << (read_byte(reader) & 63);
+            }
+        }
+        if (flags & FRAME_SCORE) {
+            score_change = unzigzag(read_varint(reader));
+        }
+        if (flags & FRAME_LIVES) {
+            lives = read_byte(reader);
+        }
+        if (!synced || reader->failed) {
+            return !reader->failed;
+        }
+
+        received.ball_dx += ball_ddx;
+        received.ball_dy += ball_ddy;
+        received.ball_x += received.ball_dx;
+        received.ball_y += received.ball_dy;
+        received.paddle_x += paddle_dx;
+        received.bricks &= ~broken;
+        received.score += score_change;
+        received.lives = lives;
+        if (broken != 0) events |= SIM_EVENT_BRICK_HIT;
+    }
+
+    if (synced && !reader->failed) {
+        queue_frame(events);
+    }
+    return !reader->failed;
+}
+
+static void receive_packets(void) {
+    uint8_t bytes[SPECTATE_MAX_PACKET];
+    ssize_t size;
+    while ((size = recv(watch_socket, bytes, sizeof(bytes), 0)) > 0) {
+        if (size < PACKET_HEADER || bytes[0] != PACKET_MAGIC || bytes[1] != PACKET_VERSION) continue;
+
+        // A gap in the sequence loses the deltas in between; wait for a key
+        uint16_t sequence = (uint16_t)(bytes[2] | bytes[3] << 8);
+        if (synced && sequence != expected_sequence) {
+            synced = false;
+            lost_packets++;
+        }
+        expected_sequence = (uint16_t)(sequence + 1);
+
+        Reader reader = {bytes + PACKET_HEADER, bytes + size, false};
+        int frames = 0;
+        while (reader.at < reader.end && decode_frame(&reader)) {
+            frames++;
+        }
+        if (reader.failed) {
+            synced = false;
+        }
+        last_packet_frames = frames > 0 ? frames : 1;
+    }
+}
+
+uint32_t spectate_watch_step(SimState* sim) {
+    if (watch_socket < 0) return 0;
+    receive_packets();
+
+    // Playback runs a packet behind. When it runs dry it waits for
+    // another packet's worth, and when it falls far behind it skips ahead.
+    if (!playing && queue_count >= last_packet_frames) {
+        playing = true;
+    }
+    while (queue_count > 3 * SPECTATE_BATCH_FRAMES) {
+        queue_head = (queue_head + 1) % SPECTATE_QUEUE_FRAMES;
+        queue_count--;
+    }
+    if (!playing || queue_count == 0) {
+        playing = false;
+        return 0;
+    }
+
+    const ShownFrame* frame = &queue[queue_head];
+    queue_head = (queue_head + 1) % SPECTATE_QUEUE_FRAMES;
+    queue_count--;
+    sim->state = frame->state;
+    sim->lives = frame->lives;
+    sim->score = frame->score;
+    sim->paddle_x = frame->paddle_x;
+    sim->ball_x = FX(frame->ball_x);
+    sim->ball_y = FX(frame->ball_y);
+    sim->brick_mask = frame->bricks;
+    return frame->events;
+}
+
+void spectate_watch_close(void) {
+    if (watch_socket < 0) return;
+    close(watch_socket);
+    watch_socket = -1;
+    if (watch_path[0] != '\0') {
+        unlink(watch_path);
+        watch_path[0] = '\0';
+    }
+    if (lost_packets > 0) {
+        printf("spectate: %u packets lost\n", lost_packets);
+    }
+}
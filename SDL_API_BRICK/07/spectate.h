@@ -0,0 +1,54 @@
+#ifndef SPECTATE_H
+#define SPECTATE_H
+
+#include "sim.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Spectator stream for tournament displays. --broadcast <target> sends
+// the game as it plays, and --spectate <source> shows it in another
+// brickout. A target is "host:port" for UDP (a broadcast address works
+// too, for several displays) or "unix:<path>" for a UNIX datagram socket
+// on the same machine; a source is the port or "unix:<path>" to receive on.
+//
+// Each simulation step becomes one frame of the stream and only what
+// changed is written. A frame starts with a byte of flags. The ball is
+// sent only when its step differs from the last one, as the change in
+// step in zigzag varints. The paddle is a varint step, and each broken
+// brick is its bit index. Score, lives and the game state follow when
+// they change. A keyframe with everything goes out every
+// SPECTATE_KEYFRAME_MS and on each state change, so a display can join
+// at any time and recover from a lost datagram. Frames are batched
+// SPECTATE_BATCH_FRAMES to a datagram, or sent after SPECTATE_FLUSH_MS,
+// which keeps the stream to a few hundred bytes a second, headers
+// included. The display plays the frames back one per step, behind by a
+// batch.
+
+#define SPECTATE_BATCH_FRAMES 10
+#define SPECTATE_FLUSH_MS 200
+#define SPECTATE_KEYFRAME_MS 2000
+#define SPECTATE_MAX_PACKET 512
+#define SPECTATE_QUEUE_FRAMES 256   // Received frames waiting to be shown
+
+// Publisher; call spectate_publish once per simulation step
+bool spectate_publish_open(const char* target);
+bool spectate_publishing(void);
+void spectate_publish(const SimState* sim, uint32_t now_ms);
+
+// Drops this percentage of datagrams before they're sent, for --netsim
+// and spectate_check
+void spectate_publish_loss(int percent);
+
+// Sends what's batched and prints the frame count, bandwidth and encode time
+void spectate_publish_close(void);
+
+// Spectator; spectate_watch_step takes the next received frame into sim
+// (only the drawn fields) once per step, and holds the last one while the
+// stream is behind. Returns SIM_EVENT_BRICK_HIT and the game over and won
+// events, for sound.
+bool spectate_watch_open(const char* source);
+bool spectate_watching(void);
+uint32_t spectate_watch_step(SimState* sim);
+void spectate_watch_close(void);
+
+#endif // SPECTATE_H
@@ -0,0 +1,178 @@
+// Spectator stream check: a scripted game is published over a UNIX
+// datagram socket with simulated loss and watched in the same process, on
+// a clock of its own so the run takes no real time. Every frame the
+// spectator shows has to be one the publisher sent, in order, and with no
+// loss every frame has to be shown. A second pass publishes synthetic
+// frames with large jumps and every brick broken at once, to cover the
+// encoder's worst cases. Prints the publisher's bandwidth and encode time
+// and exits nonzero on any mismatch.
+//
+// Usage: ./spectate_check [steps] [loss percent]
+
+#include "spectate.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_STEPS 72000         // Twenty minutes at 60 Hz
+#define SYNTHETIC_STEPS 20000
+#define STEP_HZ 60
+#define SOCKET_SPEC "unix:/tmp/spectate_check.sock"
+#define MAX_LAG_FRAMES (2 * SPECTATE_BATCH_FRAMES)
+
+// The fields a frame carries, as the spectator draws them
+typedef struct {
+    uint64_t bricks;
+    int32_t score, lives, state;
+    int32_t paddle_x, ball_x, ball_y;
+} Frame;
+
+typedef struct {
+    Frame* sent;
+    long sent_count;
+    long next;          // First sent frame the next shown one may match
+    long shown;
+    long skipped;       // Sent frames never shown, from loss or catching up
+    bool ok;
+} Checker;
+
+static uint32_t rng = 0x9E3779B9u;
+
+static uint32_t next_random(void) {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static Frame frame_of(const SimState* sim) {
+    Frame frame;
+    memset(&frame, 0, sizeof(frame));
+    frame.bricks = sim->brick_mask;
+    frame.score = sim->score;
+    frame.lives = sim->lives;
+    frame.state = sim->state;
+    frame.paddle_x = sim->paddle_x;
+    frame.ball_x = sim_ball_x(sim);
+    frame.ball_y = sim_ball_y(sim);
+    return frame;
+}
+
+// Tracks the ball with the paddle, missing now and then so lives go too
+static uint32_t input_for(const SimState* sim, long step) {
+    if ((step / 240) % 5 == 4) return 0;
+    int ball_x = sim_ball_x(sim);
+    if (ball_x > sim->paddle_x + PADDLE_WIDTH * 3 / 4) return INPUT_RIGHT;
+    if (ball_x < sim->paddle_x + PADDLE_WIDTH / 4) return INPUT_LEFT;
+    return 0;
+}
+
+// Big moves and score jumps; bricks only break, apart from a full refill
+// now and then, which the publisher sends as a keyframe
+static void synthetic_step(SimState* sim, long step) {
+    sim->state = GAME_STATE_PLAYING;
+    sim->paddle_x = (int32_t)(next_random() % (1 << 24)) - (1 << 23);
+    sim->ball_x = FX((int32_t)(next_random() % 32000) - 16000);
+    sim->ball_y = FX((int32_t)(next_random() % 32000) - 16000);
+    sim->score += (int32_t)(next_random() % (1 << 20)) - (1 << 19);
+    sim->lives = (int32_t)(next_random() % 256);
+    if (step % 50 == 0) {
+        sim->brick_mask = ((uint64_t)1 << (BRICK_ROWS * BRICK_COLS)) - 1;
+    } else if (step % 50 == 1) {
+        sim->brick_mask = 0;
+    } else {
+        sim->brick_mask &= ((uint64_t)next_random() << 32) | next_random();
+    }
+}
+
+// Finds what the spectator just showed among the frames sent so far
+static void check_shown(Checker* checker, const SimState* shown, bool lossless) {
+    Frame frame = frame_of(shown);
+    long found = checker->next;
+    while (found < checker->sent_count && memcmp(&checker->sent[found], &frame, sizeof(frame)) != 0) {
+        found++;
+    }
+    if (found == checker->sent_count) {
+        printf("spectate_check: shown frame %ld was never sent (score %d, ball %d,%d)\n",
+               checker->shown, frame.score, frame.ball_x, frame.ball_y);
+        checker->ok = false;
+        return;
+    }
+    if (lossless && found != checker->next) {
+        printf("spectate_check: skipped sent frames %ld to %ld with no loss\n", checker->next, found - 1);
+        checker->ok = false;
+    }
+    checker->skipped += found - checker->next;
+    checker->next = found + 1;
+    checker->shown++;
+}
+
+static bool run(const char* name, long steps, bool synthetic, bool lossless) {
+    Checker checker = {0};
+    checker.sent = malloc(sizeof(Frame) * (size_t)steps);
+    checker.ok = checker.sent != NULL;
+
+    SimState sim, shown;
+    sim_init(&sim, 1234);
+    memset(&shown, 0, sizeof(shown));
+    int games = 0;
+    for (long step = 0; step < steps && checker.ok; step++) {
+        if (synthetic) {
+            synthetic_step(&sim, step);
+        } else {
+            if (sim.state != GAME_STATE_PLAYING) {
+                sim_reset(&sim);
+                games++;
+            }
+            sim_advance(&sim, input_for(&sim, step));
+        }
+        spectate_publish(&sim, (uint32_t)(step * 1000 / STEP_HZ));
+        checker.sent[checker.sent_count++] = frame_of(&sim);
+
+        // Every shown frame sets the paddle, so a sentinel tells whether
+        // this step showed one
+        int32_t paddle_x = shown.paddle_x;
+        shown.paddle_x = INT32_MIN;
+        spectate_watch_step(&shown);
+        if (shown.paddle_x == INT32_MIN) {
+            shown.paddle_x = paddle_x;
+        } else {
+            check_shown(&checker, &shown, lossless);
+        }
+    }
+
+    long lag = checker.sent_count - checker.next;
+    if (checker.ok && lossless && lag > MAX_LAG_FRAMES) {
+        printf("spectate_check: the spectator is %ld frames behind\n", lag);
+        checker.ok = false;
+    }
+    printf("spectate_check %s: %ld frames sent, %ld shown, %ld skipped, %ld behind at the end",
+           name, checker.sent_count, checker.shown, checker.skipped, lag);
+    if (!synthetic) printf(", %d games", games);
+    printf("\n");
+    free(checker.sent);
+    return checker.ok;
+}
+
+int main(int argc, char* argv[]) {
+    long steps = argc > 1 ? atol(argv[1]) : DEFAULT_STEPS;
+    int loss = argc > 2 ? atoi(argv[2]) : 0;
+    if (steps <= 0 || loss < 0 || loss > 100) {
+        printf("Usage: %s [steps] [loss percent]\n", argv[0]);
+        return 1;
+    }
+
+    // Each pass gets a fresh publisher and spectator
+    bool ok = true;
+    for (int pass = 0; pass < 2 && ok; pass++) {
+        if (!spectate_watch_open(SOCKET_SPEC) || !spectate_publish_open(SOCKET_SPEC)) {
+            return 1;
+        }
+        spectate_publish_loss(loss);
+        ok = pass == 0 ? run("game", steps, false, loss == 0) : run("synthetic", SYNTHETIC_STEPS, true, loss == 0);
+        spectate_publish_close();
+        spectate_watch_close();
+    }
+    printf("spectate_check: %s\n", ok ? "every shown frame matches" : "MISMATCH");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,61 @@
+#include "startup.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct {
+    char stage[STARTUP_STAGE_LENGTH];
+    double ms;
+} StartupMark;
+
+// Clock_gettime rather than SDL's counter, which isn't usable before
+// SDL_Init on every platform
+static struct timespec origin;
+static bool enabled = false;
+static StartupMark marks[STARTUP_MAX_MARKS];
+static int mark_count = 0;
+static int marks_dropped = 0;
+
+void startup_bench_begin(void) {
+    clock_gettime(CLOCK_MONOTONIC, &origin);
+}
+
+void startup_bench_enable(void) {
+    enabled = true;
+}
+
+bool startup_bench_enabled(void) {
+    return enabled;
+}
+
+void startup_bench_mark(const char* stage) {
+    if (!enabled) return;
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (mark_count == STARTUP_MAX_MARKS) {
+        marks_dropped++;
+        return;
+    }
+
+    StartupMark* mark = &marks[mark_count++];
+    mark->ms = (now.tv_sec - origin.tv_sec) * 1000.0 + (now.tv_nsec - origin.tv_nsec) / 1000000.0;
+    // Stage names are single words in the report, so asset paths keep
+    // their slashes but lose any spaces
+    snprintf(mark->stage, sizeof(mark->stage), "%s", stage);
+    for (char* c = mark->stage; *c != '\0'; c++) {
+        if (*c == ' ' || *c == '\t') *c = '_';
+    }
+}
+
+void startup_bench_report(void) {
+    if (!enabled) return;
+
+    for (int i = 0; i < mark_count; i++) {
+        printf("startup_bench %s %.3f\n", marks[i].stage, marks[i].ms);
+    }
+    if (marks_dropped > 0) {
+        printf("startup_bench: %d marks past the first %d were dropped\n", marks_dropped, STARTUP_MAX_MARKS);
+    }
+    fflush(stdout);
+}
@@ -0,0 +1,22 @@
+#ifndef STARTUP_H
+#define STARTUP_H
+
+#include <stdbool.h>
+
+// Time-to-first-frame benchmark for --bench-startup. startup_bench_begin()
+// takes the origin as the first thing in main; with the flag set, every
+// startup_bench_mark() after that stores the monotonic time since the
+// origin under a stage name, and startup_bench_report() prints one
+// "startup_bench <stage> <ms>" line per mark for bench_startup.sh to
+// collect. Without the flag the marks return straight away.
+
+#define STARTUP_MAX_MARKS 48
+#define STARTUP_STAGE_LENGTH 48
+
+void startup_bench_begin(void);
+void startup_bench_enable(void);
+bool startup_bench_enabled(void);
+void startup_bench_mark(const char* stage);
+void startup_bench_report(void);
+
+#endif // STARTUP_H
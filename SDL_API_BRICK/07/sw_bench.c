@@ -0,0 +1,137 @@
+// Software rasterizer benchmark: draws a game in progress with
+// swraster.c at the observation sizes (84x84, 160x96) and at 800x480,
+// single-threaded and with one thread per core, and prints frames per
+// second for each. SDL is only used to decode the sprites.
+//
+// Usage: ./sw_bench [frames] [out.bmp]
+// With out.bmp, the last 800x480 frame is saved for a look.
+
+#include "swraster.h"
+#include "sim.h"
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define DEFAULT_FRAMES 2000
+
+static const struct {
+    int width, height;
+} sizes[] = {
+    {84, 84},
+    {160, 96},
+    {800, 480}
+};
+
+static SDL_Surface* surfaces[SW_SPRITE_COUNT];
+static SwImage sprites[SW_SPRITE_COUNT];
+
+static bool load_sprites(void) {
+    for (int i = 0; i < SW_SPRITE_COUNT; i++) {
+        SDL_Surface* loaded = IMG_Load(sw_sprite_paths[i]);
+        if (loaded == NULL) {
+            printf("IMG_Load Error for %s: %s\n", sw_sprite_paths[i], IMG_GetError());
+            return false;
+        }
+        surfaces[i] = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_ARGB8888, 0);
+        SDL_FreeSurface(loaded);
+        if (surfaces[i] == NULL) {
+            printf("SDL_ConvertSurfaceFormat Error: %s\n", SDL_GetError());
+            return false;
+        }
+        sprites[i] = sw_image_init(surfaces[i]->w, surfaces[i]->h, surfaces[i]->pitch / 4,
+                                   surfaces[i]->pixels);
+    }
+    return true;
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// A game that keeps moving: the paddle chases the ball a little late
+static void advance(SimState* sim, SwScene* scene) {
+    int ball = sim_ball_x(sim) + BALL_SIZE / 2, paddle = sim->paddle_x + PADDLE_WIDTH / 2;
+    sim_advance(sim, ball < paddle - 20 ? INPUT_LEFT : ball > paddle + 20 ? INPUT_RIGHT : 0);
+    if (sim->state != GAME_STATE_PLAYING) {
+        sim_reset(sim);
+    }
+    *scene = (SwScene){sim->brick_mask, sim->paddle_x, sim_ball_x(sim), sim_ball_y(sim),
+                       sim->score, sim->lives, true};
+}
+
+static void bench(int width, int height, int frames, const char* save_path) {
+    uint32_t* pixels = malloc((size_t)width * height * sizeof(uint32_t));
+    uint8_t* gray = malloc((size_t)width * height);
+    if (pixels == NULL || gray == NULL) {
+        printf("sw_bench: out of memory at %dx%d\n", width, height);
+        exit(1);
+    }
+    SwTarget target = {width, height, width, pixels};
+
+    SimState sim;
+    SwScene scene;
+    sim_init(&sim, 1);
+    sim_reset(&sim);
+    advance(&sim, &scene);
+
+    double start = now_seconds();
+    for (int frame = 0; frame < frames; frame++) {
+        advance(&sim, &scene);
+        sw_raster_draw(sprites, &scene, &target);
+    }
+    double rgba_seconds = now_seconds() - start;
+
+    start = now_seconds();
+    for (int frame = 0; frame < frames; frame++) {
+        advance(&sim, &scene);
+        sw_raster_draw(sprites, &scene, &target);
+        sw_raster_to_gray(&target, gray);
+    }
+    double gray_seconds = now_seconds() - start;
+
+    printf("sw_bench %4dx%-4d %2d threads: %9.0f fps rgba, %9.0f fps gray8\n", width, height,
+           sw_raster_threads(), frames / rgba_seconds, frames / gray_seconds);
+
+    if (save_path != NULL) {
+        SDL_Surface* shot = SDL_CreateRGBSurfaceWithFormatFrom(pixels, width, height, 32, width * 4,
+                                                               SDL_PIXELFORMAT_ARGB8888);
+        if (shot == NULL || SDL_SaveBMP(shot, save_path) != 0) {
+            printf("sw_bench: can't save %s: %s\n", save_path, SDL_GetError());
+        }
+        SDL_FreeSurface(shot);
+    }
+    free(gray);
+    free(pixels);
+}
+
+int main(int argc, char* argv[]) {
+    int frames = argc > 1 ? atoi(argv[1]) : DEFAULT_FRAMES;
+    const char* save_path = argc > 2 ? argv[2] : NULL;
+    if (frames <= 0) {
+        printf("Usage: %s [frames] [out.bmp]\n", argv[0]);
+        return 1;
+    }
+    if (!(IMG_Init(IMG_INIT_PNG) & IMG_INIT_PNG) || !load_sprites()) {
+        return 1;
+    }
+
+    int count = sizeof(sizes) / sizeof(sizes[0]);
+    for (int i = 0; i < count; i++) {
+        bench(sizes[i].width, sizes[i].height, frames, NULL);
+    }
+    sw_raster_init(0);
+    for (int i = 0; i < count; i++) {
+        bench(sizes[i].width, sizes[i].height, frames, i == count - 1 ? save_path : NULL);
+    }
+    sw_raster_shutdown();
+
+    for (int i = 0; i < SW_SPRITE_COUNT; i++) {
+        SDL_FreeSurface(surfaces[i]);
+    }
+    IMG_Quit();
+    return 0;
+}
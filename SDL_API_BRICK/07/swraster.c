@@ -0,0 +1,299 @@
+#include "swraster.h"
+#include "sim.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SW_USE_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define SW_USE_SSE2 1
+#endif
+
+#define SW_MAX_BLITS 80     // Background, bricks, paddle, ball and HUD digits
+#define SW_MAX_WIDTH 4096   // Column lookup lives on the stack
+#define FONT_CELLS 4        // font.png is a 4x4 grid
+#define DIGIT_WIDTH 20      // HUD digit size and spacing, as in claude/07
+#define DIGIT_HEIGHT 30
+#define DIGIT_ADVANCE 25
+
+const char* const sw_sprite_paths[SW_SPRITE_COUNT] = {
+    "sprites/background.png",
+    "sprites/brick-red.png",
+    "sprites/brick-blue.png",
+    "sprites/brick-yellow.png",
+    "sprites/paddle.png",
+    "sprites/ball.png",
+    "sprites/font.png"
+};
+
+// One sprite copy: a source rectangle stretched over a playfield
+// rectangle, and the target pixels whose centres it covers
+typedef struct {
+    const SwImage* image;
+    int src_x, src_y, src_w, src_h;
+    int x, y, w, h;             // Playfield coordinates
+    int x0, y0, x1, y1;         // Target pixels, end exclusive
+} SwBlit;
+
+static SwBlit blits[SW_MAX_BLITS];
+static int blit_count = 0;
+static SwTarget* job_target = NULL;
+static int job_tiles = 0;
+static atomic_int next_tile;
+
+static pthread_t workers[SW_MAX_THREADS];
+static int worker_count = 0;    // Besides the thread that calls draw
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t work_ready = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t work_done = PTHREAD_COND_INITIALIZER;
+static unsigned job_generation = 0;
+static int workers_busy = 0;
+static bool stopping = false;
+
+SwImage sw_image_init(int width, int height, int stride, const uint32_t* pixels) {
+    SwImage image = {width, height, stride, pixels, true};
+    for (int y = 0; y < height && image.opaque; y++) {
+        for (int x = 0; x < width; x++) {
+            if ((pixels[y * stride + x] >> 24) != 0xFF) {
+                image.opaque = false;
+                break;
+            }
+        }
+    }
+    return image;
+}
+
+static int64_t floor_div(int64_t a, int64_t b) {
+    int64_t q = a / b;
+    return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
+
+// First target pixel whose centre is at or right of playfield coordinate
+// pos, for a target of size pixels over a playfield of extent
+static int first_covered(int pos, int size, int extent) {
+    // (2i + 1) * extent >= 2 * pos * size
+    return (int)-floor_div(-((int64_t)2 * pos * size - extent), (int64_t)2 * extent);
+}
+
+// Source texel under target pixel i's centre
+static int sample(int i, int pos, int length, int size, int extent, int src_length) {
+    int64_t offset = (int64_t)(2 * i + 1) * extent - (int64_t)2 * pos * size;
+    int texel = (int)(offset * src_length / ((int64_t)2 * size * length));
+    return texel < src_length ? texel : src_length - 1;
+}
+
+static void add_blit(const SwImage* image, int src_x, int src_y, int src_w, int src_h,
+                     int x, int y, int w, int h, const SwTarget* target) {
+    if (blit_count == SW_MAX_BLITS || image->pixels == NULL) return;
+
+    SwBlit* blit = &blits[blit_count];
+    *blit = (SwBlit){image, src_x, src_y, src_w, src_h, x, y, w, h,
+                     first_covered(x, target->width, SCREEN_WIDTH),
+                     first_covered(y, target->height, SCREEN_HEIGHT),
+                     first_covered(x + w, target->width, SCREEN_WIDTH),
+                     first_covered(y + h, target->height, SCREEN_HEIGHT)};
+    if (blit->x0 < 0) blit->x0 = 0;
+    if (blit->y0 < 0) blit->y0 = 0;
+    if (blit->x1 > target->width) blit->x1 = target->width;
+    if (blit->y1 > target->height) blit->y1 = target->height;
+    if (blit->x0 < blit->x1 && blit->y0 < blit->y1) {
+        blit_count++;
+    }
+}
+
+static void add_image(const SwImage* image, int x, int y, int w, int h, const SwTarget* target) {
+    add_blit(image, 0, 0, image->width, image->height, x, y, w, h, target);
+}
+
+static void add_digit(const SwImage* font, int digit, int x, int y, const SwTarget* target) {
+    int cell_w = font->width / FONT_CELLS, cell_h = font->height / FONT_CELLS;
+    add_blit(font, (digit % FONT_CELLS) * cell_w, (digit / FONT_CELLS) * cell_h, cell_w, cell_h,
+             x, y, DIGIT_WIDTH, DIGIT_HEIGHT, target);
+}
+
+static void add_number(const SwImage* font, int value, int x, int y, const SwTarget* target) {
+    int digits = 1;
+    for (int rest = value / 10; rest > 0; rest /= 10) digits++;
+    for (int i = digits - 1; i >= 0; i--, value /= 10) {
+        add_digit(font, value % 10, x + i * DIGIT_ADVANCE, y, target);
+    }
+}
+
+// Alpha test: a texel is drawn when its alpha is at least 128, which is
+// its top bit, so an arithmetic shift by 31 makes the select mask
+static void blit_row(uint32_t* dst, const uint32_t* src_row, const int32_t* columns, int count, bool opaque) {
+    int i = 0;
+    if (opaque) {
+        for (; i < count; i++) {
+            dst[i] = src_row[columns[i]];
+        }
+        return;
+    }
+#if defined(SW_USE_NEON)
+    for (; i + 4 <= count; i += 4) {
+        uint32_t texels[4] = {src_row[columns[i]], src_row[columns[i + 1]],
+                              src_row[columns[i + 2]], src_row[columns[i + 3]]};
+        uint32x4_t s = vld1q_u32(texels);
+        uint32x4_t mask = vreinterpretq_u32_s32(vshrq_n_s32(vreinterpretq_s32_u32(s), 31));
+        vst1q_u32(dst + i, vbslq_u32(mask, s, vld1q_u32(dst + i)));
+    }
+#elif defined(SW_USE_SSE2)
+    for (; i + 4 <= count; i += 4) {
+        __m128i s = _mm_set_epi32((int)src_row[columns[i + 3]], (int)src_row[columns[i + 2]],
+                                  (int)src_row[columns[i + 1]], (int)src_row[columns[i]]);
+        __m128i mask = _mm_srai_epi32(s, 31);
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+        d = _mm_or_si128(_mm_and_si128(mask, s), _mm_andnot_si128(mask, d));
+        _mm_storeu_si128((__m128i*)(dst + i), d);
+    }
+#endif
+    for (; i < count; i++) {
+        uint32_t s = src_row[columns[i]];
+        if (s >> 31) {
+            dst[i] = s;
+        }
+    }
+}
+
+// Every blit, in order, clipped to target rows [top, bottom)
+static void draw_band(const SwTarget* target, int top, int bottom) {
+    int32_t columns[SW_MAX_WIDTH];
+    for (int b = 0; b < blit_count; b++) {
+        const SwBlit* blit = &blits[b];
+        int y0 = blit->y0 > top ? blit->y0 : top;
+        int y1 = blit->y1 < bottom ? blit->y1 : bottom;
+        if (y0 >= y1) continue;
+
+        int count = blit->x1 - blit->x0;
+        for (int i = 0; i < count; i++) {
+            columns[i] = blit->src_x + sample(blit->x0 + i, blit->x, blit->w, target->width,
+                                              SCREEN_WIDTH, blit->src_w);
+        }
+        for (int y = y0; y < y1; y++) {
+            int v = blit->src_y + sample(y, blit->y, blit->h, target->height, SCREEN_HEIGHT, blit->src_h);
+            blit_row(target->pixels + (size_t)y * target->stride + blit->x0,
+                     blit->image->pixels + (size_t)v * blit->image->stride,
+                     columns, count, blit->image->opaque);
+        }
+    }
+}
+
+static void run_tiles(void) {
+    int tile;
+    while ((tile = atomic_fetch_add(&next_tile, 1)) < job_tiles) {
+        int top = tile * SW_TILE_ROWS;
+        int bottom = top + SW_TILE_ROWS < job_target->height ? top + SW_TILE_ROWS : job_target->height;
+        draw_band(job_target, top, bottom);
+    }
+}
+
+static void* worker_main(void* data) {
+    (void)data;
+    unsigned seen = 0;
+    pthread_mutex_lock(&pool_lock);
+    while (true) {
+        while (job_generation == seen && !stopping) {
+            pthread_cond_wait(&work_ready, &pool_lock);
+        }
+        if (stopping) break;
+        seen = job_generation;
+        pthread_mutex_unlock(&pool_lock);
+
+        run_tiles();
+
+        pthread_mutex_lock(&pool_lock);
+        if (--workers_busy == 0) {
+            pthread_cond_signal(&work_done);
+        }
+    }
+    pthread_mutex_unlock(&pool_lock);
+    return NULL;
+}
+
+bool sw_raster_init(int threads) {
+    if (threads <= 0) {
+        threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if (threads > SW_MAX_THREADS) threads = SW_MAX_THREADS;
+
+    stopping = false;
+    for (worker_count = 0; worker_count < threads - 1; worker_count++) {
+        if (pthread_create(&workers[worker_count], NULL, worker_main, NULL) != 0) {
+            break;
+        }
+    }
+    return worker_count == threads - 1;
+}
+
+int sw_raster_threads(void) {
+    return worker_count + 1;
+}
+
+void sw_raster_shutdown(void) {
+    pthread_mutex_lock(&pool_lock);
+    stopping = true;
+    pthread_cond_broadcast(&work_ready);
+    pthread_mutex_unlock(&pool_lock);
+    for (int i = 0; i < worker_count; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    worker_count = 0;
+}
+
+void sw_raster_draw(const SwImage sprites[SW_SPRITE_COUNT], const SwScene* scene, SwTarget* target) {
+    if (target->width > SW_MAX_WIDTH) return;
+
+    // The draw list is built once; each band then walks all of it
+    blit_count = 0;
+    add_image(&sprites[SW_SPRITE_BACKGROUND], 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, target);
+    for (int row = 0; row < BRICK_ROWS; row++) {
+        const SwImage* brick = &sprites[SW_SPRITE_BRICK_RED + sim_brick_type(row)];
+        for (int col = 0; col < BRICK_COLS; col++) {
+            if (scene->brick_mask & ((uint64_t)1 << (row * BRICK_COLS + col))) {
+                add_image(brick, sim_brick_x(col), sim_brick_y(row), BRICK_WIDTH, BRICK_HEIGHT, target);
+            }
+        }
+    }
+    add_image(&sprites[SW_SPRITE_PADDLE], scene->paddle_x, PADDLE_Y, PADDLE_WIDTH, PADDLE_HEIGHT, target);
+    add_image(&sprites[SW_SPRITE_BALL], scene->ball_x, scene->ball_y, BALL_SIZE, BALL_SIZE, target);
+    if (scene->hud) {
+        add_number(&sprites[SW_SPRITE_FONT], scene->score, 10, 5, target);
+        add_number(&sprites[SW_SPRITE_FONT], scene->lives, SCREEN_WIDTH - 10 - DIGIT_WIDTH, 5, target);
+    }
+
+    job_target = target;
+    job_tiles = (target->height + SW_TILE_ROWS - 1) / SW_TILE_ROWS;
+    atomic_store(&next_tile, 0);
+    if (worker_count == 0 || job_tiles < 2) {
+        run_tiles();
+        return;
+    }
+
+    pthread_mutex_lock(&pool_lock);
+    workers_busy = worker_count;
+    job_generation++;
+    pthread_cond_broadcast(&work_ready);
+    pthread_mutex_unlock(&pool_lock);
+
+    run_tiles();
+
+    pthread_mutex_lock(&pool_lock);
+    while (workers_busy > 0) {
+        pthread_cond_wait(&work_done, &pool_lock);
+    }
+    pthread_mutex_unlock(&pool_lock);
+}
+
+void sw_raster_to_gray(const SwTarget* target, uint8_t* out) {
+    for (int y = 0; y < target->height; y++) {
+        const uint32_t* row = target->pixels + (size_t)y * target->stride;
+        uint8_t* gray = out + (size_t)y * target->width;
+        for (int x = 0; x < target->width; x++) {
+            uint32_t p = row[x];
+            gray[x] = (uint8_t)((((p >> 16) & 0xFF) * 77 + ((p >> 8) & 0xFF) * 150 + (p & 0xFF) * 29) >> 8);
+        }
+    }
+}
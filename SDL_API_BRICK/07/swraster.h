@@ -0,0 +1,70 @@
+#ifndef SWRASTER_H
+#define SWRASTER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// CPU rasterizer for headless observations and for --swraster, where the
+// playing scene skips the GPU. It draws the game's own sprites at any
+// resolution, mapping the 640x480 playfield onto the target and sampling
+// nearest texel centres the way GL_NEAREST does. Sprites are alpha tested
+// at 128 rather than blended, so soft edges can differ from the renderer
+// by a pixel's worth; --capture plus frame_diff with a tolerance compares
+// the two. Row blits run four pixels at a time with NEON or SSE2, and the
+// target is split into bands of SW_TILE_ROWS rows that a pool of threads
+// draws in parallel. Nothing here touches SDL or GL.
+
+#define SW_TILE_ROWS 16
+#define SW_MAX_THREADS 16
+
+// Pixels are 0xAARRGGBB, the layout of SDL_PIXELFORMAT_ARGB8888
+typedef struct {
+    int width, height;
+    int stride;             // Pixels from one row to the next
+    const uint32_t* pixels;
+    bool opaque;            // Set by sw_image_init; opaque images skip the alpha test
+} SwImage;
+
+typedef struct {
+    int width, height;
+    int stride;
+    uint32_t* pixels;
+} SwTarget;
+
+typedef enum {
+    SW_SPRITE_BACKGROUND,
+    SW_SPRITE_BRICK_RED,
+    SW_SPRITE_BRICK_BLUE,
+    SW_SPRITE_BRICK_YELLOW,
+    SW_SPRITE_PADDLE,
+    SW_SPRITE_BALL,
+    SW_SPRITE_FONT,         // 4x4 grid of digit cells, 0 to 9 row by row
+    SW_SPRITE_COUNT
+} SwSprite;
+
+extern const char* const sw_sprite_paths[SW_SPRITE_COUNT];
+
+// What one frame shows, filled from a SimState or a render snapshot
+typedef struct {
+    uint64_t brick_mask;
+    int paddle_x;
+    int ball_x, ball_y;
+    int score;
+    int lives;
+    bool hud;               // Score and lives in font.png digits
+} SwScene;
+
+SwImage sw_image_init(int width, int height, int stride, const uint32_t* pixels);
+
+// Starts the tile workers; 0 threads means one per core. Drawing works
+// without this, on the calling thread alone.
+bool sw_raster_init(int threads);
+int sw_raster_threads(void);
+void sw_raster_shutdown(void);
+
+void sw_raster_draw(const SwImage sprites[SW_SPRITE_COUNT], const SwScene* scene, SwTarget* target);
+
+// Luma of every pixel into width * height bytes, for 8-bit observations
+void sw_raster_to_gray(const SwTarget* target, uint8_t* out);
+
+#endif // SWRASTER_H
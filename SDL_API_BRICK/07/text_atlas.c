@@ -0,0 +1,63 @@
+#include "text_atlas.h"
+#include <stdio.h>
+#include <string.h>
+
+bool text_atlas_create(TextAtlas* atlas, SDL_Renderer* renderer, TTF_Font* font, SDL_Color color) {
+    memset(atlas, 0, sizeof(*atlas));
+
+    // Render every glyph once and pack them into a single row
+    SDL_Surface* rendered[TEXT_ATLAS_GLYPHS];
+    int width = 0;
+    atlas->line_height = TTF_FontHeight(font);
+    for (int i = 0; i < TEXT_ATLAS_GLYPHS; i++) {
+        rendered[i] = TTF_RenderGlyph_Blended(font, TEXT_ATLAS_FIRST + i, color);
+        if (rendered[i] != NULL) {
+            width += rendered[i]->w;
+        }
+    }
+
+    SDL_Surface* sheet = SDL_CreateRGBSurfaceWithFormat(0, width > 0 ? width : 1, atlas->line_height, 32,
+                                                        SDL_PIXELFORMAT_RGBA32);
+    int x = 0;
+    for (int i = 0; i < TEXT_ATLAS_GLYPHS; i++) {
+        if (rendered[i] == NULL) {
+            continue;
+        }
+        atlas->glyphs[i] = (SDL_Rect){x, 0, rendered[i]->w, rendered[i]->h};
+        if (sheet != NULL) {
+            // Copy alpha as is instead of blending onto the empty sheet
+            SDL_SetSurfaceBlendMode(rendered[i], SDL_BLENDMODE_NONE);
+            SDL_BlitSurface(rendered[i], NULL, sheet, &atlas->glyphs[i]);
+        }
+        x += rendered[i]->w;
+        SDL_FreeSurface(rendered[i]);
+    }
+
+    if (sheet == NULL) {
+        printf("SDL_CreateRGBSurfaceWithFormat Error: %s\n", SDL_GetError());
+        return false;
+    }
+
+    atlas->texture = SDL_CreateTextureFromSurface(renderer, sheet);
+    SDL_FreeSurface(sheet);
+    if (atlas->texture == NULL) {
+        printf("CreateTextureFromSurface Error for the text atlas: %s\n", SDL_GetError());
+        return false;
+    }
+    SDL_SetTextureBlendMode(atlas->texture, SDL_BLENDMODE_BLEND);
+    return true;
+}
+
+const SDL_Rect* text_atlas_glyph(const TextAtlas* atlas, char c) {
+    if (c < TEXT_ATLAS_FIRST || c > TEXT_ATLAS_LAST) {
+        return NULL;
+    }
+    return &atlas->glyphs[c - TEXT_ATLAS_FIRST];
+}
+
+void text_atlas_destroy(TextAtlas* atlas) {
+    if (atlas->texture != NULL) {
+        SDL_DestroyTexture(atlas->texture);
+        atlas->texture = NULL;
+    }
+}
@@ -0,0 +1,26 @@
+#ifndef TEXT_ATLAS_H
+#define TEXT_ATLAS_H
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include <stdbool.h>
+
+// Printable ASCII rendered once into a single texture, so text that
+// changes every frame (HUD numbers, the overlay) is just SDL_RenderCopy
+// calls from fixed source rects, with no surfaces or textures created.
+
+#define TEXT_ATLAS_FIRST 32
+#define TEXT_ATLAS_LAST 126
+#define TEXT_ATLAS_GLYPHS (TEXT_ATLAS_LAST - TEXT_ATLAS_FIRST + 1)
+
+typedef struct {
+    SDL_Texture* texture;
+    SDL_Rect glyphs[TEXT_ATLAS_GLYPHS];  // Width doubles as the advance
+    int line_height;
+} TextAtlas;
+
+bool text_atlas_create(TextAtlas* atlas, SDL_Renderer* renderer, TTF_Font* font, SDL_Color color);
+const SDL_Rect* text_atlas_glyph(const TextAtlas* atlas, char c);  // NULL if not in the atlas
+void text_atlas_destroy(TextAtlas* atlas);
+
+#endif // TEXT_ATLAS_H
@@ -0,0 +1,163 @@
+#include "trace.h"
+#include <string.h>
+
+#ifdef TRACE_ENABLED
+
+typedef struct {
+    const char* name;
+    Uint64 start;
+    Uint64 end;
+    char detail[TRACE_DETAIL_SIZE];
+} TraceEvent;
+
+// One per thread, so recording needs no locks. Full buffers drop events.
+typedef struct {
+    const char* thread_name;
+    int count;
+    int dropped;
+    TraceEvent events[TRACE_EVENTS_PER_THREAD];
+} TraceBuffer;
+
+static TraceBuffer buffers[TRACE_MAX_THREADS];
+static SDL_atomic_t buffers_claimed;
+static __thread TraceBuffer* thread_buffer = NULL;
+static __thread bool thread_out_of_buffers = false;
+
+static bool trace_enabled = false;
+static const char* trace_path = NULL;
+static Uint64 trace_origin = 0;
+static Uint64 trace_frequency = 1;
+
+bool trace_init(const char* path) {
+    trace_path = path;
+    trace_frequency = SDL_GetPerformanceFrequency();
+    trace_origin = SDL_GetPerformanceCounter();
+    trace_enabled = true;
+    trace_thread_name("main");
+    return true;
+}
+
+// Claims a buffer the first time a thread records anything
+static TraceBuffer* get_thread_buffer(void) {
+    if (thread_buffer == NULL && !thread_out_of_buffers) {
+        int index = SDL_AtomicAdd(&buffers_claimed, 1);
+        if (index < TRACE_MAX_THREADS) {
+            thread_buffer = &buffers[index];
+        } else {
+            thread_out_of_buffers = true;
+        }
+    }
+    return thread_buffer;
+}
+
+void trace_thread_name(const char* name) {
+    if (!trace_enabled) return;
+
+    TraceBuffer* buffer = get_thread_buffer();
+    if (buffer != NULL) {
+        buffer->thread_name = name;
+    }
+}
+
+TraceZone trace_zone_begin(const char* name, const char* detail) {
+    TraceZone zone;
+    zone.name = NULL;
+    if (trace_enabled) {
+        zone.name = name;
+        // The detail is often a stack buffer that's gone by the time the
+        // trace is written, so it's copied rather than pointed to
+        SDL_strlcpy(zone.detail, detail != NULL ? detail : "", sizeof(zone.detail));
+        zone.start = SDL_GetPerformanceCounter();
+    }
+    return zone;
+}
+
+void trace_zone_end(TraceZone* zone) {
+    if (zone->name == NULL) return;
+
+    Uint64 end = SDL_GetPerformanceCounter();
+    TraceBuffer* buffer = get_thread_buffer();
+    if (buffer == NULL) return;
+
+    if (buffer->count >= TRACE_EVENTS_PER_THREAD) {
+        buffer->dropped++;
+        return;
+    }
+    TraceEvent* event = &buffer->events[buffer->count++];
+    event->name = zone->name;
+    event->start = zone->start;
+    event->end = end;
+    memcpy(event->detail, zone->detail, sizeof(event->detail));
+}
+
+static double to_microseconds(Uint64 ticks) {
+    return (double)ticks * 1000000.0 / trace_frequency;
+}
+
+static void write_json_string(FILE* file, const char* text) {
+    fputc('"', file);
+    for (const char* c = text; *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\') {
+            fputc('\\', file);
+        }
+        fputc(*c, file);
+    }
+    fputc('"', file);
+}
+
+// Call once every traced thread has finished
+void trace_shutdown(void) {
+    if (!trace_enabled) return;
+    trace_enabled = false;
+
+    FILE* file = fopen(trace_path, "w");
+    if (file == NULL) {
+        printf("Failed to open %s for the trace\n", trace_path);
+        return;
+    }
+
+    int threads = SDL_AtomicGet(&buffers_claimed);
+    if (threads > TRACE_MAX_THREADS) threads = TRACE_MAX_THREADS;
+
+    int total = 0;
+    bool first = true;
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    for (int tid = 0; tid < threads; tid++) {
+        const TraceBuffer* buffer = &buffers[tid];
+
+        if (buffer->thread_name != NULL) {
+            fprintf(file, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":",
+                    first ? "" : ",", tid);
+            write_json_string(file, buffer->thread_name);
+            fprintf(file, "}}");
+            first = false;
+        }
+
+        for (int i = 0; i < buffer->count; i++) {
+            const TraceEvent* event = &buffer->events[i];
+            fprintf(file, "%s\n{\"name\":", first ? "" : ",");
+            write_json_string(file, event->name);
+            fprintf(file, ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f",
+                    tid, to_microseconds(event->start - trace_origin),
+                    to_microseconds(event->end - event->start));
+            if (event->detail[0] != '\0') {
+                fprintf(file, ",\"args\":{\"detail\":");
+                write_json_string(file, event->detail);
+                fprintf(file, "}");
+            }
+            fprintf(file, "}");
+            first = false;
+        }
+
+        total += buffer->count;
+        if (buffer->dropped > 0) {
+            printf("Trace buffer for thread %d was full, dropped %d events\n", tid, buffer->dropped);
+        }
+    }
+    fprintf(file, "\n]}\n");
+    fclose(file);
+
+    printf("Wrote %d trace events to %s\n", total, trace_path);
+}
+
+#endif // TRACE_ENABLED
@@ -0,0 +1,349 @@
+#include "versus.h"
+#include <SDL2/SDL.h>
+#include <stdio.h>
+#include <string.h>
+
+#define PACKET_MAGIC 0x53564B42u    // "BKVS"
+#define PACKET_HEADER 49           // Twelve words and the input count
+
+_Static_assert((VERSUS_HISTORY & (VERSUS_HISTORY - 1)) == 0, "VERSUS_HISTORY indexes by mask");
+_Static_assert(PACKET_HEADER + VERSUS_PACKET_INPUTS <= NET_LINK_MAX_PACKET, "packet fits the link");
+
+#define SLOT(frame) ((frame) & (VERSUS_HISTORY - 1))
+
+// Packets are little-endian whatever the host
+static void put_u32(uint8_t** at, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        *(*at)++ = (uint8_t)(value >> (8 * i));
+    }
+}
+
+static uint32_t get_u32(const uint8_t** at) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++) {
+        value |= (uint32_t)*(*at)++ << (8 * i);
+    }
+    return value;
+}
+
+bool versus_open(VersusSession* session, int local_port, const char* peer,
+                 const NetConditions* conditions, uint32_t nonce) {
+    memset(session, 0, sizeof(*session));
+    session->nonce = nonce;
+    session->rollback_from = UINT32_MAX;
+    return net_link_open(&session->link, local_port, peer, conditions);
+}
+
+void versus_close(VersusSession* session) {
+    net_link_close(&session->link);
+}
+
+void versus_request_match(VersusSession* session) {
+    if (session->phase == VERSUS_WAITING || session->phase == VERSUS_PLAYING) return;
+    session->wanted_match = session->match + 1;
+    session->phase = VERSUS_WAITING;
+    printf("versus: waiting for the other player\n");
+}
+
+uint32_t versus_hash(const VersusState* state) {
+    return sim_hash(&state->boards[0]) * 16777619u ^ sim_hash(&state->boards[1]);
+}
+
+static void start_match(VersusSession* session, uint32_t now_ms) {
+    session->match = session->wanted_match;
+    session->local = session->nonce < session->remote_nonce ? 0 : 1;
+
+    // Both ends work this out alike from the two nonces
+    uint32_t seed = (session->nonce ^ session->remote_nonce) + session->match * 0x9E3779B9u;
+    for (int board = 0; board < 2; board++) {
+        sim_init(&session->current.boards[board], seed);
+        sim_reset(&session->current.boards[board]);
+    }
+
+    session->frame = 0;
+    session->remote_next = 0;
+    session->remote_acked = 0;
+    session->rollback_from = UINT32_MAX;
+    session->checked = 0;
+    session->remote_frame = 0;
+    session->remote_advantage = 0;
+    session->since_sync_stall = 0;
+    session->remote_confirmed = 0;
+    session->remote_hash = 0;
+    session->last_heard_ms = now_ms;
+    memset(session->local_inputs, 0, sizeof(session->local_inputs));
+    memset(session->remote_inputs, 0, sizeof(session->remote_inputs));
+    session->phase = VERSUS_PLAYING;
+    session->result = VERSUS_RESULT_NONE;
+    printf("versus: match %u, playing as player %d\n", session->match, session->local + 1);
+}
+
+static void send_packet(VersusSession* session, uint32_t now_ms) {
+    uint8_t packet[NET_LINK_MAX_PACKET];
+    uint8_t* at = packet;
+
+    // Every local input the peer hasn't confirmed, as far as fits. This
+    // goes on after a match too, while waiting for the next, so the peer
+    // can confirm the last frames and see the end for itself.
+    uint32_t known = session->frame + VERSUS_INPUT_DELAY;
+    uint32_t first = session->remote_acked;
+    if (known - first > VERSUS_PACKET_INPUTS) {
+        first = known - VERSUS_PACKET_INPUTS;
+    }
+    uint32_t confirmed = session->frame < session->remote_next ? session->frame : session->remote_next;
+    const VersusState* confirmed_state = confirmed == session->frame ? &session->current
+                                                                     : &session->states[SLOT(confirmed)];
+
+    put_u32(&at, PACKET_MAGIC);
+    put_u32(&at, session->nonce);
+    put_u32(&at, session->wanted_match);
+    put_u32(&at, session->match);
+    put_u32(&at, session->frame);
+    put_u32(&at, (uint32_t)(int32_t)(session->frame - session->remote_frame));
+    put_u32(&at, session->remote_next);
+    put_u32(&at, now_ms);
+    put_u32(&at, session->echo_stamp);
+    put_u32(&at, confirmed);
+    put_u32(&at, versus_hash(confirmed_state));
+    put_u32(&at, first);
+    *at++ = (uint8_t)(known - first);
+    for (uint32_t frame = first; frame < known; frame++) {
+        *at++ = session->local_inputs[SLOT(frame)];
+    }
+    net_link_send(&session->link, packet, (int)(at - packet), now_ms);
+}
+
+static void receive_packet(VersusSession* session, const uint8_t* packet, int size, uint32_t now_ms) {
+    if (size < PACKET_HEADER) return;
+    const uint8_t* at = packet;
+    if (get_u32(&at) != PACKET_MAGIC) return;
+
+    uint32_t nonce = get_u32(&at);
+    uint32_t wanted = get_u32(&at);
+    uint32_t match = get_u32(&at);
+    uint32_t frame = get_u32(&at);
+    int32_t advantage = (int32_t)get_u32(&at);
+    uint32_t acked = get_u32(&at);
+    uint32_t stamp = get_u32(&at);
+    uint32_t echo = get_u32(&at);
+    uint32_t confirmed = get_u32(&at);
+    uint32_t hash = get_u32(&at);
+    uint32_t first = get_u32(&at);
+    int count = *at++;
+    if (count > size - PACKET_HEADER) return;
+
+    // Matching nonces would make both ends the same player; both pick again
+    if (nonce == session->nonce) {
+        session->nonce = session->nonce * 2654435761u + 1;
+        return;
+    }
+    session->remote_nonce = nonce;
+    session->remote_wanted = wanted;
+    session->last_heard_ms = now_ms;
+    session->echo_stamp = stamp;
+    if (echo != 0) {
+        session->stats.rtt_ms = now_ms - echo;
+    }
+
+    if (session->phase == VERSUS_WAITING && session->remote_wanted == session->wanted_match) {
+        start_match(session, now_ms);
+    }
+    if (session->phase == VERSUS_IDLE || session->phase == VERSUS_WAITING || match != session->match) {
+        return;
+    }
+
+    if ((int32_t)(acked - session->remote_acked) > 0) {
+        session->remote_acked = acked;
+    }
+    if ((int32_t)(frame - session->remote_frame) > 0) {
+        session->remote_frame = frame;
+        session->remote_advantage = advantage;
+    }
+    if ((int32_t)(confirmed - session->remote_confirmed) > 0) {
+        session->remote_confirmed = confirmed;
+        session->remote_hash = hash;
+    }
+
+    // Inputs are taken in order; anything past a gap comes again in a
+    // later packet. The history only reaches so far ahead.
+    for (int i = 0; i < count; i++) {
+        uint32_t input_frame = first + (uint32_t)i;
+        if (input_frame != session->remote_next) continue;
+        if (input_frame >= session->frame + VERSUS_HISTORY / 2) break;
+
+        uint8_t input = at[i];
+        session->remote_inputs[SLOT(input_frame)] = input;
+        if (input_frame < session->frame && input != session->used_remote[SLOT(input_frame)] &&
+            input_frame < session->rollback_from) {
+            session->rollback_from = input_frame;
+        }
+        session->remote_next++;
+    }
+}
+
+// Steps both boards through frame with its local input and the remote
+// one, real or predicted; returns the local board's events
+static uint32_t run_frame(VersusSession* session, uint32_t frame) {
+    uint8_t remote;
+    if (frame < session->remote_next) {
+        remote = session->remote_inputs[SLOT(frame)];
+    } else {
+        remote = session->remote_next > 0 ? session->remote_inputs[SLOT(session->remote_next - 1)] : 0;
+    }
+    session->used_remote[SLOT(frame)] = remote;
+    session->states[SLOT(frame)] = session->current;
+
+    uint32_t events = sim_advance(&session->current.boards[session->local], session->local_inputs[SLOT(frame)]);
+    sim_advance(&session->current.boards[1 - session->local], remote);
+    return events;
+}
+
+static void roll_back(VersusSession* session) {
+    uint32_t from = session->rollback_from;
+    session->rollback_from = UINT32_MAX;
+    if (from >= session->frame) return;
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    session->current = session->states[SLOT(from)];
+    for (uint32_t frame = from; frame < session->frame; frame++) {
+        run_frame(session, frame);
+    }
+    double ms = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+
+    uint32_t depth = session->frame - from;
+    VersusStats* stats = &session->stats;
+    stats->rollbacks++;
+    stats->resim_frames += depth;
+    stats->resim_ms_total += ms;
+    if (ms > stats->resim_ms_max) stats->resim_ms_max = ms;
+    if (depth > stats->max_depth) stats->max_depth = depth;
+    stats->depth_counts[depth <= VERSUS_MAX_ROLLBACK ? depth : VERSUS_MAX_ROLLBACK]++;
+}
+
+static bool board_over(const SimState* board) {
+    return board->state != GAME_STATE_PLAYING;
+}
+
+static void finish(VersusSession* session, const VersusState* state) {
+    const SimState* mine = &state->boards[session->local];
+    const SimState* theirs = &state->boards[1 - session->local];
+
+    // A cleared board wins outright; else the one still going does, and
+    // if both went out together the higher score
+    if (mine->state == GAME_STATE_WIN_SCREEN && theirs->state != GAME_STATE_WIN_SCREEN) {
+        session->result = VERSUS_RESULT_WON;
+    } else if (theirs->state == GAME_STATE_WIN_SCREEN && mine->state != GAME_STATE_WIN_SCREEN) {
+        session->result = VERSUS_RESULT_LOST;
+    } else if (board_over(mine) != board_over(theirs)) {
+        session->result = board_over(mine) ? VERSUS_RESULT_LOST : VERSUS_RESULT_WON;
+    } else if (mine->score != theirs->score) {
+        session->result = mine->score > theirs->score ? VERSUS_RESULT_WON : VERSUS_RESULT_LOST;
+    } else {
+        session->result = VERSUS_RESULT_DRAW;
+    }
+
+    session->final = *state;
+    session->phase = VERSUS_OVER;
+    static const char* names[] = {"", "won", "lost", "drew"};
+    printf("versus: match %u %s, %d to %d\n", session->match, names[session->result],
+           mine->score, theirs->score);
+    versus_report(session);
+}
+
+// Confirmed frames only ever move forward, so the first one with a board
+// over is the same on both machines
+static void check_confirmed(VersusSession* session) {
+    uint32_t confirmed = session->frame < session->remote_next ? session->frame : session->remote_next;
+    for (uint32_t frame = session->checked + 1; frame <= confirmed; frame++) {
+        const VersusState* state = frame == session->frame ? &session->current : &session->states[SLOT(frame)];
+        if (board_over(&state->boards[0]) || board_over(&state->boards[1])) {
+            finish(session, state);
+            return;
+        }
+    }
+    if (confirmed > session->checked) {
+        session->checked = confirmed;
+    }
+
+    // The peer's hash is for a frame it has confirmed; check it once it's
+    // confirmed here too and still in the history
+    uint32_t theirs = session->remote_confirmed;
+    if (session->remote_hash != 0 && theirs <= confirmed && confirmed - theirs < VERSUS_HISTORY / 2) {
+        const VersusState* state = theirs == session->frame ? &session->current : &session->states[SLOT(theirs)];
+        if (versus_hash(state) != session->remote_hash) {
+            if (session->stats.desyncs++ == 0) {
+                printf("versus: desync at frame %u\n", theirs);
+            }
+        }
+        session->remote_hash = 0;
+    }
+}
+
+uint32_t versus_step(VersusSession* session, uint32_t input, uint32_t now_ms) {
+    uint8_t packet[NET_LINK_MAX_PACKET];
+    int size;
+    while ((size = net_link_receive(&session->link, packet, sizeof(packet), now_ms)) > 0) {
+        receive_packet(session, packet, size, now_ms);
+    }
+
+    uint32_t events = 0;
+    if (session->phase == VERSUS_PLAYING) {
+        roll_back(session);
+        check_confirmed(session);
+    }
+    if (session->phase == VERSUS_PLAYING && now_ms - session->last_heard_ms > VERSUS_TIMEOUT_MS) {
+        printf("versus: the other player went quiet\n");
+        session->result = VERSUS_RESULT_WON;
+        session->final = session->current;
+        session->phase = VERSUS_OVER;
+    }
+
+    if (session->phase == VERSUS_PLAYING) {
+        // Each side's advantage is how far it runs ahead of what it has
+        // heard; half the difference is how far ahead this side really is
+        int32_t advantage = (int32_t)(session->frame - session->remote_frame);
+        session->since_sync_stall++;
+        if ((int32_t)(session->frame - session->remote_next) >= VERSUS_MAX_ROLLBACK) {
+            session->stats.input_stalls++;
+        } else if ((advantage - session->remote_advantage) / 2 >= 1 &&
+                   session->since_sync_stall >= VERSUS_SYNC_INTERVAL) {
+            session->stats.sync_stalls++;
+            session->since_sync_stall = 0;
+        } else {
+            session->local_inputs[SLOT(session->frame + VERSUS_INPUT_DELAY)] = (uint8_t)input;
+            events = run_frame(session, session->frame);
+            session->frame++;
+            session->stats.frames++;
+        }
+    }
+
+    send_packet(session, now_ms);
+    return events;
+}
+
+void versus_boards(const VersusSession* session, SimState* local, SimState* rival) {
+    const VersusState* state = session->phase == VERSUS_OVER ? &session->final : &session->current;
+    *local = state->boards[session->local];
+    *rival = state->boards[1 - session->local];
+    if (session->phase == VERSUS_OVER) {
+        local->state = session->result == VERSUS_RESULT_WON ? GAME_STATE_WIN_SCREEN : GAME_STATE_GAME_OVER;
+    }
+}
+
+void versus_report(const VersusSession* session) {
+    const VersusStats* stats = &session->stats;
+    uint32_t frames = stats->frames > 0 ? stats->frames : 1;
+    uint32_t rollbacks = stats->rollbacks > 0 ? stats->rollbacks : 1;
+    printf("versus: %u frames, %u rollbacks, depth mean %.2f max %u, resim %.2f us/frame mean %.1f us max\n",
+           stats->frames, stats->rollbacks, (double)stats->resim_frames / rollbacks, stats->max_depth,
+           stats->resim_ms_total * 1000.0 / frames, stats->resim_ms_max * 1000.0);
+    printf("versus: rollbacks by depth");
+    for (int depth = 1; depth <= VERSUS_MAX_ROLLBACK; depth++) {
+        printf(" %d:%u", depth, stats->depth_counts[depth]);
+    }
+    printf("\n");
+    printf("versus: stalls %u for input, %u for sync; rtt %u ms; %u desyncs; "
+           "packets %u sent, %u received, %u dropped\n",
+           stats->input_stalls, stats->sync_stalls, stats->rtt_ms, stats->desyncs,
+           session->link.sent, session->link.received, session->link.dropped);
+}
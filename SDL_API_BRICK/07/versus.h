@@ -0,0 +1,120 @@
+#ifndef VERSUS_H
+#define VERSUS_H
+
+#include "net_link.h"
+#include "sim.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Two-player versus over the network (--versus). Each player has a board
+// of their own. Both machines simulate both boards from the same seed, so
+// only paddle inputs cross the wire. Every packet carries every local
+// input the peer hasn't acknowledged yet, which covers lost packets
+// without resends.
+//
+// Local input is applied VERSUS_INPUT_DELAY frames after it's read. The
+// remote input isn't waited for. Until it arrives it's predicted to stay
+// what it last was. Each frame both boards are snapshotted (a memcpy of
+// two SimStates) before they step. When a real remote input turns out to
+// differ from the prediction, the session goes back to the snapshot of
+// that frame and runs forward again with the right inputs. Running more
+// than VERSUS_MAX_ROLLBACK frames ahead of the remote input stalls
+// instead, as does getting a frame ahead of the peer's clock.
+//
+// The match ends on the first fully confirmed frame where either board is
+// over, so both machines agree on the result. Confirmed frames are hashed
+// and compared between the two as a desync check.
+
+#define VERSUS_INPUT_DELAY 1
+#define VERSUS_MAX_ROLLBACK 8
+#define VERSUS_HISTORY 64           // Power of two, well past the rollback window
+#define VERSUS_PACKET_INPUTS 32
+#define VERSUS_TIMEOUT_MS 5000      // Silence that ends a match in play
+#define VERSUS_SYNC_INTERVAL 10     // Frames between time-sync stalls
+
+typedef struct {
+    SimState boards[2];     // Player 0, player 1
+} VersusState;
+
+typedef enum {
+    VERSUS_IDLE,            // No match asked for yet
+    VERSUS_WAITING,         // Asked; waiting for the peer to ask too
+    VERSUS_PLAYING,
+    VERSUS_OVER
+} VersusPhase;
+
+typedef enum {
+    VERSUS_RESULT_NONE,
+    VERSUS_RESULT_WON,
+    VERSUS_RESULT_LOST,
+    VERSUS_RESULT_DRAW
+} VersusResult;
+
+typedef struct {
+    uint32_t frames;        // Frames simulated forward
+    uint32_t rollbacks;
+    uint32_t resim_frames;  // Frames simulated again by rollbacks
+    uint32_t max_depth;
+    uint32_t depth_counts[VERSUS_MAX_ROLLBACK + 1];  // Rollbacks by depth
+    double resim_ms_total;
+    double resim_ms_max;    // Worst single frame's rollback
+    uint32_t input_stalls;  // Frames held waiting for remote input
+    uint32_t sync_stalls;   // Frames held to let the peer catch up
+    uint32_t desyncs;
+    uint32_t rtt_ms;
+} VersusStats;
+
+typedef struct {
+    NetLink link;
+    VersusPhase phase;
+    VersusResult result;
+    int local;                  // Board index of this machine's player
+    uint32_t nonce, remote_nonce;
+    uint32_t match, wanted_match, remote_wanted;
+
+    uint32_t frame;             // Next frame to simulate
+    uint32_t remote_next;       // Remote inputs known for every frame before this
+    uint32_t remote_acked;      // The peer has every local input before this
+    uint32_t rollback_from;     // Earliest mispredicted frame, or UINT32_MAX
+    uint32_t checked;           // Confirmed frames checked for the match end
+    VersusState current;        // State at the start of frame
+    VersusState final;          // Where the match ended
+    VersusState states[VERSUS_HISTORY];   // By frame: state at its start
+    uint8_t local_inputs[VERSUS_HISTORY];
+    uint8_t remote_inputs[VERSUS_HISTORY];
+    uint8_t used_remote[VERSUS_HISTORY];  // What each frame was run with
+
+    uint32_t remote_frame;      // Peer's frame in its newest packet
+    int32_t remote_advantage;   // Its frames ahead of our inputs then
+    uint32_t since_sync_stall;
+    uint32_t remote_confirmed, remote_hash;  // Peer's last confirmed hash
+    uint32_t last_heard_ms;
+    uint32_t echo_stamp;        // Peer's clock, sent back for the RTT
+
+    VersusStats stats;
+} VersusSession;
+
+// Opens the link; nonce should differ between the two machines. The lower
+// nonce plays board 0.
+bool versus_open(VersusSession* session, int local_port, const char* peer,
+                 const NetConditions* conditions, uint32_t nonce);
+void versus_close(VersusSession* session);
+
+// Asks for the next match; it starts once the peer asks for it too
+void versus_request_match(VersusSession* session);
+
+// One fixed tick: network, rollback, then a frame forward unless stalled.
+// input is INPUT_* bits. Returns the SIM_EVENT_* bits of the local board's
+// forward step, for sound.
+uint32_t versus_step(VersusSession* session, uint32_t input, uint32_t now_ms);
+
+// The boards to draw. After the match the local one carries the result as
+// its win or game-over state.
+void versus_boards(const VersusSession* session, SimState* local, SimState* rival);
+
+// Hash of both boards, as compared for the desync check
+uint32_t versus_hash(const VersusState* state);
+
+void versus_report(const VersusSession* session);
+
+#endif // VERSUS_H
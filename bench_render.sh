@@ -0,0 +1,54 @@
+#!/bin/bash
+# Cross-backend render benchmark: runs the same --bench-render scene in
+# the SDL_Renderer build (SDL_API_BRICK/07), the legacy GL build
+# (claude/07) and the GLES2 build (GPT/Bit08-4), and prints their
+# "render_bench" rows side by side, grouped by brick count.
+#
+# Usage: ./bench_render.sh [-H] [frames]
+#   -H      pass --headless to every build (offscreen video driver)
+#   frames  measured frames per scene size (default: the game's own)
+#
+# Builds that haven't been compiled are skipped. Timings are in ms; the
+# submit column is CPU time spent issuing draws, frame is present to
+# present, and draws is the mean draw calls per frame.
+
+extra=()
+if [ "$1" = "-H" ]; then
+    extra+=(--headless)
+    shift
+fi
+frames=$1
+
+builds=(
+    "SDL_API_BRICK/07 ./brickout"
+    "claude/07 ./breakout"
+    "GPT/Bit08-4 ./brickout"
+)
+
+rows=$(mktemp)
+trap 'rm -f "$rows"' EXIT
+
+for build in "${builds[@]}"; do
+    read -r dir exe <<< "$build"
+    if [ ! -x "$dir/$exe" ]; then
+        echo "Skipping $dir: $exe isn't built" >&2
+        continue
+    fi
+    echo "Running $dir" >&2
+    (cd "$dir" && "$exe" --bench-render $frames "${extra[@]}" 2> /dev/null) |
+        awk '$1 == "render_bench" && $2 != "backend"' >> "$rows"
+done
+
+if [ ! -s "$rows" ]; then
+    echo "No build produced any results" >&2
+    exit 1
+fi
+
+printf "%-14s %6s %5s %6s %10s %10s %10s %10s %8s %7s\n" "backend" "bricks" "balls" "frames" \
+    "submit_ms" "submit_p95" "frame_ms" "frame_p95" "fps" "draws"
+sort -s -n -k3,3 "$rows" | awk '
+{
+    if (NR > 1 && $3 != last) print ""
+    last = $3
+    printf "%-14s %6s %5s %6s %10s %10s %10s %10s %8s %7s\n", $2, $3, $4, $5, $6, $7, $8, $9, $10, $11
+}'
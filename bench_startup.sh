@@ -0,0 +1,107 @@
+#!/bin/bash
+# Time-to-first-frame benchmark for the builds that take --bench-startup
+# (SDL_API_BRICK/07, claude/07, GPT/Bit08-4).
+#
+# Usage: ./bench_startup.sh [-n runs] <build dir> <executable> [args...]
+#   e.g. ./bench_startup.sh -n 20 SDL_API_BRICK/07 ./brickout
+#
+# Each round starts the game once with a cold page cache and once warm,
+# collects the "startup_bench <stage> <ms>" lines it prints, and adds a
+# "process" stage timed from outside (exec, dynamic linking and teardown
+# included). The report has the median, variance and standard deviation
+# of every stage in ms. Dropping the page cache needs root (or sudo
+# without a password); without it only the warm runs are reported.
+
+runs=10
+if [ "$1" = "-n" ]; then
+    runs=$2
+    shift 2
+fi
+if [ $# -lt 2 ]; then
+    echo "Usage: $0 [-n runs] <build dir> <executable> [args...]" >&2
+    exit 1
+fi
+build_dir=$1
+shift
+
+drop_caches() {
+    sync
+    if [ -w /proc/sys/vm/drop_caches ]; then
+        echo 3 > /proc/sys/vm/drop_caches
+    else
+        sudo -n sh -c 'echo 3 > /proc/sys/vm/drop_caches' 2> /dev/null
+    fi
+}
+
+cold=1
+if ! drop_caches; then
+    echo "Can't drop the page cache, only measuring warm starts" >&2
+    cold=0
+fi
+
+samples=$(mktemp)
+trap 'rm -f "$samples"' EXIT
+
+run_once() {
+    local mode=$1
+    local start end output
+    shift
+    start=$(date +%s%N)
+    output=$(cd "$build_dir" && "$@" --bench-startup 2> /dev/null)
+    end=$(date +%s%N)
+    if ! grep -q "^startup_bench first_present " <<< "$output"; then
+        echo "$mode run never reached the first present" >&2
+        return
+    fi
+    grep "^startup_bench " <<< "$output" | awk -v mode="$mode" '{ print mode, $2, $3 }' >> "$samples"
+    awk -v mode="$mode" -v ns=$((end - start)) 'BEGIN { printf "%s process %.3f\n", mode, ns / 1000000 }' >> "$samples"
+}
+
+# Unmeasured run, so the first warm run really is warm
+(cd "$build_dir" && "$@" --bench-startup > /dev/null 2>&1)
+
+for ((i = 1; i <= runs; i++)); do
+    if [ $cold -eq 1 ]; then
+        drop_caches
+        run_once cold "$@"
+    fi
+    run_once warm "$@"
+done
+
+# Stages keep the order the game reached them in
+awk '
+{
+    key = $1 " " $2
+    if (!(key in count)) {
+        order[++keys] = key
+    }
+    values[key, ++count[key]] = $3
+}
+END {
+    printf "%-6s %-34s %5s %10s %12s %10s\n", "mode", "stage", "runs", "median", "variance", "stddev"
+    for (k = 1; k <= keys; k++) {
+        key = order[k]
+        n = count[key]
+        sum = 0
+        for (i = 1; i <= n; i++) {
+            sorted[i] = values[key, i]
+            sum += sorted[i]
+        }
+        for (i = 2; i <= n; i++) {
+            v = sorted[i]
+            for (j = i - 1; j >= 1 && sorted[j] > v; j--) {
+                sorted[j + 1] = sorted[j]
+            }
+            sorted[j + 1] = v
+        }
+        median = n % 2 ? sorted[(n + 1) / 2] : (sorted[n / 2] + sorted[n / 2 + 1]) / 2
+        mean = sum / n
+        variance = 0
+        for (i = 1; i <= n; i++) {
+            variance += (sorted[i] - mean) ^ 2
+        }
+        variance = n > 1 ? variance / (n - 1) : 0
+        split(key, parts, " ")
+        printf "%-6s %-34s %5d %10.3f %12.3f %10.3f\n", parts[1], parts[2], n, median, variance, sqrt(variance)
+    }
+}' <(grep "^cold " "$samples") <(grep "^warm " "$samples")
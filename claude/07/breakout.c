@@ -8,32 +8,73 @@
 #include <stdio.h>
 #include <time.h>
 #include <stdlib.h>
-
-#define WINDOW_WIDTH 800
-#define WINDOW_HEIGHT 480
-#define BRICK_WIDTH 80
-#define BRICK_HEIGHT 20
-#define NUM_BRICK_COLUMNS 10
-#define NUM_BRICK_ROWS 5
-#define PADDLE_WIDTH 100
-#define PADDLE_HEIGHT 20
-#define BALL_SIZE 15
-#define BALL_SPEED 5.0f
-#define INITIAL_LIVES 3
-
+#include <string.h>
+#include "profiler.h"
+#include "trace.h"
+#include "glstate.h"
+#include "startup.h"
+#include "renderbench.h"
+#include "dynres.h"
+#include "sim.h"
+#include "snapshotring.h"
+#include "handoff.h"
+#include "savestate.h"
+#include "capture.h"
+
+#define IDLE_REDRAW_MS 1000      // Keepalive present on a static screen
+#define FRAME_MS 16              // Render pacing when vsync doesn't block
+#define SIM_MAX_LAG_STEPS 5      // Resync instead of catching up past this
+#define SIM_IDLE_MS 250          // Simulation wakeup check when not playing
+#define PRESENT_REPORT_MS 60000  // Presented-frame counter interval
+#define OVERLAY_HISTORY 120      // Frames in the overlay's frame-time graph
+#define OVERLAY_MAX_RECTS (OVERLAY_HISTORY + 32)
+#define OVERLAY_MAX_DIGITS 64
+
+#define INPUT_REWIND 4  // Not a simAdvance input; steps the history back instead
+
+// Everything the main thread needs to draw a frame. The simulation fills
+// one in after every step and hands it over through a triple buffer.
+typedef struct {
+    Screen screen;
+    int paddleX;
+    int ballX, ballY;      // Centre, whole pixels
+    Uint64 brickMask;
+    int score;
+    int lives;
+    int countdownSeconds;  // 0 once the ball is in play
+} RenderSnapshot;
+
+typedef enum {
+    SIM_CMD_START
+} SimCommand;
+
+// Sounds the simulation asks the main thread to play
+typedef enum {
+    SOUND_PADDLE_HIT,
+    SOUND_BRICK_HIT,
+    SOUND_GAME_OVER,
+    SOUND_GAME_WON
+} SoundId;
+
+// The overlay is drawn as two batches, untextured quads then digits, so
+// its quads are collected first
 typedef struct {
     float x, y;
     float width, height;
-    bool active;
-    GLuint texture;
-} GameObject;
+    float r, g, b, a;
+} OverlayRect;
 
 typedef struct {
+    int digit;
     float x, y;
-    float dx, dy;
-    float size;
-    GLuint texture;
-} Ball;
+} OverlayDigit;
+
+typedef struct {
+    OverlayRect rects[OVERLAY_MAX_RECTS];
+    OverlayDigit digits[OVERLAY_MAX_DIGITS];
+    int rectCount;
+    int digitCount;
+} OverlayBatch;
 
 // Global variables
 SDL_Window* window = NULL;
@@ -43,19 +84,47 @@ GLuint gameOverTexture;
 GLuint winTexture;
 GLuint fontTexture;
 GLuint startScreenTexture;
-GameObject paddle;
-GameObject bricks[NUM_BRICK_ROWS][NUM_BRICK_COLUMNS];
-Ball ball;
+GLuint paddleTexture;
+GLuint ballTexture;
+GLuint brickTexture;
 bool gameRunning = true;
-int lives;
-bool gameOver = false;
-bool gameWon = false;
-bool gameStarted = false;
-int score = 0;
-int consecutiveHits = 0;
-Uint32 countdownStartTime = 0;
-const int COUNTDOWN_DURATION = 3000; // 3 seconds in milliseconds
-bool firstGame = true;
+
+// Simulation/render handoff. sim belongs to the simulation thread; the
+// main thread polls input, plays sounds and does all the GL work from
+// snapshots.
+SimState sim;
+RenderSnapshot snapshotSlots[3];
+TripleBuffer snapshots;
+SpscQueue simCommands;         // Main thread -> simulation
+SpscQueue simSounds;           // Simulation -> main thread, SoundId each
+SDL_atomic_t inputState;       // INPUT_LEFT | INPUT_RIGHT | INPUT_REWIND
+SDL_atomic_t simRunning;
+SDL_Thread* simThread = NULL;
+SDL_sem* simWakeup = NULL;     // Posted when the main thread wants a step
+Uint32 simEventType = (Uint32)-1;  // Pushed when the screen changes
+bool threaded = true;
+const char* resumePath = NULL;  // --resume: save on exit, load at boot
+
+// Idle mode: static screens are presented once, then the loop blocks in
+// SDL_WaitEventTimeout until an event arrives or a redraw is due
+bool idleMode = true;
+int presentedScreen = -1;
+Uint32 lastPresentTime = 0;
+int presentedFrames = 0;
+Uint32 presentReportTime = 0;
+
+// Profiler timestamps for the render side of the current frame
+Uint64 renderStartCounter = 0;
+Uint64 lastPresentCounter = 0;
+
+// Performance overlay, toggled with F1. The font atlas only has digits,
+// so each row is keyed by a colour swatch instead of a label.
+bool overlayVisible = false;
+float overlayFrameTimes[OVERLAY_HISTORY];
+int overlayFrameHead = 0;
+int frameDrawCalls = 0;      // Game draws so far this frame
+int shownDrawCalls = 0;      // Totals of the previous frame
+int shownTextureBinds = 0;
 
 // Audio variables
 Mix_Music *backgroundMusic = NULL;
@@ -68,23 +137,31 @@ Mix_Chunk *gameWonSound = NULL;
 bool initSDL(void);
 void cleanup(void);
 GLuint loadTexture(const char* filename);
-void handleInput(void);
-void updateGame(void);
-void renderGame(void);
-void initializeGame(void);
-bool checkCollision(GameObject* obj, float x, float y, float size);
+void handleInput(const RenderSnapshot* view);
+void simStep(void);
+void publishSnapshot(void);
+int simThreadMain(void* data);
+bool resumeGame(const char* path);
+void suspendGame(const char* path);
+void playSimSounds(void);
+void renderGame(const RenderSnapshot* view);
 void renderTexturedQuad(float x, float y, float width, float height, GLuint texture);
-float randomFloat(float min, float max);
-void renderScore(void);
+void renderScore(int score);
 void drawDigit(int digit, float x, float y, float width, float height);
-bool allBricksBroken(void);
+void emitDigitQuad(int digit, float x, float y, float width, float height);
+void overlayRect(OverlayBatch* batch, float x, float y, float width, float height,
+                 float r, float g, float b, float a);
+void overlayNumber(OverlayBatch* batch, float value, int decimals, float x, float y);
+void renderOverlay(void);
+void overlayFrameEnd(int drawCalls, int textureBinds);
 void renderCountdown(int remainingTime);
-
-float randomFloat(float min, float max) {
-    return min + (rand() / (float)RAND_MAX) * (max - min);
-}
+void waitWhileIdle(const RenderSnapshot* view);
+void presentFrame(Screen screen);
+void reportPresentedFrames(void);
+void renderBenchFrame(void);
 
 GLuint loadTexture(const char* filename) {
+    TRACE_ZONE_DETAIL("loadTexture", filename);
     printf("Loading texture: %s\n", filename);
 
     SDL_Surface* surface = IMG_Load(filename);
@@ -96,7 +173,7 @@ GLuint loadTexture(const char* filename) {
 
     GLuint textureID;
     glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_2D, textureID);
+    glStateBindTexture(GL_TEXTURE_2D, textureID);
 
     int mode = GL_RGB;
     if (surface->format->BytesPerPixel == 4) {
@@ -114,6 +191,7 @@ GLuint loadTexture(const char* filename) {
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
     SDL_FreeSurface(surface);
+    startupBenchMark(filename);
     return textureID;
 }
 
@@ -125,6 +203,7 @@ bool initSDL(void) {
         return false;
     }
     printf("SDL initialized successfully\n");
+    startupBenchMark("SDL_Init");
 
     int imgFlags = IMG_INIT_PNG;
     if (!(IMG_Init(imgFlags) & imgFlags)) {
@@ -132,6 +211,7 @@ bool initSDL(void) {
         return false;
     }
     printf("SDL_image initialized successfully\n");
+    startupBenchMark("IMG_Init");
 
     // Initialize SDL_mixer with OGG support
     if (Mix_Init(MIX_INIT_OGG) != MIX_INIT_OGG) {
@@ -144,6 +224,7 @@ bool initSDL(void) {
         return false;
     }
     printf("SDL_mixer initialized successfully with OGG support\n");
+    startupBenchMark("Mix_OpenAudio");
 
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 2);
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 1);
@@ -159,6 +240,8 @@ bool initSDL(void) {
         return false;
     }
 
+    startupBenchMark("SDL_CreateWindow");
+
     glContext = SDL_GL_CreateContext(window);
     if (!glContext) {
         printf("OpenGL context creation failed: %s\n", SDL_GetError());
@@ -175,61 +258,16 @@ bool initSDL(void) {
     glEnable(GL_TEXTURE_2D);
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    startupBenchMark("SDL_GL_CreateContext");
 
     return true;
 }
 
-void initializeGame(void) {
-    printf("Initializing game objects...\n");
-
-    // Initialize random seed
-    srand(time(NULL));
-
-    // Initialize lives and score
-    lives = INITIAL_LIVES;
-    score = 0;
-    consecutiveHits = 0;
-    gameOver = false;
-    gameWon = false;
-
-    if (firstGame) {
-        gameStarted = false;
-    } else {
-        gameStarted = true;
-        countdownStartTime = SDL_GetTicks();
-    }
-
-    // Initialize paddle
-    paddle.x = WINDOW_WIDTH / 2 - PADDLE_WIDTH / 2;
-    paddle.y = WINDOW_HEIGHT - 40;
-    paddle.width = PADDLE_WIDTH;
-    paddle.height = PADDLE_HEIGHT;
-
-    // Initialize ball position but don't set velocity yet
-    ball.x = WINDOW_WIDTH / 2;
-    ball.y = WINDOW_HEIGHT / 2;
-    ball.dx = 0;
-    ball.dy = 0;
-    ball.size = BALL_SIZE;
-
-    // Initialize bricks
-    for (int row = 0; row < NUM_BRICK_ROWS; row++) {
-        for (int col = 0; col < NUM_BRICK_COLUMNS; col++) {
-            bricks[row][col].x = col * BRICK_WIDTH;
-            bricks[row][col].y = row * BRICK_HEIGHT + 50;
-            bricks[row][col].width = BRICK_WIDTH;
-            bricks[row][col].height = BRICK_HEIGHT;
-            bricks[row][col].active = true;
-        }
-    }
-
-    printf("Game initialization complete.\n");
-}
-
 void renderTexturedQuad(float x, float y, float width, float height, GLuint texture) {
-    glBindTexture(GL_TEXTURE_2D, texture);
+    frameDrawCalls++;
+    glStateBindTexture(GL_TEXTURE_2D, texture);
     glBegin(GL_QUADS);
-    glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+    glStateColor4f(1.0f, 1.0f, 1.0f, 1.0f);
     glTexCoord2f(0, 0); glVertex2f(x, y);
     glTexCoord2f(1, 0); glVertex2f(x + width, y);
     glTexCoord2f(1, 1); glVertex2f(x + width, y + height);
@@ -237,14 +275,8 @@ void renderTexturedQuad(float x, float y, float width, float height, GLuint text
     glEnd();
 }
 
-bool checkCollision(GameObject* obj, float x, float y, float size) {
-    return (x + size > obj->x &&
-            x - size < obj->x + obj->width &&
-            y + size > obj->y &&
-            y - size < obj->y + obj->height);
-}
-
-void handleInput(void) {
+void handleInput(const RenderSnapshot* view) {
+    Uint64 inputStart = profilerNow();
     SDL_Event event;
     while (SDL_PollEvent(&event)) {
         if (event.type == SDL_QUIT) {
@@ -255,196 +287,201 @@ void handleInput(void) {
                 case SDLK_ESCAPE:
                     gameRunning = false;
                     break;
+                case SDLK_F1:
+                    if (!event.key.repeat) {
+                        overlayVisible = !overlayVisible;
+                    }
+                    break;
                 case SDLK_SPACE:
-                    if (!gameStarted) {
-                        gameStarted = true;
-                        countdownStartTime = SDL_GetTicks();
-                        printf("Game started. Countdown begins.\n");
-                    } else if (gameOver || gameWon) {
-                        firstGame = false;
-                        initializeGame();
-                        printf("Game restarted.\n");
+                    if (view->screen != SCREEN_PLAYING && !event.key.repeat) {
+                        printf(view->screen == SCREEN_START ? "Game started. Countdown begins.\n"
+                                                           : "Game restarted.\n");
+                        spscPush(&simCommands, SIM_CMD_START);
+                        if (simWakeup != NULL) {
+                            SDL_SemPost(simWakeup);
+                        }
                     }
                     break;
             }
         }
     }
 
-    if (gameStarted && !gameOver && !gameWon) {
-        const Uint8* keyState = SDL_GetKeyboardState(NULL);
-        float paddleSpeed = 7.0f;
-
-        if (keyState[SDL_SCANCODE_LEFT] || keyState[SDL_SCANCODE_A]) {
-            paddle.x -= paddleSpeed;
-            if (paddle.x < 0) paddle.x = 0;
-        }
-        if (keyState[SDL_SCANCODE_RIGHT] || keyState[SDL_SCANCODE_D]) {
-            paddle.x += paddleSpeed;
-            if (paddle.x > WINDOW_WIDTH - paddle.width) {
-                paddle.x = WINDOW_WIDTH - paddle.width;
-            }
-        }
+    // Held keys are sampled by the simulation once per step. Backspace
+    // runs the game backwards through the rewind history for as long as
+    // it's held.
+    const Uint8* keyState = captureActive() ? captureKeyboardState() : SDL_GetKeyboardState(NULL);
+    int input = 0;
+    if (keyState[SDL_SCANCODE_LEFT] || keyState[SDL_SCANCODE_A]) {
+        input |= INPUT_LEFT;
     }
-}
-
-bool allBricksBroken() {
-    for (int row = 0; row < NUM_BRICK_ROWS; row++) {
-        for (int col = 0; col < NUM_BRICK_COLUMNS; col++) {
-            if (bricks[row][col].active) {
-                return false;
-            }
-        }
+    if (keyState[SDL_SCANCODE_RIGHT] || keyState[SDL_SCANCODE_D]) {
+        input |= INPUT_RIGHT;
     }
-    return true;
-}
-
-void updateGame(void) {
-    if (!gameStarted || gameOver || gameWon) {
-        return;
+    if (keyState[SDL_SCANCODE_BACKSPACE]) {
+        input |= INPUT_REWIND;
     }
-
-    Uint32 currentTime = SDL_GetTicks();
-    if (currentTime - countdownStartTime < COUNTDOWN_DURATION) {
-        // Countdown is still going, don't update ball position
-        printf("Countdown: %d\n", (COUNTDOWN_DURATION - (currentTime - countdownStartTime)) / 1000 + 1);
-        return;
+    if (SDL_AtomicSet(&inputState, input) != input && simWakeup != NULL) {
+        // Rewinding from a menu needs a simulation that isn't asleep
+        SDL_SemPost(simWakeup);
     }
+    profilerRecord(PROF_INPUT, inputStart);
+}
 
-    // If this is the first update after countdown, initialize ball velocity
-    if (ball.dx == 0 && ball.dy == 0) {
-        ball.dx = randomFloat(-BALL_SPEED, BALL_SPEED);
-        ball.dy = -BALL_SPEED;
-        // Ensure the ball is not moving too slowly horizontally
-        if (fabs(ball.dx) < BALL_SPEED / 2) {
-            ball.dx = (ball.dx > 0) ? BALL_SPEED / 2 : -BALL_SPEED / 2;
+// One fixed step. Runs on the simulation thread, or inline in the main
+// loop with --single-thread. With rewind held the step goes back through
+// the history instead of forward.
+void simStep(void) {
+    int screenBefore = sim.screen;
+
+    Uint8 command;
+    while (spscPop(&simCommands, &command)) {
+        if (command == SIM_CMD_START && sim.screen != SCREEN_PLAYING) {
+            simStart(&sim);
+            snapshotRingReset(&sim);
         }
-        printf("Ball velocity initialized: dx=%f, dy=%f\n", ball.dx, ball.dy);
     }
 
-    // Update ball position
-    ball.x += ball.dx;
-    ball.y += ball.dy;
-    printf("Ball position: x=%f, y=%f\n", ball.x, ball.y);
+    Uint32 input = (Uint32)SDL_AtomicGet(&inputState);
+    if (input & INPUT_REWIND) {
+        snapshotRingStepBack(&sim);
+    } else if (sim.screen == SCREEN_PLAYING) {
+        // simAdvance's two halves, called apart so movement and collision
+        // are timed as phases of their own
+        Uint64 updateStart = profilerNow();
+        Uint32 events;
+        {
+            TRACE_ZONE("simMove");
+            events = simMove(&sim, input & (INPUT_LEFT | INPUT_RIGHT));
+        }
+        profilerRecord(PROF_UPDATE, updateStart);
 
-    // Ball collision with walls
-    if (ball.x - ball.size < 0) {
-        ball.x = ball.size;
-        ball.dx = fabs(ball.dx);
-    }
-    if (ball.x + ball.size > WINDOW_WIDTH) {
-        ball.x = WINDOW_WIDTH - ball.size;
-        ball.dx = -fabs(ball.dx);
-    }
-    if (ball.y - ball.size < 0) {
-        ball.y = ball.size;
-        ball.dy = fabs(ball.dy);
-    }
+        Uint64 collisionStart = profilerNow();
+        {
+            TRACE_ZONE("collision");
+            events |= simCollide(&sim);
+        }
+        profilerRecord(PROF_COLLISION, collisionStart);
+        snapshotRingRecord(&sim);
 
-    // Ball out of bounds (bottom)
-    if (ball.y + ball.size > WINDOW_HEIGHT) {
-        lives--;
-        printf("Life lost. Remaining lives: %d\n", lives);
-        if (lives <= 0) {
-            gameOver = true;
+        if (events & SIM_EVENT_LIFE_LOST) {
+            printf("Life lost. Remaining lives: %d\n", sim.lives);
+        }
+        if (events & SIM_EVENT_PADDLE_HIT) {
+            spscPush(&simSounds, SOUND_PADDLE_HIT);
+        }
+        if (events & SIM_EVENT_BRICK_HIT) {
+            spscPush(&simSounds, SOUND_BRICK_HIT);
+        }
+        if (events & SIM_EVENT_GAME_OVER) {
             printf("Game Over\n");
-            if (gameOverSound) {
-                Mix_PlayChannel(-1, gameOverSound, 0);
-            }
-        } else {
-            // Reset ball position with random x velocity
-            ball.x = WINDOW_WIDTH / 2;
-            ball.y = WINDOW_HEIGHT / 2;
-            ball.dx = randomFloat(-BALL_SPEED, BALL_SPEED);
-            ball.dy = -BALL_SPEED;
-
-            // Ensure the ball is not moving too slowly horizontally
-            if (fabs(ball.dx) < BALL_SPEED / 2) {
-                ball.dx = (ball.dx > 0) ? BALL_SPEED / 2 : -BALL_SPEED / 2;
-            }
-
-            // Reset paddle position
-            paddle.x = WINDOW_WIDTH / 2 - PADDLE_WIDTH / 2;
-            printf("Ball reset: dx=%f, dy=%f\n", ball.dx, ball.dy);
+            spscPush(&simSounds, SOUND_GAME_OVER);
+        }
+        if (events & SIM_EVENT_GAME_WON) {
+            printf("Game Won!\n");
+            spscPush(&simSounds, SOUND_GAME_WON);
         }
     }
 
-    // Ball collision with paddle
-    if (checkCollision(&paddle, ball.x, ball.y, ball.size)) {
-        // Calculate where on the paddle the ball hit
-        float relativeIntersectX = (paddle.x + (paddle.width / 2)) - ball.x;
-        float normalizedIntersect = relativeIntersectX / (paddle.width / 2);
-
-        // Calculate new angle (between -60 and 60 degrees)
-        float maxAngle = 60.0f * M_PI / 180.0f;
-        float angle = normalizedIntersect * maxAngle;
-
-        // Update ball velocity
-        float speed = sqrt(ball.dx * ball.dx + ball.dy * ball.dy);
-        ball.dx = speed * -sin(angle);
-        ball.dy = -fabs(speed * cos(angle));
-
-        // Move ball out of paddle to prevent multiple collisions
-        ball.y = paddle.y - ball.size;
-
-        // Reset consecutive hits when ball touches paddle
-        consecutiveHits = 0;
-        printf("Ball hit paddle. New velocity: dx=%f, dy=%f\n", ball.dx, ball.dy);
-
-        if (paddleHitSound) {
-            Mix_PlayChannel(-1, paddleHitSound, 0);
-        }
+    // Wake the main loop in case it's idling on a static screen
+    if (sim.screen != screenBefore && simEventType != (Uint32)-1) {
+        SDL_Event event;
+        memset(&event, 0, sizeof(event));
+        event.type = simEventType;
+        SDL_PushEvent(&event);
     }
+}
 
-    // Ball collision with bricks
-    bool hitBrick = false;
-    for (int row = 0; row < NUM_BRICK_ROWS; row++) {
-        for (int col = 0; col < NUM_BRICK_COLUMNS; col++) {
-            if (bricks[row][col].active &&
-                checkCollision(&bricks[row][col], ball.x, ball.y, ball.size)) {
-                bricks[row][col].active = false;
-                hitBrick = true;
+void publishSnapshot(void) {
+    RenderSnapshot* snap = tripleBufferWriteSlot(&snapshots);
+    snap->screen = (Screen)sim.screen;
+    snap->paddleX = sim.paddleX;
+    snap->ballX = simBallX(&sim);
+    snap->ballY = simBallY(&sim);
+    snap->brickMask = sim.brickMask;
+    snap->score = sim.score;
+    snap->lives = sim.lives;
+    snap->countdownSeconds = simCountdownSeconds(&sim);
+    tripleBufferPublish(&snapshots);
+}
 
-                // Update score
-                score += 10 + (consecutiveHits * 5);
-                consecutiveHits++;
-                printf("Brick hit. Score: %d, Consecutive hits: %d\n", score, consecutiveHits);
+// Loads a --resume save into the simulation. Only a game in play is
+// resumed, countdown and all; anything else boots to the start screen.
+bool resumeGame(const char* path) {
+    SimState saved;
+    if (!saveStateRead(path, &saved) || saved.screen != SCREEN_PLAYING) {
+        return false;
+    }
 
-                // Determine which side of the brick was hit
-                float brickCenterX = bricks[row][col].x + bricks[row][col].width / 2;
-                float brickCenterY = bricks[row][col].y + bricks[row][col].height / 2;
+    sim = saved;
+    snapshotRingReset(&sim);
+    startupBenchMark("resume");
+    printf("Resumed from %s: score %d, lives %d\n", path, sim.score, sim.lives);
+    return true;
+}
 
-                float dx = ball.x - brickCenterX;
-                float dy = ball.y - brickCenterY;
+// Called on the way out, once the simulation has stopped; SDL turns the
+// power switch's SIGTERM into SDL_QUIT, so that lands here too. A game in
+// play is saved; otherwise the old save goes, so the next boot doesn't
+// resume a finished game.
+void suspendGame(const char* path) {
+    if (sim.screen != SCREEN_PLAYING) {
+        remove(path);
+        return;
+    }
 
-                if (fabs(dx) * bricks[row][col].height > fabs(dy) * bricks[row][col].width) {
-                    ball.dx = -ball.dx;
-                } else {
-                    ball.dy = -ball.dy;
-                }
+    Uint64 start = SDL_GetPerformanceCounter();
+    if (saveStateWrite(path, &sim)) {
+        printf("Saved to %s in %.2f ms\n", path,
+               (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency());
+    }
+}
 
-                if (brickHitSound) {
-                    Mix_PlayChannel(-1, brickHitSound, 0);
-                }
+int simThreadMain(void* data) {
+    (void)data;
+    traceThreadName("simulation");
+    Uint64 freq = SDL_GetPerformanceFrequency();
+    Uint64 step = freq / SIM_HZ;
+    Uint64 next = SDL_GetPerformanceCounter();
+
+    while (SDL_AtomicGet(&simRunning)) {
+        simStep();
+        publishSnapshot();
+
+        // Nothing moves on the menus; sleep until a command is queued or
+        // rewind is held
+        if (sim.screen != SCREEN_PLAYING && !(SDL_AtomicGet(&inputState) & INPUT_REWIND)) {
+            SDL_SemWaitTimeout(simWakeup, SIM_IDLE_MS);
+            next = SDL_GetPerformanceCounter();
+            continue;
+        }
 
-                printf("Ball deflected. New velocity: dx=%f, dy=%f\n", ball.dx, ball.dy);
-                break;
-            }
+        // Sleep to the next tick on an absolute schedule, so a late wakeup
+        // shortens the following sleep instead of slowing the game down
+        next += step;
+        Uint64 now = SDL_GetPerformanceCounter();
+        if (now < next) {
+            SDL_Delay((Uint32)((next - now) * 1000 / freq));
+        } else if (now - next > step * SIM_MAX_LAG_STEPS) {
+            next = now;
         }
-        if (hitBrick) break;
     }
 
-    // Check for win condition
-    if (allBricksBroken()) {
-        gameWon = true;
-        printf("Game Won!\n");
-        if (gameWonSound) {
-            Mix_PlayChannel(-1, gameWonSound, 0);
+    return 0;
+}
+
+// SDL_mixer is only called from the main thread, so the simulation
+// queues its sounds and they play here once a frame
+void playSimSounds(void) {
+    Mix_Chunk* chunks[] = {paddleHitSound, brickHitSound, gameOverSound, gameWonSound};
+    Uint8 sound;
+    while (spscPop(&simSounds, &sound)) {
+        if (chunks[sound]) {
+            Mix_PlayChannel(-1, chunks[sound], 0);
         }
     }
 }
 
-
-void renderScore(void) {
+void renderScore(int score) {
     int tempScore = score;
     int digitCount = (tempScore == 0) ? 1 : log10(tempScore) + 1;
     float digitWidth = 20;
@@ -460,18 +497,131 @@ void renderScore(void) {
 }
 
 void drawDigit(int digit, float x, float y, float width, float height) {
+    frameDrawCalls++;
+    glStateBindTexture(GL_TEXTURE_2D, fontTexture);
+    glBegin(GL_QUADS);
+    emitDigitQuad(digit, x, y, width, height);
+    glEnd();
+}
+
+// Vertices of one digit from the 4x4 font atlas, inside glBegin(GL_QUADS)
+void emitDigitQuad(int digit, float x, float y, float width, float height) {
     float textureX = (digit % 4) * 0.25f;
     float textureY = (digit / 4) * 0.25f;
 
-    glBindTexture(GL_TEXTURE_2D, fontTexture);
-    glBegin(GL_QUADS);
     glTexCoord2f(textureX, textureY); glVertex2f(x, y);
     glTexCoord2f(textureX + 0.25f, textureY); glVertex2f(x + width, y);
     glTexCoord2f(textureX + 0.25f, textureY + 0.25f); glVertex2f(x + width, y + height);
     glTexCoord2f(textureX, textureY + 0.25f); glVertex2f(x, y + height);
+}
+
+void overlayRect(OverlayBatch* batch, float x, float y, float width, float height,
+                 float r, float g, float b, float a) {
+    if (batch->rectCount == OVERLAY_MAX_RECTS) return;
+    batch->rects[batch->rectCount++] = (OverlayRect){x, y, width, height, r, g, b, a};
+}
+
+// Queues a number as atlas digits, with a small square for the decimal point
+void overlayNumber(OverlayBatch* batch, float value, int decimals, float x, float y) {
+    char text[16];
+    snprintf(text, sizeof(text), "%.*f", decimals, value);
+    for (const char* c = text; *c != '\0'; c++) {
+        if (*c == '.') {
+            overlayRect(batch, x, y + 10, 2, 2, 1.0f, 1.0f, 1.0f, 1.0f);
+            x += 4;
+        } else if (*c >= '0' && *c <= '9' && batch->digitCount < OVERLAY_MAX_DIGITS) {
+            batch->digits[batch->digitCount++] = (OverlayDigit){*c - '0', x, y};
+            x += 9;
+        }
+    }
+}
+
+void renderOverlay(void) {
+    const float left = 10, top = 50, rowHeight = 14;
+    const float graphHeight = 60, pxPerMs = 2, budgetMs = 1000.0f / 60.0f;
+    OverlayBatch batch;
+    batch.rectCount = 0;
+    batch.digitCount = 0;
+
+    overlayRect(&batch, left, top, OVERLAY_HISTORY * 2 + 12, 5 * rowHeight + graphHeight + 18,
+                0.0f, 0.0f, 0.0f, 0.6f);
+
+    float frameTotal = 0;
+    int frameCount = 0;
+    for (int i = 0; i < OVERLAY_HISTORY; i++) {
+        if (overlayFrameTimes[i] > 0) {
+            frameTotal += overlayFrameTimes[i];
+            frameCount++;
+        }
+    }
+    float fps = frameTotal > 0 ? frameCount * 1000.0f / frameTotal : 0;
+    float latest = overlayFrameTimes[(overlayFrameHead + OVERLAY_HISTORY - 1) % OVERLAY_HISTORY];
+
+    // Swatches: green FPS, yellow frame ms, cyan sim ms, magenta render ms,
+    // white draw calls, orange texture binds
+    float x = left + 6, y = top + 6;
+    overlayRect(&batch, x, y + 2, 8, 8, 0.3f, 0.9f, 0.3f, 1.0f);
+    overlayNumber(&batch, fps, 1, x + 14, y);
+    y += rowHeight;
+    overlayRect(&batch, x, y + 2, 8, 8, 1.0f, 0.9f, 0.2f, 1.0f);
+    overlayNumber(&batch, latest, 2, x + 14, y);
+    y += rowHeight;
+    overlayRect(&batch, x, y + 2, 8, 8, 0.2f, 0.9f, 1.0f, 1.0f);
+    overlayNumber(&batch, profilerLastMs(PROF_UPDATE) + profilerLastMs(PROF_COLLISION), 2, x + 14, y);
+    y += rowHeight;
+    overlayRect(&batch, x, y + 2, 8, 8, 1.0f, 0.3f, 1.0f, 1.0f);
+    overlayNumber(&batch, profilerLastMs(PROF_RENDER), 2, x + 14, y);
+    y += rowHeight;
+    overlayRect(&batch, x, y + 2, 8, 8, 1.0f, 1.0f, 1.0f, 1.0f);
+    overlayNumber(&batch, shownDrawCalls, 0, x + 14, y);
+    overlayRect(&batch, x + 120, y + 2, 8, 8, 1.0f, 0.6f, 0.1f, 1.0f);
+    overlayNumber(&batch, shownTextureBinds, 0, x + 134, y);
+    y += rowHeight + 4;
+
+    // Frame-time graph, oldest on the left, red when over the 60 Hz budget
+    float graphBottom = y + graphHeight;
+    for (int i = 0; i < OVERLAY_HISTORY; i++) {
+        float ms = overlayFrameTimes[(overlayFrameHead + i) % OVERLAY_HISTORY];
+        float height = fminf(ms * pxPerMs, graphHeight);
+        if (height <= 0) continue;
+        bool slow = ms > budgetMs + 1.0f;
+        overlayRect(&batch, x + i * 2, graphBottom - height, 2, height,
+                    slow ? 0.9f : 0.3f, slow ? 0.25f : 0.85f, 0.25f, 1.0f);
+    }
+    overlayRect(&batch, x, graphBottom - budgetMs * pxPerMs, OVERLAY_HISTORY * 2, 1,
+                1.0f, 1.0f, 1.0f, 0.5f);
+
+    glDisable(GL_TEXTURE_2D);
+    glBegin(GL_QUADS);
+    for (int i = 0; i < batch.rectCount; i++) {
+        const OverlayRect* rect = &batch.rects[i];
+        glStateColor4f(rect->r, rect->g, rect->b, rect->a);
+        glVertex2f(rect->x, rect->y);
+        glVertex2f(rect->x + rect->width, rect->y);
+        glVertex2f(rect->x + rect->width, rect->y + rect->height);
+        glVertex2f(rect->x, rect->y + rect->height);
+    }
+    glEnd();
+    glEnable(GL_TEXTURE_2D);
+
+    glStateColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+    glStateBindTexture(GL_TEXTURE_2D, fontTexture);
+    glBegin(GL_QUADS);
+    for (int i = 0; i < batch.digitCount; i++) {
+        emitDigitQuad(batch.digits[i].digit, batch.digits[i].x, batch.digits[i].y, 8, 12);
+    }
     glEnd();
 }
 
+// Runs on every present, shown or not, so the graph is full when toggled on
+void overlayFrameEnd(int drawCalls, int textureBinds) {
+    overlayFrameTimes[overlayFrameHead] = profilerLastMs(PROF_FRAME);
+    overlayFrameHead = (overlayFrameHead + 1) % OVERLAY_HISTORY;
+    shownDrawCalls = drawCalls;
+    shownTextureBinds = textureBinds;
+    frameDrawCalls = 0;
+}
+
 void renderCountdown(int remainingTime) {
     char countdownText[2];
     snprintf(countdownText, sizeof(countdownText), "%d", remainingTime);
@@ -484,79 +634,148 @@ void renderCountdown(int remainingTime) {
     drawDigit(remainingTime, xPos, yPos, digitWidth, digitHeight);
 }
 
-void renderGame(void) {
+void waitWhileIdle(const RenderSnapshot* view) {
+    Screen screen = view->screen;
+    if (!idleMode || screen == SCREEN_PLAYING || (int)screen != presentedScreen) {
+        return;
+    }
+
+    // The start, game over and win screens don't animate, so there is
+    // nothing to draw until an event (input, expose) arrives
+    Uint32 sincePresent = SDL_GetTicks() - lastPresentTime;
+    if (sincePresent < IDLE_REDRAW_MS) {
+        SDL_WaitEventTimeout(NULL, IDLE_REDRAW_MS - sincePresent);
+    }
+}
+
+void presentFrame(Screen screen) {
+    profilerRecord(PROF_RENDER, renderStartCounter);
+
+    // After the render time and the game's counts are taken, so the
+    // overlay doesn't count itself
+    int gameDrawCalls = frameDrawCalls;
+    int gameTextureBinds = glStateCurrentFrame()->issued[GLSTATE_TEXTURE];
+    captureReadFrame();
+    if (overlayVisible) {
+        renderOverlay();
+    }
+
+    Uint64 presentStart = profilerNow();
+    {
+        TRACE_ZONE("present");
+        SDL_GL_SwapWindow(window);
+    }
+    profilerRecord(PROF_PRESENT, presentStart);
+
+    // --bench-startup stops at the first frame on screen
+    if (startupBenchEnabled()) {
+        startupBenchMark("first_present");
+        gameRunning = false;
+    }
+
+    // Frame time is present to present, so it includes idle waits
+    if (lastPresentCounter != 0) {
+        profilerRecord(PROF_FRAME, lastPresentCounter);
+    }
+    lastPresentCounter = profilerNow();
+    if (screen == SCREEN_PLAYING) {
+        // The governor sees the work of the frame, not pacing sleeps
+        dynResFrameEnd(profilerLastMs(PROF_RENDER) + profilerLastMs(PROF_PRESENT));
+    }
+    overlayFrameEnd(gameDrawCalls, gameTextureBinds);
+    glStateFrameEnd();
+
+    presentedScreen = screen;
+    lastPresentTime = SDL_GetTicks();
+    presentedFrames++;
+}
+
+void reportPresentedFrames(void) {
+    Uint32 now = SDL_GetTicks();
+    if (now - presentReportTime >= PRESENT_REPORT_MS) {
+        printf("Presented %d frames in the last minute (idle mode %s)\n",
+               presentedFrames, idleMode ? "on" : "off");
+        presentedFrames = 0;
+        presentReportTime = now;
+    }
+}
+
+void renderGame(const RenderSnapshot* view) {
+    TRACE_ZONE("renderGame");
+    renderStartCounter = profilerNow();
     glClear(GL_COLOR_BUFFER_BIT);
     glLoadIdentity();
 
-    if (!gameStarted && firstGame) {
+    Screen screen = view->screen;
+    if (screen == SCREEN_START) {
         // Render start screen only for the first game
         renderTexturedQuad(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT, startScreenTexture);
         printf("Rendering start screen\n");
-    } else if (!gameOver && !gameWon) {
+    } else if (screen == SCREEN_PLAYING) {
+        dynResBeginScene();
+
         // Render background
         renderTexturedQuad(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT, backgroundTexture);
 
         // Render bricks
         for (int row = 0; row < NUM_BRICK_ROWS; row++) {
             for (int col = 0; col < NUM_BRICK_COLUMNS; col++) {
-                if (bricks[row][col].active) {
-                    renderTexturedQuad(bricks[row][col].x, bricks[row][col].y,
-                                     bricks[row][col].width, bricks[row][col].height,
-                                     bricks[row][col].texture);
+                if ((view->brickMask >> (row * NUM_BRICK_COLUMNS + col)) & 1) {
+                    renderTexturedQuad(col * BRICK_WIDTH, row * BRICK_HEIGHT + BRICK_TOP,
+                                     BRICK_WIDTH, BRICK_HEIGHT, brickTexture);
                 }
             }
         }
 
         // Render paddle
-        renderTexturedQuad(paddle.x, paddle.y, paddle.width, paddle.height, paddle.texture);
+        renderTexturedQuad(view->paddleX, PADDLE_Y, PADDLE_WIDTH, PADDLE_HEIGHT, paddleTexture);
 
         // Render ball
-        renderTexturedQuad(ball.x - ball.size, ball.y - ball.size,
-                          ball.size * 2, ball.size * 2, ball.texture);
+        renderTexturedQuad(view->ballX - BALL_SIZE, view->ballY - BALL_SIZE,
+                          BALL_SIZE * 2, BALL_SIZE * 2, ballTexture);
+        dynResEndScene();
 
-        // Render remaining lives in top right corner
-        for (int i = 0; i < lives; i++) {
+        // The HUD goes on at native resolution. Render remaining lives in top right corner
+        for (int i = 0; i < view->lives; i++) {
             renderTexturedQuad(WINDOW_WIDTH - 40 - (i * 35), 10,
-                             BALL_SIZE * 2, BALL_SIZE * 2, ball.texture);
+                             BALL_SIZE * 2, BALL_SIZE * 2, ballTexture);
         }
 
         // Render score
-        renderScore();
+        renderScore(view->score);
 
         // Render countdown if necessary
-        Uint32 currentTime = SDL_GetTicks();
-        if (currentTime - countdownStartTime < COUNTDOWN_DURATION) {
-            int remainingTime = (COUNTDOWN_DURATION - (currentTime - countdownStartTime)) / 1000 + 1;
+        int remainingTime = view->countdownSeconds;
+        if (remainingTime > 0) {
             renderCountdown(remainingTime);
             printf("Rendering countdown: %d\n", remainingTime);
         }
-    } else if (gameOver) {
+    } else if (screen == SCREEN_GAME_OVER) {
         // Render game over screen
         renderTexturedQuad(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT, gameOverTexture);
         printf("Rendering game over screen\n");
-    } else if (gameWon) {
+    } else if (screen == SCREEN_WIN) {
         // Render win screen
         renderTexturedQuad(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT, winTexture);
-        renderScore();
+        renderScore(view->score);
         printf("Rendering win screen\n");
     }
 
-    SDL_GL_SwapWindow(window);
+    presentFrame(screen);
 }
 
 void cleanup(void) {
     printf("Cleaning up resources...\n");
 
-    glDeleteTextures(1, &backgroundTexture);
-    glDeleteTextures(1, &gameOverTexture);
-    glDeleteTextures(1, &winTexture);
-    glDeleteTextures(1, &fontTexture);
-    glDeleteTextures(1, &startScreenTexture);
-    glDeleteTextures(1, &paddle.texture);
-    glDeleteTextures(1, &ball.texture);
-    if (NUM_BRICK_ROWS > 0 && NUM_BRICK_COLUMNS > 0) {
-        glDeleteTextures(1, &bricks[0][0].texture);
-    }
+    dynResCleanup();
+    glStateDeleteTextures(1, &backgroundTexture);
+    glStateDeleteTextures(1, &gameOverTexture);
+    glStateDeleteTextures(1, &winTexture);
+    glStateDeleteTextures(1, &fontTexture);
+    glStateDeleteTextures(1, &startScreenTexture);
+    glStateDeleteTextures(1, &paddleTexture);
+    glStateDeleteTextures(1, &ballTexture);
+    glStateDeleteTextures(1, &brickTexture);
 
     // Clean up audio resources
     if (backgroundMusic) {
@@ -589,9 +808,103 @@ void cleanup(void) {
     printf("Cleanup complete\n");
 }
 
+// One --bench-render frame: the synthetic scene through the game's own
+// quad and present path
+void renderBenchFrame(void) {
+    SDL_Event event;
+    while (SDL_PollEvent(&event)) {
+        if (event.type == SDL_QUIT) {
+            gameRunning = false;
+        }
+    }
+
+    const RenderBenchScene* scene = renderBenchScene();
+    renderStartCounter = profilerNow();
+    glClear(GL_COLOR_BUFFER_BIT);
+    glLoadIdentity();
+    dynResBeginScene();
+    renderTexturedQuad(0, 0, RENDER_BENCH_AREA_WIDTH, RENDER_BENCH_AREA_HEIGHT, backgroundTexture);
+    for (int i = 0; i < scene->bricks; i++) {
+        BenchRect brick = renderBenchBrick(i);
+        renderTexturedQuad(brick.x, brick.y, brick.w, brick.h, brickTexture);
+    }
+    for (int i = 0; i < scene->balls; i++) {
+        BenchRect benchBall = renderBenchBall(i, scene->frame);
+        renderTexturedQuad(benchBall.x, benchBall.y, benchBall.w, benchBall.h, ballTexture);
+    }
+    dynResEndScene();
+    renderScore(scene->frame * 10);
+    presentFrame(SCREEN_PLAYING);
+
+    if (!renderBenchFrameEnd(profilerLastMs(PROF_RENDER), profilerLastMs(PROF_FRAME), shownDrawCalls)) {
+        gameRunning = false;
+    }
+}
+
 int main(int argc, char* argv[]) {
+    startupBenchBegin();
     printf("Starting Breakout game...\n");
 
+    bool profileAtExit = false;
+    const char* profileCsv = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--no-idle") == 0) {
+            idleMode = false;
+        } else if (strcmp(argv[i], "--single-thread") == 0) {
+            threaded = false;
+        } else if (strcmp(argv[i], "--bench-startup") == 0) {
+            startupBenchEnable();
+        } else if (strcmp(argv[i], "--headless") == 0) {
+            // SDL's offscreen video driver makes a surfaceless EGL context
+            // (llvmpipe without a GPU) and swaps to a pbuffer; the dummy
+            // audio driver stands in for a sound card. Both have to be
+            // picked before SDL_Init
+            SDL_setenv("SDL_VIDEODRIVER", "offscreen", 1);
+            SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+        } else if (strcmp(argv[i], "--bench-render") == 0) {
+            int frames = RENDER_BENCH_DEFAULT_FRAMES;
+            if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0) {
+                frames = atoi(argv[++i]);
+            }
+            renderBenchInit("legacy_gl", frames);
+        } else if (strcmp(argv[i], "--dynres") == 0) {
+            const char* spec = NULL;
+            if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0) {
+                spec = argv[++i];
+            }
+            if (!dynResConfigure(spec)) {
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--overlay") == 0) {
+            overlayVisible = true;
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            traceInit(argv[++i]);
+        } else if (strcmp(argv[i], "--profile") == 0) {
+            profileAtExit = true;
+            if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0) {
+                profileCsv = argv[++i];
+            }
+        } else if (strcmp(argv[i], "--capture") == 0 && i + 2 < argc) {
+            if (!captureLoad(argv[i + 1], argv[i + 2])) {
+                return 1;
+            }
+            i += 2;
+        } else if (strcmp(argv[i], "--resume") == 0) {
+            resumePath = SAVE_STATE_DEFAULT_PATH;
+            if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0) {
+                resumePath = argv[++i];
+            }
+        }
+    }
+    profilerInit(profileAtExit, profileCsv);
+
+    // Captures step inline, one step and one present per frame, so they
+    // come out the same every run
+    if (captureActive()) {
+        threaded = false;
+        idleMode = false;
+    }
+
     if (!initSDL()) {
         printf("Failed to initialize SDL. Exiting...\n");
         cleanup();
@@ -604,37 +917,42 @@ int main(int argc, char* argv[]) {
     winTexture = loadTexture("youwin.png");
     fontTexture = loadTexture("font.png");
     startScreenTexture = loadTexture("startscreen.png");
-    paddle.texture = loadTexture("paddle.png");
-    ball.texture = loadTexture("ball.png");
-    GLuint brickTexture = loadTexture("brick.png");
+    paddleTexture = loadTexture("paddle.png");
+    ballTexture = loadTexture("ball.png");
+    brickTexture = loadTexture("brick.png");
 
     if (!backgroundTexture || !gameOverTexture || !winTexture || !fontTexture ||
-        !startScreenTexture || !paddle.texture || !ball.texture || !brickTexture) {
+        !startScreenTexture || !paddleTexture || !ballTexture || !brickTexture) {
         printf("Failed to load textures. Exiting...\n");
         cleanup();
         return 1;
     }
 
-    // Set brick textures
-    for (int row = 0; row < NUM_BRICK_ROWS; row++) {
-        for (int col = 0; col < NUM_BRICK_COLUMNS; col++) {
-            bricks[row][col].texture = brickTexture;
-        }
-    }
-
     // Load audio files
     backgroundMusic = Mix_LoadMUS("background_music.ogg");
+    startupBenchMark("background_music.ogg");
     paddleHitSound = Mix_LoadWAV("paddle_hit.ogg");
+    startupBenchMark("paddle_hit.ogg");
     brickHitSound = Mix_LoadWAV("brick_hit.ogg");
+    startupBenchMark("brick_hit.ogg");
     gameOverSound = Mix_LoadWAV("game_over.ogg");
+    startupBenchMark("game_over.ogg");
     gameWonSound = Mix_LoadWAV("game_won.ogg");
+    startupBenchMark("game_won.ogg");
 
     if (!backgroundMusic || !paddleHitSound || !brickHitSound || !gameOverSound || !gameWonSound) {
         printf("Failed to load audio files. Continuing without audio.\n");
     }
 
-    firstGame = true;
-    initializeGame();
+    // Without a scene texture the game just stays at native resolution
+    dynResInit(WINDOW_WIDTH, WINDOW_HEIGHT);
+
+    // A suspended game comes back straight into play
+    simInit(&sim, captureActive() ? captureSeed() : (Uint32)time(NULL));
+    snapshotRingReset(&sim);
+    if (resumePath != NULL && !renderBenchActive() && !captureActive()) {
+        resumeGame(resumePath);
+    }
     printf("Game initialized, entering main loop...\n");
 
     // Start playing background music
@@ -642,14 +960,86 @@ int main(int argc, char* argv[]) {
         Mix_PlayMusic(backgroundMusic, -1);  // -1 means loop indefinitely
     }
 
+    presentReportTime = SDL_GetTicks();
+
+    // Hand the first snapshot over before anyone reads one
+    tripleBufferInit(&snapshots, &snapshotSlots[0], &snapshotSlots[1], &snapshotSlots[2]);
+    spscInit(&simCommands);
+    spscInit(&simSounds);
+    publishSnapshot();
+    simEventType = SDL_RegisterEvents(1);
+
+    if (threaded) {
+        simWakeup = SDL_CreateSemaphore(0);
+        SDL_AtomicSet(&simRunning, 1);
+        simThread = SDL_CreateThread(simThreadMain, "simulation", NULL);
+        if (simThread == NULL) {
+            printf("SDL_CreateThread failed: %s, running single-threaded\n", SDL_GetError());
+            threaded = false;
+        }
+    }
+
+    // Benchmarks measure how fast frames can go, so no vsync there
+    if (renderBenchActive()) {
+        SDL_GL_SetSwapInterval(0);
+    }
+
     while (gameRunning) {
-        handleInput();
-        updateGame();
-        renderGame();
-        SDL_Delay(16);  // Cap at roughly 60 FPS
+        profilerPoll();
+        if (renderBenchActive()) {
+            renderBenchFrame();
+            continue;
+        }
+        if (!captureBeginFrame()) {
+            break;
+        }
+        Uint32 frameStart = SDL_GetTicks();
+        waitWhileIdle(tripleBufferRead(&snapshots));
+        handleInput(tripleBufferRead(&snapshots));
+        if (!threaded) {
+            simStep();
+            publishSnapshot();
+        }
+        playSimSounds();
+        renderGame(tripleBufferRead(&snapshots));
+        reportPresentedFrames();
+
+        if (!threaded) {
+            // Captured frames are counted, not timed, so they don't wait
+            if (!captureActive()) {
+                SDL_Delay(16);  // Cap at roughly 60 FPS
+            }
+        } else {
+            // The simulation keeps its own clock; this only stops the loop
+            // spinning when vsync isn't throttling the present
+            Uint32 frameTime = SDL_GetTicks() - frameStart;
+            if (frameTime < FRAME_MS) {
+                SDL_Delay(FRAME_MS - frameTime);
+            }
+        }
+    }
+
+    if (simThread != NULL) {
+        SDL_AtomicSet(&simRunning, 0);
+        SDL_SemPost(simWakeup);
+        SDL_WaitThread(simThread, NULL);
+    }
+    if (simWakeup != NULL) {
+        SDL_DestroySemaphore(simWakeup);
+    }
+
+    // The simulation has stopped, so its state can be saved as it stands
+    if (resumePath != NULL && !renderBenchActive() && !captureActive()) {
+        suspendGame(resumePath);
     }
 
     printf("Game loop ended, cleaning up...\n");
+    profilerShutdown();
+    glStateReport();
+    captureShutdown();
+    traceShutdown();
     cleanup();
+    startupBenchMark("exit");
+    startupBenchReport();
     return 0;
 }
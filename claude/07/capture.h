@@ -0,0 +1,42 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+
+// Golden-frame capture for --capture <script> <dir>, with the same script
+// format as SDL_API_BRICK/07 and the GPT build. The script fixes the
+// random seed and lists key presses by frame; the game then runs as with
+// --single-thread, one simulation step and one present per frame, and
+// reads the held keys from the script instead of the keyboard, so a
+// script always produces the same frames. The frames it asks for are read
+// back with glReadPixels before the overlay is drawn and written to
+// <dir>/frame_NNNNN.png, for SDL_API_BRICK/07's frame_diff to check
+// against stored goldens.
+//
+// Script lines (# starts a comment, frames count from 1):
+//   seed <n>
+//   <frame> press <SDL key name>      e.g. "10 press Space", "40 press Left"
+//   <frame> release <SDL key name>
+//   <frame> capture
+//   <frame> quit
+
+#define CAPTURE_MAX_EVENTS 512
+#define CAPTURE_KEY_NAME_LENGTH 24
+
+bool captureLoad(const char* scriptPath, const char* outputDir);
+bool captureActive(void);
+unsigned captureSeed(void);
+
+// Starts the next frame: applies its key events and returns false once
+// the script's quit frame is reached
+bool captureBeginFrame(void);
+
+// Stands in for SDL_GetKeyboardState while capturing
+const Uint8* captureKeyboardState(void);
+
+// Call after the frame is drawn, before the overlay and the swap
+void captureReadFrame(void);
+void captureShutdown(void);
+
+#endif // CAPTURE_H
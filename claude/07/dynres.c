@@ -0,0 +1,230 @@
+#include "dynres.h"
+#include "glstate.h"
+#include <SDL2/SDL_opengl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define OVER_BUDGET 1.05    // Mean over target by this much scales down
+
+static DynResConfig config = {0.5f, 1.0f, 0.1f, 1000.0 / 60.0, 0.75, 30, 300, false};
+static bool enabled = false;
+
+static GLuint sceneTexture = 0;
+static int fullWidth, fullHeight;
+static int scaledWidth, scaledHeight;
+static float scale = 1.0f;
+static bool redirected = false;     // The current scene was drawn scaled
+
+static double samples[DYNRES_MAX_WINDOW];
+static int sampleCount = 0;
+static int sampleHead = 0;
+static double sampleSum = 0.0;
+static int framesAtScale = 0;
+static int probeWait;
+static bool probing = false;
+
+static bool parseOption(const char* key, const char* value) {
+    char* end;
+    double number = strtod(value, &end);
+    bool numeric = end != value && *end == '\0';
+
+    if (strcmp(key, "filter") == 0) {
+        if (strcmp(value, "linear") != 0 && strcmp(value, "nearest") != 0) return false;
+        config.linear = strcmp(value, "linear") == 0;
+    } else if (!numeric) {
+        return false;
+    } else if (strcmp(key, "min") == 0) {
+        config.minScale = (float)number;
+    } else if (strcmp(key, "max") == 0) {
+        config.maxScale = (float)number;
+    } else if (strcmp(key, "step") == 0) {
+        config.step = (float)number;
+    } else if (strcmp(key, "target") == 0) {
+        config.targetMs = number;
+    } else if (strcmp(key, "headroom") == 0) {
+        config.headroom = number;
+    } else if (strcmp(key, "window") == 0) {
+        config.window = (int)number;
+    } else if (strcmp(key, "probe") == 0) {
+        config.probeFrames = (int)number;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool dynResConfigure(const char* spec) {
+    enabled = true;
+    if (spec != NULL) {
+        char options[256];
+        snprintf(options, sizeof(options), "%s", spec);
+        for (char* option = strtok(options, ","); option != NULL; option = strtok(NULL, ",")) {
+            char* value = strchr(option, '=');
+            if (value == NULL) {
+                printf("dynres: expected key=value, got %s\n", option);
+                return false;
+            }
+            *value++ = '\0';
+            if (!parseOption(option, value)) {
+                printf("dynres: bad option %s=%s\n", option, value);
+                return false;
+            }
+        }
+    }
+
+    if (config.minScale <= 0.0f || config.minScale > config.maxScale || config.maxScale > 1.0f ||
+        config.step <= 0.0f || config.targetMs <= 0.0 || config.headroom <= 0.0 || config.headroom >= 1.0 ||
+        config.window < 1 || config.window > DYNRES_MAX_WINDOW || config.probeFrames < config.window) {
+        printf("dynres: need 0 < min <= max <= 1, step and target over 0, 0 < headroom < 1, "
+               "1 <= window <= %d and probe >= window\n", DYNRES_MAX_WINDOW);
+        return false;
+    }
+    return true;
+}
+
+bool dynResEnabled(void) {
+    return enabled;
+}
+
+static void resetSamples(void) {
+    sampleCount = 0;
+    sampleHead = 0;
+    sampleSum = 0.0;
+    framesAtScale = 0;
+}
+
+static void resize(float wanted) {
+    if (wanted < config.minScale) wanted = config.minScale;
+    if (wanted > config.maxScale) wanted = config.maxScale;
+    scale = wanted;
+    scaledWidth = (int)(fullWidth * scale + 0.5f);
+    scaledHeight = (int)(fullHeight * scale + 0.5f);
+    resetSamples();
+}
+
+bool dynResInit(int width, int height) {
+    if (!enabled) return true;
+
+    // RGB, so the blended upscale quad is opaque whatever the back
+    // buffer's alpha holds
+    GLint filter = config.linear ? GL_LINEAR : GL_NEAREST;
+    glGenTextures(1, &sceneTexture);
+    glStateBindTexture(GL_TEXTURE_2D, sceneTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    GLenum error = glGetError();
+    if (error != GL_NO_ERROR) {
+        printf("dynres: can't create the scene texture (%d), staying at native resolution\n", error);
+        dynResCleanup();
+        return false;
+    }
+
+    fullWidth = width;
+    fullHeight = height;
+    probeWait = config.probeFrames;
+    resize(config.maxScale);
+    printf("dynres %dx%d, scale %.2f to %.2f, target %.2f ms, %s filter\n", width, height,
+           config.minScale, config.maxScale, config.targetMs, config.linear ? "linear" : "nearest");
+    return true;
+}
+
+float dynResScale(void) {
+    return sceneTexture != 0 ? scale : 1.0f;
+}
+
+void dynResBeginScene(void) {
+    // Full size draws straight to the window and skips the copy
+    redirected = sceneTexture != 0 && (scaledWidth != fullWidth || scaledHeight != fullHeight);
+    if (!redirected) return;
+
+    // The projection is unchanged, so the whole playfield lands in the
+    // bottom-left corner of the back buffer
+    glViewport(0, 0, scaledWidth, scaledHeight);
+}
+
+void dynResEndScene(void) {
+    if (!redirected) return;
+    redirected = false;
+
+    glStateBindTexture(GL_TEXTURE_2D, sceneTexture);
+    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, scaledWidth, scaledHeight);
+    glViewport(0, 0, fullWidth, fullHeight);
+
+    // The copy has its bottom row first and the projection has y down
+    float u = (float)scaledWidth / fullWidth, v = (float)scaledHeight / fullHeight;
+    glBegin(GL_QUADS);
+    glStateColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+    glTexCoord2f(0, v); glVertex2f(0, 0);
+    glTexCoord2f(u, v); glVertex2f(fullWidth, 0);
+    glTexCoord2f(u, 0); glVertex2f(fullWidth, fullHeight);
+    glTexCoord2f(0, 0); glVertex2f(0, fullHeight);
+    glEnd();
+}
+
+static void changeScale(float wanted, double mean, const char* reason) {
+    if (wanted < config.minScale) wanted = config.minScale;
+    if (wanted > config.maxScale) wanted = config.maxScale;
+    if ((int)(fullWidth * wanted + 0.5f) == scaledWidth && (int)(fullHeight * wanted + 0.5f) == scaledHeight) {
+        return;
+    }
+
+    float from = scale;
+    resize(wanted);
+    printf("dynres %.2f -> %.2f (%dx%d), mean %.2f ms, target %.2f ms, %s\n",
+           from, scale, scaledWidth, scaledHeight, mean, config.targetMs, reason);
+    fflush(stdout);
+}
+
+void dynResFrameEnd(double frameMs) {
+    if (sceneTexture == 0) return;
+
+    if (sampleCount == config.window) {
+        sampleSum -= samples[sampleHead];
+    } else {
+        sampleCount++;
+    }
+    samples[sampleHead] = frameMs;
+    sampleSum += frameMs;
+    sampleHead = (sampleHead + 1) % config.window;
+    framesAtScale++;
+
+    // Nothing is decided until a whole window has run at this scale
+    if (sampleCount < config.window) return;
+    double mean = sampleSum / sampleCount;
+
+    if (mean > config.targetMs * OVER_BUDGET) {
+        if (probing) {
+            probeWait = probeWait * 2 < DYNRES_MAX_PROBE_FRAMES ? probeWait * 2 : DYNRES_MAX_PROBE_FRAMES;
+            probing = false;
+        }
+        // Fill cost goes with the area, so the side goes with its root
+        float wanted = scale * (float)sqrt(config.targetMs / mean);
+        changeScale(wanted < scale - config.step ? scale - config.step : wanted, mean, "over budget");
+        return;
+    }
+
+    if (probing) {
+        probing = false;
+        probeWait = config.probeFrames;
+    }
+    if (scale >= config.maxScale) return;
+    if (mean < config.targetMs * config.headroom) {
+        changeScale(scale + config.step, mean, "headroom");
+    } else if (framesAtScale >= probeWait) {
+        probing = true;
+        changeScale(scale + config.step / 2, mean, "probe");
+    }
+}
+
+void dynResCleanup(void) {
+    if (sceneTexture != 0) {
+        glStateDeleteTextures(1, &sceneTexture);
+        sceneTexture = 0;
+    }
+}
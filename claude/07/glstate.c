@@ -0,0 +1,87 @@
+#include "glstate.h"
+#include <stdio.h>
+#include <string.h>
+
+#define UNKNOWN_BINDING 0xFFFFFFFFu
+
+static const char* callNames[GLSTATE_CALL_COUNT] = {
+    "glBindTexture", "glColor4f"
+};
+
+static GLuint boundTexture2D = UNKNOWN_BINDING;
+static GLfloat currentColor[4];
+static bool colorKnown = false;
+
+static GlStateCounts currentFrame;
+static GlStateCounts lastFrame;
+static GlStateCounts totals;
+static Uint32 frameCount = 0;
+
+void glStateBindTexture(GLenum target, GLuint texture) {
+    if (target == GL_TEXTURE_2D) {
+        if (boundTexture2D == texture) {
+            currentFrame.filtered[GLSTATE_TEXTURE]++;
+            return;
+        }
+        boundTexture2D = texture;
+    }
+    currentFrame.issued[GLSTATE_TEXTURE]++;
+    glBindTexture(target, texture);
+}
+
+void glStateColor4f(GLfloat r, GLfloat g, GLfloat b, GLfloat a) {
+    if (colorKnown && currentColor[0] == r && currentColor[1] == g &&
+        currentColor[2] == b && currentColor[3] == a) {
+        currentFrame.filtered[GLSTATE_COLOR]++;
+        return;
+    }
+    currentColor[0] = r;
+    currentColor[1] = g;
+    currentColor[2] = b;
+    currentColor[3] = a;
+    colorKnown = true;
+    currentFrame.issued[GLSTATE_COLOR]++;
+    glColor4f(r, g, b, a);
+}
+
+// GL unbinds a deleted texture, so the shadow has to follow
+void glStateDeleteTextures(GLsizei n, const GLuint* textures) {
+    for (GLsizei i = 0; i < n; i++) {
+        if (textures[i] == boundTexture2D) boundTexture2D = 0;
+    }
+    glDeleteTextures(n, textures);
+}
+
+void glStateInvalidate(void) {
+    boundTexture2D = UNKNOWN_BINDING;
+    colorKnown = false;
+}
+
+void glStateFrameEnd(void) {
+    for (int call = 0; call < GLSTATE_CALL_COUNT; call++) {
+        totals.issued[call] += currentFrame.issued[call];
+        totals.filtered[call] += currentFrame.filtered[call];
+    }
+    lastFrame = currentFrame;
+    memset(&currentFrame, 0, sizeof(currentFrame));
+    frameCount++;
+}
+
+const GlStateCounts* glStateCurrentFrame(void) {
+    return &currentFrame;
+}
+
+const GlStateCounts* glStateLastFrame(void) {
+    return &lastFrame;
+}
+
+void glStateReport(void) {
+    printf("GL state calls over %u frames (per frame issued / filtered):\n", frameCount);
+    printf("%-20s %10s %10s %8s %8s\n", "call", "issued", "filtered", "issued", "filtered");
+    for (int call = 0; call < GLSTATE_CALL_COUNT; call++) {
+        double frames = frameCount > 0 ? frameCount : 1;
+        printf("%-20s %10u %10u %8.1f %8.1f\n", callNames[call],
+               totals.issued[call], totals.filtered[call],
+               totals.issued[call] / frames, totals.filtered[call] / frames);
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef GLSTATE_H
+#define GLSTATE_H
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_opengl.h>
+#include <stdbool.h>
+
+// Thin layer over the GL state calls the game makes every frame. It
+// shadows the bound 2D texture and the current colour, drops calls that
+// wouldn't change anything, and counts issued versus filtered calls per
+// frame. Every glBindTexture and glColor4f has to go through here, or the
+// shadow goes stale.
+
+typedef enum {
+    GLSTATE_TEXTURE,
+    GLSTATE_COLOR,
+    GLSTATE_CALL_COUNT
+} GlStateCall;
+
+typedef struct {
+    Uint32 issued[GLSTATE_CALL_COUNT];
+    Uint32 filtered[GLSTATE_CALL_COUNT];
+} GlStateCounts;
+
+void glStateBindTexture(GLenum target, GLuint texture);
+void glStateColor4f(GLfloat r, GLfloat g, GLfloat b, GLfloat a);  // Also inside glBegin
+void glStateDeleteTextures(GLsizei n, const GLuint* textures);
+
+// Forget everything shadowed, e.g. after GL was called directly
+void glStateInvalidate(void);
+
+// Call once per swap. The counts are the frame so far, the last finished
+// frame, and everything since startup.
+void glStateFrameEnd(void);
+const GlStateCounts* glStateCurrentFrame(void);
+const GlStateCounts* glStateLastFrame(void);
+void glStateReport(void);
+
+#endif // GLSTATE_H
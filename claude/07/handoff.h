@@ -0,0 +1,41 @@
+#ifndef HANDOFF_H
+#define HANDOFF_H
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+
+// Lock-free primitives for passing data between threads. Neither side
+// ever blocks or allocates.
+
+// Triple buffer: one writer publishes whole snapshots, one reader always
+// gets the newest complete one. The writer never waits for the reader and
+// the reader never sees a half-written slot.
+#define TRIPLE_BUFFER_FRESH 4   // Set in `middle` when the writer published
+
+typedef struct {
+    void* slots[3];
+    int back;                   // Writer-owned slot
+    int front;                  // Reader-owned slot
+    SDL_atomic_t middle;        // Slot in flight, plus TRIPLE_BUFFER_FRESH
+} TripleBuffer;
+
+void tripleBufferInit(TripleBuffer* tb, void* slot0, void* slot1, void* slot2);
+void* tripleBufferWriteSlot(TripleBuffer* tb);
+void tripleBufferPublish(TripleBuffer* tb);
+const void* tripleBufferRead(TripleBuffer* tb);
+
+// Single-producer/single-consumer queue of one-byte events. One slot is
+// kept empty to tell full from empty.
+#define SPSC_QUEUE_SIZE 64      // Power of two
+
+typedef struct {
+    Uint8 items[SPSC_QUEUE_SIZE];
+    SDL_atomic_t head;          // Next slot the producer writes
+    SDL_atomic_t tail;          // Next slot the consumer reads
+} SpscQueue;
+
+void spscInit(SpscQueue* queue);
+bool spscPush(SpscQueue* queue, Uint8 item);
+bool spscPop(SpscQueue* queue, Uint8* item);
+
+#endif // HANDOFF_H
@@ -1 +1,2 @@
-gcc -o breakout breakout.c -lSDL2 -lSDL2_image -lSDL2_mixer -lGL -lm
+gcc -o breakout breakout.c sim.c snapshotring.c handoff.c profiler.c trace.c glstate.c startup.c renderbench.c dynres.c savestate.c capture.c ${TRACE:+-DTRACE_ENABLED} -lSDL2 -lSDL2_image -lSDL2_mixer -lGL -lm
+gcc -o simcheck simcheck.c sim.c -Wall -Wextra -O2
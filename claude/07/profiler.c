@@ -0,0 +1,144 @@
+#include "profiler.h"
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef struct {
+    Uint32 samples[PROFILER_RING_SIZE];  // Nanoseconds
+    Uint32 head;                         // Total recorded; wraps the ring
+} PhaseRing;
+
+static const char* phaseNames[PROF_PHASE_COUNT] = {
+    "input", "update", "collision", "render", "present", "frame"
+};
+
+// Each ring has a single writer thread; reports read them from the main
+// thread, so a report taken mid-game may see a sample being replaced
+static PhaseRing rings[PROF_PHASE_COUNT];
+static Uint32 sortScratch[PROFILER_RING_SIZE];
+static Uint64 counterFrequency = 1;
+static bool reportAtExit = false;
+static const char* csvOutput = "profile.csv";
+static volatile sig_atomic_t reportRequested = 0;
+
+static void handleReportSignal(int sig) {
+    (void)sig;
+    reportRequested = 1;
+}
+
+void profilerInit(bool reportOnExit, const char* csvPath) {
+    counterFrequency = SDL_GetPerformanceFrequency();
+    reportAtExit = reportOnExit;
+    if (csvPath != NULL) {
+        csvOutput = csvPath;
+    }
+    memset(rings, 0, sizeof(rings));
+    signal(SIGUSR1, handleReportSignal);
+}
+
+Uint64 profilerNow(void) {
+    return SDL_GetPerformanceCounter();
+}
+
+void profilerRecord(ProfPhase phase, Uint64 start) {
+    Uint64 ticks = SDL_GetPerformanceCounter() - start;
+    // Split so the multiply can't overflow on nanosecond counters
+    Uint64 ns = ticks / counterFrequency * 1000000000ull +
+                ticks % counterFrequency * 1000000000ull / counterFrequency;
+
+    PhaseRing* ring = &rings[phase];
+    ring->samples[ring->head % PROFILER_RING_SIZE] = ns > 0xFFFFFFFFull ? 0xFFFFFFFFu : (Uint32)ns;
+    ring->head++;
+}
+
+double profilerLastMs(ProfPhase phase) {
+    const PhaseRing* ring = &rings[phase];
+    Uint32 head = ring->head;
+    if (head == 0) {
+        return 0.0;
+    }
+    return ring->samples[(head - 1) % PROFILER_RING_SIZE] / 1000000.0;
+}
+
+static int ringCount(const PhaseRing* ring) {
+    return ring->head < PROFILER_RING_SIZE ? (int)ring->head : PROFILER_RING_SIZE;
+}
+
+// Shell sort in place: no allocation, unlike glibc's qsort
+static void sortSamples(Uint32* values, int count) {
+    for (int gap = count / 2; gap > 0; gap /= 2) {
+        for (int i = gap; i < count; i++) {
+            Uint32 value = values[i];
+            int j = i;
+            while (j >= gap && values[j - gap] > value) {
+                values[j] = values[j - gap];
+                j -= gap;
+            }
+            values[j] = value;
+        }
+    }
+}
+
+static double percentileMs(const Uint32* sorted, int count, int percent) {
+    return sorted[(count - 1) * percent / 100] / 1000000.0;
+}
+
+void profilerReport(void) {
+    printf("Frame phase timings (ms), last %d samples per phase:\n", PROFILER_RING_SIZE);
+    printf("%-10s %8s %8s %8s %8s %8s\n", "phase", "samples", "p50", "p95", "p99", "max");
+
+    for (int phase = 0; phase < PROF_PHASE_COUNT; phase++) {
+        int count = ringCount(&rings[phase]);
+        if (count == 0) {
+            printf("%-10s %8d %8s %8s %8s %8s\n", phaseNames[phase], 0, "-", "-", "-", "-");
+            continue;
+        }
+
+        memcpy(sortScratch, rings[phase].samples, count * sizeof(Uint32));
+        sortSamples(sortScratch, count);
+        printf("%-10s %8d %8.3f %8.3f %8.3f %8.3f\n", phaseNames[phase], count,
+               percentileMs(sortScratch, count, 50),
+               percentileMs(sortScratch, count, 95),
+               percentileMs(sortScratch, count, 99),
+               sortScratch[count - 1] / 1000000.0);
+    }
+}
+
+static bool dumpCsv(const char* path) {
+    FILE* file = fopen(path, "w");
+    if (file == NULL) {
+        printf("Failed to open %s for the profile dump\n", path);
+        return false;
+    }
+
+    // One row per sample, oldest first within each phase
+    fprintf(file, "phase,sample,ms\n");
+    for (int phase = 0; phase < PROF_PHASE_COUNT; phase++) {
+        const PhaseRing* ring = &rings[phase];
+        int count = ringCount(ring);
+        Uint32 first = ring->head - count;
+        for (int i = 0; i < count; i++) {
+            Uint32 sample = ring->samples[(first + i) % PROFILER_RING_SIZE];
+            fprintf(file, "%s,%u,%.6f\n", phaseNames[phase], first + i, sample / 1000000.0);
+        }
+    }
+
+    fclose(file);
+    printf("Wrote frame profile to %s\n", path);
+    return true;
+}
+
+void profilerPoll(void) {
+    if (reportRequested) {
+        reportRequested = 0;
+        profilerReport();
+        dumpCsv(csvOutput);
+    }
+}
+
+void profilerShutdown(void) {
+    if (reportAtExit) {
+        profilerReport();
+        dumpCsv(csvOutput);
+    }
+}
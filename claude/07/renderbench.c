@@ -0,0 +1,116 @@
+#include "renderbench.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static const int renderBenchSizes[] = {100, 1000, 2500, 5000, 10000};
+#define SIZE_COUNT (int)(sizeof(renderBenchSizes) / sizeof(renderBenchSizes[0]))
+
+#define GRID_COLUMNS (RENDER_BENCH_AREA_WIDTH / RENDER_BENCH_BRICK_WIDTH)
+#define GRID_ROWS (RENDER_BENCH_AREA_HEIGHT / RENDER_BENCH_BRICK_HEIGHT)
+
+static const char* backendName = NULL;
+static int framesPerSize = RENDER_BENCH_DEFAULT_FRAMES;
+static int sizeIndex = 0;
+static RenderBenchScene scene;
+
+static double submitSamples[RENDER_BENCH_MAX_FRAMES];
+static double frameSamples[RENDER_BENCH_MAX_FRAMES];
+static int sampleCount = 0;
+static long long drawCallTotal = 0;
+
+void renderBenchInit(const char* backend, int frames) {
+    backendName = backend;
+    if (frames > RENDER_BENCH_WARMUP_FRAMES && frames <= RENDER_BENCH_MAX_FRAMES) {
+        framesPerSize = frames;
+    }
+    sizeIndex = 0;
+    scene = (RenderBenchScene){renderBenchSizes[0], RENDER_BENCH_BALLS, 0};
+    printf("%-12s %-14s %6s %5s %6s %10s %10s %10s %10s %8s %7s\n", "render_bench", "backend",
+           "bricks", "balls", "frames", "submit_ms", "submit_p95", "frame_ms", "frame_p95", "fps", "draws");
+}
+
+bool renderBenchActive(void) {
+    return backendName != NULL;
+}
+
+const RenderBenchScene* renderBenchScene(void) {
+    return &scene;
+}
+
+BenchRect renderBenchBrick(int index) {
+    int cell = index % (GRID_COLUMNS * GRID_ROWS);
+    int layer = index / (GRID_COLUMNS * GRID_ROWS);
+    return (BenchRect){
+        (cell % GRID_COLUMNS) * RENDER_BENCH_BRICK_WIDTH + layer * 3 % RENDER_BENCH_BRICK_WIDTH,
+        (cell / GRID_COLUMNS) * RENDER_BENCH_BRICK_HEIGHT + layer * 2 % RENDER_BENCH_BRICK_HEIGHT,
+        RENDER_BENCH_BRICK_WIDTH,
+        RENDER_BENCH_BRICK_HEIGHT
+    };
+}
+
+// Position along a bouncing path of the given length
+static int bounce(int travelled, int length) {
+    int period = travelled % (2 * length);
+    return period < length ? period : 2 * length - period;
+}
+
+BenchRect renderBenchBall(int index, int frame) {
+    const int rangeX = RENDER_BENCH_AREA_WIDTH - RENDER_BENCH_BALL_SIZE;
+    const int rangeY = RENDER_BENCH_AREA_HEIGHT - RENDER_BENCH_BALL_SIZE;
+    return (BenchRect){
+        bounce(index * 37 + frame * (3 + index % 4), rangeX),
+        bounce(index * 53 + frame * (2 + index % 3), rangeY),
+        RENDER_BENCH_BALL_SIZE,
+        RENDER_BENCH_BALL_SIZE
+    };
+}
+
+static int compareDoubles(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static void stats(double* samples, int count, double* mean, double* p95) {
+    double total = 0.0;
+    for (int i = 0; i < count; i++) {
+        total += samples[i];
+    }
+    qsort(samples, count, sizeof(double), compareDoubles);
+    *mean = total / count;
+    *p95 = samples[(count * 95) / 100];
+}
+
+static void reportSize(void) {
+    double submitMean, submitP95, frameMean, frameP95;
+    stats(submitSamples, sampleCount, &submitMean, &submitP95);
+    stats(frameSamples, sampleCount, &frameMean, &frameP95);
+    printf("%-12s %-14s %6d %5d %6d %10.3f %10.3f %10.3f %10.3f %8.1f %7lld\n", "render_bench", backendName,
+           scene.bricks, scene.balls, sampleCount, submitMean, submitP95, frameMean, frameP95,
+           frameMean > 0.0 ? 1000.0 / frameMean : 0.0, drawCallTotal / sampleCount);
+    fflush(stdout);
+}
+
+bool renderBenchFrameEnd(double submitMs, double frameMs, int drawCalls) {
+    if (!renderBenchActive()) return true;
+
+    if (scene.frame >= RENDER_BENCH_WARMUP_FRAMES) {
+        submitSamples[sampleCount] = submitMs;
+        frameSamples[sampleCount] = frameMs;
+        drawCallTotal += drawCalls;
+        sampleCount++;
+    }
+
+    scene.frame++;
+    if (scene.frame < framesPerSize) {
+        return true;
+    }
+
+    reportSize();
+    sampleCount = 0;
+    drawCallTotal = 0;
+    if (++sizeIndex == SIZE_COUNT) {
+        return false;
+    }
+    scene = (RenderBenchScene){renderBenchSizes[sizeIndex], RENDER_BENCH_BALLS, 0};
+    return true;
+}
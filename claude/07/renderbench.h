@@ -0,0 +1,44 @@
+#ifndef RENDERBENCH_H
+#define RENDERBENCH_H
+
+#include <stdbool.h>
+
+// Synthetic render benchmark for --bench-render. SDL_API_BRICK/07 and
+// the GPT build carry the same module, so all three stacks draw the same
+// scene: a background, N bricks tiled over a 640x480 area (16x8 each,
+// wrapping into further offset layers past 2400), RENDER_BENCH_BALLS
+// bouncing balls and a HUD line. N steps through renderBenchSizes; each
+// size runs for a fixed number of frames with vsync off, and one line per
+// size reports CPU submit time (scene start to present), present-to-
+// present frame time and draw calls.
+
+#define RENDER_BENCH_AREA_WIDTH 640
+#define RENDER_BENCH_AREA_HEIGHT 480
+#define RENDER_BENCH_BRICK_WIDTH 16
+#define RENDER_BENCH_BRICK_HEIGHT 8
+#define RENDER_BENCH_BALL_SIZE 15
+#define RENDER_BENCH_BALLS 16
+#define RENDER_BENCH_WARMUP_FRAMES 30   // Dropped from each size's stats
+#define RENDER_BENCH_MAX_FRAMES 2000
+#define RENDER_BENCH_DEFAULT_FRAMES 300
+
+typedef struct {
+    int x, y, w, h;  // Top-left corner, y down
+} BenchRect;
+
+typedef struct {
+    int bricks;
+    int balls;
+    int frame;       // Within this size, from 0
+} RenderBenchScene;
+
+void renderBenchInit(const char* backend, int framesPerSize);
+bool renderBenchActive(void);
+const RenderBenchScene* renderBenchScene(void);
+BenchRect renderBenchBrick(int index);  // This build has one brick texture
+BenchRect renderBenchBall(int index, int frame);
+
+// Records the frame just presented; returns false once every size is done
+bool renderBenchFrameEnd(double submitMs, double frameMs, int drawCalls);
+
+#endif // RENDERBENCH_H
@@ -0,0 +1,103 @@
+#include "savestate.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+// Differs from SDL_API_BRICK/07's magic, since the SimStates differ too
+static const char saveMagic[4] = {'B', 'R', 'K', 'C'};
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t size;      // sizeof(SimState) when written
+    uint32_t checksum;  // simHash of the payload
+} SaveHeader;
+
+// The rename lives in the directory, so the directory is synced too, or a
+// power cut can undo it even though the file's data made it to disk
+static void syncParentDirectory(const char* path) {
+    char directory[512];
+    snprintf(directory, sizeof(directory), "%s", path);
+    char* slash = strrchr(directory, '/');
+    if (slash == NULL) {
+        snprintf(directory, sizeof(directory), ".");
+    } else if (slash == directory) {
+        slash[1] = '\0';
+    } else {
+        *slash = '\0';
+    }
+
+    int fd = open(directory, O_RDONLY | O_DIRECTORY);
+    if (fd < 0 || fsync(fd) != 0) {
+        printf("savestate: can't sync %s: %s\n", directory, strerror(errno));
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+bool saveStateWrite(const char* path, const SimState* sim) {
+    char tempPath[512];
+    snprintf(tempPath, sizeof(tempPath), "%s.tmp", path);
+
+    SaveHeader header;
+    memcpy(header.magic, saveMagic, sizeof(header.magic));
+    header.version = SAVE_STATE_VERSION;
+    header.size = sizeof(SimState);
+    header.checksum = simHash(sim);
+
+    FILE* file = fopen(tempPath, "wb");
+    if (file == NULL) {
+        printf("savestate: can't write %s: %s\n", tempPath, strerror(errno));
+        return false;
+    }
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   fwrite(sim, sizeof(SimState), 1, file) == 1 &&
+                   fflush(file) == 0 &&
+                   fsync(fileno(file)) == 0;
+    written = fclose(file) == 0 && written;
+
+    // The rename is what makes the new save visible, so it only happens
+    // once the data is on disk
+    if (!written || rename(tempPath, path) != 0) {
+        printf("savestate: writing %s failed: %s\n", path, strerror(errno));
+        remove(tempPath);
+        return false;
+    }
+    syncParentDirectory(path);
+    return true;
+}
+
+bool saveStateRead(const char* path, SimState* sim) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        if (errno != ENOENT) {
+            printf("savestate: can't read %s: %s\n", path, strerror(errno));
+        }
+        return false;
+    }
+
+    SaveHeader header;
+    SimState loaded;
+    bool complete = fread(&header, sizeof(header), 1, file) == 1 &&
+                    memcmp(header.magic, saveMagic, sizeof(saveMagic)) == 0 &&
+                    header.version == SAVE_STATE_VERSION &&
+                    header.size == sizeof(SimState) &&
+                    fread(&loaded, sizeof(loaded), 1, file) == 1;
+    fclose(file);
+
+    if (!complete) {
+        printf("savestate: %s isn't a version %d save, ignoring it\n", path, SAVE_STATE_VERSION);
+        return false;
+    }
+    if (simHash(&loaded) != header.checksum) {
+        printf("savestate: %s fails its checksum, ignoring it\n", path);
+        return false;
+    }
+
+    *sim = loaded;
+    return true;
+}
@@ -0,0 +1,24 @@
+#ifndef SAVESTATE_H
+#define SAVESTATE_H
+
+#include "sim.h"
+#include <stdbool.h>
+
+// Suspend/resume file for --resume, the same format as SDL_API_BRICK/07's
+// save_state.c: a header (magic, format version, payload size, FNV-1a
+// checksum) followed by the SimState bytes in host order. Writes go to
+// "<path>.tmp", are synced and renamed over the old file, and the
+// directory is synced after the rename, so a power cut leaves either the
+// old save or the new one.
+// Bump SAVE_STATE_VERSION whenever SimState changes shape.
+
+#define SAVE_STATE_VERSION 1
+#define SAVE_STATE_DEFAULT_PATH "suspend.sav"
+
+bool saveStateWrite(const char* path, const SimState* sim);
+
+// False, with the reason printed, when the file is missing, damaged or
+// from another version; sim is only written on success
+bool saveStateRead(const char* path, SimState* sim);
+
+#endif // SAVESTATE_H
@@ -0,0 +1,275 @@
+#include "sim.h"
+#include <string.h>
+
+#define ALL_BRICKS (((uint64_t)1 << (NUM_BRICK_ROWS * NUM_BRICK_COLUMNS)) - 1)
+
+static uint32_t nextRandom(SimState* sim) {
+    uint32_t x = sim->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    sim->rng = x;
+    return x;
+}
+
+// sin of 0 to 90 degrees in 16.16, whole degrees. Written out rather than
+// filled from sin() at startup, since libm results differ between
+// platforms.
+static const int32_t sinTable[91] = {
+    0, 1144, 2287, 3430, 4572, 5712, 6850, 7987,
+    9121, 10252, 11380, 12505, 13626, 14742, 15855, 16962,
+    18064, 19161, 20252, 21336, 22415, 23486, 24550, 25607,
+    26656, 27697, 28729, 29753, 30767, 31772, 32768, 33754,
+    34729, 35693, 36647, 37590, 38521, 39441, 40348, 41243,
+    42126, 42995, 43852, 44695, 45525, 46341, 47143, 47930,
+    48703, 49461, 50203, 50931, 51643, 52339, 53020, 53684,
+    54332, 54963, 55578, 56175, 56756, 57319, 57865, 58393,
+    58903, 59396, 59870, 60326, 60764, 61183, 61584, 61966,
+    62328, 62672, 62997, 63303, 63589, 63856, 64104, 64332,
+    64540, 64729, 64898, 65048, 65177, 65287, 65376, 65446,
+    65496, 65526, 65536,
+};
+
+// Degrees from -90 to 90
+static int32_t fxSin(int degrees) {
+    return degrees < 0 ? -sinTable[-degrees] : sinTable[degrees];
+}
+
+static int32_t fxCos(int degrees) {
+    return sinTable[90 - (degrees < 0 ? -degrees : degrees)];
+}
+
+// Signed division truncates toward zero by the standard, unlike a right
+// shift of a negative number, which is up to the compiler
+static int32_t fxMul(int32_t a, int32_t b) {
+    return (int32_t)((int64_t)a * b / FX_ONE);
+}
+
+static int32_t fxAbs(int32_t value) {
+    return value < 0 ? -value : value;
+}
+
+// Bit-by-bit integer square root, exact on every platform
+static uint32_t isqrt64(uint64_t value) {
+    uint64_t root = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+    while (bit > value) bit >>= 2;
+    while (bit != 0) {
+        if (value >= root + bit) {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)root;
+}
+
+// Up, with a random sideways speed that's never too slow
+static void launchBall(SimState* sim) {
+    sim->ballDx = FX(-BALL_SPEED) + (int32_t)(nextRandom(sim) % (uint32_t)(FX(2 * BALL_SPEED) + 1));
+    sim->ballDy = FX(-BALL_SPEED);
+    if (fxAbs(sim->ballDx) < FX(BALL_SPEED) / 2) {
+        sim->ballDx = (sim->ballDx > 0) ? FX(BALL_SPEED) / 2 : -FX(BALL_SPEED) / 2;
+    }
+}
+
+// A ball centred at (x, y) in 16.16 against a rectangle in whole pixels
+static bool checkCollision(int left, int top, int width, int height, int32_t x, int32_t y) {
+    return (x + FX(BALL_SIZE) > FX(left) &&
+            x - FX(BALL_SIZE) < FX(left + width) &&
+            y + FX(BALL_SIZE) > FX(top) &&
+            y - FX(BALL_SIZE) < FX(top + height));
+}
+
+static void resetBoard(SimState* sim) {
+    sim->brickMask = ALL_BRICKS;
+    sim->ballX = FX(WINDOW_WIDTH / 2);
+    sim->ballY = FX(WINDOW_HEIGHT / 2);
+    sim->ballDx = 0;
+    sim->ballDy = 0;
+    sim->paddleX = WINDOW_WIDTH / 2 - PADDLE_WIDTH / 2;
+    sim->lives = INITIAL_LIVES;
+    sim->score = 0;
+    sim->consecutiveHits = 0;
+}
+
+void simInit(SimState* sim, uint32_t seed) {
+    *sim = (SimState){0};
+    sim->rng = seed != 0 ? seed : 0x9E3779B9u;
+    sim->screen = SCREEN_START;
+    resetBoard(sim);
+}
+
+void simStart(SimState* sim) {
+    resetBoard(sim);
+    sim->screen = SCREEN_PLAYING;
+    sim->countdownFrames = COUNTDOWN_FRAMES;
+}
+
+int simCountdownSeconds(const SimState* sim) {
+    return sim->countdownFrames > 0 ? (sim->countdownFrames - 1) / SIM_HZ + 1 : 0;
+}
+
+int simBallX(const SimState* sim) {
+    return fxFloor(sim->ballX);
+}
+
+int simBallY(const SimState* sim) {
+    return fxFloor(sim->ballY);
+}
+
+uint32_t simHash(const SimState* sim) {
+    unsigned char bytes[sizeof(SimState)];
+    memcpy(bytes, sim, sizeof(bytes));
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < sizeof(bytes); i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+bool simBrickStanding(const SimState* sim, int row, int col) {
+    return (sim->brickMask >> (row * NUM_BRICK_COLUMNS + col)) & 1;
+}
+
+static uint32_t handlePaddleCollision(SimState* sim) {
+    if (!checkCollision(sim->paddleX, PADDLE_Y, PADDLE_WIDTH, PADDLE_HEIGHT, sim->ballX, sim->ballY)) {
+        return 0;
+    }
+
+    // Where on the paddle the ball hit, -1 to 1 from right to left, as an
+    // angle of up to 60 degrees either way. The ball's edge can catch the
+    // paddle past its end, which goes a little further.
+    int64_t relativeIntersectX = (int64_t)FX(sim->paddleX + PADDLE_WIDTH / 2) - sim->ballX;
+    int angle = (int)(relativeIntersectX * 60 / FX(PADDLE_WIDTH / 2));
+    if (angle < -90) angle = -90;
+    if (angle > 90) angle = 90;
+
+    // Keep the speed, change the direction
+    uint64_t dx = (uint64_t)((int64_t)sim->ballDx * sim->ballDx);
+    uint64_t dy = (uint64_t)((int64_t)sim->ballDy * sim->ballDy);
+    int32_t speed = (int32_t)isqrt64(dx + dy);
+    sim->ballDx = -fxMul(speed, fxSin(angle));
+    sim->ballDy = -fxMul(speed, fxCos(angle));
+
+    // Move ball out of paddle to prevent multiple collisions
+    sim->ballY = FX(PADDLE_Y - BALL_SIZE);
+
+    // Reset consecutive hits when ball touches paddle
+    sim->consecutiveHits = 0;
+    return SIM_EVENT_PADDLE_HIT;
+}
+
+static uint32_t handleBrickCollisions(SimState* sim) {
+    for (int row = 0; row < NUM_BRICK_ROWS; row++) {
+        for (int col = 0; col < NUM_BRICK_COLUMNS; col++) {
+            int x = col * BRICK_WIDTH;
+            int y = row * BRICK_HEIGHT + BRICK_TOP;
+            if (!simBrickStanding(sim, row, col) ||
+                !checkCollision(x, y, BRICK_WIDTH, BRICK_HEIGHT, sim->ballX, sim->ballY)) {
+                continue;
+            }
+            sim->brickMask &= ~((uint64_t)1 << (row * NUM_BRICK_COLUMNS + col));
+
+            // Update score
+            sim->score += 10 + (sim->consecutiveHits * 5);
+            sim->consecutiveHits++;
+
+            // Determine which side of the brick was hit
+            int64_t dx = fxAbs(sim->ballX - FX(x + BRICK_WIDTH / 2));
+            int64_t dy = fxAbs(sim->ballY - FX(y + BRICK_HEIGHT / 2));
+            if (dx * BRICK_HEIGHT > dy * BRICK_WIDTH) {
+                sim->ballDx = -sim->ballDx;
+            } else {
+                sim->ballDy = -sim->ballDy;
+            }
+            return SIM_EVENT_BRICK_HIT;
+        }
+    }
+    return 0;
+}
+
+uint32_t simAdvance(SimState* sim, uint32_t input) {
+    uint32_t events = simMove(sim, input);
+    return events | simCollide(sim);
+}
+
+uint32_t simMove(SimState* sim, uint32_t input) {
+    if (sim->screen != SCREEN_PLAYING) {
+        return 0;
+    }
+    sim->frame++;
+
+    if (input & INPUT_LEFT) {
+        sim->paddleX -= PADDLE_SPEED;
+        if (sim->paddleX < 0) sim->paddleX = 0;
+    }
+    if (input & INPUT_RIGHT) {
+        sim->paddleX += PADDLE_SPEED;
+        if (sim->paddleX > WINDOW_WIDTH - PADDLE_WIDTH) {
+            sim->paddleX = WINDOW_WIDTH - PADDLE_WIDTH;
+        }
+    }
+
+    // Countdown is still going, don't update ball position
+    if (sim->countdownFrames > 0) {
+        sim->countdownFrames--;
+        return 0;
+    }
+
+    // If this is the first update after countdown, initialize ball velocity
+    if (sim->ballDx == 0 && sim->ballDy == 0) {
+        launchBall(sim);
+    }
+
+    sim->ballX += sim->ballDx;
+    sim->ballY += sim->ballDy;
+
+    // Ball collision with walls
+    if (sim->ballX < FX(BALL_SIZE)) {
+        sim->ballX = FX(BALL_SIZE);
+        sim->ballDx = fxAbs(sim->ballDx);
+    }
+    if (sim->ballX > FX(WINDOW_WIDTH - BALL_SIZE)) {
+        sim->ballX = FX(WINDOW_WIDTH - BALL_SIZE);
+        sim->ballDx = -fxAbs(sim->ballDx);
+    }
+    if (sim->ballY < FX(BALL_SIZE)) {
+        sim->ballY = FX(BALL_SIZE);
+        sim->ballDy = fxAbs(sim->ballDy);
+    }
+
+    // Ball out of bounds (bottom)
+    if (sim->ballY > FX(WINDOW_HEIGHT - BALL_SIZE)) {
+        sim->lives--;
+        if (sim->lives <= 0) {
+            sim->screen = SCREEN_GAME_OVER;
+            return SIM_EVENT_GAME_OVER;
+        }
+        sim->ballX = FX(WINDOW_WIDTH / 2);
+        sim->ballY = FX(WINDOW_HEIGHT / 2);
+        launchBall(sim);
+        sim->paddleX = WINDOW_WIDTH / 2 - PADDLE_WIDTH / 2;
+        return SIM_EVENT_LIFE_LOST;
+    }
+    return 0;
+}
+
+uint32_t simCollide(SimState* sim) {
+    // The ball has no speed until the countdown is over
+    if (sim->screen != SCREEN_PLAYING || (sim->ballDx == 0 && sim->ballDy == 0)) {
+        return 0;
+    }
+
+    uint32_t events = handlePaddleCollision(sim);
+    events |= handleBrickCollisions(sim);
+
+    // Check for win condition
+    if (sim->brickMask == 0) {
+        sim->screen = SCREEN_WIN;
+        events |= SIM_EVENT_GAME_WON;
+    }
+    return events;
+}
@@ -0,0 +1,116 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// The game simulation, apart from SDL and GL. Everything it carries from
+// one step to the next is a SimState of fixed-size fields with no
+// pointers: textures and sounds stay in breakout.c and the random
+// generator is a field, so a copy of the struct is the whole game and the
+// rewind history can be XORed deltas of it. The countdown is a number of
+// steps rather than an SDL_GetTicks timestamp, so it runs at the
+// simulation's pace and rewinds with everything else.
+//
+// Positions and speeds are 16.16 fixed point, the paddle bounce uses a
+// sine table and an integer square root, and there's no floating point
+// anywhere, so a seed and an input sequence give the same states bit for
+// bit on x86 and ARM, whatever the compiler or libm. SDL_API_BRICK/07's
+// simulation works the same way.
+
+#define WINDOW_WIDTH 800
+#define WINDOW_HEIGHT 480
+#define BRICK_WIDTH 80
+#define BRICK_HEIGHT 20
+#define BRICK_TOP 50
+#define NUM_BRICK_COLUMNS 10
+#define NUM_BRICK_ROWS 5
+#define PADDLE_WIDTH 100
+#define PADDLE_HEIGHT 20
+#define PADDLE_Y (WINDOW_HEIGHT - 40)
+#define PADDLE_SPEED 7
+#define BALL_SIZE 15
+#define BALL_SPEED 5
+#define INITIAL_LIVES 3
+#define SIM_HZ 60                     // Steps per second
+#define COUNTDOWN_FRAMES (3 * SIM_HZ) // Three seconds before the ball launches
+
+#define FX_SHIFT 16
+#define FX_ONE (1 << FX_SHIFT)
+#define FX(n) ((int32_t)(n) * FX_ONE)
+
+// Whole part, rounded down. Dividing after clearing the fraction is exact,
+// where a right shift of a negative number is up to the compiler.
+static inline int32_t fxFloor(int32_t value) {
+    return (value - (value & (FX_ONE - 1))) / FX_ONE;
+}
+
+#if NUM_BRICK_ROWS * NUM_BRICK_COLUMNS > 64
+#error "SimState.brickMask holds at most 64 bricks"
+#endif
+
+typedef enum {
+    SCREEN_START,
+    SCREEN_PLAYING,
+    SCREEN_GAME_OVER,
+    SCREEN_WIN
+} Screen;
+
+// Input bits for simAdvance
+#define INPUT_LEFT 1
+#define INPUT_RIGHT 2
+
+// What a step did, for the caller to turn into sound
+#define SIM_EVENT_PADDLE_HIT 1
+#define SIM_EVENT_BRICK_HIT 2
+#define SIM_EVENT_LIFE_LOST 4
+#define SIM_EVENT_GAME_OVER 8
+#define SIM_EVENT_GAME_WON 16
+
+typedef struct {
+    uint64_t brickMask;      // Bit (row * NUM_BRICK_COLUMNS + col) set while standing
+    int32_t ballX, ballY;    // Centre of the ball, 16.16 pixels
+    int32_t ballDx, ballDy;  // 16.16 pixels per step; both 0 until the ball launches
+    int32_t paddleX;         // Whole pixels
+    uint32_t rng;            // xorshift32 state
+    int32_t screen;          // Screen
+    int32_t lives;
+    int32_t score;
+    int32_t consecutiveHits;
+    int32_t countdownFrames; // Steps left before the ball launches
+    uint32_t frame;          // Steps since simInit
+} SimState;
+
+// Start screen, with the random generator seeded (0 is replaced)
+void simInit(SimState* sim, uint32_t seed);
+
+// A new game from the top, starting with the countdown
+void simStart(SimState* sim);
+
+// One step; does nothing off the playing screen. The paddle moves during
+// the countdown, the ball only after it. Returns SIM_EVENT_* bits. It's
+// simMove then simCollide, which breakout.c calls apart so the profiler
+// can time collision on its own.
+uint32_t simAdvance(SimState* sim, uint32_t input);
+
+// The first half of a step: the paddle, the countdown, the ball and its
+// bounces off the walls, and a ball lost out the bottom
+uint32_t simMove(SimState* sim, uint32_t input);
+
+// The second half: paddle and brick hits and the win. Does nothing while
+// the ball waits out the countdown or once the game is over.
+uint32_t simCollide(SimState* sim);
+
+// Whole seconds left on the countdown as shown, 0 once it's over
+int simCountdownSeconds(const SimState* sim);
+
+// Ball centre in whole pixels, rounded down, for drawing
+int simBallX(const SimState* sim);
+int simBallY(const SimState* sim);
+
+// FNV-1a over the state bytes, so x86 and ARM runs can be compared
+uint32_t simHash(const SimState* sim);
+
+bool simBrickStanding(const SimState* sim, int row, int col);
+
+#endif // SIM_H
@@ -0,0 +1,60 @@
+#include "startup.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct {
+    char stage[STARTUP_STAGE_LENGTH];
+    double ms;
+} StartupMark;
+
+// Clock_gettime rather than SDL's counter, which isn't usable before
+// SDL_Init on every platform
+static struct timespec origin;
+static bool enabled = false;
+static StartupMark marks[STARTUP_MAX_MARKS];
+static int markCount = 0;
+static int marksDropped = 0;
+
+void startupBenchBegin(void) {
+    clock_gettime(CLOCK_MONOTONIC, &origin);
+}
+
+void startupBenchEnable(void) {
+    enabled = true;
+}
+
+bool startupBenchEnabled(void) {
+    return enabled;
+}
+
+void startupBenchMark(const char* stage) {
+    if (!enabled) return;
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (markCount == STARTUP_MAX_MARKS) {
+        marksDropped++;
+        return;
+    }
+
+    StartupMark* mark = &marks[markCount++];
+    mark->ms = (now.tv_sec - origin.tv_sec) * 1000.0 + (now.tv_nsec - origin.tv_nsec) / 1000000.0;
+    // Stage names are single words in the report
+    snprintf(mark->stage, sizeof(mark->stage), "%s", stage);
+    for (char* c = mark->stage; *c != '\0'; c++) {
+        if (*c == ' ' || *c == '\t') *c = '_';
+    }
+}
+
+void startupBenchReport(void) {
+    if (!enabled) return;
+
+    for (int i = 0; i < markCount; i++) {
+        printf("startup_bench %s %.3f\n", marks[i].stage, marks[i].ms);
+    }
+    if (marksDropped > 0) {
+        printf("startup_bench: %d marks past the first %d were dropped\n", marksDropped, STARTUP_MAX_MARKS);
+    }
+    fflush(stdout);
+}
@@ -0,0 +1,22 @@
+#ifndef STARTUP_H
+#define STARTUP_H
+
+#include <stdbool.h>
+
+// Time-to-first-frame benchmark for --bench-startup. startupBenchBegin()
+// takes the origin as the first thing in main; with the flag set, every
+// startupBenchMark() after that stores the monotonic time since the
+// origin under a stage name, and startupBenchReport() prints one
+// "startup_bench <stage> <ms>" line per mark for bench_startup.sh to
+// collect. Without the flag the marks return straight away.
+
+#define STARTUP_MAX_MARKS 48
+#define STARTUP_STAGE_LENGTH 48
+
+void startupBenchBegin(void);
+void startupBenchEnable(void);
+bool startupBenchEnabled(void);
+void startupBenchMark(const char* stage);
+void startupBenchReport(void);
+
+#endif // STARTUP_H
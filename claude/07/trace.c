@@ -0,0 +1,163 @@
+#include "trace.h"
+#include <string.h>
+
+#ifdef TRACE_ENABLED
+
+typedef struct {
+    const char* name;
+    Uint64 start;
+    Uint64 end;
+    char detail[TRACE_DETAIL_SIZE];
+} TraceEvent;
+
+// One per thread, so recording needs no locks. Full buffers drop events.
+typedef struct {
+    const char* threadName;
+    int count;
+    int dropped;
+    TraceEvent events[TRACE_EVENTS_PER_THREAD];
+} TraceBuffer;
+
+static TraceBuffer buffers[TRACE_MAX_THREADS];
+static SDL_atomic_t buffersClaimed;
+static __thread TraceBuffer* threadBuffer = NULL;
+static __thread bool threadOutOfBuffers = false;
+
+static bool traceEnabled = false;
+static const char* tracePath = NULL;
+static Uint64 traceOrigin = 0;
+static Uint64 traceFrequency = 1;
+
+bool traceInit(const char* path) {
+    tracePath = path;
+    traceFrequency = SDL_GetPerformanceFrequency();
+    traceOrigin = SDL_GetPerformanceCounter();
+    traceEnabled = true;
+    traceThreadName("main");
+    return true;
+}
+
+// Claims a buffer the first time a thread records anything
+static TraceBuffer* getThreadBuffer(void) {
+    if (threadBuffer == NULL && !threadOutOfBuffers) {
+        int index = SDL_AtomicAdd(&buffersClaimed, 1);
+        if (index < TRACE_MAX_THREADS) {
+            threadBuffer = &buffers[index];
+        } else {
+            threadOutOfBuffers = true;
+        }
+    }
+    return threadBuffer;
+}
+
+void traceThreadName(const char* name) {
+    if (!traceEnabled) return;
+
+    TraceBuffer* buffer = getThreadBuffer();
+    if (buffer != NULL) {
+        buffer->threadName = name;
+    }
+}
+
+TraceZone traceZoneBegin(const char* name, const char* detail) {
+    TraceZone zone;
+    zone.name = NULL;
+    if (traceEnabled) {
+        zone.name = name;
+        // The detail is often a stack buffer that's gone by the time the
+        // trace is written, so it's copied rather than pointed to
+        SDL_strlcpy(zone.detail, detail != NULL ? detail : "", sizeof(zone.detail));
+        zone.start = SDL_GetPerformanceCounter();
+    }
+    return zone;
+}
+
+void traceZoneEnd(TraceZone* zone) {
+    if (zone->name == NULL) return;
+
+    Uint64 end = SDL_GetPerformanceCounter();
+    TraceBuffer* buffer = getThreadBuffer();
+    if (buffer == NULL) return;
+
+    if (buffer->count >= TRACE_EVENTS_PER_THREAD) {
+        buffer->dropped++;
+        return;
+    }
+    TraceEvent* event = &buffer->events[buffer->count++];
+    event->name = zone->name;
+    event->start = zone->start;
+    event->end = end;
+    memcpy(event->detail, zone->detail, sizeof(event->detail));
+}
+
+static double toMicroseconds(Uint64 ticks) {
+    return (double)ticks * 1000000.0 / traceFrequency;
+}
+
+static void writeJsonString(FILE* file, const char* text) {
+    fputc('"', file);
+    for (const char* c = text; *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\') {
+            fputc('\\', file);
+        }
+        fputc(*c, file);
+    }
+    fputc('"', file);
+}
+
+// Call once every traced thread has finished
+void traceShutdown(void) {
+    if (!traceEnabled) return;
+    traceEnabled = false;
+
+    FILE* file = fopen(tracePath, "w");
+    if (file == NULL) {
+        printf("Failed to open %s for the trace\n", tracePath);
+        return;
+    }
+
+    int threads = SDL_AtomicGet(&buffersClaimed);
+    if (threads > TRACE_MAX_THREADS) threads = TRACE_MAX_THREADS;
+
+    int total = 0;
+    bool first = true;
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    for (int tid = 0; tid < threads; tid++) {
+        const TraceBuffer* buffer = &buffers[tid];
+
+        if (buffer->threadName != NULL) {
+            fprintf(file, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":",
+                    first ? "" : ",", tid);
+            writeJsonString(file, buffer->threadName);
+            fprintf(file, "}}");
+            first = false;
+        }
+
+        for (int i = 0; i < buffer->count; i++) {
+            const TraceEvent* event = &buffer->events[i];
+            fprintf(file, "%s\n{\"name\":", first ? "" : ",");
+            writeJsonString(file, event->name);
+            fprintf(file, ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f",
+                    tid, toMicroseconds(event->start - traceOrigin),
+                    toMicroseconds(event->end - event->start));
+            if (event->detail[0] != '\0') {
+                fprintf(file, ",\"args\":{\"detail\":");
+                writeJsonString(file, event->detail);
+                fprintf(file, "}");
+            }
+            fprintf(file, "}");
+            first = false;
+        }
+
+        total += buffer->count;
+        if (buffer->dropped > 0) {
+            printf("Trace buffer for thread %d was full, dropped %d events\n", tid, buffer->dropped);
+        }
+    }
+    fprintf(file, "\n]}\n");
+    fclose(file);
+
+    printf("Wrote %d trace events to %s\n", total, tracePath);
+}
+
+#endif // TRACE_ENABLED